@@ -0,0 +1,56 @@
+# cmake -DOUT=<file.cpp> -DSPIRV_FILES=<a.spv|b.spv|...> -P EmbedSpirv.cmake
+#
+# Генерирует C++ TU с SPIR-V всех шейдеров как constexpr uint32_t массивами
+# и таблицей для embeddedShaders() (см. src/vk/ShaderRegistry.h).
+# Имя шейдера = имя .spv без расширения: lb_glyphlets.mesh
+
+if (NOT OUT OR NOT SPIRV_FILES)
+  message(FATAL_ERROR "EmbedSpirv.cmake: OUT and SPIRV_FILES are required")
+endif()
+
+string(REPLACE "|" ";" SPIRV_FILES "${SPIRV_FILES}")
+list(SORT SPIRV_FILES)
+
+set(ARRAYS "")
+set(TABLE "")
+
+foreach(SPV ${SPIRV_FILES})
+  get_filename_component(FULL_NAME ${SPV} NAME)
+  string(REGEX REPLACE "\\.spv$" "" NAME "${FULL_NAME}")    # lb_glyphlets.mesh
+  string(MAKE_C_IDENTIFIER "k_${NAME}" IDENT)               # k_lb_glyphlets_mesh
+
+  file(READ "${SPV}" HEX HEX)
+  string(LENGTH "${HEX}" HEX_LEN)
+  math(EXPR REM "${HEX_LEN} % 8")
+  if (HEX_LEN EQUAL 0 OR NOT REM EQUAL 0)
+    message(FATAL_ERROR "Invalid SPIR-V size: ${SPV}")
+  endif()
+  math(EXPR WORDS "${HEX_LEN} / 8")
+
+  # SPIR-V от glslang — little-endian слова
+  string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " BODY "${HEX}")
+  # по 8 слов в строке (в CMake regex нет {n})
+  set(W "0x........u, ")
+  string(REGEX REPLACE "(${W}${W}${W}${W}${W}${W}${W}${W})" "\\1\n    " BODY "${BODY}")
+  string(REGEX REPLACE " +\n" "\n" BODY "${BODY}")
+  string(REGEX REPLACE "[ \n]+$" "" BODY "${BODY}")
+
+  string(APPEND ARRAYS "static constexpr uint32_t ${IDENT}[${WORDS}] = {\n    ${BODY}\n};\n\n")
+  string(APPEND TABLE "    { \"${NAME}\", ${IDENT}, ${WORDS} },\n")
+endforeach()
+
+set(CONTENT "// Сгенерировано cmake/EmbedSpirv.cmake — не редактировать.
+#include \"vk/ShaderRegistry.h\"
+
+#include <cstdint>
+
+${ARRAYS}static constexpr EmbeddedShader kShaders[] = {
+${TABLE}};
+
+std::span<const EmbeddedShader> embeddedShaders()
+{
+    return kShaders;
+}
+")
+
+file(WRITE "${OUT}" "${CONTENT}")
@@ -2,7 +2,7 @@
 #extension GL_EXT_mesh_shader : require
 
 layout(location = 0) in vec2 inUV;
-layout(location = 1) flat in uint inPrimType;
+layout(location = 1) perprimitiveEXT flat in uint inPrimType; // per-primitive: вершины общие
 
 layout(location = 0) out vec4 outColor;
 
@@ -1,61 +1,106 @@
 #version 460
 #extension GL_EXT_mesh_shader : require
 
+// workgroup = один meshlet глифа одного инстанса (см. lb_glyphlets.task.glsl).
+// Вершины meshlet'а общие для его треугольников, тип треугольника — per-primitive.
 layout(local_size_x = 32) in;
 
-layout(triangles, max_vertices = 64, max_primitives = 32) out;
+// LoopBlinnMesh::kMaxMeshletVertices / kMaxMeshletTriangles
+layout(triangles, max_vertices = 64, max_primitives = 124) out;
 
-// per-vertex varyings
 layout(location = 0) out vec2 vUV[];
-layout(location = 1) out flat uint vPrimType[];
+layout(location = 1) perprimitiveEXT flat out uint pPrimType[];
 
-// Buffers
+// Buffers (src/vk/LoopBlinnMesh.h)
 layout(set = 0, binding = 0, std430) readonly buffer PositionsBuf { vec2 pos[]; } positions;
-layout(set = 0, binding = 1, std430) readonly buffer IndicesBuf   { uvec3 tri[]; } indices;
-layout(set = 0, binding = 2, std430) readonly buffer PrimTypeBuf  { uint primType[]; } ptypes;
-layout(set = 0, binding = 3, std430) readonly buffer InstancesBuf { vec2 offsetNDC[]; } inst;
+layout(set = 0, binding = 1, std430) readonly buffer VerticesBuf  { uint v[]; } vertices;   // позиция << 2 | угол
+layout(set = 0, binding = 2, std430) readonly buffer TrianglesBuf { uint t[]; } triangles;  // a | b << 8 | c << 16 | тип << 24
 
-const uint nPrims = 10u;
-const uint nVerts = nPrims * 3u;
+// Совпадает с GlyphInstance в src/vk/TextLayout.h
+struct GlyphInstance
+{
+    vec2 posMin; // NDC: (left, bottom)
+    vec2 posMax; // NDC: (right, top)
+    vec2 uvMin;
+    vec2 uvMax;
+    uint glyph;  // индекс в glyphs
+    uint atlas;  // MSDF атлас (здесь не нужен)
+};
+layout(set = 0, binding = 3, std430) readonly buffer InstancesBuf { GlyphInstance g[]; } inst;
+
+// Совпадает с LoopBlinnGlyph в src/vk/LoopBlinnMesh.h
+struct LbGlyph
+{
+    vec2 frameMin; // em: растягивается в quad инстанса
+    vec2 frameMax;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint codepoint;
+    uint triangleCount;
+};
+layout(set = 0, binding = 4, std430) readonly buffer GlyphsBuf { LbGlyph g[]; } glyphs;
+
+// Совпадает с LoopBlinnMeshlet в src/vk/LoopBlinnMesh.h
+struct LbMeshlet
+{
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+};
+layout(set = 0, binding = 5, std430) readonly buffer MeshletsBuf { LbMeshlet m[]; } meshlets;
+
+struct LbTaskPayload
+{
+    uint firstInstance;
+    uint meshletStart[33];
+};
+taskPayloadSharedEXT LbTaskPayload payload;
 
-vec4 toNDC(vec2 p, vec2 instOff)
+// LoopBlinnMesh::Corner: Start, Control, End, Any
+const vec2 kCornerUV[4] = vec2[4](vec2(0.0, 0.0), vec2(0.5, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0));
+
+vec4 toNDC(vec2 p, LbGlyph lg, GlyphInstance g)
 {
-    // Та же логика, что была в прототипе — только теперь instOff приходит из SSBO.
-    float s = 0.45;
-    vec2 t = vec2(-0.2, 0.0);
-    vec2 ndc = p * s + t + instOff;
-    return vec4(ndc, 0.0, 1.0);
+    // контур растягивается в quad инстанса (TextLayout)
+    vec2 t = (p - lg.frameMin) / (lg.frameMax - lg.frameMin);
+    return vec4(mix(g.posMin, g.posMax, t), 0.0, 1.0);
 }
 
 void main()
 {
-    uint primID = gl_LocalInvocationID.x;
-    uint glyphInstance = gl_WorkGroupID.x;
-
-    if (primID == 0u) {
-        SetMeshOutputsEXT(nVerts, nPrims);
-    }
-    barrier();
+    const uint tid = gl_LocalInvocationID.x;
+    const uint m = gl_WorkGroupID.x;
 
-    if (primID < nPrims)
+    // инстанс: последний k с meshletStart[k] <= m (у пустых start[k] == start[k + 1])
+    uint lo = 0u;
+    uint hi = 31u;
+    while (lo < hi)
     {
-        uvec3 idx = indices.tri[primID];
-        uint base = primID * 3u;
-        uint ttype = ptypes.primType[primID];
-        vec2 off = inst.offsetNDC[glyphInstance];
+        const uint mid = (lo + hi + 1u) >> 1u;
+        if (payload.meshletStart[mid] <= m)
+            lo = mid;
+        else
+            hi = mid - 1u;
+    }
 
-        gl_MeshVerticesEXT[base + 0u].gl_Position = toNDC(positions.pos[idx.x], off);
-        vUV[base + 0u] = vec2(0.0, 0.0);
-        vPrimType[base + 0u] = ttype;
+    const GlyphInstance g = inst.g[payload.firstInstance + lo];
+    const LbGlyph lg = glyphs.g[g.glyph];
+    const LbMeshlet ml = meshlets.m[lg.firstMeshlet + (m - payload.meshletStart[lo])];
 
-        gl_MeshVerticesEXT[base + 1u].gl_Position = toNDC(positions.pos[idx.y], off);
-        vUV[base + 1u] = vec2(0.5, 0.0);
-        vPrimType[base + 1u] = ttype;
+    SetMeshOutputsEXT(ml.vertexCount, ml.triangleCount);
 
-        gl_MeshVerticesEXT[base + 2u].gl_Position = toNDC(positions.pos[idx.z], off);
-        vUV[base + 2u] = vec2(1.0, 1.0);
-        vPrimType[base + 2u] = ttype;
+    for (uint v = tid; v < ml.vertexCount; v += gl_WorkGroupSize.x)
+    {
+        const uint packed = vertices.v[ml.vertexOffset + v];
+        gl_MeshVerticesEXT[v].gl_Position = toNDC(positions.pos[packed >> 2u], lg, g);
+        vUV[v] = kCornerUV[packed & 3u];
+    }
 
-        gl_PrimitiveTriangleIndicesEXT[primID] = uvec3(base + 0u, base + 1u, base + 2u);
+    for (uint t = tid; t < ml.triangleCount; t += gl_WorkGroupSize.x)
+    {
+        const uint packed = triangles.t[ml.triangleOffset + t];
+        gl_PrimitiveTriangleIndicesEXT[t] = uvec3(packed & 0xFFu, (packed >> 8u) & 0xFFu, (packed >> 16u) & 0xFFu);
+        pPrimType[t] = packed >> 24u;
     }
 }
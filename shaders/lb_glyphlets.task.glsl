@@ -0,0 +1,83 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// Loop–Blinn glyphlets: поток = инстанс. Каждый инстанс запускает столько mesh workgroup'ов,
+// сколько meshlet'ов у его глифа (GlyphInstance::glyph -> таблица глифов); в payload —
+// префиксная сумма, по которой mesh workgroup находит свой инстанс и meshlet.
+layout(local_size_x = 32) in;
+
+// Совпадает с GlyphInstance в src/vk/TextLayout.h
+struct GlyphInstance
+{
+    vec2 posMin;
+    vec2 posMax;
+    vec2 uvMin;
+    vec2 uvMax;
+    uint glyph;
+    uint atlas;
+};
+layout(set = 0, binding = 3, std430) readonly buffer InstancesBuf { GlyphInstance g[]; } inst;
+
+// Совпадает с LoopBlinnGlyph в src/vk/LoopBlinnMesh.h
+struct LbGlyph
+{
+    vec2 frameMin;
+    vec2 frameMax;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint codepoint;
+    uint triangleCount;
+};
+layout(set = 0, binding = 4, std430) readonly buffer GlyphsBuf { LbGlyph g[]; } glyphs;
+
+// Совпадает с LbGlyphletPushConstants в src/vk/MeshTestPipeline.h
+layout(push_constant) uniform PC
+{
+    uint instanceCount;
+    uint glyphCount;
+} pc;
+
+struct LbTaskPayload
+{
+    uint firstInstance;
+    uint meshletStart[33]; // [k] — первая mesh workgroup инстанса firstInstance + k
+};
+taskPayloadSharedEXT LbTaskPayload payload;
+
+shared uint s_counts[32];
+shared uint s_total;
+
+void main()
+{
+    const uint tid = gl_LocalInvocationID.x;
+    const uint first = gl_WorkGroupID.x * gl_WorkGroupSize.x;
+    const uint i = first + tid;
+
+    uint count = 0u;
+    if (i < pc.instanceCount)
+    {
+        const GlyphInstance g = inst.g[i];
+
+        // дырки в буфере (нулевые инстансы) и глифы без контура meshlet'ов не дают
+        if (g.glyph < pc.glyphCount && any(notEqual(g.posMin, g.posMax)))
+            count = glyphs.g[g.glyph].meshletCount;
+    }
+    s_counts[tid] = count;
+    barrier();
+
+    if (tid == 0u)
+    {
+        uint sum = 0u;
+        for (uint k = 0u; k < gl_WorkGroupSize.x; ++k)
+        {
+            payload.meshletStart[k] = sum;
+            sum += s_counts[k];
+        }
+        payload.meshletStart[32] = sum;
+        payload.firstInstance = first;
+        s_total = sum;
+    }
+    barrier();
+
+    EmitMeshTasksEXT(s_total, 1u, 1u);
+}
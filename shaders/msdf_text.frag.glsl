@@ -0,0 +1,52 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 vUv;
+layout(location = 1) flat in uint vAtlas; // слот таблицы атласов << 16 | слой
+layout(location = 0) out vec4 outColor;
+
+// Таблица атласов: texture array на слот, индекс — из инстанса, поэтому глифы любых
+// шрифтов идут одним draw. Пустые слоты не записаны (PARTIALLY_BOUND), инстансы на них
+// не ссылаются. MAX_ATLASES = kMsdfMaxAtlases в src/vk/MsdfTextPipeline.h
+const uint MAX_ATLASES = 8u;
+layout(set = 0, binding = 0) uniform sampler2DArray uAtlases[MAX_ATLASES];
+
+// Совпадает с MsdfTextPushConstants в src/vk/MsdfTextPipeline.h
+layout(push_constant) uniform PC
+{
+    vec4 params;   // x=debug(0/1)
+    vec4 viewRect;
+    vec4 pxRange[MAX_ATLASES / 4u]; // по слотам таблицы
+} pc;
+
+float median3(float a, float b, float c)
+{
+    return max(min(a,b), min(max(a,b), c));
+}
+
+void main()
+{
+    // в одной волне — фрагменты глифов разных атласов
+    const uint slot = vAtlas >> 16u;
+    const float layer = float(vAtlas & 0xFFFFu);
+
+    vec3 s = texture(uAtlases[nonuniformEXT(slot)], vec3(vUv, layer)).rgb;
+
+    if (pc.params.x > 0.5)
+    {
+        outColor = vec4(s, 1.0);
+        return;
+    }
+
+    float sd = median3(s.r, s.g, s.b) - 0.5;
+
+    vec2 texSize = vec2(textureSize(uAtlases[nonuniformEXT(slot)], 0).xy);
+    vec2 unitRange = vec2(pc.pxRange[slot >> 2u][slot & 3u]) / texSize;
+    vec2 screenTexSize = vec2(1.0) / fwidth(vUv);
+    float screenPxRange = max(0.5 * dot(unitRange, screenTexSize), 1.0);
+
+    float alpha = clamp(sd * screenPxRange + 0.5, 0.0, 1.0);
+
+    // белый текст
+    outColor = vec4(1.0, 1.0, 1.0, alpha);
+}
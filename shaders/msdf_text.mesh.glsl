@@ -0,0 +1,111 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// Упакованный вариант: одна workgroup рисует группу до GLYPHS_PER_GROUP quad'ов подряд
+// (4 вершины / 2 треугольника на глиф), потоки идут по вершинам и примитивам.
+// Какую группу рисовать, решил task shader (msdf_text.task.glsl).
+// Размер workgroup (32/64) и GLYPHS_PER_GROUP задаются спец-константами
+// из VkPhysicalDeviceMeshShaderPropertiesEXT (см. MsdfTextPipeline).
+layout(local_size_x_id = 0) in;
+layout(constant_id = 1) const uint GLYPHS_PER_GROUP = 32u;
+
+// верхняя граница: 32 глифа; фактический вывод — SetMeshOutputsEXT
+layout(triangles, max_vertices = 128, max_primitives = 64) out;
+
+struct GlyphInstance
+{
+    vec2 posMin; // NDC: (left, bottom)
+    vec2 posMax; // NDC: (right, top)
+    vec2 uvMin;  // (u0, vTop)   - v=0 вверху
+    vec2 uvMax;  // (u1, vBottom)
+    uint glyph;  // glyph index шрифта (здесь не нужен)
+    uint atlas;  // слот таблицы атласов << 16 | слой
+};
+
+// Совпадают с src/vk/TextCullTable.h
+struct TextCullBlock
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    vec2 clipMin;
+    vec2 clipMax;
+    uint firstGroup;
+    uint groupCount;
+    uint glyphCount;
+    uint pad;
+};
+
+struct TextCullGroup
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    uint firstInstance;
+    uint count;
+    uint block;
+    uint pad;
+};
+
+layout(set = 0, binding = 1, std430) readonly buffer Instances { GlyphInstance inst[]; };
+layout(set = 0, binding = 2, std430) readonly buffer CullBlocks { TextCullBlock blocks[]; };
+layout(set = 0, binding = 3, std430) readonly buffer CullGroups { TextCullGroup groups[]; };
+
+struct TextTaskPayload
+{
+    uint groups[32];
+};
+taskPayloadSharedEXT TextTaskPayload payload;
+
+// clip rect блока режет частично видимые глифы
+out gl_MeshPerVertexEXT
+{
+    vec4 gl_Position;
+    float gl_ClipDistance[4];
+} gl_MeshVerticesEXT[];
+
+layout(location = 0) out vec2 vUv[];
+layout(location = 1) flat out uint vAtlas[];
+
+void main()
+{
+    const uint tid = gl_LocalInvocationID.x;
+
+    const TextCullGroup grp = groups[payload.groups[gl_WorkGroupID.x]];
+    const TextCullBlock blk = blocks[grp.block];
+
+    const uint glyphs = min(GLYPHS_PER_GROUP, grp.count);
+    const uint nVerts = glyphs * 4u;
+    const uint nPrims = glyphs * 2u;
+
+    SetMeshOutputsEXT(nVerts, nPrims);
+
+    for (uint v = tid; v < nVerts; v += gl_WorkGroupSize.x)
+    {
+        GlyphInstance g = inst[grp.firstInstance + (v >> 2u)];
+
+        // 0=BL 1=BR 2=TR 3=TL
+        const uint corner = v & 3u;
+        const bool right = corner == 1u || corner == 2u;
+        const bool top = corner >= 2u;
+
+        const vec2 p = vec2(right ? g.posMax.x : g.posMin.x,
+                            top ? g.posMax.y : g.posMin.y);
+
+        gl_MeshVerticesEXT[v].gl_Position = vec4(p, 0.0, 1.0);
+        gl_MeshVerticesEXT[v].gl_ClipDistance[0] = p.x - blk.clipMin.x;
+        gl_MeshVerticesEXT[v].gl_ClipDistance[1] = blk.clipMax.x - p.x;
+        gl_MeshVerticesEXT[v].gl_ClipDistance[2] = p.y - blk.clipMin.y;
+        gl_MeshVerticesEXT[v].gl_ClipDistance[3] = blk.clipMax.y - p.y;
+
+        // uvs (v=0 top)
+        vUv[v] = vec2(right ? g.uvMax.x : g.uvMin.x,
+                      top ? g.uvMin.y : g.uvMax.y);
+        vAtlas[v] = g.atlas;
+    }
+
+    for (uint p = tid; p < nPrims; p += gl_WorkGroupSize.x)
+    {
+        const uint b = (p >> 1u) * 4u;
+        gl_PrimitiveTriangleIndicesEXT[p] = (p & 1u) == 0u ? uvec3(b, b + 1u, b + 2u)
+                                                          : uvec3(b, b + 2u, b + 3u);
+    }
+}
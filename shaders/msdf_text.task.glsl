@@ -0,0 +1,117 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// Отсечение текста: поток = группа глифов (одна будущая mesh workgroup).
+// Блоки целиком уже отсёк compute pre-pass (msdf_text_cull.comp.glsl): draw gl_DrawID —
+// один видимый блок, здесь группа выживает, если пересекает clip rect блока ∩ экран.
+// Выжившие группы уплотняются в payload, mesh workgroup'ы запускаются только для них.
+layout(local_size_x = 32) in;
+
+// Совпадают с src/vk/TextCullTable.h
+struct TextCullBlock
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    vec2 clipMin;
+    vec2 clipMax;
+    uint firstGroup;
+    uint groupCount;
+    uint glyphCount;
+    uint pad;
+};
+
+struct TextCullGroup
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    uint firstInstance;
+    uint count;
+    uint block;
+    uint pad;
+};
+
+layout(set = 0, binding = 2, std430) readonly buffer CullBlocks { TextCullBlock blocks[]; };
+layout(set = 0, binding = 3, std430) readonly buffer CullGroups { TextCullGroup groups[]; };
+
+// Пишет compute pre-pass: (block, firstGroup, groupCount, 0) на каждый draw
+layout(set = 0, binding = 5, std430) readonly buffer DrawInfos { uvec4 draws[]; };
+
+// Обнуляется CPU после чтения (см. MeshTestRenderer::drawFrame)
+layout(set = 0, binding = 4, std430) buffer CullStats
+{
+    uint visibleGlyphs;
+    uint culledGlyphs;
+    uint visibleGroups;
+    uint culledGroups;
+} stats;
+
+// Совпадает с MsdfTextPushConstants в src/vk/MsdfTextPipeline.h
+layout(push_constant) uniform PC
+{
+    vec4 params;   // x=debug(0/1)
+    vec4 viewRect; // видимая область в NDC: (minX, minY, maxX, maxY)
+} pc;
+
+struct TextTaskPayload
+{
+    uint groups[32];
+};
+taskPayloadSharedEXT TextTaskPayload payload;
+
+shared uint s_emitted;
+shared uint s_visibleGlyphs;
+shared uint s_culledGlyphs;
+
+bool overlaps(vec2 aMin, vec2 aMax, vec2 bMin, vec2 bMax)
+{
+    return all(lessThanEqual(aMin, bMax)) && all(lessThanEqual(bMin, aMax));
+}
+
+void main()
+{
+    const uint tid = gl_LocalInvocationID.x;
+    const uvec4 draw = draws[gl_DrawID];
+    const uint local = gl_WorkGroupID.x * gl_WorkGroupSize.x + tid;
+
+    if (tid == 0u)
+    {
+        s_emitted = 0u;
+        s_visibleGlyphs = 0u;
+        s_culledGlyphs = 0u;
+    }
+    barrier();
+
+    if (local < draw.z)
+    {
+        const uint gi = draw.y + local;
+        const TextCullGroup g = groups[gi];
+        const TextCullBlock b = blocks[draw.x];
+
+        const vec2 visMin = max(b.clipMin, pc.viewRect.xy);
+        const vec2 visMax = min(b.clipMax, pc.viewRect.zw);
+
+        const bool visible = overlaps(g.boundsMin, g.boundsMax, visMin, visMax);
+
+        if (visible)
+        {
+            payload.groups[atomicAdd(s_emitted, 1u)] = gi;
+            atomicAdd(s_visibleGlyphs, g.count);
+        }
+        else
+        {
+            atomicAdd(s_culledGlyphs, g.count);
+        }
+    }
+    barrier();
+
+    if (tid == 0u)
+    {
+        const uint groupsHere = min(gl_WorkGroupSize.x, draw.z - gl_WorkGroupID.x * gl_WorkGroupSize.x);
+        atomicAdd(stats.visibleGlyphs, s_visibleGlyphs);
+        atomicAdd(stats.culledGlyphs, s_culledGlyphs);
+        atomicAdd(stats.visibleGroups, s_emitted);
+        atomicAdd(stats.culledGroups, groupsHere - s_emitted);
+    }
+
+    EmitMeshTasksEXT(s_emitted, 1u, 1u);
+}
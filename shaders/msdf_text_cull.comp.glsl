@@ -0,0 +1,87 @@
+#version 460
+
+// GPU-driven pre-pass MSDF текста: поток = слот таблицы блоков.
+// Блок, пересекающий (clip rect ∩ экран), получает свою VkDrawMeshTasksIndirectCommandEXT
+// (ceil(groupCount / 32) task workgroup'ов) и запись TextDrawInfo с тем же индексом —
+// task shader находит её по gl_DrawID. Число записей — drawCount для
+// vkCmdDrawMeshTasksIndirectCountEXT; CPU его не читает.
+layout(local_size_x = 64) in;
+
+// Совпадает с src/vk/TextCullTable.h
+struct TextCullBlock
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    vec2 clipMin;
+    vec2 clipMax;
+    uint firstGroup;
+    uint groupCount;
+    uint glyphCount;
+    uint pad;
+};
+
+// = VkDrawMeshTasksIndirectCommandEXT (stride 12)
+struct DrawMeshTasksCommand
+{
+    uint x;
+    uint y;
+    uint z;
+};
+
+layout(set = 0, binding = 0, std430) readonly buffer CullBlocks { TextCullBlock blocks[]; };
+
+// Обнуляется vkCmdFillBuffer перед pre-pass'ом
+layout(set = 0, binding = 1, std430) buffer DrawCount { uint drawCount; };
+layout(set = 0, binding = 2, std430) writeonly buffer DrawCommands { DrawMeshTasksCommand cmds[]; };
+
+// (block, firstGroup, groupCount, 0)
+layout(set = 0, binding = 3, std430) writeonly buffer DrawInfos { uvec4 draws[]; };
+
+// Те же счётчики, что дописывает task shader; здесь — блоки, отброшенные целиком
+layout(set = 0, binding = 4, std430) buffer CullStats
+{
+    uint visibleGlyphs;
+    uint culledGlyphs;
+    uint visibleGroups;
+    uint culledGroups;
+} stats;
+
+// Совпадает с MsdfTextCullPushConstants в src/vk/MsdfTextCullPipeline.h
+layout(push_constant) uniform PC
+{
+    vec4 viewRect;   // видимая область в NDC: (minX, minY, maxX, maxY)
+    uint blockCount; // TextCullTable::blockCapacity()
+} pc;
+
+const uint GROUPS_PER_TASK = 32u; // local_size_x msdf_text.task.glsl
+
+bool overlaps(vec2 aMin, vec2 aMax, vec2 bMin, vec2 bMax)
+{
+    return all(lessThanEqual(aMin, bMax)) && all(lessThanEqual(bMin, aMax));
+}
+
+void main()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    if (i >= pc.blockCount)
+        return;
+
+    const TextCullBlock b = blocks[i];
+    if (b.groupCount == 0u)
+        return;
+
+    const vec2 visMin = max(b.clipMin, pc.viewRect.xy);
+    const vec2 visMax = min(b.clipMax, pc.viewRect.zw);
+
+    if (overlaps(b.boundsMin, b.boundsMax, visMin, visMax))
+    {
+        const uint slot = atomicAdd(drawCount, 1u);
+        cmds[slot] = DrawMeshTasksCommand((b.groupCount + GROUPS_PER_TASK - 1u) / GROUPS_PER_TASK, 1u, 1u);
+        draws[slot] = uvec4(i, b.firstGroup, b.groupCount, 0u);
+    }
+    else
+    {
+        atomicAdd(stats.culledGlyphs, b.glyphCount);
+        atomicAdd(stats.culledGroups, b.groupCount);
+    }
+}
@@ -0,0 +1,463 @@
+#version 460
+
+// GPU layout MSDF текста (GpuTextLayout): code points -> GlyphInstance без CPU.
+// Повторяет TextLayout (advance + кернинг, перенос по '\n', табы), кроме переноса
+// по maxWidth и выравнивания. Один инстанс на символ: пробелы и переводы строк —
+// вырожденные quad'ы, зато индекс инстанса = индекс символа и группы известны заранее.
+//
+// Четыре прохода (спец-константа PASS):
+//   0 — поток = символ: advance, сегментные scan'ы внутри workgroup
+//       (pen сбрасывается в начале строки, номер строки — в начале run'а), итог workgroup'ы;
+//   1 — одна workgroup: exclusive scan итогов workgroup'ов прохода 0;
+//   2 — поток = символ: глобальные pen/строка -> GlyphInstance;
+//   3 — поток = группа: TextCullGroup (bbox до glyphsPerGroup инстансов).
+layout(local_size_x = 256) in;
+layout(constant_id = 0) const uint PASS = 0u;
+
+const uint WG = 256u;
+
+// Совпадает с GpuTextRunGpu в src/vk/GpuTextLayout.cpp
+struct TextRun
+{
+    float originX;
+    float originY;
+    float scaleX;
+    float scaleY;
+    float lineStep;   // lineHeight * lineSpacing * scaleY
+    uint firstChar;
+    uint charCount;
+    uint firstGroup;
+    uint kerning;
+    uint atlas;       // GlyphInstance::atlas шрифта
+    uint pad1;
+    uint pad2;
+};
+
+struct GlyphInstance
+{
+    vec2 posMin;
+    vec2 posMax;
+    vec2 uvMin;
+    vec2 uvMax;
+    uint glyph;
+    uint atlas;
+};
+
+// Совпадает с src/vk/TextCullTable.h
+struct TextCullGroup
+{
+    vec2 boundsMin;
+    vec2 boundsMax;
+    uint firstInstance;
+    uint count;
+    uint block;
+    uint pad;
+};
+
+// Таблица шрифта: заголовок из смещений (в словах) + данные, см. GpuTextLayout::buildFontTable
+layout(set = 0, binding = 0, std430) readonly buffer Font { uint font[]; };
+layout(set = 0, binding = 1, std430) readonly buffer Codepoints { uint cps[]; };
+layout(set = 0, binding = 2, std430) readonly buffer Runs { TextRun runs[]; };
+
+// Проход 0 -> 2: (pen локально, строка локально, флаги "сегмент начался в этой workgroup", 0)
+layout(set = 0, binding = 3, std430) buffer Scratch { uvec4 scratch[]; };
+
+// Итоги workgroup'ов прохода 0; проход 1 заменяет их exclusive префиксом
+layout(set = 0, binding = 4, std430) buffer BlockSums { uvec4 blockSums[]; };
+
+layout(set = 0, binding = 5, std430) buffer Instances { GlyphInstance inst[]; };
+layout(set = 0, binding = 6, std430) writeonly buffer Groups { TextCullGroup groups[]; };
+
+// Совпадает с GpuTextLayoutPushConstants в src/vk/GpuTextLayout.h
+layout(push_constant) uniform PC
+{
+    uint charCount;
+    uint runCount;
+    uint blockCount;     // workgroup'ов в проходах 0/2
+    uint groupCount;
+    uint glyphsPerGroup;
+} pc;
+
+// Заголовок таблицы шрифта
+const uint H_DIRECT        = 0u;
+const uint H_SPARSE_COUNT  = 1u;
+const uint H_SPARSE_CP     = 2u;
+const uint H_SPARSE_GLYPH  = 3u;
+const uint H_GLYPH_COUNT   = 4u;
+const uint H_ADVANCE       = 5u;
+const uint H_QUAD          = 6u;
+const uint H_KERN_COUNT    = 7u;
+const uint H_KERN_FIRST    = 8u;
+const uint H_KERN_RIGHT    = 9u;
+const uint H_KERN_VALUE    = 10u;
+const uint H_FALLBACK      = 11u;
+const uint H_SPACE_GLYPH   = 12u;
+const uint H_SPACE_ADVANCE = 13u;
+
+const uint DIRECT_RANGE  = 0x0500u; // MsdfFont::kDirectRange
+const uint MAX_GLYPHS    = 0xFFF0u; // MsdfFont::kMaxGlyphs
+const uint INVALID_GLYPH = 0xFFFFu;
+const uint TAB_SPACES    = 4u;
+
+// Служебные коды, как в TextLayout.cpp
+const uint CODE_SPACE   = 0xFFF0u;
+const uint CODE_TAB     = 0xFFF1u;
+const uint CODE_NEWLINE = 0xFFF2u;
+const uint CODE_SKIP    = 0xFFF3u;
+
+uint glyphIndex(uint cp)
+{
+    if (cp == 32u) return CODE_SPACE;
+    if (cp == 9u)  return CODE_TAB;
+    if (cp == 10u) return CODE_NEWLINE;
+    if (cp == 13u) return CODE_SKIP;
+
+    uint gi = INVALID_GLYPH;
+    if (cp < DIRECT_RANGE)
+    {
+        gi = font[font[H_DIRECT] + cp];
+    }
+    else
+    {
+        // lower_bound по отсортированным codepoint'ам
+        const uint base = font[H_SPARSE_CP];
+        const uint count = font[H_SPARSE_COUNT];
+        uint lo = 0u;
+        uint n = count;
+        while (n > 0u)
+        {
+            const uint half = n >> 1u;
+            if (font[base + lo + half] < cp)
+            {
+                lo += half + 1u;
+                n -= half + 1u;
+            }
+            else
+            {
+                n = half;
+            }
+        }
+        if (lo < count && font[base + lo] == cp)
+            gi = font[font[H_SPARSE_GLYPH] + lo];
+    }
+
+    return gi != INVALID_GLYPH ? gi : font[H_FALLBACK];
+}
+
+// MsdfFont::kerning: пары с левым глифом left отсортированы по правому
+float kerning(uint left, uint right)
+{
+    if (font[H_KERN_COUNT] == 0u || left >= font[H_GLYPH_COUNT] || right >= MAX_GLYPHS)
+        return 0.0;
+
+    const uint firstBase = font[H_KERN_FIRST];
+    const uint rightBase = font[H_KERN_RIGHT];
+    uint lo = font[firstBase + left];
+    uint hi = font[firstBase + left + 1u];
+    const uint end = hi;
+    while (lo < hi)
+    {
+        const uint mid = (lo + hi) >> 1u;
+        if (font[rightBase + mid] < right)
+            lo = mid + 1u;
+        else
+            hi = mid;
+    }
+    return lo < end && font[rightBase + lo] == right ? uintBitsToFloat(font[font[H_KERN_VALUE] + lo]) : 0.0;
+}
+
+// run, в который попадает символ; runCount, если ни в какой
+uint findRun(uint i)
+{
+    // последний run с firstChar <= i
+    uint lo = 0u;
+    uint hi = pc.runCount;
+    while (lo < hi)
+    {
+        const uint mid = (lo + hi) >> 1u;
+        if (runs[mid].firstChar <= i)
+            lo = mid + 1u;
+        else
+            hi = mid;
+    }
+    if (lo == 0u)
+        return pc.runCount;
+    const uint r = lo - 1u;
+    return i < runs[r].firstChar + runs[r].charCount ? r : pc.runCount;
+}
+
+// Символ: pen сдвигается на advance (вместе с кернингом), инстанс стоит на pen + kern
+struct CharInfo
+{
+    uint gi;
+    float kern;
+    float advance;
+    bool lineStart; // первый символ run'а или строки
+    bool runStart;
+    uint newline;   // 1, если предыдущий символ run'а — '\n'
+};
+
+CharInfo classify(uint i, uint r)
+{
+    CharInfo c;
+    c.gi = CODE_SKIP;
+    c.kern = 0.0;
+    c.advance = 0.0;
+    c.lineStart = true;
+    c.runStart = true;
+    c.newline = 0u;
+
+    if (r >= pc.runCount)
+        return c;
+
+    const TextRun run = runs[r];
+    c.runStart = i == run.firstChar;
+
+    uint prevCode = CODE_SKIP;
+    if (!c.runStart)
+    {
+        prevCode = glyphIndex(cps[i - 1u]);
+        c.newline = prevCode == CODE_NEWLINE ? 1u : 0u;
+    }
+    c.lineStart = c.runStart || c.newline != 0u;
+
+    c.gi = glyphIndex(cps[i]);
+
+    // левый глиф пары: как prev в TextLayout (пробел кернится как глиф пробела, таб и '\r' — нет)
+    uint prev = INVALID_GLYPH;
+    if (run.kerning != 0u && !c.lineStart)
+    {
+        if (prevCode == CODE_SPACE)
+            prev = font[H_SPACE_GLYPH];
+        else if (prevCode < MAX_GLYPHS)
+            prev = prevCode;
+    }
+
+    const float spaceAdvance = uintBitsToFloat(font[H_SPACE_ADVANCE]);
+    if (c.gi == CODE_SPACE)
+    {
+        if (prev != INVALID_GLYPH)
+            c.kern = kerning(prev, font[H_SPACE_GLYPH]);
+        c.advance = spaceAdvance;
+    }
+    else if (c.gi == CODE_TAB)
+    {
+        c.advance = float(TAB_SPACES) * spaceAdvance;
+    }
+    else if (c.gi < MAX_GLYPHS)
+    {
+        if (prev != INVALID_GLYPH)
+            c.kern = kerning(prev, c.gi);
+        c.advance = uintBitsToFloat(font[font[H_ADVANCE] + c.gi]);
+    }
+    return c;
+}
+
+// --- сегментный scan в shared памяти (Hillis–Steele) ---
+// (a, fa) ⊕ (b, fb) = (fb ? b : a + b, fa | fb): сумма с начала последнего сегмента
+shared float s_pen[WG];
+shared uint s_penF[WG];
+shared uint s_line[WG];
+shared uint s_lineF[WG];
+
+void scanShared(uint tid)
+{
+    for (uint off = 1u; off < WG; off <<= 1u)
+    {
+        float pv = s_pen[tid];
+        uint pf = s_penF[tid];
+        uint lv = s_line[tid];
+        uint lf = s_lineF[tid];
+        if (tid >= off)
+        {
+            if (pf == 0u) pv += s_pen[tid - off];
+            if (lf == 0u) lv += s_line[tid - off];
+            pf |= s_penF[tid - off];
+            lf |= s_lineF[tid - off];
+        }
+        barrier();
+        s_pen[tid] = pv;
+        s_penF[tid] = pf;
+        s_line[tid] = lv;
+        s_lineF[tid] = lf;
+        barrier();
+    }
+}
+
+void passScanLocal()
+{
+    const uint tid = gl_LocalInvocationID.x;
+    const uint i = gl_GlobalInvocationID.x;
+
+    // хвост последней workgroup — нейтральный элемент
+    s_pen[tid] = 0.0;
+    s_penF[tid] = 0u;
+    s_line[tid] = 0u;
+    s_lineF[tid] = 0u;
+
+    if (i < pc.charCount)
+    {
+        const CharInfo c = classify(i, findRun(i));
+        s_pen[tid] = c.kern + c.advance;
+        s_penF[tid] = c.lineStart ? 1u : 0u;
+        s_line[tid] = c.newline;
+        s_lineF[tid] = c.runStart ? 1u : 0u;
+    }
+    barrier();
+
+    scanShared(tid);
+
+    if (i < pc.charCount)
+        scratch[i] = uvec4(floatBitsToUint(s_pen[tid]), s_line[tid], s_penF[tid] | (s_lineF[tid] << 1u), 0u);
+
+    if (tid == WG - 1u)
+        blockSums[gl_WorkGroupID.x] = uvec4(floatBitsToUint(s_pen[tid]), s_penF[tid], s_line[tid], s_lineF[tid]);
+}
+
+void passScanBlocks()
+{
+    const uint tid = gl_LocalInvocationID.x;
+
+    // префикс всех предыдущих кусков
+    float carryPen = 0.0;
+    uint carryPenF = 0u;
+    uint carryLine = 0u;
+    uint carryLineF = 0u;
+
+    for (uint base = 0u; base < pc.blockCount; base += WG)
+    {
+        const uint b = base + tid;
+        uvec4 v = b < pc.blockCount ? blockSums[b] : uvec4(0u);
+        s_pen[tid] = uintBitsToFloat(v.x);
+        s_penF[tid] = v.y;
+        s_line[tid] = v.z;
+        s_lineF[tid] = v.w;
+        barrier();
+
+        scanShared(tid);
+
+        // exclusive: carry ⊕ inclusive[tid - 1]
+        float pen = carryPen;
+        uint line = carryLine;
+        if (tid > 0u)
+        {
+            pen = s_penF[tid - 1u] != 0u ? s_pen[tid - 1u] : carryPen + s_pen[tid - 1u];
+            line = s_lineF[tid - 1u] != 0u ? s_line[tid - 1u] : carryLine + s_line[tid - 1u];
+        }
+        if (b < pc.blockCount)
+            blockSums[b] = uvec4(floatBitsToUint(pen), 0u, line, 0u);
+
+        carryPen = s_penF[WG - 1u] != 0u ? s_pen[WG - 1u] : carryPen + s_pen[WG - 1u];
+        carryLine = s_lineF[WG - 1u] != 0u ? s_line[WG - 1u] : carryLine + s_line[WG - 1u];
+        barrier();
+    }
+}
+
+void passEmit()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    if (i >= pc.charCount)
+        return;
+
+    const uint r = findRun(i);
+    const CharInfo c = classify(i, r);
+
+    GlyphInstance g;
+    g.posMin = vec2(0.0);
+    g.posMax = vec2(0.0);
+    g.uvMin = vec2(0.0);
+    g.uvMax = vec2(0.0);
+    g.glyph = 0u;
+    g.atlas = 0u;
+
+    if (r < pc.runCount && c.gi < MAX_GLYPHS)
+    {
+        const uint quadBase = font[H_QUAD] + c.gi * 8u;
+        const float planeLeft = uintBitsToFloat(font[quadBase + 0u]);
+        const float planeBottom = uintBitsToFloat(font[quadBase + 1u]);
+        const float planeRight = uintBitsToFloat(font[quadBase + 2u]);
+        const float planeTop = uintBitsToFloat(font[quadBase + 3u]);
+
+        if (planeRight > planeLeft)
+        {
+            const uvec4 local = scratch[i];
+            const uvec4 prefix = blockSums[gl_WorkGroupID.x];
+
+            const float penIncl = (local.z & 1u) != 0u ? uintBitsToFloat(local.x)
+                                                       : uintBitsToFloat(prefix.x) + uintBitsToFloat(local.x);
+            const uint line = (local.z & 2u) != 0u ? local.y : prefix.z + local.y;
+
+            // pen до этого символа + его кернинг
+            const float pen = penIncl - c.advance;
+
+            const TextRun run = runs[r];
+            const float baseline = run.originY - float(line) * run.lineStep;
+
+            g.posMin = vec2(run.originX + (pen + planeLeft) * run.scaleX, baseline + planeBottom * run.scaleY);
+            g.posMax = vec2(run.originX + (pen + planeRight) * run.scaleX, baseline + planeTop * run.scaleY);
+            g.uvMin = vec2(uintBitsToFloat(font[quadBase + 4u]), uintBitsToFloat(font[quadBase + 5u]));
+            g.uvMax = vec2(uintBitsToFloat(font[quadBase + 6u]), uintBitsToFloat(font[quadBase + 7u]));
+            g.glyph = c.gi;
+            g.atlas = run.atlas;
+        }
+    }
+
+    inst[i] = g;
+}
+
+void passGroups()
+{
+    const uint gid = gl_GlobalInvocationID.x;
+    if (gid >= pc.groupCount)
+        return;
+
+    // последний run с firstGroup <= gid (пустые run'ы групп не имеют и пропускаются сами)
+    uint lo = 0u;
+    uint hi = pc.runCount;
+    while (lo < hi)
+    {
+        const uint mid = (lo + hi) >> 1u;
+        if (runs[mid].firstGroup <= gid)
+            lo = mid + 1u;
+        else
+            hi = mid;
+    }
+    const uint r = lo - 1u;
+    const TextRun run = runs[r];
+
+    const uint local = (gid - run.firstGroup) * pc.glyphsPerGroup;
+
+    TextCullGroup grp;
+    grp.firstInstance = run.firstChar + local;
+    grp.count = min(pc.glyphsPerGroup, run.charCount - local);
+    grp.block = r;
+    grp.pad = 0u;
+
+    // bbox только по видимым quad'ам; группа из одних пробелов — пустой bbox (min > max)
+    vec2 mn = vec2(1e30);
+    vec2 mx = vec2(-1e30);
+    for (uint k = 0u; k < grp.count; ++k)
+    {
+        const GlyphInstance q = inst[grp.firstInstance + k];
+        if (q.posMin == q.posMax)
+            continue;
+        mn = min(mn, min(q.posMin, q.posMax));
+        mx = max(mx, max(q.posMin, q.posMax));
+    }
+    grp.boundsMin = mn;
+    grp.boundsMax = mx;
+
+    groups[gid] = grp;
+}
+
+void main()
+{
+    if (PASS == 0u)
+        passScanLocal();
+    else if (PASS == 1u)
+        passScanBlocks();
+    else if (PASS == 2u)
+        passEmit();
+    else
+        passGroups();
+}
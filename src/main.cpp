@@ -1,19 +1,94 @@
 #include "platform/Window.h"
 #include "vk/VulkanContext.h"
+#include "vk/GpuAllocator.h"
 #include "vk/Swapchain.h"
+#include "vk/PipelineCache.h"
 #include "vk/MeshTestPipeline.h"
+#include "vk/MsdfTextPipeline.h"
+#include "vk/MsdfTextCullPipeline.h"
 #include "vk/MeshTestRenderer.h"
+#include "vk/MsdfFont.h"
+#include "vk/FontPack.h"
+#include "vk/TextLayout.h"
+#include "vk/GlyphInstanceBuffer.h"
+#include "vk/GpuTextLayout.h"
+#include "vk/UploadManager.h"
+#include "vk/TrueTypeFont.h"
+#include "vk/LoopBlinnMesh.h"
+#include "vk/DynamicGlyphAtlas.h"
 
 #include <thread>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
-int main()
+// сменяются раз в 2 секунды; глифов нет в статическом атласе
+static const char* const kChatLines[] = {
+    "Привет! Глифы кириллицы растеризуются при первом появлении.",
+    "Γειά σου κόσμε: ελληνικά γράμματα από το ttf.",
+    "Œuvre naïve à Ærøskøbing, Łódź, Štěpán, Ğüşöç.",
+    "∀x ∈ ℝ: x² ≥ 0, ∑ ≠ ∏, ∞ ≈ ∫ ← → ↑ ↓",
+};
+
+// Слоты таблицы атласов MeshTestRenderer (GlyphInstance::atlas)
+static constexpr uint32_t kAtlasSlotStatic = 0;  // assets/font.*
+static constexpr uint32_t kAtlasSlotDynamic = 1; // --dynamic-atlas
+static constexpr uint32_t kAtlasSlotPacks = 2;   // --font-pack: texture array, слой на шрифт
+
+// app [--record-threads=N] [--instance-memory=auto|host|rebar|staged] [--ttf=path] [--dynamic-atlas]
+//     [--font-pack=path ...] [--font-json]
+//   N — потоков записи вторичных буферов (1 — только главный);
+//   instance-memory — где живут инстансы глифов (см. InstanceMemory), для сравнения времени кадра;
+//   ttf — контуры для Loop–Blinn glyphlet'ов (тот же шрифт, из которого собран MSDF атлас),
+//   без него — ")" из статьи;
+//   dynamic-atlas — MSDF текст (layout на CPU) из динамического атласа по ttf: любые его
+//   символы, растеризуются по мере появления (нужен --ttf);
+//   font-pack — ещё шрифты (msdf_gen), по строке на каждый; атласы одного размера — слои
+//   одного texture array. Текст всех шрифтов рисуется одним draw;
+//   font-json — основной шрифт из assets/font.{json,rgba} вместо собранного font pack'а
+int main(int argc, char** argv)
 {
+    uint32_t recordThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+    InstanceMemory instanceMemory = InstanceMemory::Auto;
+    std::string ttfPath;
+    bool dynamicAtlas = false;
+    std::vector<std::string> packPaths;
+    bool fontJson = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg.rfind("--record-threads=", 0) == 0)
+            recordThreads = (uint32_t)std::max(1, std::atoi(arg.c_str() + 17));
+        else if (arg.rfind("--instance-memory=", 0) == 0)
+        {
+            const std::string mode = arg.substr(18);
+            for (InstanceMemory m : { InstanceMemory::Auto, InstanceMemory::HostVisible, InstanceMemory::DeviceMapped, InstanceMemory::Staged })
+                if (mode == instance_memory_name(m))
+                    instanceMemory = m;
+        }
+        else if (arg.rfind("--ttf=", 0) == 0)
+            ttfPath = arg.substr(6);
+        else if (arg == "--dynamic-atlas")
+            dynamicAtlas = true;
+        else if (arg.rfind("--font-pack=", 0) == 0)
+            packPaths.push_back(arg.substr(12));
+        else if (arg == "--font-json")
+            fontJson = true;
+    }
+
     Window window(1280, 720, "MSDF Text (Mesh Shader Triangle)");
 
     VulkanContext vk(window.handle());
 
+    // вся память ресурсов — из общих блоков; разрушается последним, после всех владельцев
+    GpuAllocator allocator(vk.physicalDevice(), vk.device());
+
     int fbW = 0, fbH = 0;
     window.getFramebufferSize(fbW, fbH);
     while (fbW == 0 || fbH == 0)
@@ -32,46 +107,332 @@ int main()
         fbW, fbH
     );
 
-    MeshTestPipeline pipeline(vk.device(), swapchain.format());
+    // загрузки (атлас) идут на transfer очереди параллельно с кадрами
+    UploadManager uploads(allocator, vk.transferFamily(), vk.transferQueue(), vk.graphicsFamily());
 
-    auto renderer = std::make_unique<MeshTestRenderer>(
-        vk.physicalDevice(),
-        vk.device(),
+    PipelineCache pipelineCache(vk.physicalDevice(), vk.device(), APP_PIPELINE_CACHE_PATH);
+    MeshTestPipeline pipeline(vk.device(), pipelineCache, swapchain.format());
+    MsdfTextPipeline textPipeline(vk.device(), pipelineCache, swapchain.format(), vk.meshShaderProperties());
+    MsdfTextCullPipeline textCullPipeline(vk.device(), pipelineCache);
+
+    // основной шрифт: font pack, собранный msdf_pack'ом при сборке (mmap, атлас — прямо из
+    // файла); json + rgba от msdf-atlas-gen — только по --font-json
+    MsdfFont font;
+    std::vector<uint8_t> jsonAtlasBytes;
+    const uint8_t* atlasPixels = nullptr;
+    size_t atlasSize = 0;
+    if (!fontJson)
+    {
+        if (!font.loadFromPack(APP_FONT_PACK_PATH))
+            return EXIT_FAILURE;
+        atlasPixels = font.atlasPixels();
+        atlasSize = font.atlasByteSize();
+    }
+    else
+    {
+        if (!font.loadFromJson(std::string(APP_ASSETS_DIR) + "/font.json"))
+            return EXIT_FAILURE;
+        size_t pixelOffset = 0;
+        if (!readMsdfAtlasRgba(std::string(APP_ASSETS_DIR) + "/font.rgba", (uint32_t)font.atlasW(), (uint32_t)font.atlasH(),
+                               jsonAtlasBytes, pixelOffset))
+            return EXIT_FAILURE;
+        atlasPixels = jsonAtlasBytes.data() + pixelOffset;
+        atlasSize = jsonAtlasBytes.size() - pixelOffset;
+    }
+
+    TextLayout layout(font, glyph_atlas_ref(kAtlasSlotStatic, 0));
+    GlyphInstanceBuffer instances(allocator, layout, MeshTestRenderer::kFramesInFlight, 4096, instanceMemory);
+
+    // glyphlet'ы: все глифы MSDF шрифта из контуров ttf; без ttf — только ")"
+    LoopBlinnMesh glyphlets;
+    TrueTypeFont ttf;
+    const bool ttfLoaded = !ttfPath.empty() && ttf.load(ttfPath);
+    if (ttfLoaded)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        glyphlets = LoopBlinnMesh::build(ttf, font);
+        const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        uint32_t triangles = 0;
+        for (const LoopBlinnGlyph& g : glyphlets.glyphs())
+            triangles += g.triangleCount;
+        std::cout << "Glyphlets: " << glyphlets.glyphs().size() << " glyphs, " << triangles << " triangles in "
+                  << glyphlets.meshlets().size() << " meshlets, " << glyphlets.vertices().size() << " vertices (vs "
+                  << triangles * 3 << " unshared), " << glyphlets.subdividedCurves() << " curves subdivided, "
+                  << buildMs << " ms\n";
+    }
+    const bool ttfGlyphlets = !glyphlets.empty();
+    if (!ttfGlyphlets)
+        glyphlets = LoopBlinnMesh::parenthesis(font);
+
+    // строка glyphlet'ов: каждый глиф рисуется своими meshlet'ами в quad из TextLayout
+    TextLayoutParams params{};
+    params.originX = -0.55f;
+    params.originY = 0.45f;
+    params.scaleX = ttfGlyphlets ? 0.2f : 0.5f;
+    params.scaleY = ttfGlyphlets ? -0.2f : -0.5f; // NDC Vulkan: y вниз
+    instances.createBlock(ttfGlyphlets ? "Loop-Blinn glyphlets" : "))))))))", params);
+
+    // динамический атлас: свой шрифт, наполняется глифами ttf по мере надобности.
+    // Глифы строки запрашиваются до её layout'а
+    MsdfFont dynFont;
+    std::unique_ptr<DynamicGlyphAtlas> dynAtlas;
+    std::optional<TextLayout> dynLayout;
+    if (dynamicAtlas && !ttfLoaded)
+        std::cerr << "--dynamic-atlas needs --ttf, using the static atlas\n";
+    if (dynamicAtlas && ttfLoaded)
+    {
+        DynamicGlyphAtlasParams dynParams{};
+        dynParams.rasterThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+        dynAtlas = std::make_unique<DynamicGlyphAtlas>(allocator, ttf, dynFont, MeshTestRenderer::kFramesInFlight, dynParams);
+        dynLayout.emplace(dynFont, glyph_atlas_ref(kAtlasSlotDynamic, 0));
+    }
+    auto requestGlyphs = [&](std::string_view utf8)
+    {
+        if (dynAtlas)
+            dynAtlas->request(utf8);
+    };
+
+    // MSDF текст: quad'ы из атласов; шрифт — у блока, буфер и draw на всех один
+    GlyphInstanceBuffer text(allocator, dynLayout ? *dynLayout : layout, MeshTestRenderer::kFramesInFlight, 4096, instanceMemory);
+
+    TextLayoutParams textParams{};
+    textParams.originX = -0.9f;
+    textParams.originY = -0.3f;
+    textParams.scaleX = 0.12f;
+    textParams.scaleY = -0.16f;
+    textParams.maxWidth = 1.8f;
+    const std::string headerText = "MSDF text: packed mesh shader quads, 32 glyphs per workgroup.";
+    requestGlyphs(headerText);
+    const TextBlockHandle header = text.createBlock(headerText, textParams);
+
+    // прокручиваемый список в панели: task shader отбрасывает строки вне clip rect,
+    // граничные глифы обрезает clip distance
+    std::string listText;
+    for (int i = 0; i < 64; ++i)
+        listText += "Line " + std::to_string(i) + ": scrolling list clipped by its panel\n";
+
+    const TextClipRect panel{ -0.9f, 0.05f, 0.4f, 0.55f };
+
+    TextLayoutParams listParams{};
+    listParams.originX = panel.minX;
+    listParams.originY = panel.minY + 0.06f;
+    listParams.scaleX = 0.05f;
+    listParams.scaleY = -0.07f;
+    const TextBlockHandle list = text.createBlock(layout, listText, listParams); // всегда статический шрифт
+    text.setBlockClip(list, panel);
+
+    // за пределами экрана: целиком отсекается по viewRect
+    TextLayoutParams offscreenParams = textParams;
+    offscreenParams.originY = 1.5f;
+    const std::string offscreenText = "Off-screen block: never reaches the mesh shader.";
+    requestGlyphs(offscreenText);
+    const TextBlockHandle offscreen = text.createBlock(offscreenText, offscreenParams);
+
+    // чат: символы, которых заранее нет ни в одном атласе (только с динамическим)
+    TextLayoutParams chatParams = textParams;
+    chatParams.originY = -0.75f;
+    chatParams.scaleX = 0.07f;
+    chatParams.scaleY = -0.1f;
+    TextBlockHandle chat = kInvalidTextBlock;
+    uint32_t chatLine = 0;
+    uint32_t dynVersion = 0;
+    if (dynAtlas)
+    {
+        requestGlyphs(kChatLines[chatLine]);
+        chat = text.createBlock(kChatLines[chatLine], chatParams);
+        dynVersion = dynAtlas->version();
+    }
+
+    // шрифты из font pack'ов: атласы одного размера и pxRange — слои одного texture array
+    std::vector<std::unique_ptr<MsdfFont>> packFonts;
+    std::vector<std::unique_ptr<TextLayout>> packLayouts;
+    std::vector<const uint8_t*> packLayers;
+    for (const std::string& path : packPaths)
+    {
+        auto f = std::make_unique<MsdfFont>();
+        if (!f->loadFromPack(path))
+            continue;
+
+        const MsdfFont* first = packFonts.empty() ? f.get() : packFonts.front().get();
+        if (f->atlasW() != first->atlasW() || f->atlasH() != first->atlasH() || f->pxRange() != first->pxRange())
+        {
+            std::cerr << path << ": atlas " << f->atlasW() << "x" << f->atlasH() << " pxRange " << f->pxRange()
+                      << " differs from the first font pack, skipped\n";
+            continue;
+        }
+
+        const uint32_t layer = (uint32_t)packFonts.size();
+        packLayers.push_back(f->atlasPixels());
+        packLayouts.push_back(std::make_unique<TextLayout>(*f, glyph_atlas_ref(kAtlasSlotPacks, layer)));
+        packFonts.push_back(std::move(f));
+
+        TextLayoutParams packParams{};
+        packParams.originX = -0.9f;
+        packParams.originY = -0.62f + 0.07f * (float)layer;
+        packParams.scaleX = 0.04f;
+        packParams.scaleY = -0.055f;
+        const std::string name = path.substr(path.find_last_of("/\\") + 1);
+        text.createBlock(*packLayouts.back(), name + ": The quick brown fox jumps over the lazy dog 0123456789", packParams);
+    }
+
+    MeshTestRenderer renderer(
+        allocator,
         vk.graphicsQueue(),
         vk.presentQueue(),
         vk.graphicsFamily(),
         swapchain,
         pipeline,
-        vk.vkCmdDrawMeshTasksEXT
+        instances,
+        textPipeline,
+        textCullPipeline,
+        text,
+        uploads,
+        vk.vkCmdDrawMeshTasksEXT,
+        vk.vkCmdDrawMeshTasksIndirectCountEXT,
+        recordThreads
     );
 
+    renderer.setGlyphlets(glyphlets);
+
+    renderer.setFontAtlas(kAtlasSlotStatic, &atlasPixels, 1, atlasSize,
+                          (uint32_t)font.atlasW(), (uint32_t)font.atlasH(), font.pxRange());
+    if (dynAtlas)
+        renderer.setDynamicAtlas(kAtlasSlotDynamic, dynAtlas.get());
+    if (!packFonts.empty())
+    {
+        const MsdfFont& first = *packFonts.front();
+        renderer.setFontAtlas(kAtlasSlotPacks, packLayers.data(), (uint32_t)packLayers.size(), first.atlasByteSize(),
+                              (uint32_t)first.atlasW(), (uint32_t)first.atlasH(), first.pxRange());
+        std::cout << "Font packs: " << packFonts.size() << " font(s) as layers of one "
+                  << first.atlasW() << "x" << first.atlasH() << " texture array\n";
+    }
+
+    // большой лог: layout на GPU, CPU отдаёт только code points
+    GpuTextLayout gpuText(allocator, pipelineCache, font, textPipeline.glyphsPerGroup(),
+                          glyph_atlas_ref(kAtlasSlotStatic, 0));
+
+    std::vector<uint32_t> logCodepoints;
+    for (int i = 0; i < 4096; ++i)
+        GpuTextLayout::appendUtf8("[" + std::to_string(i) + "] gpu layout: advances and lines from a prefix sum\n", logCodepoints);
+
+    const TextClipRect logPanel{ 0.45f, 0.05f, 0.95f, 0.95f };
+
+    GpuTextRun logRun{};
+    logRun.charCount = (uint32_t)logCodepoints.size();
+    logRun.params.originX = logPanel.minX;
+    logRun.params.originY = logPanel.minY + 0.04f;
+    logRun.params.scaleX = 0.035f;
+    logRun.params.scaleY = -0.05f;
+    logRun.clip = logPanel;
+    gpuText.setDocument(logCodepoints.data(), (uint32_t)logCodepoints.size(), { logRun });
+    renderer.setGpuText(&gpuText);
+
+    const GpuAllocatorStats mem = allocator.stats();
+    std::cout << "GPU memory: " << mem.blockCount << " block(s) " << (mem.blockBytes >> 20) << " MiB, "
+              << mem.allocationCount << " sub-allocations (" << (mem.usedBytes >> 10) << " KiB used, "
+              << (mem.nodeBytes >> 10) << " KiB reserved), " << mem.dedicatedCount << " dedicated "
+              << (mem.dedicatedBytes >> 10) << " KiB, fragmentation " << mem.fragmentation() * 100.0 << "%\n";
+
+    const TextLayoutResult& listLayout = text.blockLayout(list);
+    const float scrollRange = std::max(0.0f, (listLayout.boundsMax[1] - listLayout.boundsMin[1]) - (panel.maxY - panel.minY));
+
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t lastVisible = ~0u;
+    uint32_t lastCulled = ~0u;
+    auto lastCullPrint = start - std::chrono::seconds(1);
+    uint32_t lastRecordSample = 0;
+
+    // бенчмарк памяти инстансов: среднее время кадра раз в 5 секунд
+    std::cout << "Instance memory: " << instance_memory_name(instances.memory()) << "\n";
+    auto frameWindowStart = start;
+    uint32_t frameWindowCount = 0;
+
     while (!window.shouldClose())
     {
         window.pollEvents();
 
+        const float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+        // динамический атлас: сначала глифы всего текста кадра (их страницы не вытесняются),
+        // потом layout. Изменились quad'ы глифов — блоки перекладываются
+        if (dynAtlas)
+        {
+            const uint32_t line = (uint32_t)(t / 2.0f) % (uint32_t)std::size(kChatLines);
+            dynAtlas->beginFrame();
+            requestGlyphs(headerText);
+            requestGlyphs(offscreenText);
+            requestGlyphs(kChatLines[line]);
+
+            if (line != chatLine || dynAtlas->version() != dynVersion)
+            {
+                chatLine = line;
+                dynVersion = dynAtlas->version();
+                text.updateBlock(header, headerText, textParams);
+                text.updateBlock(offscreen, offscreenText, offscreenParams);
+                text.updateBlock(chat, kChatLines[chatLine], chatParams);
+            }
+        }
+
+        // прокрутка: инстансы списка сдвигаются без повторного layout, clip остаётся на месте
+        text.setBlockTranslation(list, 0.0f, -scrollRange * (0.5f - 0.5f * std::cos(t * 0.25f)));
+
+        // счётчики отсечения меняются почти каждый кадр при прокрутке — не чаще раза в секунду
+        const MsdfTextCullStats& cull = renderer.textCullStats();
+        const auto cullNow = std::chrono::steady_clock::now();
+        if ((cull.visibleGlyphs != lastVisible || cull.culledGlyphs != lastCulled) &&
+            cullNow - lastCullPrint >= std::chrono::seconds(1))
+        {
+            lastCullPrint = cullNow;
+            lastVisible = cull.visibleGlyphs;
+            lastCulled = cull.culledGlyphs;
+            std::cout << "Text culling: " << cull.visibleGlyphs << " visible, "
+                      << cull.culledGlyphs << " culled glyphs ("
+                      << cull.visibleGroups << "/" << cull.visibleGroups + cull.culledGroups
+                      << " groups)\n";
+        }
+
+        // бенчмарк записи: среднее по окну кадров, раз в ~10 окон
+        const MeshTestRenderer::RecordStats& rec = renderer.recordStats();
+        if (rec.samples != lastRecordSample && rec.samples % 10 == 1)
+        {
+            std::cout << "Command recording: " << rec.avgMs * 1000.0 << " us/frame on "
+                      << rec.threads << " thread(s)\n";
+        }
+        lastRecordSample = rec.samples;
+
         window.getFramebufferSize(fbW, fbH);
         if (fbW == 0 || fbH == 0)
             continue;
 
         // drawFrame() возвращает false если swapchain out-of-date/suboptimal
-        if (!renderer->drawFrame())
+        if (!renderer.drawFrame())
         {
-            vkDeviceWaitIdle(vk.device());
+            // пересоздаём только swapchain и per-image объекты; шрифт, инстансы,
+            // командные буферы и дескрипторы переживают resize
+            renderer.waitForFrames();
 
             swapchain.recreate(fbW, fbH);
             pipeline.recreate(swapchain.format());
+            textPipeline.recreate(swapchain.format());
+            renderer.onSwapchainRecreated();
+        }
 
-            // Самый простой способ: пересоздать renderer (т.к. он хранит командные буферы/синхру по количеству images)
-            renderer = std::make_unique<MeshTestRenderer>(
-                vk.physicalDevice(),
-                vk.device(),
-                vk.graphicsQueue(),
-                vk.presentQueue(),
-                vk.graphicsFamily(),
-                swapchain,
-                pipeline,
-                vk.vkCmdDrawMeshTasksEXT
-            );
+        ++frameWindowCount;
+        const auto now = std::chrono::steady_clock::now();
+        const double windowSec = std::chrono::duration<double>(now - frameWindowStart).count();
+        if (windowSec >= 5.0)
+        {
+            std::cout << "Frame time: " << windowSec * 1000.0 / frameWindowCount << " ms avg ("
+                      << instance_memory_name(instances.memory()) << " instances)\n";
+            if (dynAtlas)
+            {
+                const DynamicGlyphAtlas::Stats ds = dynAtlas->stats();
+                std::cout << "Dynamic atlas: " << ds.residentGlyphs << " glyphs in " << ds.usedPages << "/"
+                          << ds.pageCount << " pages, " << ds.rasterized << " rasterized, "
+                          << ds.evictedPages << " pages evicted, " << ds.failed << " without space\n";
+            }
+            frameWindowStart = now;
+            frameWindowCount = 0;
         }
     }
 
@@ -0,0 +1,86 @@
+#include "platform/CpuFeatures.h"
+
+#if APP_ARCH_X86
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+#if APP_ARCH_X86
+static void cpuid(uint32_t leaf, uint32_t sub, uint32_t out[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)sub);
+    for (int i = 0; i < 4; ++i)
+        out[i] = (uint32_t)r[i];
+#else
+    __cpuid_count(leaf, sub, out[0], out[1], out[2], out[3]);
+#endif
+}
+
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static SimdLevel detect_simd_level()
+{
+    uint32_t r[4] = {};
+    cpuid(0, 0, r);
+    const uint32_t maxLeaf = r[0];
+
+    cpuid(1, 0, r);
+    const bool sse2 = (r[3] >> 26) & 1u;
+    const bool osxsave = (r[2] >> 27) & 1u;
+    const bool avx = (r[2] >> 28) & 1u;
+    if (!sse2)
+        return SimdLevel::Scalar;
+
+    // AVX-регистры должны сохраняться ОС (XCR0: XMM | YMM)
+    const bool ymmEnabled = osxsave && avx && (xgetbv0() & 0x6u) == 0x6u;
+    if (ymmEnabled && maxLeaf >= 7)
+    {
+        cpuid(7, 0, r);
+        const bool avx2 = (r[1] >> 5) & 1u;
+        const bool avx512f = (r[1] >> 16) & 1u;
+
+        // ZMM: ещё opmask, ZMM_Hi256 и Hi16_ZMM в XCR0
+        if (avx2 && avx512f && (xgetbv0() & 0xE6u) == 0xE6u)
+            return SimdLevel::AVX512;
+        if (avx2)
+            return SimdLevel::AVX2;
+    }
+    return SimdLevel::SSE2;
+}
+#endif
+
+SimdLevel cpuSimdLevel()
+{
+#if APP_ARCH_X86
+    static const SimdLevel level = detect_simd_level();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE2:   return "sse2";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    }
+    return "?";
+}
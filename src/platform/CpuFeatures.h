@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define APP_ARCH_X86 1
+#else
+#define APP_ARCH_X86 0
+#endif
+
+// Уровни SIMD для runtime dispatch; упорядочены по возрастанию.
+enum class SimdLevel : uint8_t
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512, // AVX-512F
+};
+
+// Лучший уровень, который поддерживают и CPU, и ОС (XSAVE для AVX). Считается один раз.
+SimdLevel cpuSimdLevel();
+
+const char* simdLevelName(SimdLevel level);
@@ -0,0 +1,137 @@
+#include "platform/MappedFile.h"
+
+#include <iostream>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept { *this = std::move(rhs); }
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+    if (this == &rhs) return *this;
+    close();
+    m_data = rhs.m_data; rhs.m_data = nullptr;
+    m_size = rhs.m_size; rhs.m_size = 0;
+#if defined(_WIN32)
+    m_file = rhs.m_file; rhs.m_file = nullptr;
+    m_mapping = rhs.m_mapping; rhs.m_mapping = nullptr;
+#endif
+    return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to open file: " << path << "\n";
+        return false;
+    }
+
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(file, &sz) || sz.QuadPart <= 0)
+    {
+        std::cerr << "Empty file: " << path << "\n";
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        std::cerr << "CreateFileMapping failed: " << path << "\n";
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        std::cerr << "MapViewOfFile failed: " << path << "\n";
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = (size_t)sz.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle((HANDLE)m_mapping);
+    if (m_file) CloseHandle((HANDLE)m_file);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open file: " << path << "\n";
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        std::cerr << "Empty file: " << path << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // после mmap дескриптор больше не нужен
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        std::cerr << "mmap failed: " << path << "\n";
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(p);
+    m_size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
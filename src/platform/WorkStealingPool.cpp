@@ -0,0 +1,132 @@
+#include "platform/WorkStealingPool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_workers.resize(threadCount);
+    for (std::unique_ptr<Worker>& w : m_workers)
+        w = std::make_unique<Worker>();
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+        m_workers[i]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+
+    for (std::unique_ptr<Worker>& w : m_workers)
+    {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(uint32_t count, uint32_t grain, const RangeFn& fn)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max(grain, 1u);
+    const uint32_t workers = threadCount();
+    const uint32_t chunks = (count + grain - 1) / grain;
+
+    // рабочий w получает куски [w * chunks / workers, (w + 1) * chunks / workers):
+    // соседние индексы остаются у одного потока, пока их не украдут
+    for (uint32_t w = 0; w < workers; ++w)
+    {
+        const uint32_t first = (uint32_t)((uint64_t)w * chunks / workers);
+        const uint32_t last = (uint32_t)((uint64_t)(w + 1) * chunks / workers);
+
+        std::lock_guard<std::mutex> lock(m_workers[w]->mutex);
+        for (uint32_t c = first; c < last; ++c)
+            m_workers[w]->chunks.push_back({ c * grain, std::min(count, (c + 1) * grain) });
+    }
+
+    m_stolen.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_pending = workers - 1;
+        ++m_job;
+    }
+    if (workers > 1)
+        m_start.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_fn = nullptr;
+}
+
+void WorkStealingPool::workerLoop(uint32_t worker)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_quit || m_job != seen; });
+            if (m_quit)
+                return;
+            seen = m_job;
+        }
+
+        runChunks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pending;
+        }
+        m_done.notify_one();
+    }
+}
+
+void WorkStealingPool::runChunks(uint32_t worker)
+{
+    const RangeFn& fn = *m_fn;
+
+    Chunk c{};
+    while (popLocal(worker, c) || steal(worker, c))
+        fn(c.begin, c.end, worker);
+}
+
+bool WorkStealingPool::popLocal(uint32_t worker, Chunk& out)
+{
+    Worker& w = *m_workers[worker];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.chunks.empty())
+        return false;
+
+    out = w.chunks.front();
+    w.chunks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(uint32_t thief, Chunk& out)
+{
+    // с конца чужой очереди: владелец идёт с начала, конфликтуют только на последнем куске
+    const uint32_t workers = threadCount();
+    for (uint32_t i = 1; i < workers; ++i)
+    {
+        Worker& victim = *m_workers[(thief + i) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.chunks.empty())
+            continue;
+
+        out = victim.chunks.back();
+        victim.chunks.pop_back();
+        m_stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для parallelFor по независимым задачам очень разной стоимости
+// (глифы атласа: точка и иероглиф отличаются на порядки).
+//
+// Диапазон режется на куски по grain, куски раздаются рабочим подряд равными долями.
+// Рабочий берёт свои куски с начала очереди, а когда они кончились — крадёт с конца
+// очереди соседа. Новых кусков во время задания не появляется, так что рабочий, не
+// нашедший ничего ни у себя, ни у других, своё отработал. Поток 0 — вызывающий.
+class WorkStealingPool
+{
+public:
+    // [begin, end) — кусок индексов, worker — номер рабочего [0, threadCount())
+    using RangeFn = std::function<void(uint32_t begin, uint32_t end, uint32_t worker)>;
+
+    // threadCount включает вызывающий поток; 0 — std::thread::hardware_concurrency()
+    explicit WorkStealingPool(uint32_t threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    uint32_t threadCount() const { return (uint32_t)m_workers.size(); }
+
+    // Блокирует, пока не выполнены все куски. Не реентерабелен (fn не зовёт parallelFor)
+    void parallelFor(uint32_t count, uint32_t grain, const RangeFn& fn);
+
+    // Кусков, украденных у других рабочих за последний parallelFor
+    uint32_t stolenChunks() const { return m_stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Chunk
+    {
+        uint32_t begin, end;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex; // очередь трогают владелец и воры
+        std::deque<Chunk> chunks;
+        std::thread thread; // у рабочего 0 пустой
+    };
+
+    void workerLoop(uint32_t worker);
+    void runChunks(uint32_t worker);
+    bool popLocal(uint32_t worker, Chunk& out);
+    bool steal(uint32_t thief, Chunk& out);
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers; // std::mutex не перемещается
+
+    // текущее задание (пишет вызывающий под m_mutex)
+    const RangeFn* m_fn = nullptr;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_job = 0;     // номер задания; рабочие ждут его смены
+    uint32_t m_pending = 0; // рабочих, ещё не закончивших задание
+    bool m_quit = false;
+
+    std::atomic<uint32_t> m_stolen{ 0 };
+};
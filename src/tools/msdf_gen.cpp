@@ -0,0 +1,377 @@
+#include "vk/MsdfGenerator.h"
+#include "vk/TrueTypeFont.h"
+#include "vk/FontPack.h"
+#include "vk/MsdfAtlas.h"
+#include "vk/Utf8.h"
+#include "vk/MsdfKernel.h"
+#include "platform/CpuFeatures.h"
+#include "platform/WorkStealingPool.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// msdf_gen <font.ttf> <out.msdfpack> [--size=px] [--pxrange=px] [--charset=ascii|latin1|file.txt|file.json]
+//          [--threads=N] [--bench] [--check-simd]
+// msdf_gen --check-simd-synthetic
+// MSDF атлас + font pack без msdf-atlas-gen. charset-файл — UTF-8 текст (берутся все его
+// символы) или json msdf-atlas-gen (glyphs[].unicode, например assets/font.json).
+// --bench: glyphs/sec растеризации для 1, 2, 4, ... потоков на каждом SIMD пути ядра.
+// --check-simd: SIMD пути ядра расстояний против scalar на всех текселях; код возврата 1
+// при расхождении больше kCheckToleranceUlps.
+// --check-simd-synthetic: та же сверка на контурах, построенных в коде (без .ttf) — тест CTest.
+
+// пути исполняют одни и те же операции, расхождение — ошибка, а не погрешность
+static constexpr uint32_t kCheckToleranceUlps = 2;
+
+static bool ends_with(const std::string& s, const char* suffix)
+{
+    const size_t n = std::char_traits<char>::length(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool parse_json_charset(const std::vector<uint8_t>& bytes, std::vector<uint32_t>& out)
+{
+    const nlohmann::json j = nlohmann::json::parse(bytes.begin(), bytes.end(), nullptr, false);
+    if (j.is_discarded() || !j.contains("glyphs") || !j["glyphs"].is_array())
+        return false;
+
+    for (const nlohmann::json& g : j["glyphs"])
+    {
+        if (g.contains("unicode") && g["unicode"].is_number_unsigned())
+            out.push_back(g["unicode"].get<uint32_t>());
+    }
+    return !out.empty();
+}
+
+static bool parse_charset(const std::string& name, std::vector<uint32_t>& out)
+{
+    out.clear();
+    if (name == "ascii" || name == "latin1")
+    {
+        for (uint32_t cp = 0x20; cp <= 0x7E; ++cp)
+            out.push_back(cp);
+        if (name == "latin1")
+            for (uint32_t cp = 0xA0; cp <= 0xFF; ++cp)
+                out.push_back(cp);
+        return true;
+    }
+
+    std::vector<uint8_t> bytes;
+    if (!loadFileBytes(name, bytes))
+        return false;
+
+    if (ends_with(name, ".json"))
+        return parse_json_charset(bytes, out);
+
+    const uint8_t* p = bytes.data();
+    const uint8_t* end = p + bytes.size();
+    while (p < end)
+    {
+        const uint32_t cp = utf8DecodeOne(p, end);
+        if (cp >= 0x20u && cp != kUtf8ReplacementChar)
+            out.push_back(cp);
+    }
+    return !out.empty();
+}
+
+static void run_bench_level(MsdfGenerator& gen, uint32_t maxThreads)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<uint32_t> counts;
+    for (uint32_t n = 1; n < maxThreads; n *= 2)
+        counts.push_back(n);
+    counts.push_back(maxThreads);
+
+    double base = 0.0;
+    for (const uint32_t n : counts)
+    {
+        WorkStealingPool pool(n);
+
+        // прогрев: буферы рабочих и страницы атласа
+        gen.rasterize(pool);
+
+        uint64_t glyphs = 0;
+        uint64_t stolen = 0;
+        int iterations = 0;
+        const auto t0 = clock::now();
+        double sec = 0.0;
+        do
+        {
+            gen.rasterize(pool);
+            glyphs += gen.rasterGlyphCount();
+            stolen += pool.stolenChunks();
+            ++iterations;
+            sec = std::chrono::duration<double>(clock::now() - t0).count();
+        } while (sec < 1.0);
+
+        const double rate = (double)glyphs / sec;
+        if (n == 1)
+            base = rate;
+
+        std::cout << "threads " << n << ": " << rate << " glyphs/s, x" << rate / base << " vs 1 thread, "
+                  << (double)stolen / iterations << " glyphs stolen per atlas (" << iterations << " iterations)\n";
+    }
+}
+
+// Пути ядра от scalar до cpuSimdLevel(); у уровня без своего пути (SSE2) — пропуск
+static void run_bench(MsdfGenerator& gen, uint32_t maxThreads)
+{
+    const SimdLevel prev = msdfKernelSimdLevel();
+    for (uint32_t l = 0; l <= (uint32_t)cpuSimdLevel(); ++l)
+    {
+        if (msdfKernelSetSimdLevel((SimdLevel)l) != (SimdLevel)l)
+            continue;
+        std::cout << "kernel " << simdLevelName((SimdLevel)l) << ":\n";
+        run_bench_level(gen, maxThreads);
+    }
+    msdfKernelSetSimdLevel(prev);
+}
+
+static bool check_simd(const MsdfGenerator& gen)
+{
+    const SimdLevel prev = msdfKernelSimdLevel();
+    bool ok = true;
+    bool any = false;
+    for (uint32_t l = (uint32_t)SimdLevel::SSE2; l <= (uint32_t)cpuSimdLevel(); ++l)
+    {
+        if (msdfKernelSetSimdLevel((SimdLevel)l) != (SimdLevel)l)
+            continue;
+
+        const MsdfGenerator::KernelCheck c = gen.checkKernel((SimdLevel)l, kCheckToleranceUlps);
+
+        any = true;
+        std::cout << "check " << simdLevelName(c.level) << " vs scalar: " << c.values << " values, max "
+                  << c.maxUlps << " ulp, " << c.mismatches << " over " << kCheckToleranceUlps << " ulp\n";
+        ok = ok && c.mismatches == 0;
+    }
+    msdfKernelSetSimdLevel(prev);
+    if (!any)
+        std::cout << "check: no SIMD kernel path on this CPU (" << simdLevelName(cpuSimdLevel()) << ")\n";
+    return ok;
+}
+
+// Замкнутый контур из точек: curve[i] — отрезок i квадратичный с контрольной точкой ctrl[i]
+static TtfContour make_contour(const std::vector<TtfPoint>& pts, const std::vector<TtfPoint>& ctrl, const std::vector<bool>& curve)
+{
+    TtfContour c;
+    for (size_t i = 0; i < pts.size(); ++i)
+    {
+        TtfSegment seg;
+        seg.p0 = pts[i];
+        seg.p1 = pts[(i + 1) % pts.size()];
+        seg.curve = curve[i];
+        seg.c = curve[i] ? ctrl[i] : seg.p0;
+        c.segments.push_back(seg);
+    }
+    return c;
+}
+
+// Окружность из n квадратичных дуг; clockwise — внешний контур TrueType, иначе дырка
+static TtfContour make_circle(float cx, float cy, float r, uint32_t n, bool clockwise)
+{
+    const float pi = 3.14159265f;
+    const float step = (clockwise ? -2.0f : 2.0f) * pi / (float)n;
+    const float rc = r / std::cos(0.5f * step);
+
+    std::vector<TtfPoint> pts, ctrl;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        const float a = step * (float)i;
+        pts.push_back({ cx + r * std::cos(a), cy + r * std::sin(a) });
+        ctrl.push_back({ cx + rc * std::cos(a + 0.5f * step), cy + rc * std::sin(a + 0.5f * step) });
+    }
+    return make_contour(pts, ctrl, std::vector<bool>(n, true));
+}
+
+// Контуры для --check-simd без .ttf (em): окружности, кольцо с дыркой, звезда с острыми
+// углами, почти прямые кривые, крошечные рёбра и случайные многоугольники с фиксированным seed
+static std::vector<TtfOutline> synthetic_outlines()
+{
+    std::vector<TtfOutline> out;
+    const auto add = [&](std::vector<TtfContour> contours)
+    {
+        TtfOutline o;
+        o.contours = std::move(contours);
+        out.push_back(std::move(o));
+    };
+
+    add({ make_circle(0.3f, 0.3f, 0.25f, 8, true) });
+    add({ make_circle(0.4f, 0.35f, 0.35f, 12, true), make_circle(0.4f, 0.35f, 0.18f, 6, false) });
+    add({ make_circle(-3.7f, 12.5f, 0.02f, 4, true) }); // мелкий глиф далеко от начала координат
+
+    // звезда: только отрезки, острые углы
+    {
+        std::vector<TtfPoint> pts;
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            const float a = -0.6283185f * (float)i;
+            const float r = (i & 1u) ? 0.12f : 0.4f;
+            pts.push_back({ 0.4f + r * std::sin(a), 0.4f + r * std::cos(a) });
+        }
+        add({ make_contour(pts, pts, std::vector<bool>(pts.size(), false)) });
+    }
+
+    // почти прямые кривые (становятся отрезками) и рёбра короче текселя
+    {
+        const std::vector<TtfPoint> pts = { { 0.0f, 0.0f }, { 0.0f, 0.7f }, { 0.001f, 0.7005f }, { 0.6f, 0.7f }, { 0.6f, 0.0f } };
+        const std::vector<TtfPoint> ctrl = { { 1e-6f, 0.35f }, { 0.0f, 0.0f }, { 0.3f, 0.70001f }, { 0.0f, 0.0f }, { 0.3f, -0.2f } };
+        add({ make_contour(pts, ctrl, { true, false, true, false, true }) });
+    }
+
+    uint32_t rng = 12345;
+    const auto next = [&]()
+    {
+        rng = rng * 1664525u + 1013904223u;
+        return (float)(rng >> 8) / 16777216.0f;
+    };
+    for (uint32_t g = 0; g < 48; ++g)
+    {
+        const uint32_t n = 3 + (uint32_t)(next() * 14.0f);
+        const float cx = next() * 2.0f - 1.0f;
+        const float cy = next() * 2.0f - 1.0f;
+        const float size = 0.05f + next() * 0.6f;
+
+        std::vector<TtfPoint> pts, ctrl;
+        std::vector<bool> curve;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const float a = -6.2831853f * ((float)i + 0.8f * next()) / (float)n;
+            const float r = size * (0.3f + 0.7f * next());
+            pts.push_back({ cx + r * std::cos(a), cy + r * std::sin(a) });
+            ctrl.push_back({ cx + size * (2.0f * next() - 1.0f), cy + size * (2.0f * next() - 1.0f) });
+            curve.push_back(next() < 0.6f);
+        }
+        add({ make_contour(pts, ctrl, curve) });
+    }
+    return out;
+}
+
+static bool check_simd_synthetic()
+{
+    const std::vector<TtfOutline> outlines = synthetic_outlines();
+    const SimdLevel prev = msdfKernelSimdLevel();
+    bool ok = true;
+    bool any = false;
+
+    // мелкий и крупный размер: разные шаги текселя и длины строк (хвосты SIMD блоков)
+    for (const float emSize : { 13.0f, 48.0f })
+    {
+        MsdfGeneratorParams params{};
+        params.emSize = emSize;
+
+        for (uint32_t l = (uint32_t)SimdLevel::SSE2; l <= (uint32_t)cpuSimdLevel(); ++l)
+        {
+            if (msdfKernelSetSimdLevel((SimdLevel)l) != (SimdLevel)l)
+                continue;
+
+            const MsdfGenerator::KernelCheck c = MsdfGenerator::checkKernel(outlines, params, (SimdLevel)l, kCheckToleranceUlps);
+
+            any = true;
+            std::cout << "check " << simdLevelName(c.level) << " vs scalar, " << outlines.size() << " synthetic outlines at "
+                      << emSize << " px/em: " << c.values << " values, max " << c.maxUlps << " ulp, "
+                      << c.mismatches << " over " << kCheckToleranceUlps << " ulp\n";
+            ok = ok && c.mismatches == 0 && c.values > 0;
+        }
+    }
+    msdfKernelSetSimdLevel(prev);
+    if (!any)
+        std::cout << "check: no SIMD kernel path on this CPU (" << simdLevelName(cpuSimdLevel()) << ")\n";
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 && std::string(argv[1]) == "--check-simd-synthetic")
+        return check_simd_synthetic() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (argc < 3)
+    {
+        std::cerr << "Usage: msdf_gen <font.ttf> <out.msdfpack> [--size=px] [--pxrange=px] "
+                     "[--charset=ascii|latin1|file.txt|file.json] [--threads=N] [--bench] [--check-simd]\n"
+                     "       msdf_gen --check-simd-synthetic\n";
+        return EXIT_FAILURE;
+    }
+
+    MsdfGeneratorParams params{};
+    std::string charset = "ascii";
+    uint32_t threads = 0;
+    bool bench = false;
+    bool checkSimd = false;
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0)
+            params.emSize = std::stof(arg.substr(7));
+        else if (arg.rfind("--pxrange=", 0) == 0)
+            params.pxRange = std::stof(arg.substr(10));
+        else if (arg.rfind("--charset=", 0) == 0)
+            charset = arg.substr(10);
+        else if (arg.rfind("--threads=", 0) == 0)
+            threads = (uint32_t)std::max(std::stoi(arg.substr(10)), 0);
+        else if (arg == "--bench")
+            bench = true;
+        else if (arg == "--check-simd")
+            checkSimd = true;
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (params.emSize <= 0.0f || params.pxRange <= 0.0f)
+    {
+        std::cerr << "--size and --pxrange must be positive\n";
+        return EXIT_FAILURE;
+    }
+
+    TrueTypeFont ttf;
+    if (!ttf.load(argv[1]))
+        return EXIT_FAILURE;
+
+    std::vector<uint32_t> codepoints;
+    if (!parse_charset(charset, codepoints))
+    {
+        std::cerr << "Empty or unreadable charset: " << charset << "\n";
+        return EXIT_FAILURE;
+    }
+
+    MsdfGenerator gen;
+    if (!gen.layout(ttf, codepoints, params))
+        return EXIT_FAILURE;
+
+    WorkStealingPool pool(threads);
+    const auto t0 = std::chrono::steady_clock::now();
+    gen.rasterize(pool);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "MSDF atlas: " << gen.glyphCount() << " glyphs (" << gen.rasterGlyphCount() << " with outlines), "
+              << gen.kerningCount() << " kerning pairs, " << gen.atlasWidth() << "x" << gen.atlasHeight()
+              << ", " << ms << " ms on " << pool.threadCount() << " threads, kernel "
+              << simdLevelName(msdfKernelSimdLevel()) << "\n";
+
+    if (!gen.writePack(argv[2]))
+        return EXIT_FAILURE;
+
+    // sanity: pack должен открываться нашим же загрузчиком
+    FontPack pack;
+    if (!pack.open(argv[2]))
+        return EXIT_FAILURE;
+
+    if (bench)
+        run_bench(gen, std::max(pool.threadCount(), std::thread::hardware_concurrency()));
+
+    if (checkSimd && !check_simd(gen))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+#include "vk/FontPack.h"
+
+#include <iostream>
+#include <cstdlib>
+
+// msdf_pack <font.json> <font.rgba> <out.msdfpack>
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: msdf_pack <font.json> <font.rgba> <out.msdfpack>\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!buildFontPackFromMsdfAtlasGen(argv[1], argv[2], argv[3]))
+        return EXIT_FAILURE;
+
+    // sanity: pack должен открываться нашим же загрузчиком
+    FontPack pack;
+    if (!pack.open(argv[3]))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+#include "vk/MsdfFont.h"
+#include "vk/TextLayout.h"
+#include "vk/MsdfAtlas.h"
+#include "vk/Utf8.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// text_bench <font.msdfpack|font.json> [corpus.txt]
+// Throughput TextLayout в glyphs/sec на большом корпусе.
+
+static std::string make_corpus(size_t bytes)
+{
+    static const char* kWords[] = {
+        "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+        "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore",
+        "magna", "aliqua", "[INFO]", "[WARN]", "Today", "AVG", "11.7", "P.S.",
+        "12:34:56.789", "request_id=0x7f3a", "latency=42ms",
+    };
+    constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+    // немного не-ASCII, как в реальных логах (~1 слово из 32)
+    static const char* kNonAscii[] = { "naïve", "данные", "→", "µs" };
+    constexpr size_t kNonAsciiCount = sizeof(kNonAscii) / sizeof(kNonAscii[0]);
+
+    std::string s;
+    s.reserve(bytes + 64);
+    uint32_t rng = 12345;
+    size_t lineLen = 0;
+    while (s.size() < bytes)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        const char* w = ((rng >> 24) & 31u) == 0 ? kNonAscii[(rng >> 8) % kNonAsciiCount]
+                                                  : kWords[(rng >> 8) % kWordCount];
+        s += w;
+        lineLen += std::char_traits<char>::length(w) + 1;
+        if (lineLen > 100)
+        {
+            s += '\n';
+            lineLen = 0;
+        }
+        else
+        {
+            s += ' ';
+        }
+    }
+    return s;
+}
+
+// Документ раскладывается кусками по целым строкам в один буфер на kDocumentChunk инстансов
+// (глифов не больше, чем байт), а не в буфер по инстансу на байт корпуса
+static constexpr size_t kDocumentChunk = 64 * 1024;
+
+// Конец куска [off, end): до kDocumentChunk байт, по последнему '\n'; строка длиннее
+// куска режется по границе символа UTF-8
+static size_t document_chunk_end(const std::string& corpus, size_t off)
+{
+    if (corpus.size() - off <= kDocumentChunk)
+        return corpus.size();
+
+    size_t end = off + kDocumentChunk;
+    const size_t nl = corpus.rfind('\n', end - 1);
+    if (nl != std::string::npos && nl >= off)
+        return nl + 1;
+
+    while (end > off + 1 && ((uint8_t)corpus[end] & 0xC0u) == 0x80u)
+        --end;
+    return end;
+}
+
+// labelBytes == 0 — документ (куски по строкам), иначе независимые метки по labelBytes байт
+static void run_case(const char* name, const TextLayout& layout, const std::string& corpus,
+                     size_t labelBytes, const TextLayoutParams& params, std::vector<GlyphInstance>& out)
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto pass = [&]()
+    {
+        uint64_t glyphs = 0;
+        for (size_t off = 0; off < corpus.size();)
+        {
+            const size_t end = labelBytes ? std::min(off + labelBytes, corpus.size()) : document_chunk_end(corpus, off);
+            const TextLayoutResult r = layout.layout(std::string_view(corpus).substr(off, end - off), params,
+                                                     out.data(), (uint32_t)out.size());
+            glyphs += r.glyphCount;
+            off = end;
+        }
+        return glyphs;
+    };
+
+    // прогрев
+    pass();
+
+    uint64_t glyphs = 0;
+    uint64_t chars = 0;
+    int iterations = 0;
+    const auto t0 = clock::now();
+    double sec = 0.0;
+
+    do
+    {
+        glyphs += pass();
+        chars += corpus.size();
+        ++iterations;
+        sec = std::chrono::duration<double>(clock::now() - t0).count();
+    } while (sec < 1.0);
+
+    std::cout << name << ": " << (double)glyphs / sec / 1e6 << " M glyphs/s, "
+              << (double)chars / sec / (1024.0 * 1024.0) << " MiB/s ("
+              << iterations << " iterations)\n";
+}
+
+static void run_decode(const TextLayout& layout, const std::string& corpus)
+{
+    using clock = std::chrono::steady_clock;
+
+    // та же таблица, что у TextLayout, здесь не нужна: меряем только декодер
+    std::vector<uint16_t> ascii(128);
+    for (uint32_t c = 0; c < 128; ++c)
+        ascii[c] = layout.font().glyphIndex(c);
+    Utf8AsciiShuffle shuffle;
+    utf8BuildAsciiShuffle(ascii.data(), shuffle);
+    const Utf8GlyphMap map{ ascii.data(), &layout.font(), MsdfFont::kInvalidGlyph, &shuffle };
+
+    std::vector<uint16_t> out(4096);
+    uint64_t codepoints = 0;
+    uint64_t bytes = 0;
+    const auto t0 = clock::now();
+    double sec = 0.0;
+
+    do
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(corpus.data());
+        const uint8_t* end = p + corpus.size();
+        while (p < end)
+            codepoints += utf8ToGlyphs(p, end, map, out.data(), out.size());
+        bytes += corpus.size();
+        sec = std::chrono::duration<double>(clock::now() - t0).count();
+    } while (sec < 1.0);
+
+    std::cout << "utf8 -> glyph index     : " << (double)codepoints / sec / 1e6 << " M cp/s, "
+              << (double)bytes / sec / (1024.0 * 1024.0) << " MiB/s\n";
+}
+
+// kerning(a, b) на каждой паре соседних глифов корпуса, как в layout
+static void run_kerning(const MsdfFont& font, const std::string& corpus)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<uint16_t> glyphs;
+    glyphs.reserve(corpus.size());
+    for (const char c : corpus)
+    {
+        const uint16_t gi = font.glyphIndex((uint8_t)c);
+        if (gi != MsdfFont::kInvalidGlyph)
+            glyphs.push_back(gi);
+    }
+    if (glyphs.size() < 2)
+        return;
+
+    uint64_t pairs = 0;
+    uint64_t hits = 0;
+    float sum = 0.0f;
+    const auto t0 = clock::now();
+    double sec = 0.0;
+
+    do
+    {
+        for (size_t i = 1; i < glyphs.size(); ++i)
+        {
+            const float k = font.kerning(glyphs[i - 1], glyphs[i]);
+            sum += k;
+            hits += k != 0.0f;
+        }
+        pairs += glyphs.size() - 1;
+        sec = std::chrono::duration<double>(clock::now() - t0).count();
+    } while (sec < 1.0);
+
+    std::cout << "kerning(a, b)           : " << (double)pairs / sec / 1e6 << " M pairs/s, "
+              << font.kerningPairCount() << " pairs in font, "
+              << 100.0 * (double)hits / (double)pairs << "% hit (checksum " << sum << ")\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: text_bench <font.msdfpack|font.json> [corpus.txt]\n";
+        return EXIT_FAILURE;
+    }
+
+    MsdfFont font;
+    const std::string fontPath = argv[1];
+    const bool isJson = fontPath.size() >= 5 && fontPath.compare(fontPath.size() - 5, 5, ".json") == 0;
+    if (!(isJson ? font.loadFromJson(fontPath) : font.loadFromPack(fontPath)))
+        return EXIT_FAILURE;
+
+    std::string corpus;
+    if (argc >= 3)
+    {
+        std::vector<uint8_t> bytes;
+        if (!loadFileBytes(argv[2], bytes))
+            return EXIT_FAILURE;
+        corpus.assign(bytes.begin(), bytes.end());
+    }
+    else
+    {
+        corpus = make_corpus(16u << 20);
+    }
+
+    std::cout << "Corpus: " << corpus.size() << " bytes\n";
+
+    TextLayout layout(font);
+    std::vector<GlyphInstance> out(kDocumentChunk);
+
+    size_t asciiBytes = 0;
+    for (const char c : corpus)
+        asciiBytes += (uint8_t)c < 0x80u;
+    std::cout << "ASCII: " << 100.0 * (double)asciiBytes / (double)corpus.size() << "% of bytes\n";
+
+    run_kerning(font, corpus);
+
+    // scalar / SSE2 / AVX2 — всё, что есть на этом CPU
+    const SimdLevel cpu = cpuSimdLevel();
+    for (int l = (int)SimdLevel::Scalar; l <= (int)cpu; ++l)
+    {
+        const SimdLevel level = utf8SetSimdLevel((SimdLevel)l);
+        if (level != (SimdLevel)l)
+            continue; // у декодера нет такого пути
+        std::cout << "\n--- " << simdLevelName(level) << " ---\n";
+
+        run_decode(layout, corpus);
+
+        TextLayoutParams p{};
+        p.scaleX = 16.0f;
+        p.scaleY = -16.0f;
+
+        run_case("document, no wrap       ", layout, corpus, 0, p, out);
+
+        p.kerning = false;
+        run_case("document, no kerning    ", layout, corpus, 0, p, out);
+        p.kerning = true;
+
+        run_case("labels 64B, no wrap     ", layout, corpus, 64, p, out);
+
+        p.maxWidth = 16.0f * 30.0f;
+        run_case("document, wrap 30em     ", layout, corpus, 0, p, out);
+
+        p.align = TextAlign::Center;
+        run_case("document, wrap, centered", layout, corpus, 0, p, out);
+    }
+
+    return EXIT_SUCCESS;
+}
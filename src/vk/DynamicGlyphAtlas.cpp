@@ -0,0 +1,441 @@
+#include "vk/DynamicGlyphAtlas.h"
+#include "vk/MsdfFont.h"
+#include "vk/Utf8.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+DynamicGlyphAtlas::DynamicGlyphAtlas(
+    GpuAllocator& allocator,
+    const TrueTypeFont& ttf,
+    MsdfFont& font,
+    uint32_t frameSlots,
+    const DynamicGlyphAtlasParams& params)
+    : m_allocator(allocator)
+    , m_ttf(ttf)
+    , m_font(font)
+    , m_params(params)
+    , m_pool(std::max(params.rasterThreads, 1u))
+{
+    const uint32_t ps = m_params.pageSize;
+    m_pagesX = ps ? m_params.width / ps : 0;
+    const uint32_t pagesY = ps ? m_params.height / ps : 0;
+    if (m_pagesX == 0 || pagesY == 0)
+    {
+        std::cerr << "Dynamic glyph atlas " << m_params.width << "x" << m_params.height
+                  << " is smaller than one page (" << ps << " px)\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const uint32_t width = m_pagesX * ps;
+    const uint32_t height = pagesY * ps;
+    m_texture.createEmpty(allocator, width, height);
+
+    m_pages.resize((size_t)m_pagesX * pagesY);
+    m_freePages.resize(m_pages.size());
+    // берутся с конца: страница 0 первой
+    std::iota(m_freePages.rbegin(), m_freePages.rend(), 0u);
+
+    m_staging.resize(std::max(frameSlots, 1u));
+
+    // plane bounds в em, как у pack'а MsdfGenerator
+    const TtfMetrics& tm = ttf.metrics();
+    MsdfMetrics metrics{};
+    metrics.emSize = 1.0f;
+    metrics.lineHeight = tm.lineHeight;
+    metrics.ascender = tm.ascender;
+    metrics.descender = tm.descender;
+    m_font.initDynamic(width, height, m_params.msdf.pxRange, metrics);
+
+    ttf.kerningPairs(m_ttfKerning);
+
+    for (uint32_t c = 0x20; c < 0x7F; ++c)
+        addGlyph(c);
+    addGlyph(kUtf8ReplacementChar);
+
+    m_fallbackGlyph = m_font.glyphIndex(kUtf8ReplacementChar);
+    if (m_fallbackGlyph == MsdfFont::kInvalidGlyph)
+        m_fallbackGlyph = m_font.glyphIndex('?');
+
+    rebuildKerning();
+}
+
+DynamicGlyphAtlas::~DynamicGlyphAtlas()
+{
+    for (GpuBuffer& b : m_staging)
+        m_allocator.destroyBuffer(b);
+}
+
+uint16_t DynamicGlyphAtlas::addGlyph(uint32_t codepoint)
+{
+    const uint32_t g = m_ttf.glyphIndex(codepoint);
+    if (g == 0)
+        return MsdfFont::kInvalidGlyph;
+
+    const uint16_t gi = m_font.addGlyph(codepoint, m_ttf.advance(g));
+    if (gi == MsdfFont::kInvalidGlyph)
+        return gi;
+
+    GlyphSlot slot{};
+    slot.ttfGlyph = g;
+    m_slots.push_back(slot);
+
+    m_ttfCodepoints[g].push_back(codepoint);
+    m_kerningDirty = true;
+    return gi;
+}
+
+void DynamicGlyphAtlas::touch(uint16_t gi)
+{
+    if (gi == MsdfFont::kInvalidGlyph)
+        return;
+
+    GlyphSlot& s = m_slots[gi];
+    switch (s.state)
+    {
+    case GlyphState::Resident:
+        m_pages[s.page].lastUsed = m_frame;
+        break;
+    case GlyphState::Absent:
+        s.state = GlyphState::Queued;
+        m_queued.push_back(gi);
+        break;
+    case GlyphState::Queued:
+    case GlyphState::NoOutline:
+        break;
+    }
+}
+
+uint32_t DynamicGlyphAtlas::request(std::string_view utf8)
+{
+    const uint64_t failedBefore = m_failed;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(utf8.data());
+    const uint8_t* const end = p + utf8.size();
+    while (p < end)
+    {
+        const uint32_t cp = utf8DecodeOne(p, end);
+        // переводы строк, табы: служебные коды TextLayout, глифа не нужно
+        if (cp < 0x20u)
+            continue;
+
+        uint16_t gi = m_font.glyphIndex(cp);
+        if (gi == MsdfFont::kInvalidGlyph)
+            gi = addGlyph(cp);
+
+        // нет в ttf — TextLayout нарисует fallback
+        touch(gi != MsdfFont::kInvalidGlyph ? gi : m_fallbackGlyph);
+    }
+
+    if (!m_queued.empty())
+        rasterizeQueued();
+    if (m_kerningDirty)
+        rebuildKerning();
+
+    return (uint32_t)(m_failed - failedBefore);
+}
+
+void DynamicGlyphAtlas::rasterizeQueued()
+{
+    const uint32_t count = (uint32_t)m_queued.size();
+
+    std::vector<uint32_t> ttfGlyphs(count);
+    for (uint32_t i = 0; i < count; ++i)
+        ttfGlyphs[i] = m_slots[m_queued[i]].ttfGlyph;
+
+    std::vector<MsdfGlyphBitmap> bitmaps(count);
+    m_generator.rasterizeGlyphs(m_ttf, ttfGlyphs.data(), count, m_params.msdf, bitmaps.data(), m_pool);
+    m_rasterized += count;
+
+    // высокие первыми: полки страницы плотнее
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return bitmaps[a].height > bitmaps[b].height; });
+
+    const uint32_t ps = m_params.pageSize;
+    const uint32_t atlasH = (uint32_t)m_font.atlasH();
+    for (const uint32_t i : order)
+    {
+        const uint16_t gi = m_queued[i];
+        GlyphSlot& slot = m_slots[gi];
+        const MsdfGlyphBitmap& bm = bitmaps[i];
+
+        if (!bm.hasPlane)
+        {
+            slot.state = GlyphState::NoOutline;
+            continue;
+        }
+
+        uint32_t page = 0, x = 0, y = 0;
+        if (!place(bm.width, bm.height, page, x, y))
+        {
+            // повторится в следующем request(), когда освободится страница
+            slot.state = GlyphState::Absent;
+            ++m_failed;
+            continue;
+        }
+
+        slot.state = GlyphState::Resident;
+        slot.page = page;
+        m_pages[page].glyphs.push_back(gi);
+        m_pages[page].lastUsed = m_frame;
+
+        PendingUpload up{};
+        up.page = page;
+        up.x = (page % m_pagesX) * ps + x;
+        up.y = (page / m_pagesX) * ps + y;
+        up.w = bm.width;
+        up.h = bm.height;
+        up.offset = m_pendingPixels.size();
+        m_pending.push_back(up);
+        m_pendingPixels.insert(m_pendingPixels.end(), bm.rgba.begin(), bm.rgba.end());
+
+        // atlas bounds — центры крайних текселей, y снизу
+        const MsdfBounds plane{ bm.planeLeft, bm.planeBottom, bm.planeRight, bm.planeTop };
+        MsdfBounds atlas{};
+        atlas.left = (float)up.x + 0.5f;
+        atlas.right = (float)(up.x + up.w) - 0.5f;
+        atlas.bottom = (float)(atlasH - (up.y + up.h)) + 0.5f;
+        atlas.top = (float)(atlasH - up.y) - 0.5f;
+        m_font.setGlyphBounds(gi, true, plane, true, atlas);
+        ++m_version;
+    }
+
+    m_queued.clear();
+}
+
+bool DynamicGlyphAtlas::placeInPage(Page& p, uint32_t size, uint32_t w, uint32_t h, uint32_t& x, uint32_t& y)
+{
+    // самая низкая полка, куда влезает
+    Shelf* best = nullptr;
+    for (Shelf& s : p.shelves)
+    {
+        if (h <= s.height && s.x + w <= size && (!best || s.height < best->height))
+            best = &s;
+    }
+
+    if (!best)
+    {
+        // высота полки с запасом до кратной 8: соседние по высоте глифы ложатся в ту же полку
+        const uint32_t height = std::min((h + 7u) & ~7u, size - std::min(p.usedHeight, size));
+        if (height < h)
+            return false;
+        p.shelves.push_back({ p.usedHeight, height, 0 });
+        p.usedHeight += height;
+        best = &p.shelves.back();
+    }
+
+    x = best->x;
+    y = best->y;
+    best->x += w;
+    return true;
+}
+
+bool DynamicGlyphAtlas::place(uint32_t w, uint32_t h, uint32_t& page, uint32_t& x, uint32_t& y)
+{
+    const uint32_t ps = m_params.pageSize;
+    if (w > ps || h > ps)
+        return false;
+
+    if (m_openPage != UINT32_MAX && placeInPage(m_pages[m_openPage], ps, w, h, x, y))
+    {
+        page = m_openPage;
+        return true;
+    }
+
+    // текущая страница кончилась: её остаток пропадает до вытеснения. Зато глифы,
+    // попавшие в атлас вместе, вместе из него и уходят
+    if (m_freePages.empty() && !evictLru())
+        return false;
+
+    m_openPage = m_freePages.back();
+    m_freePages.pop_back();
+    page = m_openPage;
+    return placeInPage(m_pages[m_openPage], ps, w, h, x, y);
+}
+
+bool DynamicGlyphAtlas::evictLru()
+{
+    uint32_t victim = UINT32_MAX;
+    for (uint32_t i = 0; i < (uint32_t)m_pages.size(); ++i)
+    {
+        const Page& p = m_pages[i];
+        if (p.glyphs.empty() || p.lastUsed >= m_frame)
+            continue;
+        if (victim == UINT32_MAX || p.lastUsed < m_pages[victim].lastUsed)
+            victim = i;
+    }
+    if (victim == UINT32_MAX)
+        return false;
+
+    Page& p = m_pages[victim];
+    for (const uint16_t gi : p.glyphs)
+    {
+        m_slots[gi].state = GlyphState::Absent;
+        m_font.setGlyphBounds(gi, false, {}, false, {});
+    }
+    p.glyphs.clear();
+    p.shelves.clear();
+    p.usedHeight = 0;
+
+    // ещё не записанные в кадр копии страницы легли бы поверх её новых глифов
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [victim](const PendingUpload& u) { return u.page == victim; }),
+                    m_pending.end());
+
+    if (m_openPage == victim)
+        m_openPage = UINT32_MAX;
+    m_freePages.push_back(victim);
+
+    ++m_evictedPages;
+    ++m_version;
+    return true;
+}
+
+void DynamicGlyphAtlas::rebuildKerning()
+{
+    // пары kern по glyph index'ам -> пары codepoint'ов, уже добавленных в шрифт
+    std::vector<FontPackKerning> pairs;
+    for (const TtfKerningPair& k : m_ttfKerning)
+    {
+        const auto l = m_ttfCodepoints.find(k.left);
+        const auto r = m_ttfCodepoints.find(k.right);
+        if (l == m_ttfCodepoints.end() || r == m_ttfCodepoints.end())
+            continue;
+        for (const uint32_t a : l->second)
+            for (const uint32_t b : r->second)
+                pairs.push_back({ a, b, k.advance });
+    }
+    m_font.setKerning(std::move(pairs));
+    m_kerningDirty = false;
+}
+
+void DynamicGlyphAtlas::ensureStaging(uint32_t slot, VkDeviceSize bytes)
+{
+    GpuBuffer& b = m_staging[slot];
+    if (b.buffer && b.alloc.size >= bytes)
+        return;
+
+    // срез slot уже не читается GPU (fence кадра пройден) — можно пересоздать
+    m_allocator.destroyBuffer(b);
+    VkDeviceSize size = 256ull << 10;
+    while (size < bytes)
+        size *= 2;
+    b = m_allocator.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, GpuMemoryUsage::Upload, "glyph atlas staging");
+}
+
+bool DynamicGlyphAtlas::recordUpload(VkCommandBuffer cmd, uint32_t slot)
+{
+    m_lastUploadRegions = 0;
+    m_lastUploadBytes = 0;
+    if (m_initialized && m_pending.empty())
+        return false;
+
+    const VkImage image = m_texture.image();
+
+    VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    b.subresourceRange.levelCount = 1;
+    b.subresourceRange.layerCount = 1;
+    b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+    if (!m_initialized)
+    {
+        b.srcAccessMask = 0;
+        b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &b);
+
+        // фон: вне глифов — далеко снаружи, как у атласа MsdfGenerator
+        const VkClearColorValue clear{ { 0.0f, 0.0f, 0.0f, 1.0f } };
+        vkCmdClearColorImage(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &b.subresourceRange);
+
+        // заливка и копии ниже пишут одни и те же тексели
+        b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &b);
+        m_initialized = true;
+    }
+    else
+    {
+        // прошлые кадры на этой же очереди читали image во фрагментном шейдере:
+        // для WAR хватает зависимости исполнения, старое содержимое не нужно
+        b.srcAccessMask = 0;
+        b.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &b);
+    }
+
+    if (!m_pending.empty())
+    {
+        VkDeviceSize total = 0;
+        for (const PendingUpload& u : m_pending)
+            total += (VkDeviceSize)u.w * u.h * 4;
+        ensureStaging(slot, total);
+
+        // регион на глиф; смещения кратны 4 (размер текселя RGBA8)
+        GpuBuffer& staging = m_staging[slot];
+        m_regions.clear();
+        VkDeviceSize offset = 0;
+        for (const PendingUpload& u : m_pending)
+        {
+            const size_t size = (size_t)u.w * u.h * 4;
+            std::memcpy(staging.alloc.mapped + offset, m_pendingPixels.data() + u.offset, size);
+
+            VkBufferImageCopy r{};
+            r.bufferOffset = offset;
+            r.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            r.imageSubresource.layerCount = 1;
+            r.imageOffset = { (int32_t)u.x, (int32_t)u.y, 0 };
+            r.imageExtent = { u.w, u.h, 1 };
+            m_regions.push_back(r);
+            offset += size;
+        }
+        m_allocator.flush(staging.alloc, 0, total);
+
+        vkCmdCopyBufferToImage(cmd, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32_t)m_regions.size(), m_regions.data());
+
+        m_lastUploadRegions = (uint32_t)m_regions.size();
+        m_lastUploadBytes = total;
+        m_pending.clear();
+        m_pendingPixels.clear();
+    }
+
+    b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    b.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &b);
+    return true;
+}
+
+DynamicGlyphAtlas::Stats DynamicGlyphAtlas::stats() const
+{
+    Stats s{};
+    for (const GlyphSlot& g : m_slots)
+    {
+        if (g.state == GlyphState::Resident)
+            ++s.residentGlyphs;
+    }
+    for (const Page& p : m_pages)
+    {
+        if (!p.glyphs.empty())
+            ++s.usedPages;
+    }
+    s.pageCount = (uint32_t)m_pages.size();
+    s.rasterized = m_rasterized;
+    s.evictedPages = m_evictedPages;
+    s.failed = m_failed;
+    s.lastUploadRegions = m_lastUploadRegions;
+    s.lastUploadBytes = m_lastUploadBytes;
+    return s;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+#include "vk/MsdfGenerator.h"
+#include "vk/TrueTypeFont.h"
+#include "vk/Texture2D.h"
+#include "platform/WorkStealingPool.h"
+
+#include <vulkan/vulkan.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+class MsdfFont;
+
+struct DynamicGlyphAtlasParams
+{
+    uint32_t width = 2048;       // px, кратно pageSize
+    uint32_t height = 2048;
+    uint32_t pageSize = 256;     // px, сторона страницы — единица вытеснения
+    uint32_t rasterThreads = 1;  // потоки растеризации новых глифов, включая вызывающий
+    MsdfGeneratorParams msdf{};  // emSize/pxRange глифов
+};
+
+// MSDF атлас, который заполняется по мере надобности: глифа нет в атласе — он
+// растеризуется из ttf (MsdfGenerator::rasterizeGlyphs) и копируется в image куском
+// (vkCmdCopyBufferToImage, регион на глиф) командным буфером кадра. Для чата и
+// пользовательского текста, где набор символов заранее неизвестен.
+//
+// Image поделён на страницы pageSize × pageSize, в каждой свой shelf-упаковщик. Новые
+// глифы идут в текущую страницу; не влезли — в свободную, а если свободных нет —
+// вытесняется страница, к которой дольше всех не обращались (LRU по кадрам), целиком:
+// все её глифы теряют quad в шрифте, упаковщик сбрасывается. Страницы, тронутые в
+// текущем кадре, не вытесняются — то, что кадр рисует, остаётся на месте.
+//
+// Шрифт (MsdfFont::initDynamic) принадлежит вызывающему: атлас добавляет в него глифы
+// и меняет их quad'ы. ASCII и U+FFFD добавляются сразу (без растеризации), чтобы
+// TextLayout, созданный после атласа, видел их в своей ASCII таблице.
+//
+// Контракт кадра: beginFrame(), request() для всего видимого текста, затем layout;
+// если version() изменилась с прошлого layout'а блока — блок перекладывается (его
+// глифы могли получить quad или переехать). Однопоточный, из потока рендера.
+class DynamicGlyphAtlas
+{
+public:
+    DynamicGlyphAtlas(
+        GpuAllocator& allocator,
+        const TrueTypeFont& ttf,
+        MsdfFont& font,
+        uint32_t frameSlots,
+        const DynamicGlyphAtlasParams& params = {});
+
+    ~DynamicGlyphAtlas();
+
+    DynamicGlyphAtlas(const DynamicGlyphAtlas&) = delete;
+    DynamicGlyphAtlas& operator=(const DynamicGlyphAtlas&) = delete;
+
+    // Новый кадр LRU; вызывать до request'ов кадра
+    void beginFrame() { ++m_frame; }
+
+    // Сделать резидентными глифы текста и отметить их страницы текущим кадром.
+    // Возвращает число глифов, которым не нашлось места (все страницы заняты текущим
+    // кадром или глиф больше страницы): они занимают место в строке, но не рисуются
+    uint32_t request(std::string_view utf8);
+
+    // Копии глифов, размещённых с прошлого вызова (staging среза slot -> image), с барьерами
+    // до фрагментного шейдера. Вызывать в командном буфере кадра slot до рисования и после
+    // ожидания его fence, каждый кадр: первый вызов ещё и переводит image из UNDEFINED.
+    // false — копировать нечего
+    bool recordUpload(VkCommandBuffer cmd, uint32_t slot);
+
+    VkImageView view() const { return m_texture.view(); }
+    VkSampler sampler() const { return m_texture.sampler(); }
+    float pxRange() const { return m_params.msdf.pxRange; }
+
+    // Растёт при любом изменении quad'ов шрифта (размещение, вытеснение)
+    uint32_t version() const { return m_version; }
+
+    struct Stats
+    {
+        uint32_t residentGlyphs = 0;
+        uint32_t usedPages = 0;
+        uint32_t pageCount = 0;
+        uint64_t rasterized = 0;     // всего растеризовано глифов (с повторными после вытеснения)
+        uint64_t evictedPages = 0;
+        uint64_t failed = 0;         // не нашлось места
+        uint32_t lastUploadRegions = 0;
+        VkDeviceSize lastUploadBytes = 0;
+    };
+    Stats stats() const;
+
+private:
+    enum class GlyphState : uint8_t
+    {
+        Absent,    // не растеризован или вытеснен
+        Queued,    // ждёт растеризации в текущем request()
+        Resident,
+        NoOutline, // пробел/битый контур: рисовать нечего
+    };
+
+    struct GlyphSlot
+    {
+        uint32_t ttfGlyph = 0;
+        uint32_t page = 0; // Resident
+        GlyphState state = GlyphState::Absent;
+    };
+
+    struct Shelf
+    {
+        uint32_t y = 0, height = 0, x = 0; // внутри страницы, y сверху
+    };
+
+    struct Page
+    {
+        std::vector<Shelf> shelves;
+        std::vector<uint16_t> glyphs; // резидентные глифы шрифта
+        uint32_t usedHeight = 0;
+        uint64_t lastUsed = 0;        // кадр
+    };
+
+    // глиф, ждущий копии в image
+    struct PendingUpload
+    {
+        uint32_t page = 0;
+        uint32_t x = 0, y = 0, w = 0, h = 0; // px в image, y сверху
+        size_t offset = 0;                   // в m_pendingPixels
+    };
+
+    uint16_t addGlyph(uint32_t codepoint);
+    void touch(uint16_t gi);
+    void rasterizeQueued();
+    bool place(uint32_t w, uint32_t h, uint32_t& page, uint32_t& x, uint32_t& y);
+    static bool placeInPage(Page& p, uint32_t size, uint32_t w, uint32_t h, uint32_t& x, uint32_t& y);
+    bool evictLru();
+    void rebuildKerning();
+    void ensureStaging(uint32_t slot, VkDeviceSize bytes);
+
+private:
+    GpuAllocator& m_allocator;
+    const TrueTypeFont& m_ttf;
+    MsdfFont& m_font;
+    DynamicGlyphAtlasParams m_params;
+
+    Texture2D m_texture;
+    bool m_initialized = false; // image переведён из UNDEFINED
+
+    MsdfGenerator m_generator;
+    WorkStealingPool m_pool;
+
+    std::vector<GlyphSlot> m_slots;          // по glyph index шрифта
+    std::vector<uint16_t> m_queued;          // ждут растеризации
+    uint16_t m_fallbackGlyph = 0xFFFFu;      // U+FFFD или '?'
+
+    std::vector<Page> m_pages;
+    std::vector<uint32_t> m_freePages;
+    uint32_t m_openPage = UINT32_MAX;        // сюда идут новые глифы
+    uint32_t m_pagesX = 0;
+
+    std::vector<PendingUpload> m_pending;
+    std::vector<uint8_t> m_pendingPixels;
+
+    std::vector<GpuBuffer> m_staging;        // по срезам кадров
+    std::vector<VkBufferImageCopy> m_regions;
+
+    // кернинг ttf по glyph index'ам и codepoint'ы шрифта на каждый glyph index ttf
+    std::vector<TtfKerningPair> m_ttfKerning;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_ttfCodepoints;
+    bool m_kerningDirty = false;
+
+    uint64_t m_frame = 1;
+    uint32_t m_version = 0;
+
+    uint64_t m_rasterized = 0;
+    uint64_t m_evictedPages = 0;
+    uint64_t m_failed = 0;
+    uint32_t m_lastUploadRegions = 0;
+    VkDeviceSize m_lastUploadBytes = 0;
+};
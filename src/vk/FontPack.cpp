@@ -0,0 +1,306 @@
+#include "vk/FontPack.h"
+#include "vk/MsdfAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+static constexpr size_t kSectionAlign = 16;
+static constexpr size_t kAtlasAlign = 64;
+
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+static bool section_in_file(uint64_t offset, uint64_t bytes, size_t fileSize, size_t align)
+{
+    if (offset % align != 0) return false;
+    if (offset > fileSize) return false;
+    return bytes <= fileSize - offset;
+}
+
+bool FontPack::open(const std::string& path)
+{
+    close();
+
+    if (!m_file.open(path))
+        return false;
+
+    const uint8_t* base = m_file.data();
+    const size_t size = m_file.size();
+
+    if (size < sizeof(FontPackHeader))
+    {
+        std::cerr << "Font pack too small: " << path << "\n";
+        close();
+        return false;
+    }
+
+    const auto* h = reinterpret_cast<const FontPackHeader*>(base);
+    if (h->magic != kFontPackMagic || h->headerSize != sizeof(FontPackHeader))
+    {
+        std::cerr << "Not a font pack: " << path << "\n";
+        close();
+        return false;
+    }
+    if (h->version != kFontPackVersion)
+    {
+        std::cerr << "Font pack version " << h->version << " unsupported (expected "
+                  << kFontPackVersion << "): " << path << "\n";
+        close();
+        return false;
+    }
+
+    const uint64_t atlasBytes = (uint64_t)h->atlasWidth * h->atlasHeight * 4u;
+    const bool ok =
+        h->fileSize == size &&
+        h->atlasWidth > 0 && h->atlasHeight > 0 &&
+        h->atlasSize == atlasBytes &&
+        section_in_file(h->glyphOffset, (uint64_t)h->glyphCount * sizeof(FontPackGlyph), size, kSectionAlign) &&
+        section_in_file(h->kerningOffset, (uint64_t)h->kerningCount * sizeof(FontPackKerning), size, kSectionAlign) &&
+        section_in_file(h->atlasOffset, h->atlasSize, size, kAtlasAlign);
+
+    if (!ok)
+    {
+        std::cerr << "Corrupted font pack: " << path << "\n";
+        close();
+        return false;
+    }
+
+    m_header = h;
+    m_glyphs = reinterpret_cast<const FontPackGlyph*>(base + h->glyphOffset);
+    m_kerning = reinterpret_cast<const FontPackKerning*>(base + h->kerningOffset);
+    m_atlas = base + h->atlasOffset;
+    return true;
+}
+
+void FontPack::close()
+{
+    m_file.close();
+    m_header = nullptr;
+    m_glyphs = nullptr;
+    m_kerning = nullptr;
+    m_atlas = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Запись pack
+// ---------------------------------------------------------------------------
+
+bool writeFontPack(
+    const std::string& outPath,
+    FontPackHeader h,
+    const std::vector<FontPackGlyph>& glyphs,
+    const std::vector<FontPackKerning>& kerning,
+    const uint8_t* atlas)
+{
+    h.magic = kFontPackMagic;
+    h.version = kFontPackVersion;
+    h.headerSize = sizeof(FontPackHeader);
+    h.atlasSize = (uint64_t)h.atlasWidth * h.atlasHeight * 4u;
+
+    size_t cursor = sizeof(FontPackHeader);
+    cursor = align_up(cursor, kSectionAlign);
+    h.glyphOffset = (uint32_t)cursor;
+    h.glyphCount = (uint32_t)glyphs.size();
+    cursor += glyphs.size() * sizeof(FontPackGlyph);
+
+    cursor = align_up(cursor, kSectionAlign);
+    h.kerningOffset = (uint32_t)cursor;
+    h.kerningCount = (uint32_t)kerning.size();
+    cursor += kerning.size() * sizeof(FontPackKerning);
+
+    cursor = align_up(cursor, kAtlasAlign);
+    h.atlasOffset = cursor;
+    cursor += (size_t)h.atlasSize;
+    h.fileSize = cursor;
+
+    std::vector<uint8_t> out(cursor, 0);
+    std::memcpy(out.data(), &h, sizeof(h));
+    if (!glyphs.empty())
+        std::memcpy(out.data() + h.glyphOffset, glyphs.data(), glyphs.size() * sizeof(FontPackGlyph));
+    if (!kerning.empty())
+        std::memcpy(out.data() + h.kerningOffset, kerning.data(), kerning.size() * sizeof(FontPackKerning));
+    std::memcpy(out.data() + h.atlasOffset, atlas, (size_t)h.atlasSize);
+
+    std::ofstream f(outPath, std::ios::binary | std::ios::trunc);
+    if (!f)
+    {
+        std::cerr << "Failed to write font pack: " << outPath << "\n";
+        return false;
+    }
+    f.write(reinterpret_cast<const char*>(out.data()), (std::streamsize)out.size());
+    if (!f)
+    {
+        std::cerr << "Failed to write font pack: " << outPath << "\n";
+        return false;
+    }
+
+    std::cout << "Font pack written: " << outPath
+              << " (glyphs=" << h.glyphCount
+              << ", kerning=" << h.kerningCount
+              << ", atlas=" << h.atlasWidth << "x" << h.atlasHeight
+              << ", " << h.fileSize << " bytes)\n";
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Конвертер msdf-atlas-gen -> font pack
+// ---------------------------------------------------------------------------
+
+static uint32_t read_be32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static uint32_t read_bounds(const nlohmann::json& g, const char* key, float& l, float& b, float& r, float& t)
+{
+    if (!g.contains(key) || g[key].is_null())
+        return 0;
+
+    const auto& o = g[key];
+    l = o.value("left", 0.0f);
+    b = o.value("bottom", 0.0f);
+    r = o.value("right", 0.0f);
+    t = o.value("top", 0.0f);
+    return 1;
+}
+
+bool readMsdfAtlasRgba(
+    const std::string& rgbaPath,
+    uint32_t width,
+    uint32_t height,
+    std::vector<uint8_t>& bytes,
+    size_t& pixelOffset)
+{
+    if (!loadFileBytes(rgbaPath, bytes))
+        return false;
+
+    // msdf-atlas-gen -format rgba: "RGBA" + width(BE32) + height(BE32) + пиксели
+    pixelOffset = 0;
+    if (bytes.size() >= 12 && std::memcmp(bytes.data(), "RGBA", 4) == 0)
+    {
+        const uint32_t w = read_be32(bytes.data() + 4);
+        const uint32_t hgt = read_be32(bytes.data() + 8);
+        if (w != width || hgt != height)
+        {
+            std::cerr << "RGBA size " << w << "x" << hgt << " does not match atlas "
+                      << width << "x" << height << ": " << rgbaPath << "\n";
+            return false;
+        }
+        pixelOffset = 12;
+    }
+
+    const size_t expected = (size_t)width * height * 4u;
+    if (expected == 0 || bytes.size() - pixelOffset != expected)
+    {
+        std::cerr << "RGBA size mismatch: got " << bytes.size() - pixelOffset
+                  << ", expected " << expected << ": " << rgbaPath << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool buildFontPackFromMsdfAtlasGen(
+    const std::string& jsonPath,
+    const std::string& rgbaPath,
+    const std::string& outPath)
+{
+    std::vector<uint8_t> jsonBytes;
+    if (!loadFileBytes(jsonPath, jsonBytes))
+        return false;
+
+    nlohmann::json j;
+    try
+    {
+        j = nlohmann::json::parse(jsonBytes.begin(), jsonBytes.end());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "JSON parse error: " << e.what() << "\n";
+        return false;
+    }
+
+    if (!j.contains("atlas") || !j.contains("glyphs") || !j["glyphs"].is_array())
+    {
+        std::cerr << "JSON has no atlas/glyphs: " << jsonPath << "\n";
+        return false;
+    }
+
+    FontPackHeader h{};
+    h.magic = kFontPackMagic;
+    h.version = kFontPackVersion;
+    h.headerSize = sizeof(FontPackHeader);
+
+    const auto& a = j["atlas"];
+    h.atlasWidth = a.value("width", 0u);
+    h.atlasHeight = a.value("height", 0u);
+    h.pxRange = a.value("distanceRange", 4.0f);
+    if (a.contains("pxRange"))
+        h.pxRange = a.value("pxRange", h.pxRange);
+    if (a.value("yOrigin", std::string("bottom")) == "bottom")
+        h.flags |= FONT_PACK_ATLAS_Y_BOTTOM;
+
+    h.emSize = 48.0f;
+    if (j.contains("metrics"))
+    {
+        const auto& m = j["metrics"];
+        h.emSize = m.value("emSize", h.emSize);
+        h.lineHeight = m.value("lineHeight", 0.0f);
+        h.ascender = m.value("ascender", 0.0f);
+        h.descender = m.value("descender", 0.0f);
+        h.underlineY = m.value("underlineY", 0.0f);
+        h.underlineThickness = m.value("underlineThickness", 0.0f);
+    }
+
+    std::vector<FontPackGlyph> glyphs;
+    glyphs.reserve(j["glyphs"].size());
+    for (const auto& g : j["glyphs"])
+    {
+        FontPackGlyph fg{};
+        fg.codepoint = g.value("unicode", 0u);
+        fg.advance = g.value("advance", 0.0f);
+        if (read_bounds(g, "planeBounds", fg.planeLeft, fg.planeBottom, fg.planeRight, fg.planeTop))
+            fg.flags |= FONT_PACK_GLYPH_HAS_PLANE;
+        if (read_bounds(g, "atlasBounds", fg.atlasLeft, fg.atlasBottom, fg.atlasRight, fg.atlasTop))
+            fg.flags |= FONT_PACK_GLYPH_HAS_ATLAS;
+        glyphs.push_back(fg);
+    }
+
+    std::sort(glyphs.begin(), glyphs.end(),
+              [](const FontPackGlyph& x, const FontPackGlyph& y) { return x.codepoint < y.codepoint; });
+    glyphs.erase(std::unique(glyphs.begin(), glyphs.end(),
+                             [](const FontPackGlyph& x, const FontPackGlyph& y) { return x.codepoint == y.codepoint; }),
+                 glyphs.end());
+
+    std::vector<FontPackKerning> kerning;
+    if (j.contains("kerning") && j["kerning"].is_array())
+    {
+        kerning.reserve(j["kerning"].size());
+        for (const auto& k : j["kerning"])
+        {
+            FontPackKerning fk{};
+            fk.unicode1 = k.value("unicode1", 0u);
+            fk.unicode2 = k.value("unicode2", 0u);
+            fk.advance = k.value("advance", 0.0f);
+            kerning.push_back(fk);
+        }
+        std::sort(kerning.begin(), kerning.end(), [](const FontPackKerning& x, const FontPackKerning& y)
+        {
+            return x.unicode1 != y.unicode1 ? x.unicode1 < y.unicode1 : x.unicode2 < y.unicode2;
+        });
+    }
+
+    std::vector<uint8_t> rgba;
+    size_t pixelOffset = 0;
+    if (!readMsdfAtlasRgba(rgbaPath, h.atlasWidth, h.atlasHeight, rgba, pixelOffset))
+        return false;
+
+    h.atlasSize = (uint64_t)h.atlasWidth * h.atlasHeight * 4u;
+    return writeFontPack(outPath, h, glyphs, kerning, rgba.data() + pixelOffset);
+}
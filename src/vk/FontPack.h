@@ -0,0 +1,134 @@
+#pragma once
+#include "platform/MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Бинарный font pack: один файл = метрики + отсортированная таблица глифов
+// + кернинг + пиксели атласа. Все секции выровнены, читаются прямо из mmap.
+//
+// Layout (little-endian):
+//   FontPackHeader
+//   FontPackGlyph[glyphCount]     (по возрастанию codepoint)
+//   FontPackKerning[kerningCount] (по (unicode1, unicode2))
+//   uint8_t atlas[atlasSize]      (RGBA8, atlasWidth*atlasHeight*4)
+
+static constexpr uint32_t kFontPackMagic   = 0x5044534Du; // "MSDP"
+static constexpr uint32_t kFontPackVersion = 1;
+
+enum FontPackFlags : uint32_t
+{
+    FONT_PACK_ATLAS_Y_BOTTOM = 1u << 0,
+};
+
+enum FontPackGlyphFlags : uint32_t
+{
+    FONT_PACK_GLYPH_HAS_PLANE = 1u << 0,
+    FONT_PACK_GLYPH_HAS_ATLAS = 1u << 1,
+};
+
+struct FontPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t flags;
+
+    uint32_t atlasWidth;
+    uint32_t atlasHeight;
+    float pxRange;
+    float emSize;
+
+    float lineHeight;
+    float ascender;
+    float descender;
+    float underlineY;
+
+    float underlineThickness;
+    uint32_t glyphCount;
+    uint32_t glyphOffset;
+    uint32_t kerningCount;
+
+    uint32_t kerningOffset;
+    uint32_t reserved;
+    uint64_t atlasOffset;
+
+    uint64_t atlasSize;
+    uint64_t fileSize;
+};
+
+struct FontPackGlyph
+{
+    uint32_t codepoint;
+    uint32_t flags;
+    float advance;
+    float planeLeft, planeBottom, planeRight, planeTop; // font units
+    float atlasLeft, atlasBottom, atlasRight, atlasTop; // pixels in atlas
+};
+
+struct FontPackKerning
+{
+    uint32_t unicode1;
+    uint32_t unicode2;
+    float advance;
+};
+
+static_assert(sizeof(FontPackHeader) == 96, "FontPackHeader layout changed");
+static_assert(sizeof(FontPackGlyph) == 44, "FontPackGlyph layout changed");
+static_assert(sizeof(FontPackKerning) == 12, "FontPackKerning layout changed");
+
+// Открытый (замапленный) pack. Все указатели смотрят в отображение файла.
+class FontPack
+{
+public:
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_header != nullptr; }
+
+    const FontPackHeader& header() const { return *m_header; }
+
+    const FontPackGlyph* glyphs() const { return m_glyphs; }
+    uint32_t glyphCount() const { return m_header ? m_header->glyphCount : 0; }
+
+    const FontPackKerning* kerning() const { return m_kerning; }
+    uint32_t kerningCount() const { return m_header ? m_header->kerningCount : 0; }
+
+    const uint8_t* atlasPixels() const { return m_atlas; }
+    size_t atlasSize() const { return m_header ? (size_t)m_header->atlasSize : 0; }
+
+private:
+    MappedFile m_file;
+
+    const FontPackHeader* m_header = nullptr;
+    const FontPackGlyph* m_glyphs = nullptr;
+    const FontPackKerning* m_kerning = nullptr;
+    const uint8_t* m_atlas = nullptr;
+};
+
+// Записать pack из готовых секций. В h заполнены flags, метрики и atlasWidth/atlasHeight,
+// остальное (magic, смещения, размеры) считается здесь; glyphs — по возрастанию codepoint,
+// kerning — по (unicode1, unicode2), atlas — RGBA8 строками сверху вниз.
+bool writeFontPack(
+    const std::string& outPath,
+    FontPackHeader h,
+    const std::vector<FontPackGlyph>& glyphs,
+    const std::vector<FontPackKerning>& kerning,
+    const uint8_t* atlas);
+
+// .rgba от msdf-atlas-gen ("RGBA" + width/height BE32 + пиксели, или только пиксели):
+// файл целиком в bytes, RGBA8 пиксели — с bytes[pixelOffset]; размер сверяется с width × height
+bool readMsdfAtlasRgba(
+    const std::string& rgbaPath,
+    uint32_t width,
+    uint32_t height,
+    std::vector<uint8_t>& bytes,
+    size_t& pixelOffset);
+
+// Конвертер из выходов msdf-atlas-gen (-json + -format rgba -imageout).
+bool buildFontPackFromMsdfAtlasGen(
+    const std::string& jsonPath,
+    const std::string& rgbaPath,
+    const std::string& outPath);
@@ -0,0 +1,462 @@
+#include "vk/GlyphInstanceBuffer.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static constexpr uint32_t kBlockGranularity = 16;
+static constexpr size_t kMaxDirtyRanges = 4096;
+
+const char* instance_memory_name(InstanceMemory memory)
+{
+    switch (memory)
+    {
+    case InstanceMemory::Auto: return "auto";
+    case InstanceMemory::HostVisible: return "host";
+    case InstanceMemory::DeviceMapped: return "rebar";
+    case InstanceMemory::Staged: return "staged";
+    }
+    return "?";
+}
+
+GlyphInstanceBuffer::GlyphInstanceBuffer(
+    GpuAllocator& allocator,
+    const TextLayout& layout,
+    uint32_t frameSlots,
+    uint32_t initialCapacity,
+    InstanceMemory memory)
+    : m_allocator(allocator)
+    , m_device(allocator.device())
+    , m_layout(layout)
+{
+    m_offsetAlign = std::max<VkDeviceSize>(allocator.limits().minStorageBufferOffsetAlignment, 1);
+
+    // нет ReBAR/BAR памяти — device-local через копию
+    m_memory = memory;
+    if (m_memory == InstanceMemory::Auto || (m_memory == InstanceMemory::DeviceMapped && !allocator.supports(GpuMemoryUsage::DeviceMapped)))
+        m_memory = allocator.supports(GpuMemoryUsage::DeviceMapped) ? InstanceMemory::DeviceMapped : InstanceMemory::Staged;
+
+    m_slotCount = std::max(frameSlots, 1u);
+    m_dirty.resize(m_slotCount);
+    m_copies.resize(m_slotCount);
+
+    m_capacity = std::max(initialCapacity, kBlockGranularity);
+    m_shadow.assign(m_capacity, GlyphInstance{});
+    createBuffer(m_capacity);
+
+    m_free.push_back({ 0, m_capacity });
+}
+
+GlyphInstanceBuffer::~GlyphInstanceBuffer()
+{
+    destroyBuffer();
+}
+
+void GlyphInstanceBuffer::createBuffer(uint32_t capacity)
+{
+    const VkDeviceSize slice = (VkDeviceSize)capacity * sizeof(GlyphInstance);
+    m_sliceStride = (slice + m_offsetAlign - 1) / m_offsetAlign * m_offsetAlign;
+
+    const VkDeviceSize size = m_sliceStride * m_slotCount;
+
+    switch (m_memory)
+    {
+    case InstanceMemory::Staged:
+        m_buffer = m_allocator.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                            GpuMemoryUsage::DeviceLocal, "glyph instances");
+        m_staging = m_allocator.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, GpuMemoryUsage::Upload, "glyph instances staging");
+        break;
+    case InstanceMemory::DeviceMapped:
+        m_buffer = m_allocator.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, GpuMemoryUsage::DeviceMapped, "glyph instances");
+        break;
+    default:
+        m_buffer = m_allocator.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, GpuMemoryUsage::Upload, "glyph instances");
+        break;
+    }
+
+    // свежая память — вырожденные инстансы. Device-local срез (Staged) не обнуляется:
+    // каждый выделенный диапазон блока целиком dirty (allocRange), а после роста — всё [0, instanceCount())
+    std::memset(hostAlloc().mapped, 0, (size_t)size);
+}
+
+void GlyphInstanceBuffer::destroyBuffer()
+{
+    m_allocator.destroyBuffer(m_buffer);
+    m_allocator.destroyBuffer(m_staging);
+
+    // копии старого буфера не нужны: после роста все срезы dirty целиком
+    for (auto& copies : m_copies)
+        copies.clear();
+}
+
+void GlyphInstanceBuffer::grow(uint32_t minCapacity)
+{
+    uint32_t newCapacity = m_capacity;
+    while (newCapacity < minCapacity)
+        newCapacity *= 2;
+
+    // старый буфер читают кадры в полёте; рост редкий (удвоение), поэтому просто ждём
+    vkDeviceWaitIdle(m_device);
+
+    destroyBuffer();
+    createBuffer(newCapacity);
+    m_shadow.resize(newCapacity, GlyphInstance{});
+
+    // новый хвост — свободен (сливается с последним свободным диапазоном)
+    if (!m_free.empty() && m_free.back().end == m_capacity)
+        m_free.back().end = newCapacity;
+    else
+        m_free.push_back({ m_capacity, newCapacity });
+
+    m_capacity = newCapacity;
+    ++m_generation;
+}
+
+uint32_t GlyphInstanceBuffer::allocRange(uint32_t count)
+{
+    bool grown = false;
+    for (;;)
+    {
+        for (size_t i = 0; i < m_free.size(); ++i)
+        {
+            Range& r = m_free[i];
+            if (r.end - r.begin < count)
+                continue;
+
+            const uint32_t offset = r.begin;
+            r.begin += count;
+            if (r.begin == r.end)
+                m_free.erase(m_free.begin() + (std::ptrdiff_t)i);
+
+            updateHighWater();
+
+            // новые срезы пустые: каждому нужно всё содержимое, включая этот диапазон
+            if (grown)
+                markAllSlotsDirty();
+
+            // весь диапазон, а не только будущие глифы: хвост до capacity тоже читается
+            // (instanceCount() его покрывает), а в device-local срезе там может быть мусор
+            markDirty(offset, offset + count);
+            return offset;
+        }
+
+        // места нет: хвост + рост; grow сольёт хвост с новым пространством
+        const uint32_t tailFree = (!m_free.empty() && m_free.back().end == m_capacity)
+            ? m_free.back().end - m_free.back().begin : 0;
+        grow(m_capacity + (count - tailFree));
+        grown = true;
+    }
+}
+
+void GlyphInstanceBuffer::freeRange(uint32_t offset, uint32_t count)
+{
+    const Range r{ offset, offset + count };
+
+    auto it = std::lower_bound(m_free.begin(), m_free.end(), r,
+                               [](const Range& a, const Range& b) { return a.begin < b.begin; });
+    it = m_free.insert(it, r);
+
+    // слияние с соседями
+    if (it + 1 != m_free.end() && it->end == (it + 1)->begin)
+    {
+        it->end = (it + 1)->end;
+        m_free.erase(it + 1);
+    }
+    if (it != m_free.begin() && (it - 1)->end == it->begin)
+    {
+        (it - 1)->end = it->end;
+        m_free.erase(it);
+    }
+
+    clearInstances(offset, offset + count);
+    updateHighWater();
+}
+
+void GlyphInstanceBuffer::updateHighWater()
+{
+    m_highWater = (!m_free.empty() && m_free.back().end == m_capacity) ? m_free.back().begin : m_capacity;
+}
+
+uint32_t GlyphInstanceBuffer::blockCapacityFor(size_t utf8Bytes)
+{
+    // глифов не больше, чем байт; +25% запаса на правки без переезда
+    const size_t want = std::max<size_t>(utf8Bytes + utf8Bytes / 4, 1);
+    return (uint32_t)((want + kBlockGranularity - 1) / kBlockGranularity * kBlockGranularity);
+}
+
+GlyphInstanceBuffer::Block& GlyphInstanceBuffer::block(TextBlockHandle h)
+{
+    if (h == kInvalidTextBlock || h > m_blocks.size() || m_blocks[h - 1].capacity == 0)
+    {
+        std::cerr << "Invalid text block handle: " << h << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+    return m_blocks[h - 1];
+}
+
+const GlyphInstanceBuffer::Block& GlyphInstanceBuffer::block(TextBlockHandle h) const
+{
+    return const_cast<GlyphInstanceBuffer*>(this)->block(h);
+}
+
+TextBlockHandle GlyphInstanceBuffer::createBlock(std::string_view utf8, const TextLayoutParams& params)
+{
+    return createBlock(m_layout, utf8, params);
+}
+
+TextBlockHandle GlyphInstanceBuffer::createBlock(const TextLayout& layout, std::string_view utf8, const TextLayoutParams& params)
+{
+    TextBlockHandle h = kInvalidTextBlock;
+    if (!m_freeHandles.empty())
+    {
+        h = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        m_blocks.emplace_back();
+        h = (TextBlockHandle)m_blocks.size();
+    }
+
+    const uint32_t cap = blockCapacityFor(utf8.size());
+    Block& b = m_blocks[h - 1];
+    b.offset = allocRange(cap);
+    b.capacity = cap;
+    b.result = {};
+    b.clip = {};
+    b.translation[0] = 0.0f;
+    b.translation[1] = 0.0f;
+    b.layout = &layout;
+
+    writeBlock(b, utf8, params);
+    return h;
+}
+
+void GlyphInstanceBuffer::updateBlock(TextBlockHandle h, std::string_view utf8, const TextLayoutParams& params)
+{
+    Block& b = block(h);
+
+    if (utf8.size() > b.capacity)
+    {
+        // не влезет (глифов может быть столько же, сколько байт) — переезд
+        freeRange(b.offset, b.capacity);
+        b.capacity = blockCapacityFor(utf8.size());
+        b.offset = allocRange(b.capacity);
+        b.result = {};
+    }
+
+    writeBlock(b, utf8, params);
+}
+
+void GlyphInstanceBuffer::destroyBlock(TextBlockHandle h)
+{
+    Block& b = block(h);
+    freeRange(b.offset, b.capacity);
+    b = {};
+    b.version = ++m_layoutVersion;
+    m_freeHandles.push_back(h);
+}
+
+void GlyphInstanceBuffer::setBlockClip(TextBlockHandle h, const TextClipRect& clip)
+{
+    Block& b = block(h);
+    b.clip = clip;
+    b.version = ++m_layoutVersion;
+}
+
+void GlyphInstanceBuffer::setBlockTranslation(TextBlockHandle h, float x, float y)
+{
+    Block& b = block(h);
+    const float dx = x - b.translation[0];
+    const float dy = y - b.translation[1];
+    if (dx == 0.0f && dy == 0.0f)
+        return;
+
+    b.translation[0] = x;
+    b.translation[1] = y;
+    translateBlock(b, dx, dy);
+
+    markDirty(b.offset, b.offset + b.result.glyphCount);
+    b.version = ++m_layoutVersion;
+}
+
+const TextLayoutResult& GlyphInstanceBuffer::blockLayout(TextBlockHandle h) const
+{
+    return block(h).result;
+}
+
+uint32_t GlyphInstanceBuffer::blockFirstInstance(TextBlockHandle h) const
+{
+    return block(h).offset;
+}
+
+void GlyphInstanceBuffer::writeBlock(Block& b, std::string_view utf8, const TextLayoutParams& params)
+{
+    const uint32_t oldCount = b.result.glyphCount;
+    b.result = b.layout->layout(utf8, params, m_shadow.data() + b.offset, b.capacity);
+    if (b.translation[0] != 0.0f || b.translation[1] != 0.0f)
+        translateBlock(b, b.translation[0], b.translation[1]);
+
+    // хвост прошлой версии блока
+    const uint32_t newCount = b.result.glyphCount;
+    if (oldCount > newCount)
+        std::memset(m_shadow.data() + b.offset + newCount, 0, (size_t)(oldCount - newCount) * sizeof(GlyphInstance));
+
+    markDirty(b.offset, b.offset + std::max(oldCount, newCount));
+    b.version = ++m_layoutVersion;
+}
+
+void GlyphInstanceBuffer::translateBlock(Block& b, float dx, float dy)
+{
+    GlyphInstance* inst = m_shadow.data() + b.offset;
+    for (uint32_t i = 0; i < b.result.glyphCount; ++i)
+    {
+        inst[i].posMin[0] += dx;
+        inst[i].posMin[1] += dy;
+        inst[i].posMax[0] += dx;
+        inst[i].posMax[1] += dy;
+    }
+
+    b.result.boundsMin[0] += dx;
+    b.result.boundsMin[1] += dy;
+    b.result.boundsMax[0] += dx;
+    b.result.boundsMax[1] += dy;
+}
+
+void GlyphInstanceBuffer::clearInstances(uint32_t begin, uint32_t end)
+{
+    std::memset(m_shadow.data() + begin, 0, (size_t)(end - begin) * sizeof(GlyphInstance));
+    markDirty(begin, end);
+}
+
+void GlyphInstanceBuffer::markDirty(uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+        return;
+
+    for (auto& dirty : m_dirty)
+    {
+        // срез давно не сбрасывали — схлопываем список в один охватывающий диапазон
+        if (dirty.size() >= kMaxDirtyRanges)
+        {
+            Range all = dirty.front();
+            for (const Range& r : dirty)
+            {
+                all.begin = std::min(all.begin, r.begin);
+                all.end = std::max(all.end, r.end);
+            }
+            dirty.assign(1, all);
+        }
+        dirty.push_back({ begin, end });
+    }
+}
+
+void GlyphInstanceBuffer::markAllSlotsDirty()
+{
+    for (auto& dirty : m_dirty)
+    {
+        dirty.clear();
+        if (m_highWater > 0)
+            dirty.push_back({ 0, m_highWater });
+    }
+}
+
+VkDeviceSize GlyphInstanceBuffer::flush(uint32_t slot)
+{
+    m_lastFlushRanges = 0;
+    m_lastFlushBytes = 0;
+
+    std::vector<Range>& dirty = m_dirty[slot];
+    if (dirty.empty())
+        return 0;
+
+    std::sort(dirty.begin(), dirty.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+    // слияние пересекающихся/соседних
+    size_t n = 0;
+    for (size_t i = 1; i < dirty.size(); ++i)
+    {
+        if (dirty[i].begin <= dirty[n].end)
+            dirty[n].end = std::max(dirty[n].end, dirty[i].end);
+        else
+            dirty[++n] = dirty[i];
+    }
+    dirty.resize(n + 1);
+
+    const GpuAllocation& host = hostAlloc();
+    const VkDeviceSize sliceBase = sliceOffset(slot);
+    for (const Range& r : dirty)
+    {
+        const VkDeviceSize offset = sliceBase + (VkDeviceSize)r.begin * sizeof(GlyphInstance);
+        const size_t bytes = (size_t)(r.end - r.begin) * sizeof(GlyphInstance);
+        std::memcpy(host.mapped + offset, m_shadow.data() + r.begin, bytes);
+        m_lastFlushBytes += bytes;
+
+        if (m_memory == InstanceMemory::Staged)
+            m_copies[slot].push_back({ offset, offset, bytes });
+    }
+
+    if (!host.coherent)
+    {
+        std::vector<VkMappedMemoryRange> ranges;
+        ranges.reserve(dirty.size());
+
+        for (const Range& r : dirty)
+        {
+            ranges.push_back(m_allocator.mappedRange(
+                host,
+                sliceBase + (VkDeviceSize)r.begin * sizeof(GlyphInstance),
+                (VkDeviceSize)(r.end - r.begin) * sizeof(GlyphInstance)));
+        }
+
+        vk_check(vkFlushMappedMemoryRanges(m_device, (uint32_t)ranges.size(), ranges.data()),
+                 "vkFlushMappedMemoryRanges(glyph instances)");
+    }
+
+    m_lastFlushRanges = (uint32_t)dirty.size();
+    dirty.clear();
+    return m_lastFlushBytes;
+}
+
+bool GlyphInstanceBuffer::recordUpload(VkCommandBuffer cmd, uint32_t slot)
+{
+    std::vector<VkBufferCopy>& copies = m_copies[slot];
+    if (copies.empty())
+        return false;
+
+    vkCmdCopyBuffer(cmd, m_staging.buffer, m_buffer.buffer, (uint32_t)copies.size(), copies.data());
+    copies.clear();
+
+    // прошлое чтение среза закончилось до fence кадра — нужен только RAW
+    VkBufferMemoryBarrier b{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.buffer = m_buffer.buffer;
+    b.offset = sliceOffset(slot);
+    b.size = sliceSize();
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        0, 0, nullptr, 1, &b, 0, nullptr);
+    return true;
+}
+
+GlyphInstanceBuffer::Stats GlyphInstanceBuffer::stats() const
+{
+    Stats s{};
+    for (const Block& b : m_blocks)
+    {
+        if (b.capacity == 0)
+            continue;
+        ++s.blockCount;
+        s.liveInstances += b.result.glyphCount;
+        s.reservedInstances += b.capacity;
+    }
+    s.lastFlushRanges = m_lastFlushRanges;
+    s.lastFlushBytes = m_lastFlushBytes;
+    return s;
+}
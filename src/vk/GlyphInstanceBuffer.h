@@ -0,0 +1,204 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+#include "vk/TextLayout.h"
+
+#include <vulkan/vulkan.h>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using TextBlockHandle = uint32_t;
+static constexpr TextBlockHandle kInvalidTextBlock = 0;
+
+// Прямоугольник отсечения блока в тех же единицах, что и инстансы (NDC).
+// По умолчанию не ограничивает.
+struct TextClipRect
+{
+    float minX = -1e30f;
+    float minY = -1e30f;
+    float maxX = 1e30f;
+    float maxY = 1e30f;
+};
+
+// Где живут инстансы (их читает mesh shader каждый кадр)
+enum class InstanceMemory
+{
+    Auto,         // DeviceMapped, если есть такая память, иначе Staged
+    HostVisible,  // системная память: GPU читает через PCIe (для сравнения)
+    DeviceMapped, // DEVICE_LOCAL | HOST_VISIBLE (ReBAR): CPU пишет прямо в VRAM
+    Staged,       // DEVICE_LOCAL + host-visible копия срезов, vkCmdCopyBuffer в кадре
+};
+
+const char* instance_memory_name(InstanceMemory memory);
+
+// GlyphInstance всех текстовых блоков в одном SSBO.
+// Блок занимает непрерывный диапазон инстансов (first-fit по списку свободных,
+// соседние свободные сливаются). Правка блока перекладывает только его диапазон
+// в CPU-копии и помечает его dirty.
+//
+// Буфер поделён на frameSlots одинаковых срезов — по одному на кадр в полёте.
+// GPU читает срез своего кадра, а flush(slot) (после ожидания fence этого кадра)
+// переносит в срез только накопленные для него dirty-диапазоны и, если память
+// не coherent, делает vkFlushMappedMemoryRanges только по ним. В режиме Staged
+// flush() пишет в host-visible копию среза, а recordUpload() копирует те же
+// диапазоны в device-local срез командным буфером кадра.
+//
+// Рисовать нужно [0, instanceCount()): дырки от удалённых/укоротившихся блоков
+// заполнены нулевыми (вырожденными) инстансами.
+class GlyphInstanceBuffer
+{
+public:
+    GlyphInstanceBuffer(
+        GpuAllocator& allocator,
+        const TextLayout& layout,
+        uint32_t frameSlots = 1,
+        uint32_t initialCapacity = 4096,
+        InstanceMemory memory = InstanceMemory::Auto);
+
+    ~GlyphInstanceBuffer();
+
+    GlyphInstanceBuffer(const GlyphInstanceBuffer&) = delete;
+    GlyphInstanceBuffer& operator=(const GlyphInstanceBuffer&) = delete;
+
+    TextBlockHandle createBlock(std::string_view utf8, const TextLayoutParams& params);
+
+    // Блок своим шрифтом (layout должен жить, пока жив блок): инстансы несут его
+    // GlyphInstance::atlas, поэтому шрифты в одном буфере рисуются одним draw
+    TextBlockHandle createBlock(const TextLayout& layout, std::string_view utf8, const TextLayoutParams& params);
+
+    // Перекладывает блок на месте; если текст не влезает в его диапазон — блок переезжает
+    void updateBlock(TextBlockHandle block, std::string_view utf8, const TextLayoutParams& params);
+
+    void destroyBlock(TextBlockHandle block);
+
+    // Глифы вне rect не рисуются (task shader отбрасывает блок/группы целиком, остальное — clip distance)
+    void setBlockClip(TextBlockHandle block, const TextClipRect& clip);
+
+    // Сдвиг блока относительно позиции из layout (прокрутка): инстансы и bbox сдвигаются
+    // на месте без повторного layout, clip остаётся. Сохраняется при updateBlock
+    void setBlockTranslation(TextBlockHandle block, float x, float y);
+
+    const TextLayoutResult& blockLayout(TextBlockHandle block) const;
+    uint32_t blockFirstInstance(TextBlockHandle block) const;
+
+    // f(blockIndex, firstInstance, layout, clip) для слотов блоков, изменённых после layoutVersion() == since
+    // (since = 0 — все когда-либо занятые); у удалённых блоков layout пустой (glyphCount 0). blockIndex = handle - 1
+    template<class F>
+    void forEachBlockSince(uint32_t since, F&& f) const
+    {
+        for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); ++i)
+        {
+            const Block& b = m_blocks[i];
+            if (b.version > since)
+                f(i, b.offset, b.result, b.clip);
+        }
+    }
+    uint32_t blockSlotCount() const { return (uint32_t)m_blocks.size(); }
+
+    // Растёт при любом изменении блоков (текст, clip, удаление); изменённый блок запоминает
+    // новое значение, так что производные таблицы пересобирают только блоки новее своей версии
+    uint32_t layoutVersion() const { return m_layoutVersion; }
+
+    // CPU-копия инстансов (то, что окажется в срезах после flush)
+    const GlyphInstance* instances() const { return m_shadow.data(); }
+
+    // Обновить срез slot; вызывать, когда GPU уже не читает его (fence кадра пройден),
+    // перед submit кадра. Возвращает число скопированных байт.
+    VkDeviceSize flush(uint32_t slot = 0);
+
+    // Staged: копии, накопленные flush(slot), + барьер до task/mesh/compute чтения.
+    // Вызывать в командном буфере кадра до первого чтения среза; false — копировать нечего.
+    bool recordUpload(VkCommandBuffer cmd, uint32_t slot);
+
+    VkBuffer buffer() const { return m_buffer.buffer; }
+    uint32_t frameSlots() const { return m_slotCount; }
+    VkDeviceSize sliceOffset(uint32_t slot) const { return m_sliceStride * slot; }
+    VkDeviceSize sliceSize() const { return (VkDeviceSize)m_capacity * sizeof(GlyphInstance); }
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t instanceCount() const { return m_highWater; }
+    bool isCoherent() const { return hostAlloc().coherent; }
+    InstanceMemory memory() const { return m_memory; } // уже без Auto
+
+    // Растёт при переезде в больший VkBuffer: дескрипторы на buffer() надо переписать
+    uint32_t generation() const { return m_generation; }
+
+    struct Stats
+    {
+        uint32_t blockCount = 0;
+        uint32_t liveInstances = 0;    // реально записанные глифы
+        uint32_t reservedInstances = 0; // занято диапазонами блоков
+        uint32_t lastFlushRanges = 0;
+        VkDeviceSize lastFlushBytes = 0;
+    };
+    Stats stats() const;
+
+private:
+    struct Block
+    {
+        uint32_t offset = 0;
+        uint32_t capacity = 0; // 0 = слот свободен
+        TextLayoutResult result{};
+        TextClipRect clip{};
+        float translation[2] = { 0.0f, 0.0f };
+        const TextLayout* layout = nullptr;
+        uint32_t version = 0; // layoutVersion последнего изменения (в т.ч. удаления)
+    };
+
+    struct Range
+    {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    void createBuffer(uint32_t capacity);
+    const GpuAllocation& hostAlloc() const { return m_memory == InstanceMemory::Staged ? m_staging.alloc : m_buffer.alloc; }
+    void destroyBuffer();
+    void grow(uint32_t minCapacity);
+
+    uint32_t allocRange(uint32_t count);
+    void freeRange(uint32_t offset, uint32_t count);
+    void updateHighWater();
+
+    void writeBlock(Block& b, std::string_view utf8, const TextLayoutParams& params);
+    void translateBlock(Block& b, float dx, float dy);
+    void clearInstances(uint32_t begin, uint32_t end);
+    void markDirty(uint32_t begin, uint32_t end);
+    void markAllSlotsDirty();
+
+    Block& block(TextBlockHandle h);
+    const Block& block(TextBlockHandle h) const;
+
+    static uint32_t blockCapacityFor(size_t utf8Bytes);
+
+private:
+    GpuAllocator& m_allocator;
+    VkDevice m_device = VK_NULL_HANDLE;
+    const TextLayout& m_layout; // для createBlock без своего layout'а
+
+    InstanceMemory m_memory = InstanceMemory::HostVisible;
+    GpuBuffer m_buffer{};
+    GpuBuffer m_staging{};                           // только Staged: то, что пишет CPU
+    std::vector<std::vector<VkBufferCopy>> m_copies; // Staged: по срезам, ещё не записанные в кадр
+    VkDeviceSize m_offsetAlign = 1;
+
+    uint32_t m_slotCount = 1;
+    VkDeviceSize m_sliceStride = 0;   // байт между срезами (выровнено под storage offset)
+
+    uint32_t m_capacity = 0;
+    uint32_t m_highWater = 0;
+    uint32_t m_generation = 0;
+    uint32_t m_layoutVersion = 0;
+
+    std::vector<Block> m_blocks;        // handle = индекс + 1
+    std::vector<TextBlockHandle> m_freeHandles;
+    std::vector<Range> m_free;          // отсортированы по begin, не соприкасаются
+    std::vector<std::vector<Range>> m_dirty; // по срезам: что ещё не перенесено в срез
+
+    // Авторитетная CPU-копия всех инстансов; layout пишет сюда
+    // (перенос строк читает уже записанное, а чтение mapped памяти дорогое)
+    std::vector<GlyphInstance> m_shadow;
+
+    uint32_t m_lastFlushRanges = 0;
+    VkDeviceSize m_lastFlushBytes = 0;
+};
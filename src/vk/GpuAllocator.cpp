@@ -0,0 +1,386 @@
+#include "vk/GpuAllocator.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+
+GpuAllocator::GpuAllocator(VkPhysicalDevice phys, VkDevice device, VkDeviceSize blockSize)
+    : m_phys(phys)
+    , m_device(device)
+    , m_blockSize(std::bit_floor(std::max(blockSize, kMinNodeSize)))
+{
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(m_phys, &props);
+    m_limits = props.limits;
+
+    vkGetPhysicalDeviceMemoryProperties(m_phys, &m_memProps);
+}
+
+GpuAllocator::~GpuAllocator()
+{
+    uint32_t leaked = 0;
+    for (Pool& pool : m_pools)
+    {
+        for (Block& block : pool.blocks)
+        {
+            if (!block.memory)
+                continue;
+            leaked += block.liveCount;
+            if (block.mapped) vkUnmapMemory(m_device, block.memory);
+            vkFreeMemory(m_device, block.memory, nullptr);
+        }
+    }
+
+    if (leaked || m_dedicatedCount)
+        std::cerr << "[GpuAllocator] leaked " << leaked << " sub-allocation(s), " << m_dedicatedCount << " dedicated\n";
+}
+
+GpuBuffer GpuAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuMemoryUsage memory, const char* what)
+{
+    GpuBuffer b{};
+
+    VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bci.size = size;
+    bci.usage = usage;
+    bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    vk_check(vkCreateBuffer(m_device, &bci, nullptr, &b.buffer), what);
+
+    VkMemoryRequirements mr{};
+    vkGetBufferMemoryRequirements(m_device, b.buffer, &mr);
+
+    b.alloc = allocate(mr, memory, true, what);
+    vk_check(vkBindBufferMemory(m_device, b.buffer, b.alloc.memory, b.alloc.offset), what);
+    return b;
+}
+
+void GpuAllocator::destroyBuffer(GpuBuffer& b)
+{
+    if (b.buffer) vkDestroyBuffer(m_device, b.buffer, nullptr);
+    free(b.alloc);
+    b = {};
+}
+
+GpuImage GpuAllocator::createImage(const VkImageCreateInfo& ci, const char* what)
+{
+    GpuImage img{};
+    vk_check(vkCreateImage(m_device, &ci, nullptr, &img.image), what);
+
+    VkMemoryRequirements mr{};
+    vkGetImageMemoryRequirements(m_device, img.image, &mr);
+
+    img.alloc = allocate(mr, GpuMemoryUsage::DeviceLocal, ci.tiling == VK_IMAGE_TILING_LINEAR, what);
+    vk_check(vkBindImageMemory(m_device, img.image, img.alloc.memory, img.alloc.offset), what);
+    return img;
+}
+
+void GpuAllocator::destroyImage(GpuImage& img)
+{
+    if (img.image) vkDestroyImage(m_device, img.image, nullptr);
+    free(img.alloc);
+    img = {};
+}
+
+std::optional<uint32_t> GpuAllocator::findMemoryType(uint32_t typeBits, GpuMemoryUsage memory) const
+{
+    std::optional<uint32_t> type;
+    switch (memory)
+    {
+    case GpuMemoryUsage::DeviceLocal:
+        type = find_memory_type(m_memProps, typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!type) type = find_memory_type(m_memProps, typeBits, 0);
+        break;
+    case GpuMemoryUsage::Upload:
+        type = find_memory_type(m_memProps, typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        break;
+    case GpuMemoryUsage::Readback:
+        type = find_memory_type(
+            m_memProps, typeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        if (!type) type = find_memory_type(m_memProps, typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        break;
+    case GpuMemoryUsage::DeviceMapped:
+        type = find_memory_type(
+            m_memProps, typeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        break;
+    }
+    return type;
+}
+
+uint32_t GpuAllocator::memoryTypeFor(uint32_t typeBits, GpuMemoryUsage memory) const
+{
+    const std::optional<uint32_t> type = findMemoryType(typeBits, memory);
+    if (!type)
+    {
+        std::cerr << "[GpuAllocator] no memory type for typeBits=0x" << std::hex << typeBits << std::dec << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+    return *type;
+}
+
+VkDeviceSize GpuAllocator::blockSizeFor(uint32_t memoryType) const
+{
+    // маленькие кучи (BAR 256 MiB и т.п.) не отдаём одному блоку целиком
+    const VkDeviceSize heap = m_memProps.memoryHeaps[m_memProps.memoryTypes[memoryType].heapIndex].size;
+    return std::max(kMinNodeSize, std::min(m_blockSize, std::bit_floor(std::max<VkDeviceSize>(heap / 8, 1))));
+}
+
+GpuAllocator::Pool& GpuAllocator::poolFor(uint32_t memoryType, bool linear)
+{
+    for (Pool& pool : m_pools)
+        if (pool.memoryType == memoryType && pool.linear == linear)
+            return pool;
+
+    const VkMemoryPropertyFlags flags = m_memProps.memoryTypes[memoryType].propertyFlags;
+
+    Pool pool{};
+    pool.memoryType = memoryType;
+    pool.linear = linear;
+    pool.hostVisible = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+    pool.coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    pool.blockSize = blockSizeFor(memoryType);
+    pool.levels = (uint32_t)(std::countr_zero(pool.blockSize) - std::countr_zero(kMinNodeSize)) + 1;
+    m_pools.push_back(std::move(pool));
+    return m_pools.back();
+}
+
+void GpuAllocator::createBlock(Pool& pool, Block& block)
+{
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = pool.blockSize;
+    mai.memoryTypeIndex = pool.memoryType;
+    vk_check(vkAllocateMemory(m_device, &mai, nullptr, &block.memory), "vkAllocateMemory(allocator block)");
+
+    if (pool.hostVisible)
+    {
+        void* mapped = nullptr;
+        vk_check(vkMapMemory(m_device, block.memory, 0, VK_WHOLE_SIZE, 0, &mapped), "vkMapMemory(allocator block)");
+        block.mapped = static_cast<uint8_t*>(mapped);
+    }
+
+    block.freeNodes.assign(pool.levels, {});
+    block.freeNodes[0].insert(0);
+    block.liveCount = 0;
+}
+
+bool GpuAllocator::allocateFromBlock(Pool& pool, Block& block, uint32_t level, VkDeviceSize& outOffset)
+{
+    // ближайший свободный узел не меньше нужного
+    int from = (int)level;
+    while (from >= 0 && block.freeNodes[from].empty())
+        --from;
+    if (from < 0)
+        return false;
+
+    VkDeviceSize offset = *block.freeNodes[from].begin();
+    block.freeNodes[from].erase(block.freeNodes[from].begin());
+
+    // делим пополам до нужного уровня, правые половины — в свободные
+    for (uint32_t l = (uint32_t)from; l < level; ++l)
+        block.freeNodes[l + 1].insert(offset + nodeSize(pool, l + 1));
+
+    ++block.liveCount;
+    outOffset = offset;
+    return true;
+}
+
+GpuAllocation GpuAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryType, const char* what)
+{
+    const VkMemoryPropertyFlags flags = m_memProps.memoryTypes[memoryType].propertyFlags;
+    const VkDeviceSize atom = std::max<VkDeviceSize>(m_limits.nonCoherentAtomSize, 1);
+
+    GpuAllocation a{};
+    a.size = size;
+    a.coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    // до атома: flush по выровненному диапазону не выходит за память
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = (size + atom - 1) / atom * atom;
+    mai.memoryTypeIndex = memoryType;
+    vk_check(vkAllocateMemory(m_device, &mai, nullptr, &a.memory), what);
+
+    if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void* mapped = nullptr;
+        vk_check(vkMapMemory(m_device, a.memory, 0, VK_WHOLE_SIZE, 0, &mapped), what);
+        a.mapped = static_cast<uint8_t*>(mapped);
+    }
+
+    ++m_dedicatedCount;
+    m_dedicatedBytes += mai.allocationSize;
+    return a;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& mr, GpuMemoryUsage memory, bool linear, const char* what)
+{
+    const uint32_t memoryType = memoryTypeFor(mr.memoryTypeBits, memory);
+    Pool& pool = poolFor(memoryType, linear);
+
+    // узел выровнен по своему размеру — достаточно узла >= max(size, alignment)
+    const VkDeviceSize need = std::bit_ceil(std::max({ mr.size, mr.alignment, kMinNodeSize }));
+    if (need > pool.blockSize / 2)
+        return allocateDedicated(mr.size, memoryType, what);
+
+    const uint32_t level = (uint32_t)(std::countr_zero(pool.blockSize) - std::countr_zero(need));
+    const uint32_t poolIndex = (uint32_t)(&pool - m_pools.data());
+
+    GpuAllocation a{};
+    a.size = mr.size;
+    a.coherent = pool.coherent;
+    a.pool = poolIndex;
+    a.level = level;
+
+    for (uint32_t i = 0; i < (uint32_t)pool.blocks.size(); ++i)
+    {
+        Block& block = pool.blocks[i];
+        if (block.memory && allocateFromBlock(pool, block, level, a.offset))
+        {
+            a.block = i;
+            a.memory = block.memory;
+            a.mapped = block.mapped ? block.mapped + a.offset : nullptr;
+            m_usedBytes += a.size;
+            return a;
+        }
+    }
+
+    // новый блок: в освободившийся слот или в конец
+    uint32_t slot = 0;
+    while (slot < (uint32_t)pool.blocks.size() && pool.blocks[slot].memory)
+        ++slot;
+    if (slot == pool.blocks.size())
+        pool.blocks.emplace_back();
+
+    Block& block = pool.blocks[slot];
+    createBlock(pool, block);
+    allocateFromBlock(pool, block, level, a.offset);
+
+    a.block = slot;
+    a.memory = block.memory;
+    a.mapped = block.mapped ? block.mapped + a.offset : nullptr;
+    m_usedBytes += a.size;
+    return a;
+}
+
+void GpuAllocator::free(GpuAllocation& a)
+{
+    if (!a.memory)
+        return;
+
+    if (a.pool == UINT32_MAX)
+    {
+        const VkDeviceSize atom = std::max<VkDeviceSize>(m_limits.nonCoherentAtomSize, 1);
+        if (a.mapped) vkUnmapMemory(m_device, a.memory);
+        vkFreeMemory(m_device, a.memory, nullptr);
+        --m_dedicatedCount;
+        m_dedicatedBytes -= (a.size + atom - 1) / atom * atom;
+        a = {};
+        return;
+    }
+
+    Pool& pool = m_pools[a.pool];
+    Block& block = pool.blocks[a.block];
+
+    // сливаем с buddy, пока он свободен
+    VkDeviceSize offset = a.offset;
+    uint32_t level = a.level;
+    while (level > 0)
+    {
+        const VkDeviceSize buddy = offset ^ nodeSize(pool, level);
+        auto it = block.freeNodes[level].find(buddy);
+        if (it == block.freeNodes[level].end())
+            break;
+        block.freeNodes[level].erase(it);
+        offset = std::min(offset, buddy);
+        --level;
+    }
+    block.freeNodes[level].insert(offset);
+
+    --block.liveCount;
+    m_usedBytes -= a.size;
+
+    // пустой блок отдаём драйверу, если в пуле есть другой живой — один держим про запас
+    if (block.liveCount == 0)
+    {
+        const bool otherAlive = std::any_of(pool.blocks.begin(), pool.blocks.end(),
+            [&](const Block& b) { return &b != &block && b.memory; });
+        if (otherAlive)
+        {
+            if (block.mapped) vkUnmapMemory(m_device, block.memory);
+            vkFreeMemory(m_device, block.memory, nullptr);
+            block = {};
+        }
+    }
+
+    a = {};
+}
+
+VkMappedMemoryRange GpuAllocator::mappedRange(const GpuAllocation& a, VkDeviceSize offset, VkDeviceSize size) const
+{
+    const VkDeviceSize atom = std::max<VkDeviceSize>(m_limits.nonCoherentAtomSize, 1);
+    const VkDeviceSize end = size == VK_WHOLE_SIZE ? a.size : std::min(a.size, offset + size);
+
+    // узел buddy и dedicated память кратны атому — выровненный диапазон не выходит за них
+    const VkDeviceSize begin = (a.offset + offset) / atom * atom;
+    const VkDeviceSize last = (a.offset + end + atom - 1) / atom * atom;
+
+    VkMappedMemoryRange r{ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+    r.memory = a.memory;
+    r.offset = begin;
+    r.size = last - begin;
+    return r;
+}
+
+void GpuAllocator::flush(const GpuAllocation& a, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (a.coherent || !a.memory)
+        return;
+
+    const VkMappedMemoryRange r = mappedRange(a, offset, size);
+    vk_check(vkFlushMappedMemoryRanges(m_device, 1, &r), "vkFlushMappedMemoryRanges");
+}
+
+void GpuAllocator::invalidate(const GpuAllocation& a, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (a.coherent || !a.memory)
+        return;
+
+    const VkMappedMemoryRange r = mappedRange(a, offset, size);
+    vk_check(vkInvalidateMappedMemoryRanges(m_device, 1, &r), "vkInvalidateMappedMemoryRanges");
+}
+
+GpuAllocatorStats GpuAllocator::stats() const
+{
+    GpuAllocatorStats s{};
+    s.dedicatedCount = m_dedicatedCount;
+    s.dedicatedBytes = m_dedicatedBytes;
+    s.usedBytes = m_usedBytes;
+
+    VkDeviceSize freeBytes = 0;
+    for (const Pool& pool : m_pools)
+    {
+        for (const Block& block : pool.blocks)
+        {
+            if (!block.memory)
+                continue;
+
+            ++s.blockCount;
+            s.blockBytes += pool.blockSize;
+            s.allocationCount += block.liveCount;
+
+            for (uint32_t l = 0; l < pool.levels; ++l)
+            {
+                if (block.freeNodes[l].empty())
+                    continue;
+                freeBytes += block.freeNodes[l].size() * nodeSize(pool, l);
+                s.largestFreeNode = std::max(s.largestFreeNode, nodeSize(pool, l));
+            }
+        }
+    }
+
+    s.nodeBytes = s.blockBytes - freeBytes;
+    return s;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <vector>
+
+// Куда кладётся ресурс
+enum class GpuMemoryUsage
+{
+    DeviceLocal, // только GPU
+    Upload,      // CPU пишет (HOST_VISIBLE, coherent предпочтительнее), постоянно замаплен
+    Readback,    // CPU читает (HOST_VISIBLE | HOST_COHERENT, cached предпочтительнее)
+    DeviceMapped, // CPU пишет прямо в VRAM (DEVICE_LOCAL | HOST_VISIBLE: ReBAR/BAR), см. supports()
+};
+
+// Кусок VkDeviceMemory: свой (dedicated) или узел buddy-блока
+struct GpuAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;    // внутри memory
+    VkDeviceSize size = 0;      // запрошенный
+    uint8_t* mapped = nullptr;  // host-visible: уже со смещением offset
+    bool coherent = true;
+
+    // для free()
+    uint32_t pool = UINT32_MAX; // UINT32_MAX — dedicated
+    uint32_t block = 0;
+    uint32_t level = 0;
+};
+
+struct GpuBuffer
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    GpuAllocation alloc{};
+};
+
+struct GpuImage
+{
+    VkImage image = VK_NULL_HANDLE;
+    GpuAllocation alloc{};
+};
+
+struct GpuAllocatorStats
+{
+    uint32_t blockCount = 0;            // vkAllocateMemory под buddy-блоки
+    uint32_t dedicatedCount = 0;        // vkAllocateMemory под отдельные ресурсы
+    uint32_t allocationCount = 0;       // живые под-выделения в блоках
+    VkDeviceSize blockBytes = 0;        // память блоков у драйвера
+    VkDeviceSize dedicatedBytes = 0;
+    VkDeviceSize usedBytes = 0;         // запрошено под-выделениями
+    VkDeviceSize nodeBytes = 0;         // занято узлами buddy (>= usedBytes: округление до 2^k)
+    VkDeviceSize largestFreeNode = 0;
+
+    // внешняя фрагментация: 1 - наибольший свободный узел / всё свободное в блоках
+    double fragmentation() const
+    {
+        const VkDeviceSize freeBytes = blockBytes - nodeBytes;
+        return freeBytes ? 1.0 - (double)largestFreeNode / (double)freeBytes : 0.0;
+    }
+};
+
+// Общий аллокатор памяти устройства: вместо vkAllocateMemory на ресурс — buddy-блоки
+// (по kDefaultBlockSize) на каждый тип памяти. Узел — степень двойки >= kMinNodeSize, поэтому
+// выравнивание до размера узла получается само. Буферы и optimal-image живут в разных
+// пулах — bufferImageGranularity не нужно учитывать внутри блока. Запросы больше половины
+// блока получают dedicated VkDeviceMemory. Host-visible блоки замаплены постоянно.
+//
+// Однопоточный: все вызовы — из потока рендера.
+class GpuAllocator
+{
+public:
+    static constexpr VkDeviceSize kDefaultBlockSize = 64ull << 20;
+    static constexpr VkDeviceSize kMinNodeSize = 256; // >= nonCoherentAtomSize (спецификация: <= 256)
+
+    GpuAllocator(VkPhysicalDevice phys, VkDevice device, VkDeviceSize blockSize = kDefaultBlockSize);
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    VkPhysicalDevice physicalDevice() const { return m_phys; }
+    VkDevice device() const { return m_device; }
+    const VkPhysicalDeviceLimits& limits() const { return m_limits; }
+
+    // Есть ли тип памяти под memory (DeviceMapped есть не везде)
+    bool supports(GpuMemoryUsage memory) const { return findMemoryType(~0u, memory).has_value(); }
+
+    // Буфер/image + память + bind; при ошибке — exit
+    GpuBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuMemoryUsage memory, const char* what);
+    void destroyBuffer(GpuBuffer& b);
+
+    GpuImage createImage(const VkImageCreateInfo& ci, const char* what);
+    void destroyImage(GpuImage& img);
+
+    GpuAllocation allocate(const VkMemoryRequirements& mr, GpuMemoryUsage memory, bool linear, const char* what);
+    void free(GpuAllocation& a);
+
+    // Диапазон [offset, offset + size) выделения для vkFlush/InvalidateMappedMemoryRanges,
+    // выровненный по nonCoherentAtomSize
+    VkMappedMemoryRange mappedRange(const GpuAllocation& a, VkDeviceSize offset, VkDeviceSize size) const;
+    void flush(const GpuAllocation& a, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+    // перед чтением CPU того, что записал GPU (no-op для coherent памяти)
+    void invalidate(const GpuAllocation& a, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+    GpuAllocatorStats stats() const;
+
+private:
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        std::vector<std::set<VkDeviceSize>> freeNodes; // по уровню: 0 — весь блок
+        uint32_t liveCount = 0;
+    };
+
+    struct Pool
+    {
+        uint32_t memoryType = 0;
+        bool linear = true;
+        bool coherent = true;
+        bool hostVisible = false;
+        VkDeviceSize blockSize = 0;
+        uint32_t levels = 0;
+        std::vector<Block> blocks; // пустые слоты (memory == null) переиспользуются
+    };
+
+    std::optional<uint32_t> findMemoryType(uint32_t typeBits, GpuMemoryUsage memory) const;
+    uint32_t memoryTypeFor(uint32_t typeBits, GpuMemoryUsage memory) const;
+    Pool& poolFor(uint32_t memoryType, bool linear);
+    VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+
+    bool allocateFromBlock(Pool& pool, Block& block, uint32_t level, VkDeviceSize& outOffset);
+    void createBlock(Pool& pool, Block& block);
+    GpuAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryType, const char* what);
+
+    VkDeviceSize nodeSize(const Pool& pool, uint32_t level) const { return pool.blockSize >> level; }
+
+private:
+    VkPhysicalDevice m_phys = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceLimits m_limits{};
+    VkPhysicalDeviceMemoryProperties m_memProps{};
+    VkDeviceSize m_blockSize = kDefaultBlockSize;
+
+    std::vector<Pool> m_pools;
+
+    uint32_t m_dedicatedCount = 0;
+    VkDeviceSize m_dedicatedBytes = 0;
+    VkDeviceSize m_usedBytes = 0;
+};
@@ -0,0 +1,482 @@
+#include "vk/GpuTextLayout.h"
+#include "vk/MsdfFont.h"
+#include "vk/PipelineCache.h"
+#include "vk/Utf8.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+    // Совпадает с TextRun в shaders/msdf_text_layout.comp.glsl (std430)
+    struct GpuTextRunGpu
+    {
+        float originX;
+        float originY;
+        float scaleX;
+        float scaleY;
+        float lineStep;
+        uint32_t firstChar;
+        uint32_t charCount;
+        uint32_t firstGroup;
+        uint32_t kerning;
+        uint32_t atlas;
+        uint32_t pad[2];
+    };
+    static_assert(sizeof(GpuTextRunGpu) == 48, "GpuTextRunGpu must match std430 layout");
+
+    // Заголовок таблицы шрифта (H_* в шейдере)
+    enum FontHeader : uint32_t
+    {
+        kHDirect = 0,
+        kHSparseCount,
+        kHSparseCp,
+        kHSparseGlyph,
+        kHGlyphCount,
+        kHAdvance,
+        kHQuad,
+        kHKernCount,
+        kHKernFirst,
+        kHKernRight,
+        kHKernValue,
+        kHFallback,
+        kHSpaceGlyph,
+        kHSpaceAdvance,
+        kHeaderWords = 16,
+    };
+
+    // vkCmdDispatch: maxComputeWorkGroupCount[0] >= 65535 гарантировано
+    constexpr uint32_t kMaxDispatch = 65535;
+
+    uint32_t float_bits(float f)
+    {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    void compute_barrier(VkCommandBuffer cmd)
+    {
+        VkMemoryBarrier mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             1, &mb, 0, nullptr, 0, nullptr);
+    }
+}
+
+GpuTextLayout::GpuTextLayout(
+    GpuAllocator& allocator,
+    PipelineCache& cache,
+    const MsdfFont& font,
+    uint32_t glyphsPerGroup,
+    uint32_t atlas)
+    : m_allocator(allocator)
+    , m_device(allocator.device())
+    , m_cache(cache)
+    , m_glyphsPerGroup(std::max(glyphsPerGroup, 1u))
+    , m_atlas(atlas)
+{
+    buildFontTable(font);
+    createLayouts();
+    createPipelines();
+    createDescriptors();
+
+    createDocumentBuffers(4096, 16, 256);
+    writeDescriptors();
+    setDocument(nullptr, 0, {});
+}
+
+GpuTextLayout::~GpuTextLayout()
+{
+    destroyDocumentBuffers();
+    m_allocator.destroyBuffer(m_font);
+
+    if (m_descPool) vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+    for (VkPipeline p : m_pipelines)
+        if (p) vkDestroyPipeline(m_device, p, nullptr);
+    if (m_layout) vkDestroyPipelineLayout(m_device, m_layout, nullptr);
+    if (m_setLayout) vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+}
+
+void GpuTextLayout::appendUtf8(std::string_view utf8, std::vector<uint32_t>& out)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(utf8.data());
+    const uint8_t* end = p + utf8.size();
+
+    out.reserve(out.size() + utf8.size());
+    while (p < end)
+    {
+        const size_t ascii = utf8AsciiPrefix(p, (size_t)(end - p));
+        out.insert(out.end(), p, p + ascii);
+        p += ascii;
+        if (p < end)
+            out.push_back(utf8DecodeOne(p, end));
+    }
+}
+
+void GpuTextLayout::buildFontTable(const MsdfFont& font)
+{
+    const uint32_t glyphCount = font.glyphCount();
+    const uint32_t sparseCount = font.sparseCount();
+    const uint32_t kernCount = font.kerningFirst() ? font.kerningPairCount() : 0;
+
+    std::vector<uint32_t> t(kHeaderWords, 0);
+
+    t[kHDirect] = (uint32_t)t.size();
+    for (uint32_t cp = 0; cp < MsdfFont::kDirectRange; ++cp)
+        t.push_back(font.directTable()[cp]);
+
+    t[kHSparseCount] = sparseCount;
+    t[kHSparseCp] = (uint32_t)t.size();
+    t.insert(t.end(), font.sparseCodepoints(), font.sparseCodepoints() + sparseCount);
+    t[kHSparseGlyph] = (uint32_t)t.size();
+    t.insert(t.end(), font.sparseGlyphs(), font.sparseGlyphs() + sparseCount);
+
+    t[kHGlyphCount] = glyphCount;
+    t[kHAdvance] = (uint32_t)t.size();
+    for (uint32_t gi = 0; gi < glyphCount; ++gi)
+        t.push_back(float_bits(font.advances()[gi]));
+
+    t[kHQuad] = (uint32_t)t.size();
+    for (uint32_t gi = 0; gi < glyphCount; ++gi)
+    {
+        const MsdfGlyphQuad& q = font.quads()[gi];
+        for (float f : { q.planeLeft, q.planeBottom, q.planeRight, q.planeTop, q.u0, q.vTop, q.u1, q.vBottom })
+            t.push_back(float_bits(f));
+    }
+
+    t[kHKernCount] = kernCount;
+    t[kHKernFirst] = (uint32_t)t.size();
+    if (kernCount > 0)
+    {
+        t.insert(t.end(), font.kerningFirst(), font.kerningFirst() + glyphCount + 1);
+        t[kHKernRight] = (uint32_t)t.size();
+        t.insert(t.end(), font.kerningRight(), font.kerningRight() + kernCount);
+        t[kHKernValue] = (uint32_t)t.size();
+        for (uint32_t i = 0; i < kernCount; ++i)
+            t.push_back(float_bits(font.kerningValues()[i]));
+    }
+
+    // как TextLayout: U+FFFD, иначе '?'
+    uint16_t fallback = font.glyphIndex(kUtf8ReplacementChar);
+    if (fallback == MsdfFont::kInvalidGlyph)
+        fallback = font.glyphIndex('?');
+    const uint16_t spaceGlyph = font.glyphIndex(' ');
+
+    t[kHFallback] = fallback;
+    t[kHSpaceGlyph] = spaceGlyph;
+    t[kHSpaceAdvance] = float_bits(spaceGlyph != MsdfFont::kInvalidGlyph ? font.advance(spaceGlyph) : 0.25f);
+
+    m_font = createBuffer(t.size() * sizeof(uint32_t), GpuMemoryUsage::Upload, "gpu text font");
+    std::memcpy(m_font.alloc.mapped, t.data(), t.size() * sizeof(uint32_t));
+    m_allocator.flush(m_font.alloc);
+
+    m_lineHeight = font.metrics().lineHeight;
+    m_ascender = font.metrics().ascender;
+    m_descender = font.metrics().descender;
+}
+
+void GpuTextLayout::createLayouts()
+{
+    VkDescriptorSetLayoutBinding b[7]{};
+    for (uint32_t i = 0; i < 7; ++i)
+    {
+        b[i].binding = i;
+        b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[i].descriptorCount = 1;
+        b[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo sl{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    sl.bindingCount = 7;
+    sl.pBindings = b;
+
+    vk_check(vkCreateDescriptorSetLayout(m_device, &sl, nullptr, &m_setLayout),
+             "vkCreateDescriptorSetLayout(gpu text layout)");
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcr.offset = 0;
+    pcr.size = sizeof(GpuTextLayoutPushConstants);
+
+    VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pl.setLayoutCount = 1;
+    pl.pSetLayouts = &m_setLayout;
+    pl.pushConstantRangeCount = 1;
+    pl.pPushConstantRanges = &pcr;
+
+    vk_check(vkCreatePipelineLayout(m_device, &pl, nullptr, &m_layout),
+             "vkCreatePipelineLayout(gpu text layout)");
+}
+
+void GpuTextLayout::createPipelines()
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    VkShaderModule compMod = create_shader_module(m_device, "msdf_text_layout.comp");
+
+    // constant_id 0 = PASS
+    uint32_t passes[4] = { 0, 1, 2, 3 };
+    VkSpecializationMapEntry entry{ 0, 0, sizeof(uint32_t) };
+    VkSpecializationInfo spec[4]{};
+    VkComputePipelineCreateInfo cp[4]{};
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        spec[i].mapEntryCount = 1;
+        spec[i].pMapEntries = &entry;
+        spec[i].dataSize = sizeof(uint32_t);
+        spec[i].pData = &passes[i];
+
+        cp[i] = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+        cp[i].stage = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+        cp[i].stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        cp[i].stage.module = compMod;
+        cp[i].stage.pName = "main";
+        cp[i].stage.pSpecializationInfo = &spec[i];
+        cp[i].layout = m_layout;
+    }
+
+    vk_check(vkCreateComputePipelines(m_device, m_cache.handle(), 4, cp, nullptr, m_pipelines),
+             "vkCreateComputePipelines(gpu text layout)");
+
+    vkDestroyShaderModule(m_device, compMod, nullptr);
+
+    const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Pipeline created (gpu text layout, 4 passes): " << createMs << " ms\n";
+}
+
+void GpuTextLayout::createDescriptors()
+{
+    VkDescriptorPoolSize ps{};
+    ps.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    ps.descriptorCount = 7;
+
+    VkDescriptorPoolCreateInfo dp{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dp.maxSets = 1;
+    dp.poolSizeCount = 1;
+    dp.pPoolSizes = &ps;
+
+    vk_check(vkCreateDescriptorPool(m_device, &dp, nullptr, &m_descPool), "vkCreateDescriptorPool(gpu text layout)");
+
+    VkDescriptorSetAllocateInfo dai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dai.descriptorPool = m_descPool;
+    dai.descriptorSetCount = 1;
+    dai.pSetLayouts = &m_setLayout;
+
+    vk_check(vkAllocateDescriptorSets(m_device, &dai, &m_set), "vkAllocateDescriptorSets(gpu text layout)");
+}
+
+void GpuTextLayout::writeDescriptors()
+{
+    const uint32_t blockCount = (m_charCapacity + kWorkgroupSize - 1) / kWorkgroupSize;
+
+    const VkDescriptorBufferInfo bi[7] = {
+        { m_font.buffer, 0, VK_WHOLE_SIZE },
+        { m_codepoints.buffer, 0, VK_WHOLE_SIZE },
+        { m_runs.buffer, 0, VK_WHOLE_SIZE },
+        { m_scratch.buffer, 0, (VkDeviceSize)m_charCapacity * 4 * sizeof(uint32_t) },
+        { m_blockSums.buffer, 0, (VkDeviceSize)blockCount * 4 * sizeof(uint32_t) },
+        instances(),
+        cullGroups(),
+    };
+
+    VkWriteDescriptorSet w[7]{};
+    for (uint32_t i = 0; i < 7; ++i)
+    {
+        w[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        w[i].dstSet = m_set;
+        w[i].dstBinding = i;
+        w[i].descriptorCount = 1;
+        w[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        w[i].pBufferInfo = &bi[i];
+    }
+
+    vkUpdateDescriptorSets(m_device, 7, w, 0, nullptr);
+}
+
+GpuBuffer GpuTextLayout::createBuffer(VkDeviceSize size, GpuMemoryUsage memory, const char* what)
+{
+    return m_allocator.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, memory, what);
+}
+
+void GpuTextLayout::createDocumentBuffers(uint32_t charCapacity, uint32_t runCapacity, uint32_t groupCapacity)
+{
+    m_charCapacity = charCapacity;
+    m_runCapacity = runCapacity;
+    m_groupCapacity = groupCapacity;
+
+    const uint32_t blockCount = (charCapacity + kWorkgroupSize - 1) / kWorkgroupSize;
+
+    m_codepoints = createBuffer((VkDeviceSize)charCapacity * sizeof(uint32_t), GpuMemoryUsage::Upload, "gpu text codepoints");
+    m_runs = createBuffer((VkDeviceSize)runCapacity * sizeof(GpuTextRunGpu), GpuMemoryUsage::Upload, "gpu text runs");
+    m_blocks = createBuffer((VkDeviceSize)runCapacity * sizeof(TextCullBlock), GpuMemoryUsage::Upload, "gpu text blocks");
+
+    m_scratch = createBuffer((VkDeviceSize)charCapacity * 4 * sizeof(uint32_t), GpuMemoryUsage::DeviceLocal, "gpu text scratch");
+    m_blockSums = createBuffer((VkDeviceSize)blockCount * 4 * sizeof(uint32_t), GpuMemoryUsage::DeviceLocal, "gpu text block sums");
+    m_instances = createBuffer(instancesSize(), GpuMemoryUsage::DeviceLocal, "gpu text instances");
+    m_groups = createBuffer((VkDeviceSize)groupCapacity * sizeof(TextCullGroup), GpuMemoryUsage::DeviceLocal, "gpu text groups");
+}
+
+void GpuTextLayout::destroyDocumentBuffers()
+{
+    for (GpuBuffer* b : { &m_codepoints, &m_runs, &m_blocks, &m_scratch, &m_blockSums, &m_instances, &m_groups })
+        m_allocator.destroyBuffer(*b);
+}
+
+void GpuTextLayout::setDocument(const uint32_t* codepoints, uint32_t count, const std::vector<GpuTextRun>& runs)
+{
+    // каждый символ — поток, workgroup'ов не больше kMaxDispatch
+    const uint32_t maxChars = kMaxDispatch * kWorkgroupSize;
+    if (count > maxChars)
+    {
+        std::cerr << "GpuTextLayout: document truncated to " << maxChars << " chars\n";
+        count = maxChars;
+    }
+
+    // буферы документа могли читаться кадрами в полёте
+    vkDeviceWaitIdle(m_device);
+
+    // run'ы, обрезанные по документу
+    std::vector<GpuTextRunGpu> gpuRuns;
+    std::vector<TextCullBlock> blocks;
+    gpuRuns.reserve(runs.size());
+    blocks.reserve(runs.size());
+
+    uint32_t groupCount = 0;
+    for (const GpuTextRun& r : runs)
+    {
+        const uint32_t first = std::min(r.firstChar, count);
+        const uint32_t n = std::min(r.charCount, count - first);
+        const TextLayoutParams& p = r.params;
+
+        GpuTextRunGpu g{};
+        g.originX = p.originX;
+        g.originY = p.originY;
+        g.scaleX = p.scaleX;
+        g.scaleY = p.scaleY;
+        g.lineStep = m_lineHeight * p.lineSpacing * p.scaleY;
+        g.firstChar = first;
+        g.charCount = n;
+        g.firstGroup = groupCount;
+        g.kerning = p.kerning ? 1u : 0u;
+        g.atlas = m_atlas;
+        gpuRuns.push_back(g);
+
+        // bbox без ширины строк (её знает только GPU): по y — точный, по x — полубесконечный
+        uint32_t lines = 1;
+        for (uint32_t i = first; i < first + n; ++i)
+            lines += codepoints[i] == '\n';
+        const float top = p.originY + m_ascender * p.scaleY;
+        const float bottom = p.originY - (float)(lines - 1) * m_lineHeight * p.lineSpacing * p.scaleY + m_descender * p.scaleY;
+
+        TextCullBlock b{};
+        b.boundsMin[0] = p.scaleX >= 0.0f ? p.originX : -1e30f;
+        b.boundsMax[0] = p.scaleX >= 0.0f ? 1e30f : p.originX;
+        b.boundsMin[1] = std::min(top, bottom);
+        b.boundsMax[1] = std::max(top, bottom);
+        b.clipMin[0] = r.clip.minX;
+        b.clipMin[1] = r.clip.minY;
+        b.clipMax[0] = r.clip.maxX;
+        b.clipMax[1] = r.clip.maxY;
+        b.firstGroup = groupCount;
+        b.groupCount = (n + m_glyphsPerGroup - 1) / m_glyphsPerGroup;
+        // считаем инстансы (с пробелами), как group.count в task shader'е:
+        // culled из compute и visible/culled из task складываются в одни счётчики
+        b.glyphCount = n;
+        blocks.push_back(b);
+
+        groupCount += b.groupCount;
+    }
+
+    const uint32_t runCount = (uint32_t)gpuRuns.size();
+    if (count > m_charCapacity || runCount > m_runCapacity || groupCount > m_groupCapacity)
+    {
+        uint32_t charCap = m_charCapacity;
+        uint32_t runCap = m_runCapacity;
+        uint32_t groupCap = m_groupCapacity;
+        while (charCap < count) charCap *= 2;
+        while (runCap < runCount) runCap *= 2;
+        while (groupCap < groupCount) groupCap *= 2;
+
+        destroyDocumentBuffers();
+        createDocumentBuffers(charCap, runCap, groupCap);
+        writeDescriptors();
+        ++m_generation;
+    }
+
+    if (count > 0)
+        std::memcpy(m_codepoints.alloc.mapped, codepoints, (size_t)count * sizeof(uint32_t));
+    if (runCount > 0)
+        std::memcpy(m_runs.alloc.mapped, gpuRuns.data(), gpuRuns.size() * sizeof(GpuTextRunGpu));
+
+    // хвост до ёмкости — пустые блоки: compute pre-pass обходит всю таблицу
+    blocks.resize(m_runCapacity, TextCullBlock{ { 1.0f, 1.0f }, { -1.0f, -1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0, 0, 0, 0 });
+    std::memcpy(m_blocks.alloc.mapped, blocks.data(), blocks.size() * sizeof(TextCullBlock));
+
+    m_allocator.flush(m_codepoints.alloc);
+    m_allocator.flush(m_runs.alloc);
+    m_allocator.flush(m_blocks.alloc);
+
+    m_charCount = count;
+    m_runCount = runCount;
+    m_groupCount = groupCount;
+    m_dirty = count > 0 && runCount > 0;
+}
+
+void GpuTextLayout::record(VkCommandBuffer cmd)
+{
+    if (!m_dirty)
+        return;
+    m_dirty = false;
+
+    // прошлые кадры могли ещё читать инстансы/группы (WAR)
+    VkMemoryBarrier before{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    before.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    before.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &before, 0, nullptr, 0, nullptr);
+
+    GpuTextLayoutPushConstants pc{};
+    pc.charCount = m_charCount;
+    pc.runCount = m_runCount;
+    pc.blockCount = (m_charCount + kWorkgroupSize - 1) / kWorkgroupSize;
+    pc.groupCount = m_groupCount;
+    pc.glyphsPerGroup = m_glyphsPerGroup;
+
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &m_set, 0, nullptr);
+    vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+
+    // 0: локальные scan'ы, 1: scan итогов workgroup'ов, 2: инстансы, 3: группы
+    const uint32_t dispatch[4] = {
+        pc.blockCount,
+        1,
+        pc.blockCount,
+        std::min((m_groupCount + kWorkgroupSize - 1) / kWorkgroupSize, kMaxDispatch),
+    };
+
+    for (uint32_t pass = 0; pass < 4; ++pass)
+    {
+        if (pass > 0)
+            compute_barrier(cmd);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[pass]);
+        vkCmdDispatch(cmd, dispatch[pass], 1, 1);
+    }
+
+    // инстансы и группы читают task/mesh shader'ы этого же кадра
+    VkMemoryBarrier after{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    after.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    after.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT, 0,
+                         1, &after, 0, nullptr, 0, nullptr);
+}
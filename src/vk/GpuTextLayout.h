@@ -0,0 +1,137 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+#include "vk/TextLayout.h"
+#include "vk/GlyphInstanceBuffer.h"
+#include "vk/TextCullTable.h"
+
+#include <vulkan/vulkan.h>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class MsdfFont;
+class PipelineCache;
+
+// Отрезок документа [firstChar, firstChar + charCount) со своим стилем и clip rect.
+// Из params используются origin, scale, lineSpacing и kerning; перенос по maxWidth
+// и выравнивание GPU layout не делает (строки рвутся только по '\n', всё влево).
+struct GpuTextRun
+{
+    uint32_t firstChar = 0;
+    uint32_t charCount = 0;
+    TextLayoutParams params{};
+    TextClipRect clip{};
+};
+
+// Совпадает с push_constant в shaders/msdf_text_layout.comp.glsl
+struct GpuTextLayoutPushConstants
+{
+    uint32_t charCount = 0;
+    uint32_t runCount = 0;
+    uint32_t blockCount = 0;
+    uint32_t groupCount = 0;
+    uint32_t glyphsPerGroup = 0;
+};
+
+// Layout больших документов (логов) на GPU: на GPU уходят code points (4 байта на символ)
+// вместо GlyphInstance (40 байт), advance'ы, переводы строк и инстансы считает
+// compute (msdf_text_layout.comp.glsl: сегментные prefix sum'ы по advance и строкам).
+//
+// Инстанс i = символ i (пробелы — вырожденные quad'ы), поэтому группы и блоки для
+// TextCullTable-совместимых таблиц известны без readback'а: блок = run, группы
+// строит тот же compute. Результат рисуется MsdfTextPipeline как обычный text.
+//
+// Документ один на все кадры: setDocument() ждёт vkDeviceWaitIdle (меняется редко),
+// record() пишет layout в командный буфер кадра, если документ изменился.
+class GpuTextLayout
+{
+public:
+    static constexpr uint32_t kWorkgroupSize = 256; // local_size_x шейдера
+
+    GpuTextLayout(
+        GpuAllocator& allocator,
+        PipelineCache& cache,
+        const MsdfFont& font,
+        uint32_t glyphsPerGroup,
+        uint32_t atlas = 0); // glyph_atlas_ref атласа font
+    ~GpuTextLayout();
+
+    GpuTextLayout(const GpuTextLayout&) = delete;
+    GpuTextLayout& operator=(const GpuTextLayout&) = delete;
+
+    // runs — по возрастанию firstChar, без пересечений; символы вне run'ов не рисуются
+    void setDocument(const uint32_t* codepoints, uint32_t count, const std::vector<GpuTextRun>& runs);
+
+    // UTF-8 -> code points (битые последовательности -> U+FFFD)
+    static void appendUtf8(std::string_view utf8, std::vector<uint32_t>& out);
+
+    bool needsLayout() const { return m_dirty; }
+
+    // Проходы layout (вне rendering); после него инстансы и группы готовы для task/mesh shader'ов
+    void record(VkCommandBuffer cmd);
+
+    // Входы MsdfTextPipeline / MsdfTextCullPipeline
+    VkDescriptorBufferInfo instances() const { return { m_instances.buffer, 0, instancesSize() }; }
+    VkDescriptorBufferInfo cullBlocks() const { return { m_blocks.buffer, 0, (VkDeviceSize)m_runCapacity * sizeof(TextCullBlock) }; }
+    VkDescriptorBufferInfo cullGroups() const { return { m_groups.buffer, 0, (VkDeviceSize)m_groupCapacity * sizeof(TextCullGroup) }; }
+    uint32_t blockCapacity() const { return m_runCapacity; }
+
+    uint32_t charCount() const { return m_charCount; }
+
+    // Растёт при пересоздании буферов: дескрипторы на них надо переписать
+    uint32_t generation() const { return m_generation; }
+
+private:
+    void buildFontTable(const MsdfFont& font);
+    void createLayouts();
+    void createPipelines();
+    void createDescriptors();
+    void writeDescriptors();
+
+    void createDocumentBuffers(uint32_t charCapacity, uint32_t runCapacity, uint32_t groupCapacity);
+    void destroyDocumentBuffers();
+    GpuBuffer createBuffer(VkDeviceSize size, GpuMemoryUsage memory, const char* what);
+
+    VkDeviceSize instancesSize() const { return (VkDeviceSize)m_charCapacity * sizeof(GlyphInstance); }
+
+private:
+    GpuAllocator& m_allocator;
+    VkDevice m_device = VK_NULL_HANDLE;
+    PipelineCache& m_cache;
+    uint32_t m_glyphsPerGroup = 32;
+    uint32_t m_atlas = 0;
+
+    // MsdfMetrics: шаг строки и bbox блоков
+    float m_lineHeight = 0.0f;
+    float m_ascender = 0.0f;
+    float m_descender = 0.0f;
+
+    // шрифт: неизменная таблица, host-visible
+    GpuBuffer m_font;
+
+    // документ: входы host-visible, всё, что считает GPU, — device-local
+    GpuBuffer m_codepoints;
+    GpuBuffer m_runs;
+    GpuBuffer m_blocks; // TextCullBlock по run'ам, хвост до ёмкости — пустые
+    GpuBuffer m_scratch;
+    GpuBuffer m_blockSums;
+    GpuBuffer m_instances;
+    GpuBuffer m_groups;
+
+    uint32_t m_charCapacity = 0;
+    uint32_t m_runCapacity = 0;
+    uint32_t m_groupCapacity = 0;
+
+    uint32_t m_charCount = 0;
+    uint32_t m_runCount = 0;
+    uint32_t m_groupCount = 0;
+    uint32_t m_generation = 0;
+    bool m_dirty = false;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipelines[4]{}; // по проходу
+    VkDescriptorPool m_descPool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+};
@@ -0,0 +1,886 @@
+#include "vk/LoopBlinnMesh.h"
+#include "vk/MsdfFont.h"
+#include "vk/TrueTypeFont.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    struct P2
+    {
+        double x, y;
+    };
+
+    P2 to_p2(TtfPoint p) { return { p.x, p.y }; }
+
+    // > 0: c слева от a->b (y вверх)
+    double orient(P2 a, P2 b, P2 c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    double loop_area(const std::vector<P2>& pts)
+    {
+        double a = 0.0;
+        for (size_t i = 0, j = pts.size() - 1; i < pts.size(); j = i++)
+            a += (pts[j].x - pts[i].x) * (pts[j].y + pts[i].y);
+        return a * 0.5; // > 0 — против часовой (y вверх)
+    }
+
+    bool point_in_loop(const std::vector<P2>& pts, P2 p)
+    {
+        bool inside = false;
+        for (size_t i = 0, j = pts.size() - 1; i < pts.size(); j = i++)
+        {
+            if ((pts[i].y > p.y) != (pts[j].y > p.y) &&
+                p.x < (pts[j].x - pts[i].x) * (p.y - pts[i].y) / (pts[j].y - pts[i].y) + pts[i].x)
+                inside = !inside;
+        }
+        return inside;
+    }
+
+    // SAT для выпуклых многоугольников (отрезок — 2 точки): true, если внутренности
+    // пересекаются глубже eps (касание по вершине/ребру — не пересечение)
+    bool convex_overlap(const P2* a, size_t na, const P2* b, size_t nb, double eps)
+    {
+        auto separated = [&](const P2* poly, size_t n) -> bool
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const P2 p = poly[i], q = poly[(i + 1) % n];
+                double nx = q.y - p.y, ny = p.x - q.x;
+                const double len = std::sqrt(nx * nx + ny * ny);
+                if (len == 0.0)
+                    continue;
+                nx /= len;
+                ny /= len;
+
+                double minA = INFINITY, maxA = -INFINITY, minB = INFINITY, maxB = -INFINITY;
+                for (size_t k = 0; k < na; ++k)
+                {
+                    const double d = a[k].x * nx + a[k].y * ny;
+                    minA = std::min(minA, d);
+                    maxA = std::max(maxA, d);
+                }
+                for (size_t k = 0; k < nb; ++k)
+                {
+                    const double d = b[k].x * nx + b[k].y * ny;
+                    minB = std::min(minB, d);
+                    maxB = std::max(maxB, d);
+                }
+                if (maxA <= minB + eps || maxB <= minA + eps)
+                    return true;
+            }
+            return false;
+        };
+        return !separated(a, na) && !separated(b, nb);
+    }
+
+    // Ear clipping многоугольника с дырками (схема earcut: мосты к дыркам, затем отрезание ушей;
+    // если ушей нет — чистка самопересечений и разрез пополам). Внешний контур — против часовой.
+    class EarClipper
+    {
+    public:
+        // loops[0] — внешний, остальные — дырки; на выход — индексы в сквозной нумерации точек loops
+        void triangulate(const std::vector<std::vector<P2>>& loops, std::vector<uint32_t>& out)
+        {
+            m_nodes.clear();
+            m_out = &out;
+
+            int outer = linkedList(loops[0], 0, true);
+            if (outer < 0 || next(outer) == prev(outer))
+                return;
+
+            uint32_t base = (uint32_t)loops[0].size();
+            std::vector<int> holes;
+            for (size_t h = 1; h < loops.size(); ++h)
+            {
+                const int list = linkedList(loops[h], base, false);
+                base += (uint32_t)loops[h].size();
+                if (list < 0)
+                    continue;
+                if (list == next(list))
+                    m_nodes[(size_t)list].steiner = true;
+                holes.push_back(leftmost(list));
+            }
+
+            std::sort(holes.begin(), holes.end(), [this](int a, int b) { return x(a) < x(b); });
+            for (int h : holes)
+                outer = eliminateHole(h, outer);
+
+            earcutLinked(outer, 0);
+        }
+
+    private:
+        struct Node
+        {
+            double x, y;
+            uint32_t i;
+            int prev, next;
+            bool steiner;
+        };
+
+        double x(int n) const { return m_nodes[(size_t)n].x; }
+        double y(int n) const { return m_nodes[(size_t)n].y; }
+        uint32_t idx(int n) const { return m_nodes[(size_t)n].i; }
+        int& next(int n) { return m_nodes[(size_t)n].next; }
+        int& prev(int n) { return m_nodes[(size_t)n].prev; }
+
+        // < 0: p, q, r против часовой
+        double area(int p, int q, int r) const
+        {
+            return (y(q) - y(p)) * (x(r) - x(q)) - (x(q) - x(p)) * (y(r) - y(q));
+        }
+
+        bool equals(int a, int b) const { return x(a) == x(b) && y(a) == y(b); }
+
+        int insertNode(uint32_t i, P2 p, int last)
+        {
+            const int n = (int)m_nodes.size();
+            m_nodes.push_back({ p.x, p.y, i, n, n, false });
+            if (last >= 0)
+            {
+                next(n) = next(last);
+                prev(n) = last;
+                prev(next(last)) = n;
+                next(last) = n;
+            }
+            return n;
+        }
+
+        void removeNode(int p)
+        {
+            next(prev(p)) = next(p);
+            prev(next(p)) = prev(p);
+        }
+
+        int linkedList(const std::vector<P2>& pts, uint32_t base, bool ccw)
+        {
+            int last = -1;
+            if (ccw == (loop_area(pts) > 0.0))
+            {
+                for (size_t k = 0; k < pts.size(); ++k)
+                    last = insertNode(base + (uint32_t)k, pts[k], last);
+            }
+            else
+            {
+                for (size_t k = pts.size(); k-- > 0;)
+                    last = insertNode(base + (uint32_t)k, pts[k], last);
+            }
+
+            if (last >= 0 && equals(last, next(last)))
+            {
+                const int n = next(last);
+                removeNode(last);
+                last = n;
+            }
+            return last;
+        }
+
+        int leftmost(int start)
+        {
+            int p = start, best = start;
+            do
+            {
+                if (x(p) < x(best) || (x(p) == x(best) && y(p) < y(best)))
+                    best = p;
+                p = next(p);
+            } while (p != start);
+            return best;
+        }
+
+        // убрать совпадающие и коллинеарные вершины
+        int filterPoints(int start, int end = -1)
+        {
+            if (start < 0)
+                return start;
+            if (end < 0)
+                end = start;
+
+            int p = start;
+            bool again = false;
+            do
+            {
+                again = false;
+                if (!m_nodes[(size_t)p].steiner && (equals(p, next(p)) || area(prev(p), p, next(p)) == 0.0))
+                {
+                    removeNode(p);
+                    p = end = prev(p);
+                    if (p == next(p))
+                        break;
+                    again = true;
+                }
+                else
+                    p = next(p);
+            } while (again || p != end);
+
+            return end;
+        }
+
+        bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py) const
+        {
+            return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+                   (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+                   (bx - px) * (cy - py) >= (cx - px) * (by - py);
+        }
+
+        bool isEar(int ear)
+        {
+            const int a = prev(ear), b = ear, c = next(ear);
+            if (area(a, b, c) >= 0.0)
+                return false; // reflex
+
+            for (int p = next(c); p != a; p = next(p))
+            {
+                if (pointInTriangle(x(a), y(a), x(b), y(b), x(c), y(c), x(p), y(p)) &&
+                    area(prev(p), p, next(p)) >= 0.0)
+                    return false;
+            }
+            return true;
+        }
+
+        void emit(int a, int b, int c)
+        {
+            m_out->push_back(idx(a));
+            m_out->push_back(idx(b));
+            m_out->push_back(idx(c));
+        }
+
+        void earcutLinked(int ear, int pass)
+        {
+            if (ear < 0)
+                return;
+
+            int stop = ear;
+            while (prev(ear) != next(ear))
+            {
+                const int p = prev(ear), n = next(ear);
+                if (isEar(ear))
+                {
+                    emit(p, ear, n);
+                    removeNode(ear);
+                    ear = stop = next(n);
+                    continue;
+                }
+
+                ear = n;
+                if (ear == stop)
+                {
+                    // ушей нет: сначала чистим вырожденные точки, потом локальные самопересечения,
+                    // в конце режем многоугольник диагональю
+                    if (pass == 0)
+                        earcutLinked(filterPoints(ear), 1);
+                    else if (pass == 1)
+                        earcutLinked(cureLocalIntersections(filterPoints(ear)), 2);
+                    else
+                        splitEarcut(ear);
+                    break;
+                }
+            }
+        }
+
+        static int sign(double v) { return (v > 0.0) - (v < 0.0); }
+
+        bool onSegment(int p, int q, int r) const
+        {
+            return x(q) <= std::max(x(p), x(r)) && x(q) >= std::min(x(p), x(r)) &&
+                   y(q) <= std::max(y(p), y(r)) && y(q) >= std::min(y(p), y(r));
+        }
+
+        bool intersects(int p1, int q1, int p2, int q2) const
+        {
+            const int o1 = sign(area(p1, q1, p2));
+            const int o2 = sign(area(p1, q1, q2));
+            const int o3 = sign(area(p2, q2, p1));
+            const int o4 = sign(area(p2, q2, q1));
+
+            if (o1 != o2 && o3 != o4) return true;
+            if (o1 == 0 && onSegment(p1, p2, q1)) return true;
+            if (o2 == 0 && onSegment(p1, q2, q1)) return true;
+            if (o3 == 0 && onSegment(p2, p1, q2)) return true;
+            if (o4 == 0 && onSegment(p2, q1, q2)) return true;
+            return false;
+        }
+
+        bool intersectsPolygon(int a, int b)
+        {
+            int p = a;
+            do
+            {
+                const int n = next(p);
+                if (idx(p) != idx(a) && idx(n) != idx(a) && idx(p) != idx(b) && idx(n) != idx(b) &&
+                    intersects(p, n, a, b))
+                    return true;
+                p = n;
+            } while (p != a);
+            return false;
+        }
+
+        bool locallyInside(int a, int b)
+        {
+            return area(prev(a), a, next(a)) < 0.0
+                ? area(a, b, next(a)) >= 0.0 && area(a, prev(a), b) >= 0.0
+                : area(a, b, prev(a)) < 0.0 || area(a, next(a), b) < 0.0;
+        }
+
+        bool middleInside(int a, int b)
+        {
+            const double px = (x(a) + x(b)) * 0.5, py = (y(a) + y(b)) * 0.5;
+            bool inside = false;
+            int p = a;
+            do
+            {
+                const int n = next(p);
+                if ((y(p) > py) != (y(n) > py) && y(n) != y(p) &&
+                    px < (x(n) - x(p)) * (py - y(p)) / (y(n) - y(p)) + x(p))
+                    inside = !inside;
+                p = n;
+            } while (p != a);
+            return inside;
+        }
+
+        bool isValidDiagonal(int a, int b)
+        {
+            return idx(next(a)) != idx(b) && idx(prev(a)) != idx(b) && !intersectsPolygon(a, b) &&
+                   ((locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b) &&
+                     (area(prev(a), a, prev(b)) != 0.0 || area(a, prev(b), b) != 0.0)) ||
+                    (equals(a, b) && area(prev(a), a, next(a)) > 0.0 && area(prev(b), b, next(b)) > 0.0));
+        }
+
+        // диагональ a-b: два кольца, возвращает копию b во втором
+        int splitPolygon(int a, int b)
+        {
+            const int a2 = insertNode(idx(a), { x(a), y(a) }, -1);
+            const int b2 = insertNode(idx(b), { x(b), y(b) }, -1);
+            const int an = next(a);
+            const int bp = prev(b);
+
+            next(a) = b;
+            prev(b) = a;
+
+            next(a2) = an;
+            prev(an) = a2;
+
+            next(b2) = a2;
+            prev(a2) = b2;
+
+            next(bp) = b2;
+            prev(b2) = bp;
+
+            return b2;
+        }
+
+        int cureLocalIntersections(int start)
+        {
+            int p = start;
+            do
+            {
+                const int a = prev(p), b = next(next(p));
+                if (!equals(a, b) && intersects(a, p, next(p), b) && locallyInside(a, b) && locallyInside(b, a))
+                {
+                    emit(a, p, b);
+                    removeNode(p);
+                    removeNode(next(p));
+                    p = start = b;
+                }
+                p = next(p);
+            } while (p != start);
+
+            return filterPoints(p);
+        }
+
+        void splitEarcut(int start)
+        {
+            int a = start;
+            do
+            {
+                for (int b = next(next(a)); b != prev(a); b = next(b))
+                {
+                    if (idx(a) != idx(b) && isValidDiagonal(a, b))
+                    {
+                        int c = splitPolygon(a, b);
+                        a = filterPoints(a, next(a));
+                        c = filterPoints(c, next(c));
+                        earcutLinked(a, 0);
+                        earcutLinked(c, 0);
+                        return;
+                    }
+                }
+                a = next(a);
+            } while (a != start);
+        }
+
+        bool sectorContainsSector(int m, int p)
+        {
+            return area(prev(m), m, prev(p)) < 0.0 && area(next(p), m, next(m)) < 0.0;
+        }
+
+        // вершина внешнего кольца, видимая из самой левой точки дырки (луч влево)
+        int findHoleBridge(int hole, int outer)
+        {
+            const double hx = x(hole), hy = y(hole);
+            double qx = -INFINITY;
+            int m = -1;
+
+            int p = outer;
+            do
+            {
+                const int n = next(p);
+                if (hy <= y(p) && hy >= y(n) && y(n) != y(p))
+                {
+                    const double ix = x(p) + (hy - y(p)) * (x(n) - x(p)) / (y(n) - y(p));
+                    if (ix <= hx && ix > qx)
+                    {
+                        qx = ix;
+                        m = x(p) < x(n) ? p : n;
+                        if (ix == hx)
+                            return m;
+                    }
+                }
+                p = n;
+            } while (p != outer);
+
+            if (m < 0)
+                return -1;
+
+            // ближайшая к лучу вершина внутри треугольника (hole, точка пересечения, m)
+            const int stop = m;
+            const double mx = x(m), my = y(m);
+            double tanMin = INFINITY;
+
+            p = m;
+            do
+            {
+                if (hx >= x(p) && x(p) >= mx && hx != x(p) &&
+                    pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, x(p), y(p)))
+                {
+                    const double tan = std::fabs(hy - y(p)) / (hx - x(p));
+                    if (locallyInside(p, hole) &&
+                        (tan < tanMin || (tan == tanMin && (x(p) > x(m) || (x(p) == x(m) && sectorContainsSector(m, p))))))
+                    {
+                        m = p;
+                        tanMin = tan;
+                    }
+                }
+                p = next(p);
+            } while (p != stop);
+
+            return m;
+        }
+
+        int eliminateHole(int hole, int outer)
+        {
+            const int bridge = findHoleBridge(hole, outer);
+            if (bridge < 0)
+                return outer;
+
+            const int bridgeReverse = splitPolygon(bridge, hole);
+            filterPoints(bridgeReverse, next(bridgeReverse));
+            return filterPoints(bridge, next(bridge));
+        }
+
+    private:
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t>* m_out = nullptr;
+    };
+
+    struct Seg
+    {
+        P2 p0, c, p1;
+        bool curve;
+    };
+
+    // хорда почти совпадает с кривой: треугольник нулевой площади не нужен
+    bool nearly_flat(const Seg& s)
+    {
+        const double dx = s.p1.x - s.p0.x, dy = s.p1.y - s.p0.y;
+        return std::fabs(orient(s.p0, s.p1, s.c)) <= 1e-6 * (dx * dx + dy * dy);
+    }
+
+    constexpr double kOverlapEps = 1e-7; // em
+    constexpr uint32_t kMaxSubdivisionRounds = 5;
+}
+
+void LoopBlinnMesh::addEmptyGlyph(uint32_t codepoint)
+{
+    LoopBlinnGlyph glyph{};
+    glyph.firstMeshlet = (uint32_t)m_meshlets.size();
+    glyph.codepoint = codepoint;
+    m_glyphs.push_back(glyph);
+}
+
+void LoopBlinnMesh::appendMeshlets(LoopBlinnGlyph& glyph, const std::vector<SourceTriangle>& tris)
+{
+    glyph.firstMeshlet = (uint32_t)m_meshlets.size();
+    glyph.meshletCount = 0;
+    glyph.triangleCount = (uint32_t)tris.size();
+
+    LoopBlinnMeshlet ml{};
+    auto flush = [&]()
+    {
+        if (ml.triangleCount == 0)
+            return;
+        m_meshlets.push_back(ml);
+        ++glyph.meshletCount;
+        ml = {};
+    };
+
+    // ищет вершину meshlet'а под угол; Any подходит под любой угол и уточняется при совпадении
+    auto findVertex = [&](uint32_t position, Corner corner) -> int
+    {
+        for (uint32_t v = 0; v < ml.vertexCount; ++v)
+        {
+            const uint32_t packed = m_vertices[ml.vertexOffset + v];
+            if (packed >> 2 != position)
+                continue;
+
+            const Corner have = (Corner)(packed & 3u);
+            if (corner == Corner::Any || have == corner || have == Corner::Any)
+                return (int)v;
+        }
+        return -1;
+    };
+
+    ml.vertexOffset = (uint32_t)m_vertices.size();
+    ml.triangleOffset = (uint32_t)m_triangles.size();
+
+    for (const SourceTriangle& t : tris)
+    {
+        const uint32_t pos[3] = { t.a, t.b, t.c };
+        Corner corners[3] = { Corner::Start, Corner::Control, Corner::End };
+        if (t.type == LoopBlinnPrim::Solid)
+            corners[0] = corners[1] = corners[2] = Corner::Any;
+
+        uint32_t missing = 0;
+        for (int k = 0; k < 3; ++k)
+            missing += findVertex(pos[k], corners[k]) < 0 ? 1u : 0u;
+
+        if (ml.vertexCount + missing > kMaxMeshletVertices || ml.triangleCount == kMaxMeshletTriangles)
+        {
+            flush();
+            ml.vertexOffset = (uint32_t)m_vertices.size();
+            ml.triangleOffset = (uint32_t)m_triangles.size();
+        }
+
+        uint32_t local[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            const int v = findVertex(pos[k], corners[k]);
+            if (v >= 0)
+            {
+                local[k] = (uint32_t)v;
+                if (corners[k] != Corner::Any)
+                    m_vertices[ml.vertexOffset + (uint32_t)v] = packVertex(pos[k], corners[k]);
+            }
+            else
+            {
+                local[k] = ml.vertexCount++;
+                m_vertices.push_back(packVertex(pos[k], corners[k]));
+            }
+        }
+
+        m_triangles.push_back(packTriangle(local[0], local[1], local[2], t.type));
+        ++ml.triangleCount;
+    }
+    flush();
+}
+
+bool LoopBlinnMesh::addGlyph(uint32_t codepoint, const TtfOutline& outline, const float frameMin[2], const float frameMax[2])
+{
+    // контуры -> отрезки; направление приводим к «заливка слева» (внешние — против часовой)
+    std::vector<std::vector<Seg>> contours;
+    double total = 0.0;
+    for (const TtfContour& tc : outline.contours)
+    {
+        std::vector<Seg> segs;
+        for (const TtfSegment& ts : tc.segments)
+        {
+            Seg s{ to_p2(ts.p0), to_p2(ts.c), to_p2(ts.p1), ts.curve };
+            if (s.curve && nearly_flat(s))
+                s.curve = false;
+            if (!s.curve && s.p0.x == s.p1.x && s.p0.y == s.p1.y)
+                continue;
+            segs.push_back(s);
+
+            // площадь по ломаной p0 -> c -> p1: хватает для знака
+            total += orient({ 0.0, 0.0 }, s.p0, s.curve ? s.c : s.p1);
+            if (s.curve)
+                total += orient({ 0.0, 0.0 }, s.c, s.p1);
+        }
+        if (segs.size() >= 2 || (segs.size() == 1 && segs[0].curve))
+            contours.push_back(std::move(segs));
+    }
+    if (contours.empty())
+        return false;
+
+    if (total < 0.0) // TrueType: по часовой
+    {
+        for (std::vector<Seg>& segs : contours)
+        {
+            std::reverse(segs.begin(), segs.end());
+            for (Seg& s : segs)
+                std::swap(s.p0, s.p1);
+        }
+    }
+
+    // c справа от хорды — снаружи заливки
+    auto convex = [](const Seg& s) { return orient(s.p0, s.p1, s.c) < 0.0; };
+
+    // Треугольники кривых не должны перекрываться между собой и с другими отрезками контура
+    // (иначе хорды/контрольные точки ломают многоугольник): такие кривые делим пополам
+    for (uint32_t round = 0; round < kMaxSubdivisionRounds; ++round)
+    {
+        std::vector<const Seg*> all;
+        for (const std::vector<Seg>& segs : contours)
+            for (const Seg& s : segs)
+                all.push_back(&s);
+
+        std::vector<bool> split(all.size(), false);
+        bool any = false;
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            if (!all[i]->curve)
+                continue;
+
+            const P2 tri[3] = { all[i]->p0, all[i]->c, all[i]->p1 };
+            for (size_t j = 0; j < all.size() && !split[i]; ++j)
+            {
+                if (j == i)
+                    continue;
+
+                const Seg& o = *all[j];
+                const P2 other[3] = { o.p0, o.c, o.p1 };
+                const P2 edge[2] = { o.p0, o.p1 };
+                split[i] = o.curve ? convex_overlap(tri, 3, other, 3, kOverlapEps)
+                                   : convex_overlap(tri, 3, edge, 2, kOverlapEps);
+            }
+            any = any || split[i];
+        }
+        if (!any)
+            break;
+
+        size_t k = 0;
+        for (std::vector<Seg>& segs : contours)
+        {
+            std::vector<Seg> next;
+            next.reserve(segs.size() * 2);
+            for (const Seg& s : segs)
+            {
+                if (!split[k++])
+                {
+                    next.push_back(s);
+                    continue;
+                }
+
+                // de Casteljau, t = 0.5
+                const P2 a{ (s.p0.x + s.c.x) * 0.5, (s.p0.y + s.c.y) * 0.5 };
+                const P2 b{ (s.c.x + s.p1.x) * 0.5, (s.c.y + s.p1.y) * 0.5 };
+                const P2 m{ (a.x + b.x) * 0.5, (a.y + b.y) * 0.5 };
+                Seg first{ s.p0, a, m, true };
+                Seg second{ m, b, s.p1, true };
+                first.curve = !nearly_flat(first);
+                second.curve = !nearly_flat(second);
+                next.push_back(first);
+                next.push_back(second);
+                ++m_subdivided;
+            }
+            segs = std::move(next);
+        }
+    }
+
+    const size_t positionsBefore = m_positions.size();
+    std::vector<SourceTriangle> tris;
+    auto addPosition = [this](P2 p)
+    {
+        m_positions.push_back({ (float)p.x, (float)p.y });
+        return (uint32_t)m_positions.size() - 1;
+    };
+    auto addTriangle = [&tris](uint32_t a, uint32_t b, uint32_t c, LoopBlinnPrim type)
+    {
+        tris.push_back({ a, b, c, type });
+    };
+
+    // многоугольник контура: p0 каждого отрезка + c вогнутых кривых; у выпуклых — хорда
+    std::vector<std::vector<P2>> loops;
+    std::vector<std::vector<uint32_t>> loopIndices;
+    for (const std::vector<Seg>& segs : contours)
+    {
+        std::vector<P2> pts;
+        std::vector<uint32_t> ids;
+        std::vector<uint32_t> segStart;
+        for (const Seg& s : segs)
+        {
+            segStart.push_back((uint32_t)pts.size());
+            pts.push_back(s.p0);
+            ids.push_back(addPosition(s.p0));
+            if (s.curve && !convex(s))
+            {
+                pts.push_back(s.c);
+                ids.push_back(addPosition(s.c));
+            }
+        }
+
+        for (size_t k = 0; k < segs.size(); ++k)
+        {
+            const Seg& s = segs[k];
+            if (!s.curve)
+                continue;
+
+            const uint32_t p0 = ids[segStart[k]];
+            const uint32_t p1 = ids[segStart[(k + 1) % segs.size()]];
+            if (convex(s))
+                addTriangle(p0, addPosition(s.c), p1, LoopBlinnPrim::Convex);
+            else
+                addTriangle(p0, ids[segStart[k] + 1], p1, LoopBlinnPrim::Concave);
+        }
+
+        if (pts.size() >= 3)
+        {
+            loops.push_back(std::move(pts));
+            loopIndices.push_back(std::move(ids));
+        }
+    }
+
+    // внешние (против часовой) и дырки; дырка — к наименьшему внешнему, который её содержит
+    std::vector<double> areas(loops.size());
+    for (size_t i = 0; i < loops.size(); ++i)
+        areas[i] = loop_area(loops[i]);
+
+    std::vector<std::vector<size_t>> groups(loops.size());
+    for (size_t h = 0; h < loops.size(); ++h)
+    {
+        if (areas[h] >= 0.0)
+            continue;
+
+        size_t best = SIZE_MAX;
+        for (size_t o = 0; o < loops.size(); ++o)
+        {
+            if (areas[o] <= 0.0 || areas[o] < -areas[h] || !point_in_loop(loops[o], loops[h][0]))
+                continue;
+            if (best == SIZE_MAX || areas[o] < areas[best])
+                best = o;
+        }
+        if (best != SIZE_MAX)
+            groups[best].push_back(h);
+    }
+
+    EarClipper clipper;
+    std::vector<uint32_t> local;
+    for (size_t o = 0; o < loops.size(); ++o)
+    {
+        if (areas[o] <= 0.0)
+            continue;
+
+        std::vector<std::vector<P2>> ring{ loops[o] };
+        std::vector<uint32_t> ids = loopIndices[o];
+        for (size_t h : groups[o])
+        {
+            ring.push_back(loops[h]);
+            ids.insert(ids.end(), loopIndices[h].begin(), loopIndices[h].end());
+        }
+
+        local.clear();
+        clipper.triangulate(ring, local);
+        for (size_t t = 0; t + 2 < local.size(); t += 3)
+            addTriangle(ids[local[t]], ids[local[t + 1]], ids[local[t + 2]], LoopBlinnPrim::Solid);
+    }
+
+    if (tris.empty())
+    {
+        m_positions.resize(positionsBefore);
+        addEmptyGlyph(codepoint);
+        return false;
+    }
+
+    LoopBlinnGlyph glyph{};
+    glyph.frameMin[0] = frameMin[0];
+    glyph.frameMin[1] = frameMin[1];
+    glyph.frameMax[0] = frameMax[0];
+    glyph.frameMax[1] = frameMax[1];
+    glyph.codepoint = codepoint;
+    appendMeshlets(glyph, tris);
+    m_glyphs.push_back(glyph);
+    return true;
+}
+
+LoopBlinnMesh LoopBlinnMesh::build(const TrueTypeFont& ttf, const MsdfFont& msdf)
+{
+    LoopBlinnMesh mesh;
+    TtfOutline outline;
+
+    for (uint32_t gi = 0; gi < msdf.glyphCount(); ++gi)
+    {
+        const MsdfGlyph& g = msdf.glyph((uint16_t)gi);
+        const uint32_t glyph = ttf.glyphIndex(g.codepoint);
+        if (glyph == 0 || !ttf.outline(glyph, outline) || outline.empty())
+        {
+            mesh.addEmptyGlyph(g.codepoint);
+            continue;
+        }
+
+        float frameMin[2] = { outline.min.x, outline.min.y };
+        float frameMax[2] = { outline.max.x, outline.max.y };
+        if (g.hasPlane)
+        {
+            frameMin[0] = g.plane.left;
+            frameMin[1] = g.plane.bottom;
+            frameMax[0] = g.plane.right;
+            frameMax[1] = g.plane.top;
+        }
+        mesh.addGlyph(g.codepoint, outline, frameMin, frameMax);
+    }
+    return mesh;
+}
+
+LoopBlinnMesh LoopBlinnMesh::parenthesis(const MsdfFont& msdf)
+{
+    LoopBlinnMesh mesh;
+
+    mesh.m_positions = {
+        {+0.000f, -1.00f},
+        {+0.150f, -0.50f},
+        {+0.150f, +0.00f},
+        {+0.150f, +0.50f},
+        {+0.000f, +1.00f},
+        {-0.300f, +1.00f},
+        {-0.165f, +0.50f},
+        {-0.165f, +0.00f},
+        {-0.165f, -0.50f},
+        {-0.300f, -1.00f},
+    };
+
+    const std::vector<SourceTriangle> tris = {
+        {0, 1, 2, LoopBlinnPrim::Convex},
+        {2, 3, 4, LoopBlinnPrim::Convex},
+        {5, 6, 7, LoopBlinnPrim::Concave},
+        {7, 8, 9, LoopBlinnPrim::Concave},
+        {4, 5, 6, LoopBlinnPrim::Solid},
+        {4, 6, 2, LoopBlinnPrim::Solid},
+        {6, 7, 2, LoopBlinnPrim::Solid},
+        {7, 8, 2, LoopBlinnPrim::Solid},
+        {2, 8, 0, LoopBlinnPrim::Solid},
+        {9, 0, 8, LoopBlinnPrim::Solid},
+    };
+
+    const uint16_t paren = msdf.glyphIndex(')');
+    for (uint32_t gi = 0; gi < msdf.glyphCount(); ++gi)
+    {
+        if (gi != paren)
+        {
+            mesh.addEmptyGlyph(msdf.glyph((uint16_t)gi).codepoint);
+            continue;
+        }
+
+        LoopBlinnGlyph g{};
+        g.frameMin[0] = -0.300f;
+        g.frameMin[1] = -1.0f;
+        g.frameMax[0] = +0.150f;
+        g.frameMax[1] = +1.0f;
+        g.codepoint = ')';
+        mesh.appendMeshlets(g, tris);
+        mesh.m_glyphs.push_back(g);
+    }
+    return mesh;
+}
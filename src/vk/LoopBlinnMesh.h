@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TrueTypeFont;
+class MsdfFont;
+struct TtfOutline;
+
+// Тип треугольника для lb_glyphlets.frag.glsl (y = u² - v по UV углов (0,0), (0.5,0), (1,1))
+enum class LoopBlinnPrim : uint32_t
+{
+    Solid = 0,   // внутренность контура, без отсечения
+    Convex = 1,  // (p0, c, p1), c снаружи заливки: остаётся сторона хорды (y <= 0)
+    Concave = 2, // (p0, c, p1), c внутри заливки: остаётся сторона c (y >= 0)
+};
+
+// Meshlet: кусок глифа с общими вершинами (std430, 16 байт; LbMeshlet в lb_glyphlets.mesh.glsl)
+struct LoopBlinnMeshlet
+{
+    uint32_t vertexOffset = 0;   // в vertices()
+    uint32_t triangleOffset = 0; // в triangles()
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+};
+
+// Запись глифа в таблице (std430, 32 байта; LbGlyph в lb_glyphlets.{task,mesh}.glsl)
+struct LoopBlinnGlyph
+{
+    float frameMin[2] = { 0.0f, 0.0f }; // em: прямоугольник, который растягивается в quad инстанса
+    float frameMax[2] = { 0.0f, 0.0f };
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0; // 0 — глифа нет (пробел, нет контура)
+    uint32_t codepoint = 0;
+    uint32_t triangleCount = 0;
+};
+
+// Геометрия Loop–Blinn для набора глифов в общих массивах (SSBO lb_glyphlets.mesh.glsl):
+// внутренность контуров — SOLID треугольники (ear clipping с дырками), каждая квадратичная
+// Безье — свой CONVEX/CONCAVE треугольник.
+//
+// Треугольники глифа режутся на meshlet'ы (<= kMaxMeshletVertices вершин, <= kMaxMeshletTriangles
+// треугольников): у meshlet'а свой список вершин без повторов, треугольник — три 8-битных
+// локальных индекса и тип в одном uint. Вершина — индекс позиции и угол треугольника кривой
+// (UV Loop–Blinn); SOLID треугольникам UV не нужны, они берут любую вершину с той же позицией.
+//
+// Таблица глифов индексируется glyph index'ом MsdfFont — тем же, что лежит в GlyphInstance::glyph.
+class LoopBlinnMesh
+{
+public:
+    static constexpr uint32_t kMaxMeshletVertices = 64;
+    static constexpr uint32_t kMaxMeshletTriangles = 124;
+
+    // Угол вершины: UV (0,0), (0.5,0), (1,1); Any — только у SOLID треугольников
+    enum class Corner : uint32_t
+    {
+        Start = 0,
+        Control = 1,
+        End = 2,
+        Any = 3,
+    };
+
+    // vertices(): позиция << 2 | Corner
+    static uint32_t packVertex(uint32_t position, Corner corner) { return position << 2 | (uint32_t)corner; }
+
+    // triangles(): a | b << 8 | c << 16 | LoopBlinnPrim << 24 (a, b, c — в вершинах meshlet'а)
+    static uint32_t packTriangle(uint32_t a, uint32_t b, uint32_t c, LoopBlinnPrim type)
+    {
+        return a | b << 8 | c << 16 | (uint32_t)type << 24;
+    }
+
+    struct Position
+    {
+        float x, y;
+    };
+
+    // Все глифы MSDF шрифта (по glyph index), контуры — из ttf; frame — planeBounds MSDF глифа,
+    // чтобы контур лёг в тот же quad, что строит TextLayout. Глифы без контура — пустые записи.
+    static LoopBlinnMesh build(const TrueTypeFont& ttf, const MsdfFont& msdf);
+
+    // ")" из статьи Loop–Blinn без шрифта: на месте глифа ')' MSDF шрифта, остальные пустые
+    static LoopBlinnMesh parenthesis(const MsdfFont& msdf);
+
+    // Добавить глиф (контуры в em) следующей записью таблицы; false — ни одного треугольника
+    // (запись всё равно добавлена, пустая)
+    bool addGlyph(uint32_t codepoint, const TtfOutline& outline, const float frameMin[2], const float frameMax[2]);
+
+    const std::vector<Position>& positions() const { return m_positions; }
+    const std::vector<uint32_t>& vertices() const { return m_vertices; }
+    const std::vector<uint32_t>& triangles() const { return m_triangles; }
+    const std::vector<LoopBlinnMeshlet>& meshlets() const { return m_meshlets; }
+    const std::vector<LoopBlinnGlyph>& glyphs() const { return m_glyphs; }
+
+    // есть хотя бы один непустой глиф
+    bool empty() const { return m_meshlets.empty(); }
+
+    // Кривые, разбитые пополам из-за пересечения треугольников (статистика build())
+    uint32_t subdividedCurves() const { return m_subdivided; }
+
+private:
+    struct SourceTriangle
+    {
+        uint32_t a, b, c; // в m_positions
+        LoopBlinnPrim type;
+    };
+
+    // жадно: треугольники по порядку, новый meshlet — когда не влезают вершины/треугольники
+    void appendMeshlets(LoopBlinnGlyph& glyph, const std::vector<SourceTriangle>& tris);
+
+    // пустая запись таблицы (по glyph index)
+    void addEmptyGlyph(uint32_t codepoint);
+
+private:
+    std::vector<Position> m_positions;
+    std::vector<uint32_t> m_vertices;
+    std::vector<uint32_t> m_triangles;
+    std::vector<LoopBlinnMeshlet> m_meshlets;
+    std::vector<LoopBlinnGlyph> m_glyphs;
+    uint32_t m_subdivided = 0;
+};
@@ -1,38 +1,12 @@
 #include "vk/MeshTestPipeline.h"
+#include "vk/PipelineCache.h"
 #include "vk/VulkanUtils.h"
 
-#include <fstream>
-#include <vector>
-#include <string>
+#include <chrono>
 #include <iostream>
 
-static std::vector<uint32_t> read_spv_u32(const std::string& path)
-{
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) { std::cerr << "Failed to open SPV: " << path << "\n"; std::exit(EXIT_FAILURE); }
-
-    const std::streamsize size = file.tellg();
-    if (size <= 0 || (size % 4) != 0) { std::cerr << "Invalid SPV size: " << path << "\n"; std::exit(EXIT_FAILURE); }
-
-    std::vector<uint32_t> data((size_t)size / 4);
-    file.seekg(0, std::ios::beg);
-    file.read(reinterpret_cast<char*>(data.data()), size);
-    return data;
-}
-
-static VkShaderModule create_shader_module(VkDevice device, const std::vector<uint32_t>& code)
-{
-    VkShaderModuleCreateInfo ci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-    ci.codeSize = code.size() * sizeof(uint32_t);
-    ci.pCode = code.data();
-
-    VkShaderModule mod = VK_NULL_HANDLE;
-    vk_check(vkCreateShaderModule(device, &ci, nullptr, &mod), "vkCreateShaderModule");
-    return mod;
-}
-
-MeshTestPipeline::MeshTestPipeline(VkDevice device, VkFormat colorFormat)
-    : m_device(device), m_colorFormat(colorFormat)
+MeshTestPipeline::MeshTestPipeline(VkDevice device, PipelineCache& cache, VkFormat colorFormat)
+    : m_device(device), m_cache(cache), m_colorFormat(colorFormat)
 {
     createLayouts();
     createPipeline();
@@ -68,27 +42,37 @@ void MeshTestPipeline::recreate(VkFormat colorFormat)
 
 void MeshTestPipeline::createLayouts()
 {
-    // 4 storage buffers, mesh stage only
-    VkDescriptorSetLayoutBinding b[4]{};
+    // 6 storage buffers: positions, meshlet vertices, meshlet triangles, instances, glyphs, meshlets.
+    // instances и glyphs читает и task shader (число meshlet'ов инстанса)
+    VkDescriptorSetLayoutBinding b[6]{};
 
-    for (int i = 0; i < 4; ++i)
+    for (int i = 0; i < 6; ++i)
     {
         b[i].binding = (uint32_t)i;
         b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         b[i].descriptorCount = 1;
         b[i].stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT;
     }
+    b[3].stageFlags |= VK_SHADER_STAGE_TASK_BIT_EXT;
+    b[4].stageFlags |= VK_SHADER_STAGE_TASK_BIT_EXT;
 
     VkDescriptorSetLayoutCreateInfo sl{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-    sl.bindingCount = 4;
+    sl.bindingCount = 6;
     sl.pBindings = b;
 
     vk_check(vkCreateDescriptorSetLayout(m_device, &sl, nullptr, &m_setLayout),
              "vkCreateDescriptorSetLayout");
 
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT;
+    pcr.offset = 0;
+    pcr.size = sizeof(LbGlyphletPushConstants);
+
     VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
     pl.setLayoutCount = 1;
     pl.pSetLayouts = &m_setLayout;
+    pl.pushConstantRangeCount = 1;
+    pl.pPushConstantRanges = &pcr;
 
     vk_check(vkCreatePipelineLayout(m_device, &pl, nullptr, &m_layout),
              "vkCreatePipelineLayout");
@@ -96,27 +80,28 @@ void MeshTestPipeline::createLayouts()
 
 void MeshTestPipeline::createPipeline()
 {
-    const std::string base = std::string(APP_SHADER_DIR);
-    const std::string meshPath = base + "/lb_glyphlets.mesh.spv";
-    const std::string fragPath = base + "/lb_glyphlets.frag.spv";
+    const auto t0 = std::chrono::steady_clock::now();
 
-    auto meshCode = read_spv_u32(meshPath);
-    auto fragCode = read_spv_u32(fragPath);
+    VkShaderModule taskMod = create_shader_module(m_device, "lb_glyphlets.task");
+    VkShaderModule meshMod = create_shader_module(m_device, "lb_glyphlets.mesh");
+    VkShaderModule fragMod = create_shader_module(m_device, "lb_glyphlets.frag");
 
-    VkShaderModule meshMod = create_shader_module(m_device, meshCode);
-    VkShaderModule fragMod = create_shader_module(m_device, fragCode);
-
-    VkPipelineShaderStageCreateInfo stages[2]{};
+    VkPipelineShaderStageCreateInfo stages[3]{};
     stages[0] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
-    stages[0].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
-    stages[0].module = meshMod;
+    stages[0].stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+    stages[0].module = taskMod;
     stages[0].pName = "main";
 
     stages[1] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
-    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stages[1].module = fragMod;
+    stages[1].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+    stages[1].module = meshMod;
     stages[1].pName = "main";
 
+    stages[2] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    stages[2].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[2].module = fragMod;
+    stages[2].pName = "main";
+
     VkPipelineVertexInputStateCreateInfo vi{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
 
     VkPipelineInputAssemblyStateCreateInfo ia{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
@@ -156,7 +141,7 @@ void MeshTestPipeline::createPipeline()
 
     VkGraphicsPipelineCreateInfo gp{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
     gp.pNext = &rendering;
-    gp.stageCount = 2;
+    gp.stageCount = 3;
     gp.pStages = stages;
     gp.pVertexInputState = &vi;
     gp.pInputAssemblyState = &ia;
@@ -169,9 +154,13 @@ void MeshTestPipeline::createPipeline()
     gp.renderPass = VK_NULL_HANDLE;
     gp.subpass = 0;
 
-    vk_check(vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &gp, nullptr, &m_pipeline),
+    vk_check(vkCreateGraphicsPipelines(m_device, m_cache.handle(), 1, &gp, nullptr, &m_pipeline),
              "vkCreateGraphicsPipelines(loop-blinn)");
 
     vkDestroyShaderModule(m_device, fragMod, nullptr);
     vkDestroyShaderModule(m_device, meshMod, nullptr);
+    vkDestroyShaderModule(m_device, taskMod, nullptr);
+
+    const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Pipeline created (loop-blinn): " << createMs << " ms\n";
 }
@@ -1,10 +1,20 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <cstdint>
+
+class PipelineCache;
+
+// Совпадает с push_constant в shaders/lb_glyphlets.task.glsl
+struct LbGlyphletPushConstants
+{
+    uint32_t instanceCount = 0;
+    uint32_t glyphCount = 0; // записей в таблице глифов (binding 4)
+};
 
 class MeshTestPipeline
 {
 public:
-    MeshTestPipeline(VkDevice device, VkFormat colorFormat);
+    MeshTestPipeline(VkDevice device, PipelineCache& cache, VkFormat colorFormat);
     ~MeshTestPipeline();
 
     MeshTestPipeline(const MeshTestPipeline&) = delete;
@@ -24,6 +34,7 @@ private:
 
 private:
     VkDevice m_device = VK_NULL_HANDLE;
+    PipelineCache& m_cache;
     VkFormat m_colorFormat = VK_FORMAT_UNDEFINED;
 
     VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
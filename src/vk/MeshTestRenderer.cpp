@@ -1,11 +1,17 @@
 #include "vk/MeshTestRenderer.h"
 #include "vk/MeshTestPipeline.h"
 #include "vk/Swapchain.h"
-
+#include "vk/GlyphInstanceBuffer.h"
+#include "vk/GpuTextLayout.h"
+#include "vk/LoopBlinnMesh.h"
+#include "vk/DynamicGlyphAtlas.h"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
 #include <vector>
 #include <iostream>
 #include <cstdlib>
-#include <cstring>
 
 namespace
 {
@@ -18,50 +24,6 @@ namespace
         }
     }
 
-    uint32_t lbFindMemoryType(VkPhysicalDevice phys, uint32_t typeBits, VkMemoryPropertyFlags props)
-    {
-        VkPhysicalDeviceMemoryProperties mp{};
-        vkGetPhysicalDeviceMemoryProperties(phys, &mp);
-
-        for (uint32_t i = 0; i < mp.memoryTypeCount; ++i)
-        {
-            if ((typeBits & (1u << i)) && ((mp.memoryTypes[i].propertyFlags & props) == props))
-                return i;
-        }
-
-        std::cerr << "Failed to find suitable memory type\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-    void lbCreateBuffer(VkPhysicalDevice phys, VkDevice dev, VkDeviceSize size,
-                        VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
-                        VkBuffer& buf, VkDeviceMemory& mem)
-    {
-        VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        bci.size = size;
-        bci.usage = usage;
-        bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        VK_CHECK(vkCreateBuffer(dev, &bci, nullptr, &buf), "vkCreateBuffer");
-
-        VkMemoryRequirements mr{};
-        vkGetBufferMemoryRequirements(dev, buf, &mr);
-
-        VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        mai.allocationSize = mr.size;
-        mai.memoryTypeIndex = lbFindMemoryType(phys, mr.memoryTypeBits, props);
-
-        VK_CHECK(vkAllocateMemory(dev, &mai, nullptr, &mem), "vkAllocateMemory");
-        VK_CHECK(vkBindBufferMemory(dev, buf, mem, 0), "vkBindBufferMemory");
-    }
-
-    void lbUploadToMemory(VkDevice dev, VkDeviceMemory mem, const void* data, size_t size)
-    {
-        void* mapped = nullptr;
-        VK_CHECK(vkMapMemory(dev, mem, 0, (VkDeviceSize)size, 0, &mapped), "vkMapMemory");
-        std::memcpy(mapped, data, size);
-        vkUnmapMemory(dev, mem);
-    }
-
     void barrierImage(VkCommandBuffer cmd, VkImage img,
                       VkImageLayout oldLayout, VkImageLayout newLayout,
                       VkAccessFlags srcAccess, VkAccessFlags dstAccess,
@@ -86,50 +48,68 @@ namespace
                              1, &b);
     }
 
-    // std430: array of uvec3 имеет stride 16, поэтому в C++ делаем padding до 16 байт
-    struct alignas(16) UVec3Std430
-    {
-        uint32_t x, y, z, pad;
-    };
-
-    struct Vec2 { float x, y; };
 }
 
 MeshTestRenderer::MeshTestRenderer(
-    VkPhysicalDevice phys,
-    VkDevice device,
+    GpuAllocator& allocator,
     VkQueue graphicsQueue,
     VkQueue presentQueue,
     uint32_t graphicsQueueFamilyIndex,
     Swapchain& swapchain,
     MeshTestPipeline& pipeline,
-    PFN_vkCmdDrawMeshTasksEXT cmdDrawMeshTasks)
-    : m_phys(phys)
-    , m_device(device)
+    GlyphInstanceBuffer& instances,
+    MsdfTextPipeline& textPipeline,
+    MsdfTextCullPipeline& textCullPipeline,
+    GlyphInstanceBuffer& text,
+    UploadManager& uploads,
+    PFN_vkCmdDrawMeshTasksEXT cmdDrawMeshTasks,
+    PFN_vkCmdDrawMeshTasksIndirectCountEXT cmdDrawMeshTasksIndirectCount,
+    uint32_t recordThreads)
+    : m_allocator(allocator)
+    , m_device(allocator.device())
     , m_gfxQueue(graphicsQueue)
     , m_presentQueue(presentQueue)
     , m_gfxQueueFamily(graphicsQueueFamilyIndex)
     , m_swapchain(swapchain)
     , m_pipeline(pipeline)
+    , m_instances(instances)
+    , m_textPipeline(textPipeline)
+    , m_textCullPipeline(textCullPipeline)
+    , m_text(text)
+    , m_textCull(allocator, kFramesInFlight)
+    , m_uploads(uploads)
     , m_cmdDrawMeshTasks(cmdDrawMeshTasks)
+    , m_cmdDrawMeshTasksIndirectCount(cmdDrawMeshTasksIndirectCount)
+    , m_recorder(allocator.device(), graphicsQueueFamilyIndex, kFramesInFlight, recordThreads)
 {
-    if (!m_cmdDrawMeshTasks)
+    if (!m_cmdDrawMeshTasks || !m_cmdDrawMeshTasksIndirectCount)
     {
-        std::cerr << "vkCmdDrawMeshTasksEXT is null (mesh shader fn not loaded)\n";
+        std::cerr << "vkCmdDrawMeshTasks(IndirectCount)EXT is null (mesh shader fn not loaded)\n";
         std::exit(EXIT_FAILURE);
     }
 
     createCommandPoolAndBuffers();
     createSyncObjects();
 
-    createLoopBlinnBuffers();
     createLBDescriptors();
+
+    createTextDescriptors();
 }
 
 MeshTestRenderer::~MeshTestRenderer()
 {
     vkDeviceWaitIdle(m_device);
 
+    destroyTextDescriptors();
+    for (AtlasSlot& a : m_atlases)
+    {
+        m_uploads.wait(a.pendingTicket);
+        a.pending.destroy();
+        a.retired.destroy();
+        a.atlas.destroy();
+    }
+
+    m_uploads.wait(m_lbTicket);
     destroyLBDescriptors();
     destroyLoopBlinnBuffers();
 
@@ -144,211 +124,223 @@ void MeshTestRenderer::createCommandPoolAndBuffers()
     pci.queueFamilyIndex = m_gfxQueueFamily;
     VK_CHECK(vkCreateCommandPool(m_device, &pci, nullptr, &m_cmdPool), "vkCreateCommandPool");
 
-    m_cmdBufferCount = m_swapchain.imageCount();
-    m_cmdBuffers = new VkCommandBuffer[m_cmdBufferCount]{};
-
     VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
     ai.commandPool = m_cmdPool;
     ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    ai.commandBufferCount = m_cmdBufferCount;
+    ai.commandBufferCount = kFramesInFlight;
 
-    VK_CHECK(vkAllocateCommandBuffers(m_device, &ai, m_cmdBuffers), "vkAllocateCommandBuffers");
+    VK_CHECK(vkAllocateCommandBuffers(m_device, &ai, m_cmdBuffers.data()), "vkAllocateCommandBuffers");
 }
 
 void MeshTestRenderer::destroyCommandPoolAndBuffers()
 {
-    if (m_cmdBuffers)
-    {
-        vkFreeCommandBuffers(m_device, m_cmdPool, m_cmdBufferCount, m_cmdBuffers);
-        delete[] m_cmdBuffers;
-        m_cmdBuffers = nullptr;
-    }
-
     if (m_cmdPool)
     {
+        vkFreeCommandBuffers(m_device, m_cmdPool, kFramesInFlight, m_cmdBuffers.data());
         vkDestroyCommandPool(m_device, m_cmdPool, nullptr);
         m_cmdPool = VK_NULL_HANDLE;
     }
-
-    m_cmdBufferCount = 0;
+    m_cmdBuffers = {};
 }
 
 void MeshTestRenderer::createSyncObjects()
 {
-    const uint32_t n = m_swapchain.imageCount();
-    m_imageAvailable = new VkSemaphore[n]{};
-    m_renderFinished = new VkSemaphore[n]{};
-    m_inFlightFence  = new VkFence[n]{};
-
     VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
     VkFenceCreateInfo fci{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
     fci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (uint32_t i = 0; i < n; ++i)
+    for (uint32_t i = 0; i < kFramesInFlight; ++i)
     {
         VK_CHECK(vkCreateSemaphore(m_device, &sci, nullptr, &m_imageAvailable[i]), "vkCreateSemaphore(imageAvailable)");
-        VK_CHECK(vkCreateSemaphore(m_device, &sci, nullptr, &m_renderFinished[i]), "vkCreateSemaphore(renderFinished)");
         VK_CHECK(vkCreateFence(m_device, &fci, nullptr, &m_inFlightFence[i]), "vkCreateFence(inFlight)");
     }
+
+    createPerImageSemaphores();
 }
 
 void MeshTestRenderer::destroySyncObjects()
 {
-    const uint32_t n = m_swapchain.imageCount();
-
-    if (m_imageAvailable)
-    {
-        for (uint32_t i = 0; i < n; ++i) vkDestroySemaphore(m_device, m_imageAvailable[i], nullptr);
-        delete[] m_imageAvailable;
-        m_imageAvailable = nullptr;
-    }
-    if (m_renderFinished)
-    {
-        for (uint32_t i = 0; i < n; ++i) vkDestroySemaphore(m_device, m_renderFinished[i], nullptr);
-        delete[] m_renderFinished;
-        m_renderFinished = nullptr;
-    }
-    if (m_inFlightFence)
+    for (uint32_t i = 0; i < kFramesInFlight; ++i)
     {
-        for (uint32_t i = 0; i < n; ++i) vkDestroyFence(m_device, m_inFlightFence[i], nullptr);
-        delete[] m_inFlightFence;
-        m_inFlightFence = nullptr;
+        if (m_imageAvailable[i]) vkDestroySemaphore(m_device, m_imageAvailable[i], nullptr);
+        if (m_inFlightFence[i])  vkDestroyFence(m_device, m_inFlightFence[i], nullptr);
     }
+    m_imageAvailable = {};
+    m_inFlightFence = {};
+
+    destroyPerImageSemaphores();
+}
+
+void MeshTestRenderer::createPerImageSemaphores()
+{
+    VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+
+    m_renderFinished.resize(m_swapchain.imageCount(), VK_NULL_HANDLE);
+    for (VkSemaphore& sem : m_renderFinished)
+        VK_CHECK(vkCreateSemaphore(m_device, &sci, nullptr, &sem), "vkCreateSemaphore(renderFinished)");
 }
 
-void MeshTestRenderer::createLoopBlinnBuffers()
-{
-    // ")" из статьи (positions, indices, types)
-    const Vec2 positions[10] = {
-        {+0.000f, -1.00f},
-        {+0.150f, -0.50f},
-        {+0.150f, +0.00f},
-        {+0.150f, +0.50f},
-        {+0.000f, +1.00f},
-        {-0.300f, +1.00f},
-        {-0.165f, +0.50f},
-        {-0.165f, +0.00f},
-        {-0.165f, -0.50f},
-        {-0.300f, -1.00f},
-    };
-
-    const UVec3Std430 tris[10] = {
-        {0,1,2,0},
-        {2,3,4,0},
-        {5,6,7,0},
-        {7,8,9,0},
-        {4,5,6,0},
-        {4,6,2,0},
-        {6,7,2,0},
-        {7,8,2,0},
-        {2,8,0,0},
-        {9,0,8,0},
-    };
-
-    // 0=SOLID 1=CONVEX 2=CONCAVE
-    const uint32_t primType[10] = {
-        1,1,
-        2,2,
-        0,0,0,0,0,0
-    };
-
-    std::vector<Vec2> offsets(m_instanceCount);
-    // ряд скобок по X в NDC
-    const float startX = -0.55f;
-    const float stepX  =  0.16f;
-    for (uint32_t i = 0; i < m_instanceCount; ++i)
-        offsets[i] = { startX + stepX * float(i), 0.0f };
-
-    const VkMemoryPropertyFlags hostProps =
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-    lbCreateBuffer(m_phys, m_device, sizeof(positions),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostProps, m_lbPosBuf, m_lbPosMem);
-
-    lbCreateBuffer(m_phys, m_device, sizeof(tris),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostProps, m_lbIdxBuf, m_lbIdxMem);
-
-    lbCreateBuffer(m_phys, m_device, sizeof(primType),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostProps, m_lbTypeBuf, m_lbTypeMem);
-
-    lbCreateBuffer(m_phys, m_device, sizeof(Vec2) * offsets.size(),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostProps, m_lbInstBuf, m_lbInstMem);
-
-    lbUploadToMemory(m_device, m_lbPosMem, positions, sizeof(positions));
-    lbUploadToMemory(m_device, m_lbIdxMem, tris, sizeof(tris));
-    lbUploadToMemory(m_device, m_lbTypeMem, primType, sizeof(primType));
-
-    // instances держим mapped (можно потом анимировать)
-    VK_CHECK(vkMapMemory(m_device, m_lbInstMem, 0, VK_WHOLE_SIZE, 0, &m_lbInstMapped), "vkMapMemory(instances)");
-    std::memcpy(m_lbInstMapped, offsets.data(), sizeof(Vec2) * offsets.size());
+void MeshTestRenderer::destroyPerImageSemaphores()
+{
+    for (VkSemaphore sem : m_renderFinished)
+        vkDestroySemaphore(m_device, sem, nullptr);
+    m_renderFinished.clear();
 }
 
-void MeshTestRenderer::destroyLoopBlinnBuffers()
+void MeshTestRenderer::waitForFrames()
 {
-    if (m_lbInstMapped)
+    VK_CHECK(vkWaitForFences(m_device, kFramesInFlight, m_inFlightFence.data(), VK_TRUE, UINT64_MAX),
+             "vkWaitForFences(all frames)");
+
+    // present может ещё ждать renderFinished
+    VK_CHECK(vkQueueWaitIdle(m_presentQueue), "vkQueueWaitIdle(present)");
+}
+
+void MeshTestRenderer::onSwapchainRecreated()
+{
+    // число images могло измениться; командные буферы, SSBO и дескрипторы от swapchain не зависят
+    destroyPerImageSemaphores();
+    createPerImageSemaphores();
+}
+
+void MeshTestRenderer::setGlyphlets(const LoopBlinnMesh& mesh)
+{
+    if (mesh.empty())
     {
-        vkUnmapMemory(m_device, m_lbInstMem);
-        m_lbInstMapped = nullptr;
+        std::cerr << "Glyphlet mesh has no meshlets\n";
+        return;
     }
 
-    auto kill = [&](VkBuffer& b, VkDeviceMemory& m)
+    // старые буферы могут читать кадры в полёте и дописывать незавершённая загрузка
+    if (m_lbPosBuf.buffer)
     {
-        if (b) vkDestroyBuffer(m_device, b, nullptr);
-        if (m) vkFreeMemory(m_device, m, nullptr);
-        b = VK_NULL_HANDLE;
-        m = VK_NULL_HANDLE;
-    };
+        waitForFrames();
+        m_uploads.wait(m_lbTicket);
+        destroyLoopBlinnBuffers();
+    }
+
+    createLoopBlinnBuffers(mesh);
+    writeGlyphletDescriptors();
 
-    kill(m_lbPosBuf,  m_lbPosMem);
-    kill(m_lbIdxBuf,  m_lbIdxMem);
-    kill(m_lbTypeBuf, m_lbTypeMem);
-    kill(m_lbInstBuf, m_lbInstMem);
+    m_lbGlyphCount = (uint32_t)mesh.glyphs().size();
+    m_lbReady = false;
+}
+
+void MeshTestRenderer::createLoopBlinnBuffers(const LoopBlinnMesh& mesh)
+{
+    // неизменные: device-local, данные — через staging ring UploadManager'а
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    const GpuMemoryUsage memory = GpuMemoryUsage::DeviceLocal;
+
+    const VkDeviceSize posBytes = mesh.positions().size() * sizeof(LoopBlinnMesh::Position);
+    const VkDeviceSize vertBytes = mesh.vertices().size() * sizeof(uint32_t);
+    const VkDeviceSize triBytes = mesh.triangles().size() * sizeof(uint32_t);
+    const VkDeviceSize glyphBytes = mesh.glyphs().size() * sizeof(LoopBlinnGlyph);
+    const VkDeviceSize meshletBytes = mesh.meshlets().size() * sizeof(LoopBlinnMeshlet);
+
+    m_lbPosBuf = m_allocator.createBuffer(posBytes, usage, memory, "loop-blinn positions");
+    m_lbVertBuf = m_allocator.createBuffer(vertBytes, usage, memory, "loop-blinn meshlet vertices");
+    m_lbTriBuf = m_allocator.createBuffer(triBytes, usage, memory, "loop-blinn meshlet triangles");
+    m_lbGlyphBuf = m_allocator.createBuffer(glyphBytes, usage, memory, "loop-blinn glyphs");
+    m_lbMeshletBuf = m_allocator.createBuffer(meshletBytes, usage, memory, "loop-blinn meshlets");
+
+    // таблицу глифов читает и task shader
+    const VkPipelineStageFlags stage = VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT;
+    const VkPipelineStageFlags taskStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT;
+    m_uploads.uploadBuffer(m_lbPosBuf.buffer, 0, mesh.positions().data(), posBytes, stage, VK_ACCESS_SHADER_READ_BIT);
+    m_uploads.uploadBuffer(m_lbVertBuf.buffer, 0, mesh.vertices().data(), vertBytes, stage, VK_ACCESS_SHADER_READ_BIT);
+    m_uploads.uploadBuffer(m_lbTriBuf.buffer, 0, mesh.triangles().data(), triBytes, stage, VK_ACCESS_SHADER_READ_BIT);
+    m_uploads.uploadBuffer(m_lbGlyphBuf.buffer, 0, mesh.glyphs().data(), glyphBytes, taskStage, VK_ACCESS_SHADER_READ_BIT);
+    m_uploads.uploadBuffer(m_lbMeshletBuf.buffer, 0, mesh.meshlets().data(), meshletBytes, stage, VK_ACCESS_SHADER_READ_BIT);
+    m_lbTicket = m_uploads.flush();
+
+    // instances — GlyphInstance из GlyphInstanceBuffer (binding 3), живут снаружи renderer'а
+}
+
+void MeshTestRenderer::destroyLoopBlinnBuffers()
+{
+    m_allocator.destroyBuffer(m_lbPosBuf);
+    m_allocator.destroyBuffer(m_lbVertBuf);
+    m_allocator.destroyBuffer(m_lbTriBuf);
+    m_allocator.destroyBuffer(m_lbGlyphBuf);
+    m_allocator.destroyBuffer(m_lbMeshletBuf);
 }
 
 void MeshTestRenderer::createLBDescriptors()
 {
     VkDescriptorPoolSize ps{};
     ps.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    ps.descriptorCount = 4;
+    ps.descriptorCount = 6 * kFramesInFlight;
 
     VkDescriptorPoolCreateInfo dp{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-    dp.maxSets = 1;
+    dp.maxSets = kFramesInFlight;
     dp.poolSizeCount = 1;
     dp.pPoolSizes = &ps;
 
     VK_CHECK(vkCreateDescriptorPool(m_device, &dp, nullptr, &m_lbDescPool), "vkCreateDescriptorPool");
 
-    VkDescriptorSetLayout dsl = m_pipeline.descriptorSetLayout();
+    std::array<VkDescriptorSetLayout, kFramesInFlight> layouts{};
+    layouts.fill(m_pipeline.descriptorSetLayout());
 
     VkDescriptorSetAllocateInfo dai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
     dai.descriptorPool = m_lbDescPool;
-    dai.descriptorSetCount = 1;
-    dai.pSetLayouts = &dsl;
-
-    VK_CHECK(vkAllocateDescriptorSets(m_device, &dai, &m_lbDescSet), "vkAllocateDescriptorSets");
+    dai.descriptorSetCount = kFramesInFlight;
+    dai.pSetLayouts = layouts.data();
 
-    VkDescriptorBufferInfo b0{ m_lbPosBuf,  0, VK_WHOLE_SIZE };
-    VkDescriptorBufferInfo b1{ m_lbIdxBuf,  0, VK_WHOLE_SIZE };
-    VkDescriptorBufferInfo b2{ m_lbTypeBuf, 0, VK_WHOLE_SIZE };
-    VkDescriptorBufferInfo b3{ m_lbInstBuf, 0, VK_WHOLE_SIZE };
+    VK_CHECK(vkAllocateDescriptorSets(m_device, &dai, m_lbDescSets.data()), "vkAllocateDescriptorSets");
 
-    VkWriteDescriptorSet w[4]{};
+    // геометрия (bindings 0–2, 4, 5) — в setGlyphlets()
+    writeInstanceDescriptors();
+}
 
-    for (uint32_t i = 0; i < 4; ++i)
+void MeshTestRenderer::writeGlyphletDescriptors()
+{
+    VkDescriptorBufferInfo b0{ m_lbPosBuf.buffer,     0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo b1{ m_lbVertBuf.buffer,    0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo b2{ m_lbTriBuf.buffer,     0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo b4{ m_lbGlyphBuf.buffer,   0, VK_WHOLE_SIZE };
+    VkDescriptorBufferInfo b5{ m_lbMeshletBuf.buffer, 0, VK_WHOLE_SIZE };
+    const VkDescriptorBufferInfo* infos[5] = { &b0, &b1, &b2, &b4, &b5 };
+    const uint32_t bindings[5] = { 0, 1, 2, 4, 5 };
+
+    // статичная геометрия glyphlet'ов общая для всех кадров
+    VkWriteDescriptorSet w[5 * kFramesInFlight]{};
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
     {
-        w[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-        w[i].dstSet = m_lbDescSet;
-        w[i].dstBinding = i;
-        w[i].descriptorCount = 1;
-        w[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            VkWriteDescriptorSet& wi = w[f * 5 + i];
+            wi = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            wi.dstSet = m_lbDescSets[f];
+            wi.dstBinding = bindings[i];
+            wi.descriptorCount = 1;
+            wi.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            wi.pBufferInfo = infos[i];
+        }
     }
 
-    w[0].pBufferInfo = &b0;
-    w[1].pBufferInfo = &b1;
-    w[2].pBufferInfo = &b2;
-    w[3].pBufferInfo = &b3;
+    vkUpdateDescriptorSets(m_device, 5 * kFramesInFlight, w, 0, nullptr);
+}
+
+void MeshTestRenderer::writeInstanceDescriptors()
+{
+    std::array<VkDescriptorBufferInfo, kFramesInFlight> bi{};
+    std::array<VkWriteDescriptorSet, kFramesInFlight> w{};
+
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
+    {
+        bi[f] = { m_instances.buffer(), m_instances.sliceOffset(f), m_instances.sliceSize() };
+
+        w[f] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        w[f].dstSet = m_lbDescSets[f];
+        w[f].dstBinding = 3;
+        w[f].descriptorCount = 1;
+        w[f].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        w[f].pBufferInfo = &bi[f];
+    }
 
-    vkUpdateDescriptorSets(m_device, 4, w, 0, nullptr);
+    vkUpdateDescriptorSets(m_device, kFramesInFlight, w.data(), 0, nullptr);
+    m_instancesGeneration = m_instances.generation();
 }
 
 void MeshTestRenderer::destroyLBDescriptors()
@@ -357,17 +349,450 @@ void MeshTestRenderer::destroyLBDescriptors()
     {
         vkDestroyDescriptorPool(m_device, m_lbDescPool, nullptr);
         m_lbDescPool = VK_NULL_HANDLE;
-        m_lbDescSet = VK_NULL_HANDLE;
+        m_lbDescSets = {};
+    }
+}
+
+void MeshTestRenderer::createTextDescriptors()
+{
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
+    {
+        m_cullStatsBufs[f] = m_allocator.createBuffer(
+            sizeof(MsdfTextCullStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, GpuMemoryUsage::Readback, "cull stats");
+        *cullStats(f) = {};
+        m_allocator.flush(m_cullStatsBufs[f].alloc);
+    }
+
+    // на слот и кадр: graphics — таблица атласов + 5 SSBO (1..5), compute — 5 SSBO (0..4)
+    constexpr uint32_t kSlots = (uint32_t)std::tuple_size<decltype(m_textDraws)>::value;
+
+    VkDescriptorPoolSize ps[2]{};
+    ps[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    ps[0].descriptorCount = kSlots * kMsdfMaxAtlases * kFramesInFlight;
+    ps[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    ps[1].descriptorCount = kSlots * 10 * kFramesInFlight;
+
+    VkDescriptorPoolCreateInfo dp{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dp.maxSets = kSlots * 2 * kFramesInFlight;
+    dp.poolSizeCount = 2;
+    dp.pPoolSizes = ps;
+
+    VK_CHECK(vkCreateDescriptorPool(m_device, &dp, nullptr, &m_textDescPool), "vkCreateDescriptorPool(text)");
+
+    std::array<VkDescriptorSetLayout, kFramesInFlight> textLayouts{};
+    std::array<VkDescriptorSetLayout, kFramesInFlight> cullLayouts{};
+    textLayouts.fill(m_textPipeline.descriptorSetLayout());
+    cullLayouts.fill(m_textCullPipeline.descriptorSetLayout());
+
+    for (TextDrawSlot& slot : m_textDraws)
+    {
+        VkDescriptorSetAllocateInfo dai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        dai.descriptorPool = m_textDescPool;
+        dai.descriptorSetCount = kFramesInFlight;
+
+        dai.pSetLayouts = textLayouts.data();
+        VK_CHECK(vkAllocateDescriptorSets(m_device, &dai, slot.sets.data()), "vkAllocateDescriptorSets(text)");
+
+        dai.pSetLayouts = cullLayouts.data();
+        VK_CHECK(vkAllocateDescriptorSets(m_device, &dai, slot.cullSets.data()), "vkAllocateDescriptorSets(text cull)");
+    }
+
+    // binding 0 (атласы) пишет updateAtlases, слот GPU layout — setGpuText
+    writeTextDescriptors();
+}
+
+void MeshTestRenderer::writeTextDescriptors()
+{
+    std::array<TextDrawSource, kFramesInFlight> src{};
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
+    {
+        src[f].instances = { m_text.buffer(), m_text.sliceOffset(f), m_text.sliceSize() };
+        src[f].blocks = { m_textCull.buffer(), m_textCull.blocksOffset(f), m_textCull.blocksSize() };
+        src[f].groups = { m_textCull.buffer(), m_textCull.groupsOffset(f), m_textCull.groupsSize() };
+    }
+
+    writeTextDrawSlot(m_textDraws[kTextSlotCpu], m_textCull.blockCapacity(), src);
+
+    m_textGeneration = m_text.generation();
+    m_textCullGeneration = m_textCull.generation();
+}
+
+void MeshTestRenderer::writeGpuTextDescriptors()
+{
+    // документ один на все кадры
+    std::array<TextDrawSource, kFramesInFlight> src{};
+    src.fill({ m_gpuText->instances(), m_gpuText->cullBlocks(), m_gpuText->cullGroups() });
+
+    writeTextDrawSlot(m_textDraws[kTextSlotGpu], m_gpuText->blockCapacity(), src);
+    m_gpuTextGeneration = m_gpuText->generation();
+}
+
+void MeshTestRenderer::createTextDrawBuffers(TextDrawSlot& slot, uint32_t maxDraws)
+{
+    const VkDeviceSize align = std::max<VkDeviceSize>(m_allocator.limits().minStorageBufferOffsetAlignment, 4);
+    auto alignUp = [align](VkDeviceSize v) { return (v + align - 1) / align * align; };
+
+    slot.maxDraws = maxDraws;
+    slot.cmdsOffset = alignUp(sizeof(uint32_t));
+    slot.infosOffset = alignUp(slot.cmdsOffset + (VkDeviceSize)maxDraws * sizeof(VkDrawMeshTasksIndirectCommandEXT));
+    const VkDeviceSize size = slot.infosOffset + (VkDeviceSize)maxDraws * 4 * sizeof(uint32_t);
+
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
+    {
+        slot.drawBufs[f] = m_allocator.createBuffer(size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            GpuMemoryUsage::DeviceLocal, "text draw args");
+    }
+}
+
+void MeshTestRenderer::destroyTextDrawBuffers(TextDrawSlot& slot)
+{
+    for (GpuBuffer& b : slot.drawBufs)
+        m_allocator.destroyBuffer(b);
+    slot.maxDraws = 0;
+}
+
+void MeshTestRenderer::writeTextDrawSlot(TextDrawSlot& slot, uint32_t maxDraws,
+                                         const std::array<TextDrawSource, kFramesInFlight>& src)
+{
+    // ёмкость таблицы блоков выросла (её владелец уже дождался vkDeviceWaitIdle) —
+    // indirect буферы должны вместить по команде на слот таблицы
+    if (slot.maxDraws != maxDraws)
+    {
+        destroyTextDrawBuffers(slot);
+        createTextDrawBuffers(slot, maxDraws);
+    }
+
+    const VkDeviceSize cmdsSize = (VkDeviceSize)slot.maxDraws * sizeof(VkDrawMeshTasksIndirectCommandEXT);
+    const VkDeviceSize infosSize = (VkDeviceSize)slot.maxDraws * 4 * sizeof(uint32_t);
+
+    // graphics: 1 instances, 2 blocks, 3 groups, 4 stats, 5 draw infos;
+    // compute: 0 blocks, 1 count, 2 cmds, 3 infos, 4 stats
+    constexpr uint32_t kWritesPerFrame = 10;
+    std::array<VkDescriptorBufferInfo, kWritesPerFrame * kFramesInFlight> bi{};
+    std::array<VkWriteDescriptorSet, kWritesPerFrame * kFramesInFlight> w{};
+
+    for (uint32_t f = 0; f < kFramesInFlight; ++f)
+    {
+        const VkDescriptorBufferInfo stats{ m_cullStatsBufs[f].buffer, 0, sizeof(MsdfTextCullStats) };
+        const VkDescriptorBufferInfo count{ slot.drawBufs[f].buffer, 0, sizeof(uint32_t) };
+        const VkDescriptorBufferInfo cmds{ slot.drawBufs[f].buffer, slot.cmdsOffset, cmdsSize };
+        const VkDescriptorBufferInfo infos{ slot.drawBufs[f].buffer, slot.infosOffset, infosSize };
+
+        const struct { VkDescriptorSet set; uint32_t binding; VkDescriptorBufferInfo info; } writes[kWritesPerFrame] = {
+            { slot.sets[f], 1, src[f].instances },
+            { slot.sets[f], 2, src[f].blocks },
+            { slot.sets[f], 3, src[f].groups },
+            { slot.sets[f], 4, stats },
+            { slot.sets[f], 5, infos },
+            { slot.cullSets[f], 0, src[f].blocks },
+            { slot.cullSets[f], 1, count },
+            { slot.cullSets[f], 2, cmds },
+            { slot.cullSets[f], 3, infos },
+            { slot.cullSets[f], 4, stats },
+        };
+
+        for (uint32_t i = 0; i < kWritesPerFrame; ++i)
+        {
+            const uint32_t k = kWritesPerFrame * f + i;
+            bi[k] = writes[i].info;
+
+            w[k] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            w[k].dstSet = writes[i].set;
+            w[k].dstBinding = writes[i].binding;
+            w[k].descriptorCount = 1;
+            w[k].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w[k].pBufferInfo = &bi[k];
+        }
+    }
+
+    vkUpdateDescriptorSets(m_device, (uint32_t)w.size(), w.data(), 0, nullptr);
+}
+
+void MeshTestRenderer::destroyTextDescriptors()
+{
+    if (m_textDescPool)
+    {
+        vkDestroyDescriptorPool(m_device, m_textDescPool, nullptr);
+        m_textDescPool = VK_NULL_HANDLE;
+    }
+
+    for (TextDrawSlot& slot : m_textDraws)
+    {
+        slot.sets = {};
+        slot.cullSets = {};
+        destroyTextDrawBuffers(slot);
+    }
+
+    for (GpuBuffer& b : m_cullStatsBufs)
+        m_allocator.destroyBuffer(b);
+}
+
+void MeshTestRenderer::setGpuText(GpuTextLayout* layout)
+{
+    // set'ы слота могут читаться кадрами в полёте
+    waitForFrames();
+
+    m_gpuText = layout;
+    if (m_gpuText)
+        writeGpuTextDescriptors();
+}
+
+void MeshTestRenderer::setFontAtlas(uint32_t slot, const uint8_t* const* layers, uint32_t layerCount, size_t layerSize,
+                                    uint32_t width, uint32_t height, float pxRange)
+{
+    if (slot >= kMsdfMaxAtlases)
+    {
+        std::cerr << "Atlas slot " << slot << " out of range (" << kMsdfMaxAtlases << " slots)\n";
+        std::exit(EXIT_FAILURE);
+    }
+    AtlasSlot& a = m_atlases[slot];
+
+    // предыдущая незавершённая загрузка вытесняется; её image ещё пишет transfer очередь
+    m_uploads.wait(a.pendingTicket);
+
+    a.pending.createArrayFromRGBA8(m_allocator, m_uploads, width, height, layers, layerCount, layerSize);
+    a.pendingTicket = m_uploads.flush();
+    a.pendingPxRange = pxRange;
+}
+
+void MeshTestRenderer::setDynamicAtlas(uint32_t slot, DynamicGlyphAtlas* atlas)
+{
+    if (slot >= kMsdfMaxAtlases)
+    {
+        std::cerr << "Atlas slot " << slot << " out of range (" << kMsdfMaxAtlases << " slots)\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // set'ы и копии атласа могут читаться кадрами в полёте
+    waitForFrames();
+
+    m_atlases[slot].dynamic = atlas;
+    ++m_atlasVersion;
+}
+
+bool MeshTestRenderer::atlasesReady() const
+{
+    // инстансы могут ссылаться на любой заданный слот: пока хоть один грузится впервые,
+    // его дескриптор не записан — текст не рисуется
+    bool any = false;
+    for (const AtlasSlot& a : m_atlases)
+    {
+        if (a.pendingTicket.valid() && !a.ready && !a.dynamic)
+            return false;
+        any |= a.ready || a.dynamic != nullptr;
+    }
+    return any;
+}
+
+void MeshTestRenderer::updateAtlases(uint32_t frame)
+{
+    for (AtlasSlot& a : m_atlases)
+    {
+        // fence кадра пройден: последний кадр со старым атласом (kFramesInFlight назад) завершён
+        if (a.retiredFrames > 0 && --a.retiredFrames == 0)
+            a.retired.destroy();
+
+        // новый атлас скопирован — переключаемся без ожидания; пока старый не освобождён, ждём кадр
+        if (a.pendingTicket.valid() && a.retiredFrames == 0 && m_uploads.isComplete(a.pendingTicket))
+        {
+            if (a.ready)
+            {
+                a.retired = std::move(a.atlas);
+                a.retiredFrames = kFramesInFlight;
+            }
+
+            a.atlas = std::move(a.pending);
+            a.pendingTicket = {};
+            a.pxRange = a.pendingPxRange;
+            a.ready = true;
+            ++m_atlasVersion;
+        }
     }
+
+    // set'ы остальных кадров ещё могут читаться GPU — каждый кадр обновляет только свои
+    if (m_atlasSetVersion[frame] != m_atlasVersion)
+        writeAtlasDescriptors(frame);
+}
+
+void MeshTestRenderer::writeAtlasDescriptors(uint32_t frame)
+{
+    constexpr size_t kSlots = std::tuple_size<decltype(m_textDraws)>::value;
+
+    // таблица одна на оба слота рисования: и CPU, и GPU layout видят все атласы.
+    // Слоты без атласа не пишутся (PARTIALLY_BOUND): на них не ссылается ни один инстанс
+    std::array<VkDescriptorImageInfo, kMsdfMaxAtlases> ii{};
+    for (uint32_t i = 0; i < kMsdfMaxAtlases; ++i)
+    {
+        const AtlasSlot& a = m_atlases[i];
+        if (a.dynamic)
+        {
+            ii[i].sampler = a.dynamic->sampler();
+            ii[i].imageView = a.dynamic->view();
+        }
+        else if (a.ready)
+        {
+            ii[i].sampler = a.atlas.sampler();
+            ii[i].imageView = a.atlas.view();
+        }
+        ii[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    std::array<VkWriteDescriptorSet, kSlots * kMsdfMaxAtlases> w{};
+    uint32_t count = 0;
+    for (size_t s = 0; s < kSlots; ++s)
+    {
+        for (uint32_t i = 0; i < kMsdfMaxAtlases; ++i)
+        {
+            if (!ii[i].imageView)
+                continue;
+
+            VkWriteDescriptorSet& wr = w[count++];
+            wr = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            wr.dstSet = m_textDraws[s].sets[frame];
+            wr.dstBinding = 0;
+            wr.dstArrayElement = i;
+            wr.descriptorCount = 1;
+            wr.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            wr.pImageInfo = &ii[i];
+        }
+    }
+
+    vkUpdateDescriptorSets(m_device, count, w.data(), 0, nullptr);
+    m_atlasSetVersion[frame] = m_atlasVersion;
+}
+
+void MeshTestRenderer::recordTextCullPass(VkCommandBuffer cmd, const TextDrawSlot& slot, uint32_t frame)
+{
+    const VkBuffer drawBuf = slot.drawBufs[frame].buffer;
+
+    // drawCount = 0; прошлый indirect draw этого слота завершён (fence), ждать его не нужно
+    vkCmdFillBuffer(cmd, drawBuf, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier toCompute{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    toCompute.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toCompute.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &toCompute, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_textCullPipeline.pipeline());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_textCullPipeline.layout(),
+                            0, 1, &slot.cullSets[frame], 0, nullptr);
+
+    MsdfTextCullPushConstants pc{};
+    pc.blockCount = slot.maxDraws;
+    vkCmdPushConstants(cmd, m_textCullPipeline.layout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+
+    vkCmdDispatch(cmd, MsdfTextCullPipeline::dispatchCountFor(pc.blockCount), 1, 1);
+
+    // команды/число — для indirect, draw infos и счётчики — для task shader'а
+    VkMemoryBarrier toDraw{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    toDraw.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    toDraw.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT, 0,
+                         1, &toDraw, 0, nullptr, 0, nullptr);
+}
+
+void MeshTestRenderer::recordTextDraw(VkCommandBuffer cmd, const TextDrawSlot& slot, uint32_t frame)
+{
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_textPipeline.layout(),
+                            0, 1, &slot.sets[frame], 0, nullptr);
+
+    m_cmdDrawMeshTasksIndirectCount(cmd,
+        slot.drawBufs[frame].buffer, slot.cmdsOffset,
+        slot.drawBufs[frame].buffer, 0,
+        slot.maxDraws, sizeof(VkDrawMeshTasksIndirectCommandEXT));
 }
 
-void MeshTestRenderer::recordCommandBuffer(uint32_t imageIndex)
+void MeshTestRenderer::recordDrawLayer(VkCommandBuffer cmd, DrawLayer layer, uint32_t frame)
 {
-    VkCommandBuffer cmd = m_cmdBuffers[imageIndex];
+    // вторичный буфер ничего не наследует, кроме attachment'ов: dynamic state — заново
+    VkExtent2D ext = m_swapchain.extent();
+
+    VkViewport vp{};
+    vp.x = 0.0f;
+    vp.y = 0.0f;
+    vp.width  = (float)ext.width;
+    vp.height = (float)ext.height;
+    vp.minDepth = 0.0f;
+    vp.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &vp);
 
+    VkRect2D sc{};
+    sc.offset = { 0, 0 };
+    sc.extent = ext;
+    vkCmdSetScissor(cmd, 0, 1, &sc);
+
+    switch (layer)
+    {
+    case DrawLayer::Glyphlets:
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.pipeline());
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.layout(),
+                                0, 1, &m_lbDescSets[frame], 0, nullptr);
+
+        LbGlyphletPushConstants pc{};
+        pc.instanceCount = m_instances.instanceCount();
+        pc.glyphCount = m_lbGlyphCount;
+        vkCmdPushConstants(cmd, m_pipeline.layout(), VK_SHADER_STAGE_TASK_BIT_EXT, 0, sizeof(pc), &pc);
+
+        // task workgroup на kGlyphletInstancesPerTask инстансов, mesh workgroup на meshlet;
+        // глифы инстансов любые — один draw на всю строку
+        const uint32_t tasks = (pc.instanceCount + kGlyphletInstancesPerTask - 1) / kGlyphletInstancesPerTask;
+        m_cmdDrawMeshTasks(cmd, tasks, 1, 1);
+        break;
+    }
+    case DrawLayer::Text:
+    case DrawLayer::GpuText:
+    {
+        // MSDF: draw на видимый блок (число — из drawCount), task shader отсекает группы глифов,
+        // mesh рисует glyphsPerGroup() quad'ов на workgroup. От числа глифов запись не зависит.
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_textPipeline.pipeline());
+
+        MsdfTextPushConstants pc{};
+        for (uint32_t i = 0; i < kMsdfMaxAtlases; ++i)
+            pc.pxRange[i] = m_atlases[i].dynamic ? m_atlases[i].dynamic->pxRange() : m_atlases[i].pxRange;
+        vkCmdPushConstants(cmd, m_textPipeline.layout(),
+                           VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                           0, sizeof(pc), &pc);
+
+        recordTextDraw(cmd, m_textDraws[layer == DrawLayer::Text ? kTextSlotCpu : kTextSlotGpu], frame);
+        break;
+    }
+    }
+}
+
+void MeshTestRenderer::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t frame)
+{
     VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     VK_CHECK(vkBeginCommandBuffer(cmd, &bi), "vkBeginCommandBuffer");
 
+    // ресурсы, докопированные transfer очередью, переходят во владение graphics
+    m_uploadWait = m_uploads.recordAcquires(cmd);
+
+    // InstanceMemory::Staged: изменения срезов этого кадра — в device-local буферы
+    m_instances.recordUpload(cmd, frame);
+    m_text.recordUpload(cmd, frame);
+
+    // глифы, размещённые в динамических атласах с прошлого кадра
+    for (AtlasSlot& a : m_atlases)
+        if (a.dynamic)
+            a.dynamic->recordUpload(cmd, frame);
+
+    // GPU layout документа (только когда он изменился), затем GPU-driven отсечение:
+    // сколько блоков видно и сколько task workgroup'ов им нужно, решает compute
+    const bool drawText = atlasesReady();
+    const bool drawGpuText = drawText && m_gpuText && m_gpuText->charCount() > 0;
+    if (drawGpuText)
+        m_gpuText->record(cmd);
+
+    if (drawText)
+        recordTextCullPass(cmd, m_textDraws[kTextSlotCpu], frame);
+    if (drawGpuText)
+        recordTextCullPass(cmd, m_textDraws[kTextSlotGpu], frame);
+
     // Layout: PRESENT -> COLOR_ATTACHMENT
     barrierImage(cmd,
         m_swapchain.image(imageIndex),
@@ -392,36 +817,40 @@ void MeshTestRenderer::recordCommandBuffer(uint32_t imageIndex)
     colorAtt.clearValue = clear;
 
     VkRenderingInfo ri{ VK_STRUCTURE_TYPE_RENDERING_INFO };
+    ri.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
     ri.renderArea.offset = { 0, 0 };
     ri.renderArea.extent = m_swapchain.extent();
     ri.layerCount = 1;
     ri.colorAttachmentCount = 1;
     ri.pColorAttachments = &colorAtt;
 
-    vkCmdBeginRendering(cmd, &ri);
+    // слои кадра в порядке отрисовки; каждый — свой вторичный буфер
+    std::array<DrawLayer, kDrawLayerCount> layers{};
+    uint32_t layerCount = 0;
+    if (m_lbReady && m_instances.instanceCount() > 0)
+        layers[layerCount++] = DrawLayer::Glyphlets;
+    if (drawText)
+        layers[layerCount++] = DrawLayer::Text;
+    if (drawGpuText)
+        layers[layerCount++] = DrawLayer::GpuText;
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.pipeline());
+    const VkFormat colorFormat = m_swapchain.format();
 
-    VkExtent2D ext = m_swapchain.extent();
+    VkCommandBufferInheritanceRenderingInfo inheritRendering{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+    inheritRendering.colorAttachmentCount = 1;
+    inheritRendering.pColorAttachmentFormats = &colorFormat;
+    inheritRendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-    VkViewport vp{};
-    vp.x = 0.0f;
-    vp.y = 0.0f;
-    vp.width  = (float)ext.width;
-    vp.height = (float)ext.height;
-    vp.minDepth = 0.0f;
-    vp.maxDepth = 1.0f;
-    vkCmdSetViewport(cmd, 0, 1, &vp);
+    VkCommandBufferInheritanceInfo inherit{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inherit.pNext = &inheritRendering;
 
-    VkRect2D sc{};
-    sc.offset = { 0, 0 };
-    sc.extent = ext;
-    vkCmdSetScissor(cmd, 0, 1, &sc);
+    const std::vector<VkCommandBuffer>& secondaries = m_recorder.record(frame, layerCount, inherit,
+        [&](VkCommandBuffer sec, uint32_t i) { recordDrawLayer(sec, layers[i], frame); });
 
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.layout(),
-                            0, 1, &m_lbDescSet, 0, nullptr);
+    vkCmdBeginRendering(cmd, &ri);
 
-    m_cmdDrawMeshTasks(cmd, m_instanceCount, 1, 1);
+    if (!secondaries.empty())
+        vkCmdExecuteCommands(cmd, (uint32_t)secondaries.size(), secondaries.data());
 
     vkCmdEndRendering(cmd);
 
@@ -435,58 +864,121 @@ void MeshTestRenderer::recordCommandBuffer(uint32_t imageIndex)
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
+    // атомики счётчиков отсечения (compute + task) -> чтение CPU после fence
+    VkMemoryBarrier toHost{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    toHost.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &toHost, 0, nullptr, 0, nullptr);
+
     VK_CHECK(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
 }
 
+void MeshTestRenderer::accumulateRecordTime(double ms)
+{
+    m_recordAccumMs += ms;
+    if (++m_recordAccumFrames < kRecordStatsWindow)
+        return;
+
+    m_recordStats.avgMs = m_recordAccumMs / m_recordAccumFrames;
+    m_recordStats.threads = m_recorder.threadCount();
+    ++m_recordStats.samples;
+    m_recordAccumMs = 0.0;
+    m_recordAccumFrames = 0;
+}
+
 bool MeshTestRenderer::drawFrame()
 {
-    // per-image sync: используем imageIndex как слот
-    uint32_t imageIndex = 0;
+    const uint32_t frame = m_frameIndex;
 
+    // ждём только кадр, который kFramesInFlight назад использовал этот слот
+    VK_CHECK(vkWaitForFences(m_device, 1, &m_inFlightFence[frame], VK_TRUE, UINT64_MAX), "vkWaitForFences");
+
+    uint32_t imageIndex = 0;
     VkResult acq = vkAcquireNextImageKHR(
         m_device,
         m_swapchain.handle(),
         UINT64_MAX,
-        VK_NULL_HANDLE, // мы подождём fence и используем семафоры на submit/present
+        m_imageAvailable[frame],
         VK_NULL_HANDLE,
         &imageIndex);
 
-    if (acq == VK_ERROR_OUT_OF_DATE_KHR || acq == VK_SUBOPTIMAL_KHR)
+    // fence ещё не сброшен — следующий drawFrame не зависнет
+    if (acq == VK_ERROR_OUT_OF_DATE_KHR)
         return false;
+    if (acq != VK_SUBOPTIMAL_KHR)
+        VK_CHECK(acq, "vkAcquireNextImageKHR");
+
+    VK_CHECK(vkResetFences(m_device, 1, &m_inFlightFence[frame]), "vkResetFences");
+
+    updateAtlases(frame);
 
-    VK_CHECK(acq, "vkAcquireNextImageKHR");
+    // glyphlet буферы рисуются с первого кадра после завершения их загрузки
+    if (!m_lbReady && m_lbPosBuf.buffer)
+        m_lbReady = m_uploads.isComplete(m_lbTicket);
 
-    VK_CHECK(vkWaitForFences(m_device, 1, &m_inFlightFence[imageIndex], VK_TRUE, UINT64_MAX), "vkWaitForFences");
-    VK_CHECK(vkResetFences(m_device, 1, &m_inFlightFence[imageIndex]), "vkResetFences");
+    // счётчики отсечения кадра, который последним использовал этот слот;
+    // запись шейдеров доступна хосту барьером в конце его command buffer'а
+    m_allocator.invalidate(m_cullStatsBufs[frame].alloc);
+    m_cullStats = *cullStats(frame);
+    *cullStats(frame) = {};
+    m_allocator.flush(m_cullStatsBufs[frame].alloc);
 
-    VK_CHECK(vkResetCommandBuffer(m_cmdBuffers[imageIndex], 0), "vkResetCommandBuffer");
-    recordCommandBuffer(imageIndex);
+    // буфер инстансов переехал (grow ждёт vkDeviceWaitIdle, так что set'ы сейчас не используются GPU)
+    if (m_instancesGeneration != m_instances.generation())
+        writeInstanceDescriptors();
+
+    m_textCull.update(m_text, m_textPipeline.glyphsPerGroup());
+    if (m_textGeneration != m_text.generation() || m_textCullGeneration != m_textCull.generation())
+        writeTextDescriptors();
+    if (m_gpuText && m_gpuTextGeneration != m_gpuText->generation())
+        writeGpuTextDescriptors();
+
+    // срез этого кадра GPU больше не читает (fence пройден) — догоняем его до CPU-копии
+    m_instances.flush(frame);
+    m_text.flush(frame);
+    m_textCull.flush(frame);
+
+    VkCommandBuffer cmd = m_cmdBuffers[frame];
+    VK_CHECK(vkResetCommandBuffer(cmd, 0), "vkResetCommandBuffer");
+
+    const auto recordStart = std::chrono::steady_clock::now();
+    recordCommandBuffer(cmd, imageIndex, frame);
+    accumulateRecordTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count());
 
     // Submit
-    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    // + timeline semaphore загрузок, если в кадре есть acquire (значение уже достигнуто)
+    const VkSemaphore waitSems[2] = { m_imageAvailable[frame], m_uploads.timelineSemaphore() };
+    const VkPipelineStageFlags waitStages[2] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+    const uint64_t waitValues[2] = { 0, m_uploadWait }; // binary semaphore: значение игнорируется
+    VkSemaphore renderFinished = m_renderFinished[imageIndex];
 
-    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-    // сигналим imageAvailable на acquire через отдельный семафор — здесь проще:
-    // используем бинарники: imageAvailable будет сигналиться вручную нельзя,
-    // поэтому делаем acquire без семафора и ждём fence — это ок на минималке.
-    // (Если хочешь, я дам версию с semaphores: acquire -> imageAvailable[imageIndex].)
+    VkTimelineSemaphoreSubmitInfo tsi{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    tsi.waitSemaphoreValueCount = m_uploadWait ? 2 : 1;
+    tsi.pWaitSemaphoreValues = waitValues;
 
-    si.waitSemaphoreCount = 0;
-    si.pWaitSemaphores = nullptr;
-    si.pWaitDstStageMask = &waitStage;
+    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    si.pNext = &tsi;
+    si.waitSemaphoreCount = m_uploadWait ? 2 : 1;
+    si.pWaitSemaphores = waitSems;
+    si.pWaitDstStageMask = waitStages;
 
     si.commandBufferCount = 1;
-    si.pCommandBuffers = &m_cmdBuffers[imageIndex];
+    si.pCommandBuffers = &cmd;
 
     si.signalSemaphoreCount = 1;
-    si.pSignalSemaphores = &m_renderFinished[imageIndex];
+    si.pSignalSemaphores = &renderFinished;
+
+    VK_CHECK(vkQueueSubmit(m_gfxQueue, 1, &si, m_inFlightFence[frame]), "vkQueueSubmit");
 
-    VK_CHECK(vkQueueSubmit(m_gfxQueue, 1, &si, m_inFlightFence[imageIndex]), "vkQueueSubmit");
+    m_frameIndex = (m_frameIndex + 1) % kFramesInFlight;
 
     // Present
     VkPresentInfoKHR pi{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
     pi.waitSemaphoreCount = 1;
-    pi.pWaitSemaphores = &m_renderFinished[imageIndex];
+    pi.pWaitSemaphores = &renderFinished;
 
     VkSwapchainKHR sc = m_swapchain.handle();
     pi.swapchainCount = 1;
@@ -494,7 +986,7 @@ bool MeshTestRenderer::drawFrame()
     pi.pImageIndices = &imageIndex;
 
     VkResult pres = vkQueuePresentKHR(m_presentQueue, &pi);
-    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR)
+    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || acq == VK_SUBOPTIMAL_KHR)
         return false;
 
     VK_CHECK(pres, "vkQueuePresentKHR");
@@ -1,32 +1,99 @@
 #pragma once
 
+#include "vk/GpuAllocator.h"
+#include "vk/Texture2D.h"
+#include "vk/TextCullTable.h"
+#include "vk/MsdfTextPipeline.h"
+#include "vk/MsdfTextCullPipeline.h"
+#include "vk/SecondaryRecorder.h"
+#include "vk/UploadManager.h"
+
 #include <vulkan/vulkan.h>
+#include <array>
+#include <vector>
 #include <cstdint>
 
 class Swapchain;
 class MeshTestPipeline;
+class GlyphInstanceBuffer;
+class GpuTextLayout;
+class UploadManager;
+class LoopBlinnMesh;
+class DynamicGlyphAtlas;
 
 class MeshTestRenderer
 {
 public:
+    // CPU записывает кадр N+1, пока GPU исполняет кадр N.
+    // Оба GlyphInstanceBuffer должны быть созданы с frameSlots = kFramesInFlight.
+    // instances рисуются Loop–Blinn glyphlet'ами, text — MSDF quad'ами из атласа.
+    static constexpr uint32_t kFramesInFlight = 2;
+
     MeshTestRenderer(
-        VkPhysicalDevice phys,
-        VkDevice device,
+        GpuAllocator& allocator,
         VkQueue graphicsQueue,
         VkQueue presentQueue,
         uint32_t graphicsQueueFamilyIndex,
         Swapchain& swapchain,
         MeshTestPipeline& pipeline,
-        PFN_vkCmdDrawMeshTasksEXT cmdDrawMeshTasks);
+        GlyphInstanceBuffer& instances,
+        MsdfTextPipeline& textPipeline,
+        MsdfTextCullPipeline& textCullPipeline,
+        GlyphInstanceBuffer& text,
+        UploadManager& uploads,
+        PFN_vkCmdDrawMeshTasksEXT cmdDrawMeshTasks,
+        PFN_vkCmdDrawMeshTasksIndirectCountEXT cmdDrawMeshTasksIndirectCount,
+        uint32_t recordThreads = 1);
 
     ~MeshTestRenderer();
 
     MeshTestRenderer(const MeshTestRenderer&) = delete;
     MeshTestRenderer& operator=(const MeshTestRenderer&) = delete;
 
-    // Возвращает false если swapchain out-of-date/suboptimal (тогда снаружи пересоздай swapchain и renderer/pipeline)
+    // Возвращает false если swapchain out-of-date/suboptimal (тогда снаружи:
+    // waitForFrames() -> swapchain.recreate() -> pipeline.recreate() -> onSwapchainRecreated())
     bool drawFrame();
 
+    // Дождаться кадров в полёте и present'ов (без vkDeviceWaitIdle)
+    void waitForFrames();
+
+    // Пересоздаёт только то, что зависит от images swapchain'а
+    void onSwapchainRecreated();
+
+    // Таблица атласов MSDF текста: kMsdfMaxAtlases слотов, инстанс выбирает слот и слой
+    // (GlyphInstance::atlas, glyph_atlas_ref), поэтому text и GPU layout рисуют глифы любых
+    // шрифтов своими draw'ами без перепривязок.
+    //
+    // Слот slot — texture array из layerCount атласов (RGBA8, по layerSize байт, общий pxRange):
+    // грузится асинхронно через UploadManager, кадры идут дальше (со старым атласом слота или
+    // без его глифов) и переключаются на новый, когда копия завершена
+    void setFontAtlas(uint32_t slot, const uint8_t* const* layers, uint32_t layerCount, size_t layerSize,
+                      uint32_t width, uint32_t height, float pxRange);
+
+    // Слот slot — динамический атлас (один слой); копии новых глифов пишутся в командный
+    // буфер кадра. nullptr — освободить слот. Ждёт кадры в полёте; атлас должен жить, пока подключён
+    void setDynamicAtlas(uint32_t slot, DynamicGlyphAtlas* atlas);
+
+    // Meshlet'ы Loop–Blinn glyphlet'ов (копируются на GPU асинхронно): каждый инстанс рисуется
+    // глифом GlyphInstance::glyph из mesh.glyphs(). Повторный вызов ждёт кадры в полёте
+    void setGlyphlets(const LoopBlinnMesh& mesh);
+
+    // Документ с layout'ом на GPU (рисуется вторым MSDF draw'ом); nullptr — не рисовать.
+    // Должен жить, пока подключён
+    void setGpuText(GpuTextLayout* layout);
+
+    // Время записи командного буфера кадра (CPU), среднее по kRecordStatsWindow кадрам
+    struct RecordStats
+    {
+        double avgMs = 0.0;
+        uint32_t threads = 0;
+        uint32_t samples = 0; // растёт при каждом обновлении
+    };
+    const RecordStats& recordStats() const { return m_recordStats; }
+
+    // Счётчики отсечения последнего завершённого кадра этого слота (отстают на kFramesInFlight)
+    const MsdfTextCullStats& textCullStats() const { return m_cullStats; }
+
 private:
     void createCommandPoolAndBuffers();
     void destroyCommandPoolAndBuffers();
@@ -34,17 +101,79 @@ private:
     void createSyncObjects();
     void destroySyncObjects();
 
-    void recordCommandBuffer(uint32_t imageIndex);
+    void createPerImageSemaphores();
+    void destroyPerImageSemaphores();
+
+    void recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t frame);
+
+    // Слои внутри rendering: по вторичному буферу на слой, пишутся параллельно (SecondaryRecorder)
+    enum class DrawLayer : uint32_t
+    {
+        Glyphlets, // Loop–Blinn инстансы
+        Text,      // MSDF, layout на CPU
+        GpuText,   // MSDF, layout на GPU
+    };
+    static constexpr uint32_t kDrawLayerCount = 3;
+
+    void recordDrawLayer(VkCommandBuffer cmd, DrawLayer layer, uint32_t frame);
+
+    static constexpr uint32_t kRecordStatsWindow = 120;
+    void accumulateRecordTime(double ms);
 
     // Loop–Blinn (glyphlets) resources
-    void createLoopBlinnBuffers();
+    void createLoopBlinnBuffers(const LoopBlinnMesh& mesh);
     void destroyLoopBlinnBuffers();
 
     void createLBDescriptors();
     void destroyLBDescriptors();
+    void writeGlyphletDescriptors();
+    void writeInstanceDescriptors();
+
+    // local_size_x в lb_glyphlets.task.glsl
+    static constexpr uint32_t kGlyphletInstancesPerTask = 32;
+
+    // MSDF text resources: по слоту на indirect draw (m_text, GpuTextLayout)
+    struct TextDrawSlot
+    {
+        std::array<VkDescriptorSet, kFramesInFlight> sets{};     // MsdfTextPipeline
+        std::array<VkDescriptorSet, kFramesInFlight> cullSets{}; // MsdfTextCullPipeline
+
+        // Аргументы indirect draw по кадрам (device-local, пишет только GPU):
+        // [drawCount | VkDrawMeshTasksIndirectCommandEXT × maxDraws | TextDrawInfo × maxDraws]
+        std::array<GpuBuffer, kFramesInFlight> drawBufs{};
+        uint32_t maxDraws = 0; // = ёмкость таблицы блоков на момент создания
+        VkDeviceSize cmdsOffset = 0;
+        VkDeviceSize infosOffset = 0;
+    };
+
+    // Входы слота в кадре
+    struct TextDrawSource
+    {
+        VkDescriptorBufferInfo instances{};
+        VkDescriptorBufferInfo blocks{};
+        VkDescriptorBufferInfo groups{};
+    };
+
+    static constexpr uint32_t kTextSlotCpu = 0; // m_text + m_textCull
+    static constexpr uint32_t kTextSlotGpu = 1; // m_gpuText
+
+    void createTextDescriptors();
+    void destroyTextDescriptors();
+    void writeTextDescriptors();
+    void writeGpuTextDescriptors();
+    void writeTextDrawSlot(TextDrawSlot& slot, uint32_t maxDraws, const std::array<TextDrawSource, kFramesInFlight>& src);
+    void createTextDrawBuffers(TextDrawSlot& slot, uint32_t maxDraws);
+    void destroyTextDrawBuffers(TextDrawSlot& slot);
+    void recordTextCullPass(VkCommandBuffer cmd, const TextDrawSlot& slot, uint32_t frame);
+    void recordTextDraw(VkCommandBuffer cmd, const TextDrawSlot& slot, uint32_t frame);
+
+    // атласы: загруженные -> текущие, binding 0 set'ов кадра
+    void updateAtlases(uint32_t frame);
+    void writeAtlasDescriptors(uint32_t frame);
+    bool atlasesReady() const;
 
 private:
-    VkPhysicalDevice m_phys = VK_NULL_HANDLE;
+    GpuAllocator& m_allocator;
     VkDevice m_device = VK_NULL_HANDLE;
 
     VkQueue m_gfxQueue = VK_NULL_HANDLE;
@@ -53,36 +182,89 @@ private:
 
     Swapchain& m_swapchain;
     MeshTestPipeline& m_pipeline;
+    GlyphInstanceBuffer& m_instances;
+    uint32_t m_instancesGeneration = 0;
+
+    MsdfTextPipeline& m_textPipeline;
+    MsdfTextCullPipeline& m_textCullPipeline;
+    GlyphInstanceBuffer& m_text;
+    uint32_t m_textGeneration = 0;
+
+    TextCullTable m_textCull;
+    uint32_t m_textCullGeneration = 0;
+
+    GpuTextLayout* m_gpuText = nullptr;
+    uint32_t m_gpuTextGeneration = 0;
+
+    UploadManager& m_uploads;
+    uint64_t m_uploadWait = 0; // timeline значение, которое ждёт сабмит текущего кадра
+
+    struct AtlasSlot
+    {
+        Texture2D atlas;
+        bool ready = false;
+        float pxRange = 4.0f;
+
+        // ещё копируется на transfer очереди
+        Texture2D pending;
+        UploadTicket pendingTicket{};
+        float pendingPxRange = 4.0f;
+
+        // прошлый атлас: живёт, пока его могут читать кадры в полёте
+        Texture2D retired;
+        uint32_t retiredFrames = 0;
+
+        DynamicGlyphAtlas* dynamic = nullptr; // вместо atlas
+    };
+
+    std::array<AtlasSlot, kMsdfMaxAtlases> m_atlases;
+    uint32_t m_atlasVersion = 0;
+    std::array<uint32_t, kFramesInFlight> m_atlasSetVersion{}; // версия таблицы в set'ах кадра
 
     PFN_vkCmdDrawMeshTasksEXT m_cmdDrawMeshTasks = nullptr;
+    PFN_vkCmdDrawMeshTasksIndirectCountEXT m_cmdDrawMeshTasksIndirectCount = nullptr;
 
     VkCommandPool m_cmdPool = VK_NULL_HANDLE;
 
-    VkCommandBuffer* m_cmdBuffers = nullptr;
-    uint32_t m_cmdBufferCount = 0;
-
-    // Per-swapchain-image sync (чтобы не ловить semaphore reuse ошибки)
-    VkSemaphore* m_imageAvailable = nullptr;
-    VkSemaphore* m_renderFinished = nullptr;
-    VkFence*     m_inFlightFence  = nullptr;
+    // вторичные буферы слоёв: пулы по потокам и кадрам
+    SecondaryRecorder m_recorder;
+    RecordStats m_recordStats{};
+    double m_recordAccumMs = 0.0;
+    uint32_t m_recordAccumFrames = 0;
 
-    // Loop–Blinn SSBOs
-    VkBuffer m_lbPosBuf = VK_NULL_HANDLE;
-    VkDeviceMemory m_lbPosMem = VK_NULL_HANDLE;
+    uint32_t m_frameIndex = 0;
 
-    VkBuffer m_lbIdxBuf = VK_NULL_HANDLE;
-    VkDeviceMemory m_lbIdxMem = VK_NULL_HANDLE;
+    // per-frame
+    std::array<VkCommandBuffer, kFramesInFlight> m_cmdBuffers{};
+    std::array<VkSemaphore, kFramesInFlight> m_imageAvailable{};
+    std::array<VkFence, kFramesInFlight> m_inFlightFence{};
 
-    VkBuffer m_lbTypeBuf = VK_NULL_HANDLE;
-    VkDeviceMemory m_lbTypeMem = VK_NULL_HANDLE;
+    // per-swapchain-image: present ждёт его, пока image не вернётся (semaphore reuse)
+    std::vector<VkSemaphore> m_renderFinished;
 
-    VkBuffer m_lbInstBuf = VK_NULL_HANDLE;
-    VkDeviceMemory m_lbInstMem = VK_NULL_HANDLE;
-    void* m_lbInstMapped = nullptr;
+    // Loop–Blinn SSBOs: meshlet'ы всех глифов и таблица глифов (по glyph index)
+    GpuBuffer m_lbPosBuf{};
+    GpuBuffer m_lbVertBuf{};
+    GpuBuffer m_lbTriBuf{};
+    GpuBuffer m_lbGlyphBuf{};
+    GpuBuffer m_lbMeshletBuf{};
+    uint32_t m_lbGlyphCount = 0;
 
-    uint32_t m_instanceCount = 8;
+    UploadTicket m_lbTicket{};
+    bool m_lbReady = false;
 
-    // Descriptor (Loop–Blinn)
+    // Descriptor (Loop–Blinn): по set'у на кадр — binding 3 смотрит в срез инстансов этого кадра,
+    // остальные общие
     VkDescriptorPool m_lbDescPool = VK_NULL_HANDLE;
-    VkDescriptorSet  m_lbDescSet  = VK_NULL_HANDLE;
+    std::array<VkDescriptorSet, kFramesInFlight> m_lbDescSets{};
+
+    // Descriptor (MSDF text): атлас + инстансы/cull таблицы + счётчики + draw infos
+    // и set'ы compute pre-pass'а — всех слотов из одного пула
+    VkDescriptorPool m_textDescPool = VK_NULL_HANDLE;
+    std::array<TextDrawSlot, 2> m_textDraws{};
+
+    // MsdfTextCullStats по кадрам: host-visible, CPU читает и обнуляет после fence
+    std::array<GpuBuffer, kFramesInFlight> m_cullStatsBufs{};
+    MsdfTextCullStats* cullStats(uint32_t frame) const { return reinterpret_cast<MsdfTextCullStats*>(m_cullStatsBufs[frame].alloc.mapped); }
+    MsdfTextCullStats m_cullStats{};
 };
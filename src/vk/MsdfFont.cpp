@@ -1,4 +1,5 @@
 #include "vk/MsdfFont.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -87,7 +88,14 @@ bool MsdfFont::loadFromJson(const std::string& jsonPath)
         return false;
     }
 
-    m_glyphs.clear();
+    if (m_atlasW <= 0 || m_atlasH <= 0)
+    {
+        std::cerr << "Invalid atlas size in json\n";
+        return false;
+    }
+
+    std::vector<MsdfGlyph> glyphs;
+    glyphs.reserve(j["glyphs"].size());
     for (const auto& g : j["glyphs"])
     {
         MsdfGlyph glyph{};
@@ -97,16 +105,42 @@ bool MsdfFont::loadFromJson(const std::string& jsonPath)
         glyph.hasPlane = readBounds(g, "planeBounds", glyph.plane);
         glyph.hasAtlas = readBounds(g, "atlasBounds", glyph.atlas);
 
-        m_glyphs[glyph.codepoint] = glyph;
+        glyphs.push_back(glyph);
     }
 
-    if (m_atlasW <= 0 || m_atlasH <= 0)
+    // json не обязан быть отсортирован; при дублях побеждает последний (как раньше с map)
+    std::stable_sort(glyphs.begin(), glyphs.end(),
+                     [](const MsdfGlyph& a, const MsdfGlyph& b) { return a.codepoint < b.codepoint; });
+    std::vector<MsdfGlyph> unique;
+    unique.reserve(glyphs.size());
+    for (const auto& g : glyphs)
     {
-        std::cerr << "Invalid atlas size in json\n";
+        if (!unique.empty() && unique.back().codepoint == g.codepoint)
+            unique.back() = g;
+        else
+            unique.push_back(g);
+    }
+
+    if (!buildLookup(std::move(unique)))
         return false;
+
+    std::vector<FontPackKerning> pairs;
+    if (j.contains("kerning") && j["kerning"].is_array())
+    {
+        pairs.reserve(j["kerning"].size());
+        for (const auto& k : j["kerning"])
+        {
+            FontPackKerning pair{};
+            pair.unicode1 = k.value("unicode1", 0u);
+            pair.unicode2 = k.value("unicode2", 0u);
+            pair.advance = k.value("advance", 0.0f);
+            pairs.push_back(pair);
+        }
     }
+    buildKerning(std::move(pairs));
 
     std::cout << "Font JSON loaded: glyphs=" << m_glyphs.size()
+              << ", kerning=" << kerningPairCount()
               << ", atlas=" << m_atlasW << "x" << m_atlasH
               << ", pxRange=" << m_pxRange
               << ", emSize=" << m_metrics.emSize << "\n";
@@ -114,10 +148,271 @@ bool MsdfFont::loadFromJson(const std::string& jsonPath)
     return true;
 }
 
+bool MsdfFont::loadFromPack(const std::string& packPath)
+{
+    if (!m_pack.open(packPath))
+        return false;
+
+    const FontPackHeader& h = m_pack.header();
+    m_atlasW = (int)h.atlasWidth;
+    m_atlasH = (int)h.atlasHeight;
+    m_atlasYBottom = (h.flags & FONT_PACK_ATLAS_Y_BOTTOM) != 0;
+    m_pxRange = h.pxRange;
+
+    m_metrics.emSize = h.emSize;
+    m_metrics.lineHeight = h.lineHeight;
+    m_metrics.ascender = h.ascender;
+    m_metrics.descender = h.descender;
+
+    // таблица в pack уже отсортирована конвертером
+    std::vector<MsdfGlyph> glyphs;
+    glyphs.reserve(m_pack.glyphCount());
+
+    const FontPackGlyph* src = m_pack.glyphs();
+    for (uint32_t i = 0; i < m_pack.glyphCount(); ++i)
+    {
+        const FontPackGlyph& g = src[i];
+
+        MsdfGlyph glyph{};
+        glyph.codepoint = g.codepoint;
+        glyph.advance = g.advance;
+        glyph.hasPlane = (g.flags & FONT_PACK_GLYPH_HAS_PLANE) != 0;
+        glyph.hasAtlas = (g.flags & FONT_PACK_GLYPH_HAS_ATLAS) != 0;
+        glyph.plane = { g.planeLeft, g.planeBottom, g.planeRight, g.planeTop };
+        glyph.atlas = { g.atlasLeft, g.atlasBottom, g.atlasRight, g.atlasTop };
+
+        if (!glyphs.empty() && glyphs.back().codepoint >= glyph.codepoint)
+        {
+            std::cerr << "Font pack glyph table is not sorted: " << packPath << "\n";
+            return false;
+        }
+        glyphs.push_back(glyph);
+    }
+
+    if (!buildLookup(std::move(glyphs)))
+        return false;
+
+    buildKerning(std::vector<FontPackKerning>(m_pack.kerning(), m_pack.kerning() + m_pack.kerningCount()));
+
+    std::cout << "Font pack loaded: glyphs=" << m_glyphs.size()
+              << ", kerning=" << kerningPairCount()
+              << ", atlas=" << m_atlasW << "x" << m_atlasH
+              << ", pxRange=" << m_pxRange
+              << ", emSize=" << m_metrics.emSize << "\n";
+
+    return true;
+}
+
+bool MsdfFont::buildLookup(std::vector<MsdfGlyph>&& glyphs)
+{
+    if (glyphs.size() > kMaxGlyphs)
+    {
+        std::cerr << "Too many glyphs for 16-bit glyph index: " << glyphs.size() << "\n";
+        return false;
+    }
+
+    m_glyphs = std::move(glyphs);
+
+    m_direct.fill(kInvalidGlyph);
+    m_sparseCodepoints.clear();
+    m_sparseGlyphs.clear();
+
+    m_advance.resize(m_glyphs.size());
+    m_quad.resize(m_glyphs.size());
+
+    for (size_t i = 0; i < m_glyphs.size(); ++i)
+    {
+        const MsdfGlyph& g = m_glyphs[i];
+        const uint16_t gi = (uint16_t)i;
+
+        if (g.codepoint < kDirectRange)
+        {
+            m_direct[g.codepoint] = gi;
+        }
+        else
+        {
+            m_sparseCodepoints.push_back(g.codepoint);
+            m_sparseGlyphs.push_back(gi);
+        }
+
+        m_advance[i] = g.advance;
+        m_quad[i] = makeQuad(g);
+    }
+
+    return true;
+}
+
+MsdfGlyphQuad MsdfFont::makeQuad(const MsdfGlyph& g) const
+{
+    MsdfGlyphQuad q{};
+    if (!g.hasPlane || !g.hasAtlas)
+        return q;
+
+    const float invW = 1.0f / (float)m_atlasW;
+    const float invH = 1.0f / (float)m_atlasH;
+
+    q.planeLeft = g.plane.left;
+    q.planeBottom = g.plane.bottom;
+    q.planeRight = g.plane.right;
+    q.planeTop = g.plane.top;
+
+    q.u0 = g.atlas.left * invW;
+    q.u1 = g.atlas.right * invW;
+    // v=0 вверху (как ждёт mesh shader)
+    if (m_atlasYBottom)
+    {
+        q.vTop = 1.0f - g.atlas.top * invH;
+        q.vBottom = 1.0f - g.atlas.bottom * invH;
+    }
+    else
+    {
+        q.vTop = g.atlas.top * invH;
+        q.vBottom = g.atlas.bottom * invH;
+    }
+    return q;
+}
+
+void MsdfFont::initDynamic(uint32_t atlasW, uint32_t atlasH, float pxRange, const MsdfMetrics& metrics)
+{
+    m_pack.close();
+    m_atlasW = (int)atlasW;
+    m_atlasH = (int)atlasH;
+    m_atlasYBottom = true;
+    m_pxRange = pxRange;
+    m_metrics = metrics;
+
+    buildLookup({});
+    buildKerning({});
+}
+
+uint16_t MsdfFont::addGlyph(uint32_t codepoint, float advance)
+{
+    if (m_glyphs.size() >= kMaxGlyphs || glyphIndex(codepoint) != kInvalidGlyph)
+        return kInvalidGlyph;
+
+    const uint16_t gi = (uint16_t)m_glyphs.size();
+    MsdfGlyph g{};
+    g.codepoint = codepoint;
+    g.advance = advance;
+    m_glyphs.push_back(g);
+    m_advance.push_back(advance);
+    m_quad.push_back(MsdfGlyphQuad{});
+
+    // у нового глифа пар нет: пустой спан в конце
+    if (!m_kernFirst.empty())
+        m_kernFirst.push_back(m_kernFirst.back());
+
+    if (codepoint < kDirectRange)
+    {
+        m_direct[codepoint] = gi;
+    }
+    else
+    {
+        const auto it = std::lower_bound(m_sparseCodepoints.begin(), m_sparseCodepoints.end(), codepoint);
+        const size_t at = (size_t)(it - m_sparseCodepoints.begin());
+        m_sparseCodepoints.insert(it, codepoint);
+        m_sparseGlyphs.insert(m_sparseGlyphs.begin() + (ptrdiff_t)at, gi);
+    }
+    return gi;
+}
+
+void MsdfFont::setGlyphBounds(uint16_t gi, bool hasPlane, const MsdfBounds& plane, bool hasAtlas, const MsdfBounds& atlas)
+{
+    MsdfGlyph& g = m_glyphs[gi];
+    g.hasPlane = hasPlane;
+    g.plane = plane;
+    g.hasAtlas = hasAtlas;
+    g.atlas = atlas;
+    m_quad[gi] = makeQuad(g);
+}
+
+void MsdfFont::buildKerning(std::vector<FontPackKerning>&& pairs)
+{
+    struct GlyphPair
+    {
+        uint16_t left, right;
+        float advance;
+    };
+
+    std::vector<GlyphPair> mapped;
+    mapped.reserve(pairs.size());
+    for (const FontPackKerning& k : pairs)
+    {
+        const uint16_t l = glyphIndex(k.unicode1);
+        const uint16_t r = glyphIndex(k.unicode2);
+        if (l == kInvalidGlyph || r == kInvalidGlyph || k.advance == 0.0f)
+            continue;
+        mapped.push_back({ l, r, k.advance });
+    }
+
+    // при дублях побеждает последний
+    std::stable_sort(mapped.begin(), mapped.end(), [](const GlyphPair& a, const GlyphPair& b)
+    {
+        return a.left != b.left ? a.left < b.left : a.right < b.right;
+    });
+
+    m_kernFirst.assign(m_glyphs.size() + 1, 0);
+    m_kernRight.clear();
+    m_kernValue.clear();
+    m_kernRight.reserve(mapped.size());
+    m_kernValue.reserve(mapped.size());
+
+    for (size_t i = 0; i < mapped.size(); ++i)
+    {
+        const GlyphPair& k = mapped[i];
+        if (i + 1 < mapped.size() && mapped[i + 1].left == k.left && mapped[i + 1].right == k.right)
+            continue;
+
+        m_kernRight.push_back(k.right);
+        m_kernValue.push_back(k.advance);
+        ++m_kernFirst[k.left + 1];
+    }
+
+    for (size_t gi = 0; gi < m_glyphs.size(); ++gi)
+        m_kernFirst[gi + 1] += m_kernFirst[gi];
+}
+
+float MsdfFont::kerningSearch(uint32_t begin, uint32_t end, uint16_t right) const
+{
+    const uint16_t* base = m_kernRight.data() + begin;
+    size_t n = end - begin;
+
+    while (n > 1)
+    {
+        const size_t half = n / 2;
+        base = (base[half] <= right) ? base + half : base;
+        n -= half;
+    }
+
+    if (*base != right)
+        return 0.0f;
+    return m_kernValue[(size_t)(base - m_kernRight.data())];
+}
+
+uint16_t MsdfFont::findSparse(uint32_t cp) const
+{
+    // branchless lower_bound: на каждом шаге одна cmov вместо непредсказуемого перехода
+    const uint32_t* base = m_sparseCodepoints.data();
+    size_t n = m_sparseCodepoints.size();
+    if (n == 0)
+        return kInvalidGlyph;
+
+    while (n > 1)
+    {
+        const size_t half = n / 2;
+        base = (base[half] <= cp) ? base + half : base;
+        n -= half;
+    }
+
+    if (*base != cp)
+        return kInvalidGlyph;
+    return m_sparseGlyphs[(size_t)(base - m_sparseCodepoints.data())];
+}
+
 const MsdfGlyph* MsdfFont::find(uint32_t cp) const
 {
-    auto it = m_glyphs.find(cp);
-    if (it == m_glyphs.end())
+    const uint16_t gi = glyphIndex(cp);
+    if (gi == kInvalidGlyph)
         return nullptr;
-    return &it->second;
+    return &m_glyphs[gi];
 }
@@ -1,6 +1,9 @@
 #pragma once
+#include "vk/FontPack.h"
+
 #include <string>
-#include <unordered_map>
+#include <vector>
+#include <array>
 #include <cstdint>
 
 struct MsdfBounds
@@ -20,6 +23,14 @@ struct MsdfGlyph
     MsdfBounds atlas; // pixels in atlas
 };
 
+// Горячие данные глифа для layout: plane bounds + UV в атласе (v=0 вверху).
+// 32 байта, лежат плотным массивом по glyph index.
+struct MsdfGlyphQuad
+{
+    float planeLeft = 0, planeBottom = 0, planeRight = 0, planeTop = 0; // font units
+    float u0 = 0, vTop = 0, u1 = 0, vBottom = 0;                        // normalized atlas UV
+};
+
 struct MsdfMetrics
 {
     float emSize = 48.0f;
@@ -33,6 +44,84 @@ class MsdfFont
 public:
     bool loadFromJson(const std::string& jsonPath);
 
+    // Бинарный pack (см. FontPack.h): без парсинга, атлас остаётся в mmap
+    bool loadFromPack(const std::string& packPath);
+
+    // Пустой шрифт под динамический атлас (DynamicGlyphAtlas): глифы добавляются addGlyph(),
+    // а quad появляется и пропадает вместе с местом в атласе (setGlyphBounds)
+    void initDynamic(uint32_t atlasW, uint32_t atlasH, float pxRange, const MsdfMetrics& metrics);
+
+    // Новый глиф без quad'а; индексы не переиспользуются. kInvalidGlyph — codepoint уже
+    // есть или кончились индексы
+    uint16_t addGlyph(uint32_t codepoint, float advance);
+
+    // Размещение глифа: plane — em, atlas — px (y снизу). hasAtlas == false — глиф вытеснен
+    // из атласа: advance остаётся, quad'а нет
+    void setGlyphBounds(uint16_t gi, bool hasPlane, const MsdfBounds& plane, bool hasAtlas, const MsdfBounds& atlas);
+
+    // Заменить таблицу кернинга (пары по codepoint'ам, глифы без записи пропускаются)
+    void setKerning(std::vector<FontPackKerning>&& pairs) { buildKerning(std::move(pairs)); }
+
+    static constexpr uint16_t kInvalidGlyph = 0xFFFFu;
+
+    // Индексы [kMaxGlyphs, 0xFFFF] зарезервированы (kInvalidGlyph, служебные коды TextLayout)
+    static constexpr uint32_t kMaxGlyphs = 0xFFF0u;
+
+    // Codepoint'ы [0, kDirectRange) ищутся прямой индексацией:
+    // Basic Latin, Latin-1, Latin Extended-A/B, IPA, Greek, Cyrillic.
+    static constexpr uint32_t kDirectRange = 0x0500u;
+
+    // codepoint -> glyph index (kInvalidGlyph если глифа нет)
+    uint16_t glyphIndex(uint32_t cp) const
+    {
+        if (cp < kDirectRange)
+            return m_direct[cp];
+        return findSparse(cp);
+    }
+
+    uint32_t glyphCount() const { return (uint32_t)m_advance.size(); }
+
+    // hot SoA
+    float advance(uint16_t gi) const { return m_advance[gi]; }
+    const MsdfGlyphQuad& quad(uint16_t gi) const { return m_quad[gi]; }
+    bool hasQuad(uint16_t gi) const { return m_quad[gi].planeRight > m_quad[gi].planeLeft; }
+
+    const float* advances() const { return m_advance.data(); }
+    const MsdfGlyphQuad* quads() const { return m_quad.data(); }
+    const uint16_t* directTable() const { return m_direct.data(); }
+
+    // Кернинг пары соседних глифов (em, прибавляется к advance левого); 0 если пары нет.
+    // Пары лежат спанами по левому глифу, внутри отсортированы по правому.
+    float kerning(uint16_t left, uint16_t right) const
+    {
+        if ((size_t)left + 1 >= m_kernFirst.size())
+            return 0.0f;
+
+        uint32_t i = m_kernFirst[left];
+        const uint32_t e = m_kernFirst[left + 1];
+        if (e - i > kKernLinearSpan)
+            return kerningSearch(i, e, right);
+
+        for (; i < e; ++i)
+        {
+            if (m_kernRight[i] >= right)
+                return m_kernRight[i] == right ? m_kernValue[i] : 0.0f;
+        }
+        return 0.0f;
+    }
+
+    uint32_t kerningPairCount() const { return (uint32_t)m_kernRight.size(); }
+
+    // Сырые таблицы lookup/кернинга — для копии шрифта на GPU (GpuTextLayout)
+    uint32_t sparseCount() const { return (uint32_t)m_sparseCodepoints.size(); }
+    const uint32_t* sparseCodepoints() const { return m_sparseCodepoints.data(); }
+    const uint16_t* sparseGlyphs() const { return m_sparseGlyphs.data(); }
+    const uint32_t* kerningFirst() const { return m_kernFirst.empty() ? nullptr : m_kernFirst.data(); } // glyphCount() + 1
+    const uint16_t* kerningRight() const { return m_kernRight.data(); }
+    const float* kerningValues() const { return m_kernValue.data(); }
+
+    // cold (полная запись глифа)
+    const MsdfGlyph& glyph(uint16_t gi) const { return m_glyphs[gi]; }
     const MsdfGlyph* find(uint32_t cp) const;
 
     int atlasW() const { return m_atlasW; }
@@ -40,6 +129,10 @@ public:
     float pxRange() const { return m_pxRange; }
     const MsdfMetrics& metrics() const { return m_metrics; }
 
+    // RGBA8 пиксели атласа из pack (nullptr если шрифт загружен из json)
+    const uint8_t* atlasPixels() const { return m_pack.atlasPixels(); }
+    size_t atlasByteSize() const { return m_pack.atlasSize(); }
+
     bool atlasYBottom() const { return m_atlasYBottom; }
     bool m_atlasYBottom = true;
 
@@ -48,6 +141,35 @@ private:
     int m_atlasH = 0;
     float m_pxRange = 4.0f;
 
+    // glyphs должны быть отсортированы по codepoint без дублей
+    bool buildLookup(std::vector<MsdfGlyph>&& glyphs);
+    MsdfGlyphQuad makeQuad(const MsdfGlyph& g) const;
+    uint16_t findSparse(uint32_t cp) const;
+
+    // пары по codepoint'ам; вызывать после buildLookup
+    void buildKerning(std::vector<FontPackKerning>&& pairs);
+    float kerningSearch(uint32_t begin, uint32_t end, uint16_t right) const;
+
+    static constexpr uint32_t kKernLinearSpan = 8;
+
     MsdfMetrics m_metrics{};
-    std::unordered_map<uint32_t, MsdfGlyph> m_glyphs;
+
+    // lookup: плотная таблица + отсортированный хвост
+    std::array<uint16_t, kDirectRange> m_direct{};
+    std::vector<uint32_t> m_sparseCodepoints;
+    std::vector<uint16_t> m_sparseGlyphs;
+
+    // hot
+    std::vector<float> m_advance;
+    std::vector<MsdfGlyphQuad> m_quad;
+
+    // kerning: m_kernFirst[gi]..m_kernFirst[gi + 1] — пары с левым глифом gi
+    std::vector<uint32_t> m_kernFirst;
+    std::vector<uint16_t> m_kernRight;
+    std::vector<float> m_kernValue;
+
+    // cold
+    std::vector<MsdfGlyph> m_glyphs;
+
+    FontPack m_pack;
 };
@@ -0,0 +1,865 @@
+#include "vk/MsdfGenerator.h"
+#include "vk/MsdfKernel.h"
+#include "vk/TrueTypeFont.h"
+#include "platform/WorkStealingPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+using Vec2 = MsdfGenerator::Vec2;
+using Edge = MsdfGenerator::Edge;
+
+// Цвета рёбер: биты каналов
+enum EdgeColor : uint8_t
+{
+    kBlack = 0,
+    kRed = 1,
+    kGreen = 2,
+    kYellow = 3,
+    kBlue = 4,
+    kMagenta = 5,
+    kCyan = 6,
+    kWhite = 7,
+};
+
+static Vec2 operator+(Vec2 a, Vec2 b) { return { a.x + b.x, a.y + b.y }; }
+static Vec2 operator-(Vec2 a, Vec2 b) { return { a.x - b.x, a.y - b.y }; }
+static Vec2 operator*(double s, Vec2 a) { return { s * a.x, s * a.y }; }
+static bool operator==(Vec2 a, Vec2 b) { return a.x == b.x && a.y == b.y; }
+
+static double dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+static double cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+static double length(Vec2 a) { return std::sqrt(dot(a, a)); }
+
+static Vec2 normalize(Vec2 a)
+{
+    const double l = length(a);
+    return l > 0.0 ? (1.0 / l) * a : Vec2{ 0.0, 1.0 };
+}
+
+static Vec2 mix(Vec2 a, Vec2 b, double t) { return a + t * (b - a); }
+
+static float median3(float a, float b, float c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// ---------------------------------------------------------------------------
+// Геометрия рёбер
+// ---------------------------------------------------------------------------
+
+static Vec2 edge_point(const Edge& e, double t)
+{
+    if (!e.curve)
+        return mix(e.p0, e.p1, t);
+    return mix(mix(e.p0, e.c, t), mix(e.c, e.p1, t), t);
+}
+
+// касательная (не нормирована); у вырожденной кривой в конце — хорда
+static Vec2 edge_direction(const Edge& e, double t)
+{
+    if (!e.curve)
+        return e.p1 - e.p0;
+
+    const Vec2 d = mix(e.c - e.p0, e.p1 - e.c, t);
+    if (d.x == 0.0 && d.y == 0.0)
+        return e.p1 - e.p0;
+    return d;
+}
+
+static void split_in_thirds(const Edge& e, Edge& a, Edge& b, Edge& c)
+{
+    a = b = c = e;
+    const Vec2 t1 = edge_point(e, 1.0 / 3.0);
+    const Vec2 t2 = edge_point(e, 2.0 / 3.0);
+    a.p1 = b.p0 = t1;
+    b.p1 = c.p0 = t2;
+    if (e.curve)
+    {
+        a.c = mix(e.p0, e.c, 1.0 / 3.0);
+        b.c = mix(mix(e.p0, e.c, 5.0 / 9.0), mix(e.c, e.p1, 4.0 / 9.0), 0.5);
+        c.c = mix(e.c, e.p1, 2.0 / 3.0);
+    }
+}
+
+static void include_point(Vec2 p, Vec2& lo, Vec2& hi)
+{
+    lo = { std::min(lo.x, p.x), std::min(lo.y, p.y) };
+    hi = { std::max(hi.x, p.x), std::max(hi.y, p.y) };
+}
+
+// точный bbox: концы + экстремумы кривой по осям
+static void edge_bounds(const Edge& e, Vec2& lo, Vec2& hi)
+{
+    include_point(e.p0, lo, hi);
+    include_point(e.p1, lo, hi);
+    if (!e.curve)
+        return;
+
+    const Vec2 den = e.p0 - 2.0 * e.c + e.p1;
+    if (den.x != 0.0)
+    {
+        const double t = (e.p0.x - e.c.x) / den.x;
+        if (t > 0.0 && t < 1.0)
+            include_point(edge_point(e, t), lo, hi);
+    }
+    if (den.y != 0.0)
+    {
+        const double t = (e.p0.y - e.c.y) / den.y;
+        if (t > 0.0 && t < 1.0)
+            include_point(edge_point(e, t), lo, hi);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Рёбра для ядра расстояний
+// ---------------------------------------------------------------------------
+
+// |b/a| кубики ближайшей точки, начиная с которого кривая считается отрезком: во float
+// нормировка на почти нулевой dot(br, br) теряет больше, чем отклонение кривой от хорды
+static constexpr double kMaxCubicRatio = 1e4;
+
+static void set2(float out[2], Vec2 v)
+{
+    out[0] = (float)v.x;
+    out[1] = (float)v.y;
+}
+
+static MsdfKernelEdge to_kernel_edge(const Edge& e)
+{
+    MsdfKernelEdge k{};
+    set2(k.p0, e.p0);
+    set2(k.p1, e.p1);
+    set2(k.c, e.c);
+    k.color = e.color;
+
+    if (e.curve)
+    {
+        const Vec2 ab = e.c - e.p0;
+        const Vec2 br = e.p1 - e.c - ab;
+        const double a = dot(br, br);
+        const double b = 3.0 * dot(ab, br);
+        if (a != 0.0 && std::fabs(b / a) < kMaxCubicRatio)
+        {
+            const Vec2 e1 = e.p1 - e.c;
+            k.curve = 1;
+            set2(k.ab, ab);
+            set2(k.br, br);
+            set2(k.e1, e1);
+            set2(k.dir0, normalize(edge_direction(e, 0.0)));
+            set2(k.dir1, normalize(edge_direction(e, 1.0)));
+            k.invAbLength2 = (float)(1.0 / dot(ab, ab));
+            k.invE1Length2 = (float)(1.0 / dot(e1, e1));
+            k.cubicA = (float)(b / a);
+            k.cubicB = (float)(2.0 * dot(ab, ab) / a);
+            set2(k.brA, (1.0 / a) * br);
+            set2(k.abA, (1.0 / a) * ab);
+            return k;
+        }
+    }
+
+    const Vec2 ab = e.p1 - e.p0;
+    set2(k.ab, ab);
+    set2(k.dir0, normalize(ab));
+    set2(k.dir1, normalize(ab));
+    k.invAbLength = (float)(1.0 / length(ab));
+    k.invAbLength2 = (float)(1.0 / dot(ab, ab));
+    return k;
+}
+
+// ---------------------------------------------------------------------------
+// Раскраска рёбер (edge coloring simple, Chlumsky)
+// ---------------------------------------------------------------------------
+
+static void switch_color(uint8_t& color, uint64_t& seed, uint8_t banned = kBlack)
+{
+    const uint8_t combined = color & banned;
+    if (combined == kRed || combined == kGreen || combined == kBlue)
+    {
+        color = combined ^ kWhite;
+        return;
+    }
+    if (color == kBlack || color == kWhite)
+    {
+        static const uint8_t kStart[3] = { kCyan, kMagenta, kYellow };
+        color = kStart[seed % 3];
+        seed /= 3;
+        return;
+    }
+    const uint32_t shifted = (uint32_t)color << (1 + (seed & 1));
+    color = (uint8_t)((shifted | shifted >> 3) & kWhite);
+    seed >>= 1;
+}
+
+// позиция ребра на сглаженном контуре с одним углом: -1, 0, 1 — три цвета по дуге
+static int symmetrical_trichotomy(int position, int n)
+{
+    return (int)(3.0 + 2.875 * position / (n - 1) - 1.4375 + 0.5) - 3;
+}
+
+static bool is_corner(Vec2 a, Vec2 b, double crossThreshold)
+{
+    return dot(a, b) <= 0.0 || std::fabs(cross(a, b)) > crossThreshold;
+}
+
+static void color_contour(std::vector<Edge>& edges, double crossThreshold, uint8_t& color, uint64_t& seed)
+{
+    std::vector<int> corners;
+    Vec2 prev = edge_direction(edges.back(), 1.0);
+    for (int i = 0; i < (int)edges.size(); ++i)
+    {
+        if (is_corner(normalize(prev), normalize(edge_direction(edges[i], 0.0)), crossThreshold))
+            corners.push_back(i);
+        prev = edge_direction(edges[i], 1.0);
+    }
+
+    const int m = (int)edges.size();
+    if (corners.empty())
+    {
+        // гладкий контур: один цвет
+        switch_color(color, seed);
+        for (Edge& e : edges)
+            e.color = color;
+    }
+    else if (corners.size() == 1)
+    {
+        // "капля": три цвета по дуге от угла к углу
+        uint8_t colors[3];
+        switch_color(color, seed);
+        colors[0] = color;
+        colors[1] = kWhite;
+        switch_color(color, seed);
+        colors[2] = color;
+
+        const int corner = corners[0];
+        if (m >= 3)
+        {
+            for (int i = 0; i < m; ++i)
+                edges[(corner + i) % m].color = colors[1 + symmetrical_trichotomy(i, m)];
+        }
+        else
+        {
+            // на три цвета не хватает рёбер: режем каждое на трети
+            std::array<Edge, 6> parts;
+            split_in_thirds(edges[0], parts[3 * corner], parts[1 + 3 * corner], parts[2 + 3 * corner]);
+            if (m == 2)
+            {
+                split_in_thirds(edges[1], parts[3 - 3 * corner], parts[4 - 3 * corner], parts[5 - 3 * corner]);
+                parts[0].color = parts[1].color = colors[0];
+                parts[2].color = parts[3].color = colors[1];
+                parts[4].color = parts[5].color = colors[2];
+            }
+            else
+            {
+                parts[0].color = colors[0];
+                parts[1].color = colors[1];
+                parts[2].color = colors[2];
+            }
+            edges.assign(parts.begin(), parts.begin() + 3 * m);
+        }
+    }
+    else
+    {
+        // несколько углов: цвет меняется на каждом, последний отрезок не совпадает с первым
+        const int cornerCount = (int)corners.size();
+        const int start = corners[0];
+        int spline = 0;
+        switch_color(color, seed);
+        const uint8_t initial = color;
+        for (int i = 0; i < m; ++i)
+        {
+            const int index = (start + i) % m;
+            if (spline + 1 < cornerCount && corners[spline + 1] == index)
+            {
+                ++spline;
+                switch_color(color, seed, spline == cornerCount - 1 ? initial : (uint8_t)kBlack);
+            }
+            edges[index].color = color;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Знак по заливке
+// ---------------------------------------------------------------------------
+
+static int solve_quadratic(double x[2], double a, double b, double c)
+{
+    // a ~ 0: уравнение линейное
+    if (a == 0.0 || std::fabs(b) > 1e12 * std::fabs(a))
+    {
+        if (b == 0.0)
+            return 0;
+        x[0] = -c / b;
+        return 1;
+    }
+
+    double disc = b * b - 4.0 * a * c;
+    if (disc > 0.0)
+    {
+        disc = std::sqrt(disc);
+        x[0] = (-b + disc) / (2.0 * a);
+        x[1] = (-b - disc) / (2.0 * a);
+        return 2;
+    }
+    if (disc == 0.0)
+    {
+        x[0] = -b / (2.0 * a);
+        return 1;
+    }
+    return 0;
+}
+
+
+struct Crossing
+{
+    double x;
+    int dir;
+};
+
+// пересечения ребра с горизонталью y; полуинтервалы (ya <= y) != (yb <= y) не считают
+// вершину дважды, а в экстремуме дают пару с разными знаками
+static void row_crossings(const Edge& e, double y, std::vector<Crossing>& out)
+{
+    if (!e.curve)
+    {
+        if ((e.p0.y <= y) != (e.p1.y <= y))
+        {
+            const double t = (y - e.p0.y) / (e.p1.y - e.p0.y);
+            out.push_back({ e.p0.x + t * (e.p1.x - e.p0.x), e.p1.y > e.p0.y ? 1 : -1 });
+        }
+        return;
+    }
+
+    // куски, монотонные по y
+    double bounds[3] = { 0.0, 1.0, 1.0 };
+    int pieces = 1;
+    const double den = e.p0.y - 2.0 * e.c.y + e.p1.y;
+    if (den != 0.0)
+    {
+        const double te = (e.p0.y - e.c.y) / den;
+        if (te > 0.0 && te < 1.0)
+        {
+            bounds[1] = te;
+            pieces = 2;
+        }
+    }
+
+    // y(t) = den·t² + 2(c - p0)·t + p0
+    const double qa = den;
+    const double qb = 2.0 * (e.c.y - e.p0.y);
+    const double qc = e.p0.y - y;
+    for (int k = 0; k < pieces; ++k)
+    {
+        const double t0 = bounds[k];
+        const double t1 = bounds[k + 1];
+        const double ya = edge_point(e, t0).y;
+        const double yb = edge_point(e, t1).y;
+        if ((ya <= y) == (yb <= y))
+            continue;
+
+        double roots[2];
+        const int n = solve_quadratic(roots, qa, qb, qc);
+        double t = 0.5 * (t0 + t1);
+        double bestOut = DBL_MAX;
+        for (int r = 0; r < n; ++r)
+        {
+            const double outside = std::max(t0 - roots[r], roots[r] - t1);
+            if (outside < bestOut)
+            {
+                bestOut = outside;
+                t = std::clamp(roots[r], t0, t1);
+            }
+        }
+        out.push_back({ edge_point(e, t).x, yb > ya ? 1 : -1 });
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Исправление конфликтов (msdfgen legacy error correction)
+// ---------------------------------------------------------------------------
+
+// Канал, сильнее всех меняющийся между a и b, при интерполяции пересекает 0.5 там, где
+// медиана не должна: такой тексель (тот из пары, что дальше от края) — артефакт
+static bool detect_clash(const float* a, const float* b, float threshold)
+{
+    float a0 = a[0], a1 = a[1], a2 = a[2];
+    float b0 = b[0], b1 = b[1], b2 = b[2];
+
+    // пары по убыванию |b - a|
+    if (std::fabs(b0 - a0) < std::fabs(b1 - a1))
+    {
+        std::swap(a0, a1);
+        std::swap(b0, b1);
+    }
+    if (std::fabs(b1 - a1) < std::fabs(b2 - a2))
+    {
+        std::swap(a1, a2);
+        std::swap(b1, b2);
+        if (std::fabs(b0 - a0) < std::fabs(b1 - a1))
+        {
+            std::swap(a0, a1);
+            std::swap(b0, b1);
+        }
+    }
+
+    return std::fabs(b1 - a1) >= threshold &&
+           !(b0 == b1 && b0 == b2) && // сосед уже сброшен в медиану
+           std::fabs(a2 - 0.5f) >= std::fabs(b2 - 0.5f);
+}
+
+static void correct_clashes(float* field, uint32_t w, uint32_t h, float threshold, std::vector<uint8_t>& clashes)
+{
+    clashes.assign((size_t)w * h, 0);
+    for (uint32_t y = 0; y < h; ++y)
+    {
+        for (uint32_t x = 0; x < w; ++x)
+        {
+            const float* t = field + ((size_t)y * w + x) * 3;
+            clashes[(size_t)y * w + x] =
+                (x > 0 && detect_clash(t, t - 3, threshold)) ||
+                (x + 1 < w && detect_clash(t, t + 3, threshold)) ||
+                (y > 0 && detect_clash(t, t - (size_t)w * 3, threshold)) ||
+                (y + 1 < h && detect_clash(t, t + (size_t)w * 3, threshold));
+        }
+    }
+
+    for (size_t i = 0; i < clashes.size(); ++i)
+    {
+        if (!clashes[i])
+            continue;
+        float* t = field + i * 3;
+        t[0] = t[1] = t[2] = median3(t[0], t[1], t[2]);
+    }
+}
+
+// как msdfgen pixelFloatToByte
+static uint8_t to_byte(float v)
+{
+    return (uint8_t)std::clamp(256.0f * v, 0.0f, 255.0f);
+}
+
+// ---------------------------------------------------------------------------
+// MsdfGenerator
+// ---------------------------------------------------------------------------
+
+bool MsdfGenerator::buildJob(const TrueTypeFont& ttf, uint32_t glyph, TtfOutline& outline, GlyphJob& job,
+                             uint32_t& broken) const
+{
+    if (!ttf.outline(glyph, outline))
+    {
+        ++broken;
+        return false;
+    }
+    return buildJob(outline, job);
+}
+
+bool MsdfGenerator::buildJob(const TtfOutline& outline, GlyphJob& job) const
+{
+    const double scale = m_params.emSize;
+    const double range = m_params.pxRange / m_params.emSize; // em
+    const double crossThreshold = std::sin(m_params.angleThreshold);
+
+    // цвет и seed общие на весь глиф: соседние контуры получают разные цвета
+    uint8_t color = kWhite;
+    uint64_t seed = 0;
+    std::vector<Edge> contour;
+    for (const TtfContour& tc : outline.contours)
+    {
+        contour.clear();
+        for (const TtfSegment& s : tc.segments)
+        {
+            Edge e;
+            e.p0 = { s.p0.x, s.p0.y };
+            e.c = { s.c.x, s.c.y };
+            e.p1 = { s.p1.x, s.p1.y };
+            e.curve = s.curve && !(e.c == e.p0) && !(e.c == e.p1);
+            if (e.p0 == e.p1 && (!e.curve || e.c == e.p0))
+                continue;
+            contour.push_back(e);
+        }
+        if (contour.empty())
+            continue;
+
+        color_contour(contour, crossThreshold, color, seed);
+        job.edges.insert(job.edges.end(), contour.begin(), contour.end());
+    }
+
+    // пробел и т.п.: только advance
+    if (job.edges.empty())
+        return false;
+
+    job.kernelEdges.reserve(job.edges.size());
+    for (const Edge& e : job.edges)
+        job.kernelEdges.push_back(to_kernel_edge(e));
+
+    Vec2 lo{ DBL_MAX, DBL_MAX };
+    Vec2 hi{ -DBL_MAX, -DBL_MAX };
+    for (const Edge& e : job.edges)
+        edge_bounds(e, lo, hi);
+
+    // бокс: bbox + половина range с каждой стороны, до целых текселей (+1 на центры по краям)
+    lo = lo - Vec2{ 0.5 * range, 0.5 * range };
+    hi = hi + Vec2{ 0.5 * range, 0.5 * range };
+    const double w = scale * (hi.x - lo.x);
+    const double h = scale * (hi.y - lo.y);
+    job.w = (uint32_t)std::ceil(w) + 1;
+    job.h = (uint32_t)std::ceil(h) + 1;
+    job.x0 = lo.x - 0.5 * (job.w - w) / scale + 0.5 / scale;
+    job.y0 = lo.y - 0.5 * (job.h - h) / scale + 0.5 / scale;
+    return true;
+}
+
+bool MsdfGenerator::layout(const TrueTypeFont& ttf, const std::vector<uint32_t>& codepoints, const MsdfGeneratorParams& params)
+{
+    m_params = params;
+    m_header = FontPackHeader{};
+    m_glyphs.clear();
+    m_kerning.clear();
+    m_jobs.clear();
+    m_pixels.clear();
+
+    std::vector<uint32_t> cps = codepoints;
+    std::sort(cps.begin(), cps.end());
+    cps.erase(std::unique(cps.begin(), cps.end()), cps.end());
+
+    const double scale = params.emSize;
+
+    // glyph index ttf -> codepoint'ы (для кернинга)
+    std::unordered_map<uint32_t, std::vector<uint32_t>> glyphCodepoints;
+    uint32_t missing = 0;
+    uint32_t broken = 0;
+
+    TtfOutline outline;
+    for (const uint32_t cp : cps)
+    {
+        const uint32_t g = ttf.glyphIndex(cp);
+        if (g == 0)
+        {
+            ++missing;
+            continue;
+        }
+        glyphCodepoints[g].push_back(cp);
+
+        FontPackGlyph fg{};
+        fg.codepoint = cp;
+        fg.advance = ttf.advance(g);
+        m_glyphs.push_back(fg);
+
+        GlyphJob job;
+        job.glyph = (uint32_t)m_glyphs.size() - 1;
+        if (!buildJob(ttf, g, outline, job, broken))
+            continue;
+
+        // quad — по центрам крайних текселей
+        fg.flags |= FONT_PACK_GLYPH_HAS_PLANE;
+        fg.planeLeft = (float)job.x0;
+        fg.planeBottom = (float)job.y0;
+        fg.planeRight = (float)(job.x0 + (job.w - 1) / scale);
+        fg.planeTop = (float)(job.y0 + (job.h - 1) / scale);
+        m_glyphs.back() = fg;
+
+        m_jobs.push_back(std::move(job));
+    }
+
+    if (missing || broken)
+        std::cerr << "MSDF: " << missing << " codepoints not in font, " << broken << " glyphs with broken outlines\n";
+
+    if (m_glyphs.empty())
+    {
+        std::cerr << "MSDF: no glyphs to generate\n";
+        return false;
+    }
+
+    // полки: высокие глифы первыми; дорогие глифы заодно попадают в начало очереди пула
+    std::sort(m_jobs.begin(), m_jobs.end(), [](const GlyphJob& a, const GlyphJob& b)
+    {
+        return a.h != b.h ? a.h > b.h : a.w > b.w;
+    });
+
+    uint64_t area = 0;
+    uint32_t widest = 1;
+    for (const GlyphJob& job : m_jobs)
+    {
+        area += (uint64_t)job.w * job.h;
+        widest = std::max(widest, job.w);
+    }
+
+    // почти квадрат с запасом на пустоты полок; стороны кратны 4 (блоки BCn, если понадобятся)
+    const uint32_t width = (std::max(widest, (uint32_t)std::ceil(std::sqrt((double)area * 1.15))) + 3u) & ~3u;
+    uint32_t x = 0, y = 0, shelf = 0;
+    for (GlyphJob& job : m_jobs)
+    {
+        if (x + job.w > width)
+        {
+            y += shelf;
+            x = 0;
+            shelf = 0;
+        }
+        job.x = x;
+        job.y = y;
+        x += job.w;
+        shelf = std::max(shelf, job.h);
+
+        FontPackGlyph& fg = m_glyphs[job.glyph];
+        fg.flags |= FONT_PACK_GLYPH_HAS_ATLAS;
+        fg.atlasLeft = (float)job.x + 0.5f;
+        fg.atlasBottom = (float)job.y + 0.5f;
+        fg.atlasRight = (float)(job.x + job.w) - 0.5f;
+        fg.atlasTop = (float)(job.y + job.h) - 0.5f;
+    }
+    const uint32_t height = (std::max(y + shelf, 1u) + 3u) & ~3u;
+
+    if (width > kMaxAtlasSize || height > kMaxAtlasSize)
+    {
+        std::cerr << "MSDF: atlas " << width << "x" << height << " exceeds " << kMaxAtlasSize
+                  << " (reduce emSize or the charset)\n";
+        return false;
+    }
+
+    // кернинг: пары kern по glyph index'ам -> пары codepoint'ов набора
+    std::vector<TtfKerningPair> pairs;
+    ttf.kerningPairs(pairs);
+    for (const TtfKerningPair& p : pairs)
+    {
+        const auto l = glyphCodepoints.find(p.left);
+        const auto r = glyphCodepoints.find(p.right);
+        if (l == glyphCodepoints.end() || r == glyphCodepoints.end())
+            continue;
+        for (const uint32_t a : l->second)
+            for (const uint32_t b : r->second)
+                m_kerning.push_back({ a, b, p.advance });
+    }
+    std::sort(m_kerning.begin(), m_kerning.end(), [](const FontPackKerning& a, const FontPackKerning& b)
+    {
+        return a.unicode1 != b.unicode1 ? a.unicode1 < b.unicode1 : a.unicode2 < b.unicode2;
+    });
+    m_kerning.erase(std::unique(m_kerning.begin(), m_kerning.end(), [](const FontPackKerning& a, const FontPackKerning& b)
+    {
+        return a.unicode1 == b.unicode1 && a.unicode2 == b.unicode2;
+    }), m_kerning.end());
+
+    // plane bounds в em, как msdf-atlas-gen с нормализацией em
+    const TtfMetrics& m = ttf.metrics();
+    m_header.flags = FONT_PACK_ATLAS_Y_BOTTOM;
+    m_header.atlasWidth = width;
+    m_header.atlasHeight = height;
+    m_header.pxRange = params.pxRange;
+    m_header.emSize = 1.0f;
+    m_header.lineHeight = m.lineHeight;
+    m_header.ascender = m.ascender;
+    m_header.descender = m.descender;
+    m_header.underlineY = m.underlineY;
+    m_header.underlineThickness = m.underlineThickness;
+    return true;
+}
+
+void MsdfGenerator::rasterize(WorkStealingPool& pool)
+{
+    // фон: вне глифов — далеко снаружи
+    m_pixels.assign((size_t)m_header.atlasWidth * m_header.atlasHeight * 4, 0);
+    for (size_t i = 3; i < m_pixels.size(); i += 4)
+        m_pixels[i] = 255;
+
+    m_scratch.resize(pool.threadCount());
+
+    pool.parallelFor((uint32_t)m_jobs.size(), 1, [this](uint32_t begin, uint32_t end, uint32_t worker)
+    {
+        // бокс в атласе: y снизу, строки атласа — сверху вниз
+        const size_t pitch = (size_t)m_header.atlasWidth * 4;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const GlyphJob& job = m_jobs[i];
+            uint8_t* top = m_pixels.data() + (m_header.atlasHeight - (job.y + job.h)) * pitch + (size_t)job.x * 4;
+            rasterizeGlyph(job, m_scratch[worker], top, pitch);
+        }
+    });
+}
+
+bool MsdfGenerator::rasterizeGlyphs(const TrueTypeFont& ttf, const uint32_t* glyphs, uint32_t count,
+                                    const MsdfGeneratorParams& params, MsdfGlyphBitmap* out, WorkStealingPool& pool)
+{
+    m_params = params;
+    const double scale = params.emSize;
+
+    // контуры и раскраска последовательно (дёшево), поле — параллельно
+    std::vector<GlyphJob> jobs;
+    uint32_t broken = 0;
+    TtfOutline outline;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        MsdfGlyphBitmap& bm = out[i];
+        bm = MsdfGlyphBitmap{};
+
+        GlyphJob job;
+        job.glyph = i;
+        if (!buildJob(ttf, glyphs[i], outline, job, broken))
+            continue;
+
+        bm.hasPlane = true;
+        bm.planeLeft = (float)job.x0;
+        bm.planeBottom = (float)job.y0;
+        bm.planeRight = (float)(job.x0 + (job.w - 1) / scale);
+        bm.planeTop = (float)(job.y0 + (job.h - 1) / scale);
+        bm.width = job.w;
+        bm.height = job.h;
+        bm.rgba.assign((size_t)job.w * job.h * 4, 255);
+        jobs.push_back(std::move(job));
+    }
+
+    m_scratch.resize(pool.threadCount());
+
+    pool.parallelFor((uint32_t)jobs.size(), 1, [&](uint32_t begin, uint32_t end, uint32_t worker)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            MsdfGlyphBitmap& bm = out[jobs[i].glyph];
+            rasterizeGlyph(jobs[i], m_scratch[worker], bm.rgba.data(), (size_t)bm.width * 4);
+        }
+    });
+    return broken == 0;
+}
+
+void MsdfGenerator::rasterizeGlyph(const GlyphJob& job, Scratch& scratch, uint8_t* top, size_t pitch)
+{
+    const double scale = m_params.emSize;
+    const float invRange = m_params.emSize / m_params.pxRange; // em -> доли range
+    std::vector<float>& field = scratch.field;
+    field.resize((size_t)job.w * job.h * 3);
+    scratch.channels.resize((size_t)job.w * 3);
+    float* const r = scratch.channels.data();
+    float* const g = r + job.w;
+    float* const b = g + job.w;
+
+    std::vector<Crossing> crossings;
+    for (uint32_t j = 0; j < job.h; ++j)
+    {
+        const double py = job.y0 + j / scale;
+        msdfDistanceRow(job.kernelEdges.data(), (uint32_t)job.kernelEdges.size(), (float)job.x0, (float)(1.0 / scale),
+                        (float)py, job.w, r, g, b);
+
+        crossings.clear();
+        for (const Edge& e : job.edges)
+            row_crossings(e, py, crossings);
+        std::sort(crossings.begin(), crossings.end(), [](const Crossing& a, const Crossing& b) { return a.x < b.x; });
+
+        size_t next = 0;
+        int winding = 0;
+        float* row = field.data() + (size_t)j * job.w * 3;
+        for (uint32_t i = 0; i < job.w; ++i)
+        {
+            float* t = row + i * 3;
+            t[0] = r[i] * invRange + 0.5f;
+            t[1] = g[i] * invRange + 0.5f;
+            t[2] = b[i] * invRange + 0.5f;
+
+            // nonzero: медиана должна быть по ту же сторону 0.5, что и заливка. Исправляет
+            // контуры с неверной ориентацией и ошибки выбора ребра на стыках контуров
+            const double px = job.x0 + i / scale;
+            while (next < crossings.size() && crossings[next].x < px)
+                winding += crossings[next++].dir;
+            const bool fill = winding != 0;
+            const float med = median3(t[0], t[1], t[2]);
+            if ((fill && med < 0.5f) || (!fill && med > 0.5f))
+            {
+                for (int ch = 0; ch < 3; ++ch)
+                    t[ch] = 1.0f - t[ch];
+            }
+        }
+    }
+
+    correct_clashes(field.data(), job.w, job.h, m_params.clashThreshold / m_params.pxRange, scratch.clashes);
+
+    // поле снизу вверх, выход — сверху вниз; альфу не трогаем
+    for (uint32_t j = 0; j < job.h; ++j)
+    {
+        const float* src = field.data() + (size_t)j * job.w * 3;
+        uint8_t* dst = top + (job.h - 1 - j) * pitch;
+        for (uint32_t i = 0; i < job.w; ++i)
+        {
+            dst[i * 4 + 0] = to_byte(src[i * 3 + 0]);
+            dst[i * 4 + 1] = to_byte(src[i * 3 + 1]);
+            dst[i * 4 + 2] = to_byte(src[i * 3 + 2]);
+        }
+    }
+}
+
+// расстояние в ulp между float одного знака; разные знаки — через 0
+static uint32_t ulp_distance(float a, float b)
+{
+    int32_t ia, ib;
+    std::memcpy(&ia, &a, 4);
+    std::memcpy(&ib, &b, 4);
+    // порядок битов как у чисел: отрицательные зеркалим
+    const int64_t la = ia < 0 ? (int64_t)INT32_MIN - ia : ia;
+    const int64_t lb = ib < 0 ? (int64_t)INT32_MIN - ib : ib;
+    const int64_t d = la > lb ? la - lb : lb - la;
+    return d > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+}
+
+MsdfGenerator::KernelCheck MsdfGenerator::checkKernel(SimdLevel level, uint32_t toleranceUlps) const
+{
+    const SimdLevel prev = msdfKernelSimdLevel();
+    KernelCheck result;
+    result.level = msdfKernelSetSimdLevel(level);
+
+    const double scale = m_params.emSize;
+    std::vector<float> ref, simd;
+    for (const GlyphJob& job : m_jobs)
+    {
+        ref.resize((size_t)job.w * 3);
+        simd.resize((size_t)job.w * 3);
+        for (uint32_t j = 0; j < job.h; ++j)
+        {
+            const float py = (float)(job.y0 + j / scale);
+            msdfKernelSetSimdLevel(SimdLevel::Scalar);
+            msdfDistanceRow(job.kernelEdges.data(), (uint32_t)job.kernelEdges.size(), (float)job.x0, (float)(1.0 / scale),
+                            py, job.w, ref.data(), ref.data() + job.w, ref.data() + 2 * job.w);
+            msdfKernelSetSimdLevel(result.level);
+            msdfDistanceRow(job.kernelEdges.data(), (uint32_t)job.kernelEdges.size(), (float)job.x0, (float)(1.0 / scale),
+                            py, job.w, simd.data(), simd.data() + job.w, simd.data() + 2 * job.w);
+
+            for (size_t i = 0; i < ref.size(); ++i)
+            {
+                const uint32_t ulps = ulp_distance(ref[i], simd[i]);
+                result.maxUlps = std::max(result.maxUlps, ulps);
+                if (ulps > toleranceUlps)
+                    ++result.mismatches;
+            }
+            result.values += ref.size();
+        }
+    }
+
+    msdfKernelSetSimdLevel(prev);
+    return result;
+}
+
+MsdfGenerator::KernelCheck MsdfGenerator::checkKernel(const std::vector<TtfOutline>& outlines, const MsdfGeneratorParams& params,
+                                                      SimdLevel level, uint32_t toleranceUlps)
+{
+    MsdfGenerator gen;
+    gen.m_params = params;
+    for (const TtfOutline& outline : outlines)
+    {
+        GlyphJob job;
+        if (gen.buildJob(outline, job))
+            gen.m_jobs.push_back(std::move(job));
+    }
+    return gen.checkKernel(level, toleranceUlps);
+}
+
+bool MsdfGenerator::writePack(const std::string& path) const
+{
+    if (m_pixels.empty())
+    {
+        std::cerr << "MSDF: atlas not rasterized\n";
+        return false;
+    }
+    return writeFontPack(path, m_header, m_glyphs, m_kerning, m_pixels.data());
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "vk/FontPack.h"
+#include "vk/MsdfKernel.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TrueTypeFont;
+class WorkStealingPool;
+struct TtfOutline;
+
+struct MsdfGeneratorParams
+{
+    float emSize = 48.0f;          // px на em в атласе (msdf-atlas-gen -size)
+    float pxRange = 4.0f;          // ширина поля расстояний, px (-pxrange)
+    float angleThreshold = 3.0f;   // рад: излом контура острее — угол, на нём меняется цвет рёбер
+    float clashThreshold = 1.001f; // px: скачок канала между соседними текселями, после которого это артефакт
+};
+
+// Глиф, растеризованный вне атласа (MsdfGenerator::rasterizeGlyphs)
+struct MsdfGlyphBitmap
+{
+    bool hasPlane = false; // false — контура нет (пробел) или он битый: только advance
+    float planeLeft = 0, planeBottom = 0, planeRight = 0, planeTop = 0; // em, по центрам крайних текселей
+    uint32_t width = 0, height = 0;
+    std::vector<uint8_t> rgba; // RGBA8, строки сверху вниз
+};
+
+// MSDF атлас из контуров TrueType прямо в layout font pack'а, который читает MsdfFont:
+// таблица глифов с planeBounds (em) и atlasBounds (px, y снизу), RGBA8 строками сверху вниз.
+// Геометрия боксов и округление — как у msdf-atlas-gen -type msdf -yorigin bottom.
+//
+// Глиф: рёбра раскрашиваются в R/G/B так, чтобы на каждом угле контура сходились разные
+// каналы; канал текселя — псевдо-расстояние до ближайшего ребра своего цвета. Знак потом
+// сверяется с заливкой строки (nonzero), а тексели, между которыми билинейная интерполяция
+// даст ложный край, сбрасываются в медиану.
+//
+// layout() идёт последовательно (контуры, раскраска, упаковка), rasterize() — параллельно
+// по глифам на WorkStealingPool: каждый глиф пишет только свой прямоугольник атласа.
+class MsdfGenerator
+{
+public:
+    // Codepoint'ы без глифа в ttf пропускаются. false — ни одного глифа или атлас не влез
+    bool layout(const TrueTypeFont& ttf, const std::vector<uint32_t>& codepoints, const MsdfGeneratorParams& params);
+
+    // Заполняет pixels(); можно звать повторно (бенчмарк), результат не меняется
+    void rasterize(WorkStealingPool& pool);
+
+    bool writePack(const std::string& path) const;
+
+    // Глифы по glyph index ttf мимо layout'а — для динамического атласа (DynamicGlyphAtlas).
+    // Бокс и plane bounds те же, что дал бы layout(); out[i] — для glyphs[i].
+    // false — были битые контуры (такие глифы остаются без plane)
+    bool rasterizeGlyphs(const TrueTypeFont& ttf, const uint32_t* glyphs, uint32_t count,
+                         const MsdfGeneratorParams& params, MsdfGlyphBitmap* out, WorkStealingPool& pool);
+
+    // Сверка SIMD пути ядра расстояний со scalar эталоном на всех текселях layout'а
+    struct KernelCheck
+    {
+        SimdLevel level = SimdLevel::Scalar; // реально проверенный путь
+        uint64_t values = 0;                 // сравнено значений (тексель × канал)
+        uint64_t mismatches = 0;             // разошлись больше чем на toleranceUlps
+        uint32_t maxUlps = 0;
+    };
+
+    // Однопоточно; на время сверки переключает msdfKernelSetSimdLevel, потом возвращает
+    KernelCheck checkKernel(SimdLevel level, uint32_t toleranceUlps) const;
+
+    // То же на готовых контурах (em) без ttf и атласа: рёбра, раскраска и боксы — как у layout()
+    static KernelCheck checkKernel(const std::vector<TtfOutline>& outlines, const MsdfGeneratorParams& params,
+                                   SimdLevel level, uint32_t toleranceUlps);
+
+    uint32_t glyphCount() const { return (uint32_t)m_glyphs.size(); }
+    uint32_t rasterGlyphCount() const { return (uint32_t)m_jobs.size(); } // с контуром
+    uint32_t kerningCount() const { return (uint32_t)m_kerning.size(); }
+    uint32_t atlasWidth() const { return m_header.atlasWidth; }
+    uint32_t atlasHeight() const { return m_header.atlasHeight; }
+
+    const std::vector<uint8_t>& pixels() const { return m_pixels; }
+
+    static constexpr uint32_t kMaxAtlasSize = 16384;
+
+    struct Vec2
+    {
+        double x = 0.0, y = 0.0;
+    };
+
+    // Отрезок контура в em; color — биты каналов (1 R, 2 G, 4 B)
+    struct Edge
+    {
+        Vec2 p0, c, p1;
+        bool curve = false;
+        uint8_t color = 7;
+    };
+
+private:
+    // Глиф с контуром: рёбра всех контуров подряд, бокс в атласе (px, y снизу),
+    // центр текселя (i, j) бокса — em (x0 + i / emSize, y0 + j / emSize)
+    struct GlyphJob
+    {
+        uint32_t glyph = 0; // в m_glyphs (rasterizeGlyphs: индекс выхода)
+        std::vector<Edge> edges;
+        std::vector<MsdfKernelEdge> kernelEdges; // те же рёбра во float для msdfDistanceRow
+        uint32_t x = 0, y = 0, w = 0, h = 0;
+        double x0 = 0.0, y0 = 0.0;
+    };
+
+    // буферы рабочего пула
+    struct Scratch
+    {
+        std::vector<float> field;    // float RGB текселей бокса, снизу вверх
+        std::vector<float> channels; // R, G, B строки подряд (выход ядра)
+        std::vector<uint8_t> clashes;
+    };
+
+    // рёбра, раскраска и бокс по m_params; false — контура нет (пробел) или он битый (++broken)
+    bool buildJob(const TrueTypeFont& ttf, uint32_t glyph, TtfOutline& outline, GlyphJob& job, uint32_t& broken) const;
+    bool buildJob(const TtfOutline& outline, GlyphJob& job) const;
+
+    // top — левый верхний тексель бокса, pitch — байт на строку
+    void rasterizeGlyph(const GlyphJob& job, Scratch& scratch, uint8_t* top, size_t pitch);
+
+private:
+    MsdfGeneratorParams m_params;
+
+    FontPackHeader m_header{};
+    std::vector<FontPackGlyph> m_glyphs;
+    std::vector<FontPackKerning> m_kerning;
+    std::vector<GlyphJob> m_jobs;
+
+    std::vector<uint8_t> m_pixels;
+
+    std::vector<Scratch> m_scratch; // по рабочему пула
+};
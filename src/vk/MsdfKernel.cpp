@@ -0,0 +1,122 @@
+#include "vk/MsdfKernel.h"
+
+#include <cmath>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Scalar: эталон, тот же шаблон на одном lane'е
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+struct MaskF1
+{
+    bool m;
+};
+
+struct VecF1
+{
+    static constexpr uint32_t kLanes = 1;
+    using Mask = MaskF1;
+
+    float v;
+
+    VecF1() = default;
+    VecF1(float x) : v(x) {}
+
+    static VecF1 iota() { return VecF1(0.0f); }
+    void store(float* p) const { *p = v; }
+};
+
+inline VecF1 operator+(VecF1 a, VecF1 b) { return a.v + b.v; }
+inline VecF1 operator-(VecF1 a, VecF1 b) { return a.v - b.v; }
+inline VecF1 operator*(VecF1 a, VecF1 b) { return a.v * b.v; }
+inline VecF1 operator/(VecF1 a, VecF1 b) { return a.v / b.v; }
+
+inline MaskF1 operator<(VecF1 a, VecF1 b) { return { a.v < b.v }; }
+inline MaskF1 operator<=(VecF1 a, VecF1 b) { return { a.v <= b.v }; }
+inline MaskF1 operator>(VecF1 a, VecF1 b) { return { a.v > b.v }; }
+inline MaskF1 operator>=(VecF1 a, VecF1 b) { return { a.v >= b.v }; }
+inline MaskF1 operator==(VecF1 a, VecF1 b) { return { a.v == b.v }; }
+inline MaskF1 operator&(MaskF1 a, MaskF1 b) { return { a.m && b.m }; }
+inline MaskF1 operator|(MaskF1 a, MaskF1 b) { return { a.m || b.m }; }
+
+inline VecF1 select(MaskF1 m, VecF1 a, VecF1 b) { return m.m ? a : b; }
+inline VecF1 vsqrt(VecF1 a) { return std::sqrt(a.v); }
+inline VecF1 vabs(VecF1 a) { return std::fabs(a.v); }
+inline VecF1 vmin(VecF1 a, VecF1 b) { return a.v < b.v ? a : b; }
+inline VecF1 vmax(VecF1 a, VecF1 b) { return a.v > b.v ? a : b; }
+
+// биты float как int, делённые на 3, плюс магическая константа: ∛ с точностью ~5%
+inline VecF1 cbrt_estimate(VecF1 a)
+{
+    int32_t bits;
+    std::memcpy(&bits, &a.v, 4);
+    bits = (int32_t)((float)bits * (1.0f / 3.0f)) + 0x2a514067;
+    float r;
+    std::memcpy(&r, &bits, 4);
+    return r;
+}
+
+} // namespace
+
+#include "vk/MsdfKernelImpl.h"
+
+static void distance_row_scalar(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                                uint32_t count, float* r, float* g, float* b)
+{
+    distance_row<VecF1>(edges, edgeCount, x0, dx, y, count, r, g, b);
+}
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+using DistanceRowFn = void (*)(const MsdfKernelEdge*, uint32_t, float, float, float, uint32_t, float*, float*, float*);
+
+struct MsdfKernelDispatch
+{
+    SimdLevel level;
+    DistanceRowFn distanceRow;
+};
+
+static MsdfKernelDispatch make_dispatch(SimdLevel level)
+{
+#if APP_ARCH_X86
+    switch (level)
+    {
+    case SimdLevel::AVX512: return { SimdLevel::AVX512, msdfDistanceRowAvx512 };
+    case SimdLevel::AVX2: return { SimdLevel::AVX2, msdfDistanceRowAvx2 };
+    case SimdLevel::SSE2:
+    case SimdLevel::Scalar: break;
+    }
+#else
+    (void)level;
+#endif
+    return { SimdLevel::Scalar, distance_row_scalar };
+}
+
+static MsdfKernelDispatch& dispatch()
+{
+    static MsdfKernelDispatch d = make_dispatch(cpuSimdLevel());
+    return d;
+}
+
+void msdfDistanceRow(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                     uint32_t count, float* r, float* g, float* b)
+{
+    dispatch().distanceRow(edges, edgeCount, x0, dx, y, count, r, g, b);
+}
+
+SimdLevel msdfKernelSimdLevel()
+{
+    return dispatch().level;
+}
+
+SimdLevel msdfKernelSetSimdLevel(SimdLevel level)
+{
+    const SimdLevel cpu = cpuSimdLevel();
+    dispatch() = make_dispatch(level < cpu ? level : cpu);
+    return dispatch().level;
+}
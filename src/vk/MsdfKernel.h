@@ -0,0 +1,52 @@
+#pragma once
+
+#include "platform/CpuFeatures.h"
+
+#include <cstdint>
+
+// Ребро контура для ядра расстояний (float, em). Всё, что не зависит от текселя,
+// посчитано заранее (MsdfGenerator::layout). Почти прямые кривые приходят отрезками.
+struct MsdfKernelEdge
+{
+    float p0[2];
+    float p1[2];
+    float c[2];    // контрольная точка (у отрезка не используется)
+    float ab[2];   // кривая: c - p0; отрезок: p1 - p0
+    float br[2];   // кривая: p1 - c - ab
+    float e1[2];   // кривая: p1 - c
+    float dir0[2]; // нормированная касательная в p0
+    float dir1[2]; // нормированная касательная в p1
+    float invAbLength;  // отрезок: 1 / |ab|
+    float invAbLength2; // 1 / dot(ab, ab)
+    float invE1Length2; // кривая: 1 / dot(e1, e1)
+
+    // кривая: ближайшая точка — корень t³ + cubicA·t² + B·t + C, где
+    // B = cubicB + dot(p0 - p, brA), C = dot(p0 - p, abA) (нормировка на dot(br, br))
+    float cubicA;
+    float cubicB;
+    float brA[2];
+    float abA[2];
+
+    uint32_t color; // биты каналов: 1 R, 2 G, 4 B
+    uint32_t curve; // 0 — отрезок
+};
+
+// Канал без единого ребра своего цвета: далеко снаружи (после нормализации — 0)
+static constexpr float kMsdfNoEdgeDistance = -1e6f;
+
+// Псевдо-расстояния R, G, B (em, > 0 — справа по ходу рёбер) для count текселей строки,
+// центр i-го — (x0 + i * dx, y). По каналу — ребро этого цвета с минимальным |расстоянием|
+// (при равенстве — то, к которому точка ближе по нормали), за его концами — расстояние до
+// продолжения касательной.
+//
+// Scalar путь — эталон: SIMD пути (8 текселей AVX2, 16 AVX-512) исполняют тот же шаблон
+// (MsdfKernelImpl.h) с теми же операциями в том же порядке, без FMA.
+void msdfDistanceRow(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                     uint32_t count, float* r, float* g, float* b);
+
+// Текущий путь dispatch (по умолчанию cpuSimdLevel(); у SSE2 своего пути нет — scalar).
+SimdLevel msdfKernelSimdLevel();
+
+// Принудительно понизить уровень (бенчмарки/сверка со scalar). Не потокобезопасно:
+// вызывать до начала работы. Возвращает реально выставленный уровень.
+SimdLevel msdfKernelSetSimdLevel(SimdLevel level);
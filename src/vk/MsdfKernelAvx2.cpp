@@ -0,0 +1,69 @@
+// Путь AVX2: 8 текселей. Файл собирается с -mavx2 (CMakeLists.txt), вызывается только
+// через dispatch MsdfKernel.cpp, когда cpuSimdLevel() >= AVX2.
+
+#include "vk/MsdfKernel.h"
+
+#if APP_ARCH_X86
+
+#include <immintrin.h>
+
+namespace
+{
+
+struct MaskF8
+{
+    __m256 m;
+};
+
+struct VecF8
+{
+    static constexpr uint32_t kLanes = 8;
+    using Mask = MaskF8;
+
+    __m256 v;
+
+    VecF8() = default;
+    VecF8(float x) : v(_mm256_set1_ps(x)) {}
+    VecF8(__m256 x) : v(x) {}
+
+    static VecF8 iota() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline VecF8 operator+(VecF8 a, VecF8 b) { return _mm256_add_ps(a.v, b.v); }
+inline VecF8 operator-(VecF8 a, VecF8 b) { return _mm256_sub_ps(a.v, b.v); }
+inline VecF8 operator*(VecF8 a, VecF8 b) { return _mm256_mul_ps(a.v, b.v); }
+inline VecF8 operator/(VecF8 a, VecF8 b) { return _mm256_div_ps(a.v, b.v); }
+
+inline MaskF8 operator<(VecF8 a, VecF8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline MaskF8 operator<=(VecF8 a, VecF8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline MaskF8 operator>(VecF8 a, VecF8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline MaskF8 operator>=(VecF8 a, VecF8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline MaskF8 operator==(VecF8 a, VecF8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+inline MaskF8 operator&(MaskF8 a, MaskF8 b) { return { _mm256_and_ps(a.m, b.m) }; }
+inline MaskF8 operator|(MaskF8 a, MaskF8 b) { return { _mm256_or_ps(a.m, b.m) }; }
+
+inline VecF8 select(MaskF8 m, VecF8 a, VecF8 b) { return _mm256_blendv_ps(b.v, a.v, m.m); }
+inline VecF8 vsqrt(VecF8 a) { return _mm256_sqrt_ps(a.v); }
+inline VecF8 vabs(VecF8 a) { return _mm256_and_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))); }
+inline VecF8 vmin(VecF8 a, VecF8 b) { return _mm256_min_ps(a.v, b.v); }
+inline VecF8 vmax(VecF8 a, VecF8 b) { return _mm256_max_ps(a.v, b.v); }
+
+inline VecF8 cbrt_estimate(VecF8 a)
+{
+    const __m256 bits = _mm256_cvtepi32_ps(_mm256_castps_si256(a.v));
+    const __m256i third = _mm256_cvttps_epi32(_mm256_mul_ps(bits, _mm256_set1_ps(1.0f / 3.0f)));
+    return _mm256_castsi256_ps(_mm256_add_epi32(third, _mm256_set1_epi32(0x2a514067)));
+}
+
+} // namespace
+
+#include "vk/MsdfKernelImpl.h"
+
+void msdfDistanceRowAvx2(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                         uint32_t count, float* r, float* g, float* b)
+{
+    distance_row<VecF8>(edges, edgeCount, x0, dx, y, count, r, g, b);
+}
+
+#endif // APP_ARCH_X86
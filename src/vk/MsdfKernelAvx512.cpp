@@ -0,0 +1,79 @@
+// Путь AVX-512F: 16 текселей, маски — k-регистры. Файл собирается с -mavx512f
+// (CMakeLists.txt), вызывается только через dispatch MsdfKernel.cpp, когда
+// cpuSimdLevel() == AVX512. Только инструкции F: без DQ (_mm512_and_ps) и VL.
+
+#include "vk/MsdfKernel.h"
+
+#if APP_ARCH_X86
+
+#include <immintrin.h>
+
+// gcc 12: ложное -Wmaybe-uninitialized из _mm512_undefined_ps в заголовках (PR 105593)
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace
+{
+
+struct MaskF16
+{
+    __mmask16 m;
+};
+
+struct VecF16
+{
+    static constexpr uint32_t kLanes = 16;
+    using Mask = MaskF16;
+
+    __m512 v;
+
+    VecF16() = default;
+    VecF16(float x) : v(_mm512_set1_ps(x)) {}
+    VecF16(__m512 x) : v(x) {}
+
+    static VecF16 iota()
+    {
+        return _mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+                              8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+    }
+    void store(float* p) const { _mm512_storeu_ps(p, v); }
+};
+
+inline VecF16 operator+(VecF16 a, VecF16 b) { return _mm512_add_ps(a.v, b.v); }
+inline VecF16 operator-(VecF16 a, VecF16 b) { return _mm512_sub_ps(a.v, b.v); }
+inline VecF16 operator*(VecF16 a, VecF16 b) { return _mm512_mul_ps(a.v, b.v); }
+inline VecF16 operator/(VecF16 a, VecF16 b) { return _mm512_div_ps(a.v, b.v); }
+
+inline MaskF16 operator<(VecF16 a, VecF16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline MaskF16 operator<=(VecF16 a, VecF16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) }; }
+inline MaskF16 operator>(VecF16 a, VecF16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+inline MaskF16 operator>=(VecF16 a, VecF16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ) }; }
+inline MaskF16 operator==(VecF16 a, VecF16 b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ) }; }
+inline MaskF16 operator&(MaskF16 a, MaskF16 b) { return { (__mmask16)(a.m & b.m) }; }
+inline MaskF16 operator|(MaskF16 a, MaskF16 b) { return { (__mmask16)(a.m | b.m) }; }
+
+inline VecF16 select(MaskF16 m, VecF16 a, VecF16 b) { return _mm512_mask_blend_ps(m.m, b.v, a.v); }
+inline VecF16 vsqrt(VecF16 a) { return _mm512_sqrt_ps(a.v); }
+inline VecF16 vabs(VecF16 a) { return _mm512_abs_ps(a.v); }
+inline VecF16 vmin(VecF16 a, VecF16 b) { return _mm512_min_ps(a.v, b.v); }
+inline VecF16 vmax(VecF16 a, VecF16 b) { return _mm512_max_ps(a.v, b.v); }
+
+inline VecF16 cbrt_estimate(VecF16 a)
+{
+    const __m512 bits = _mm512_cvtepi32_ps(_mm512_castps_si512(a.v));
+    const __m512i third = _mm512_cvttps_epi32(_mm512_mul_ps(bits, _mm512_set1_ps(1.0f / 3.0f)));
+    return _mm512_castsi512_ps(_mm512_add_epi32(third, _mm512_set1_epi32(0x2a514067)));
+}
+
+} // namespace
+
+#include "vk/MsdfKernelImpl.h"
+
+void msdfDistanceRowAvx512(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                           uint32_t count, float* r, float* g, float* b)
+{
+    distance_row<VecF16>(edges, edgeCount, x0, dx, y, count, r, g, b);
+}
+
+#endif // APP_ARCH_X86
@@ -0,0 +1,280 @@
+#pragma once
+
+// Ядро расстояний MSDF, общее для всех путей dispatch. Подключается из MsdfKernel.cpp
+// (scalar) и MsdfKernelAvx2.cpp / MsdfKernelAvx512.cpp, каждый раз после своей обёртки
+// регистра V. Всё — в безымянном namespace: копии, собранные с разными -m флагами,
+// не должны склеиться линкером. По той же причине здесь нет std:: шаблонов.
+//
+// Обёртка V (kLanes текселей float):
+//   V(float) — broadcast, V::iota() — 0, 1, ..., kLanes - 1, store(float*);
+//   + - * /, vsqrt, vabs, vmin/vmax (семантика minps/maxps: при NaN — второй аргумент);
+//   < <= > == -> V::Mask; маски: &, |; select(mask, a, b); cbrt_estimate (см. vcbrt).
+// Порядок операций одинаков для всех V, поэтому пути совпадают со scalar бит в бит
+// (сборка без FMA-контракции: -ffp-contract=off).
+
+#include "vk/MsdfKernel.h"
+
+#include <cfloat>
+#include <cstdint>
+
+// точки входа путей (определены, только если путь собран)
+void msdfDistanceRowAvx2(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                         uint32_t count, float* r, float* g, float* b);
+void msdfDistanceRowAvx512(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                           uint32_t count, float* r, float* g, float* b);
+
+namespace
+{
+
+constexpr float kKernelPi = 3.14159265f;
+constexpr float kKernelTiny = 1e-30f;
+
+template <class V>
+inline V non_zero_sign(V x)
+{
+    return select(x > V(0.0f), V(1.0f), V(-1.0f));
+}
+
+// ∛w, w >= 0: оценка по битам float + 3 шага Ньютона
+template <class V>
+inline V vcbrt(V w)
+{
+    V y = cbrt_estimate(w);
+    for (int k = 0; k < 3; ++k)
+        y = (V(2.0f) * y + w / (y * y)) * V(1.0f / 3.0f);
+    return select(w > V(0.0f), y, V(0.0f));
+}
+
+// acos, |x| <= 1: Abramowitz–Stegun 4.4.46, ошибка ~2e-8
+template <class V>
+inline V vacos(V x)
+{
+    const V ax = vabs(x);
+    V p = V(-0.0012624911f);
+    p = p * ax + V(0.0066700901f);
+    p = p * ax + V(-0.0170881256f);
+    p = p * ax + V(0.0308918810f);
+    p = p * ax + V(-0.0501743046f);
+    p = p * ax + V(0.0889789874f);
+    p = p * ax + V(-0.2145988016f);
+    p = p * ax + V(1.5707963050f);
+    const V r = vsqrt(V(1.0f) - ax) * p;
+    return select(x < V(0.0f), V(kKernelPi) - r, r);
+}
+
+// sin/cos на [0, π/3]: ряды Тейлора до x¹⁰
+template <class V>
+inline void vsincos_small(V x, V& s, V& c)
+{
+    const V x2 = x * x;
+    s = x * (V(1.0f) + x2 * (V(-1.0f / 6.0f) + x2 * (V(1.0f / 120.0f) + x2 * (V(-1.0f / 5040.0f) + x2 * V(1.0f / 362880.0f)))));
+    c = V(1.0f) + x2 * (V(-0.5f) + x2 * (V(1.0f / 24.0f) + x2 * (V(-1.0f / 720.0f) + x2 * (V(1.0f / 40320.0f) + x2 * V(-1.0f / 3628800.0f)))));
+}
+
+// Корни x³ + a·x² + b·x + c. Обе ветки считаются во всех lane'ах и выбираются маской:
+// три вещественных корня — тригонометрически, один — Кардано (x1 = x2 — кандидат
+// двойного корня, как -0.5 (u + v) - a/3 у msdfgen)
+template <class V>
+inline void solve_cubic_normed(V a, V b, V c, V& x0, V& x1, V& x2)
+{
+    const V a2 = a * a;
+    const V q = (a2 - V(3.0f) * b) * V(1.0f / 9.0f);
+    const V r = (a * (V(2.0f) * a2 - V(9.0f) * b) + V(27.0f) * c) * V(1.0f / 54.0f);
+    const V r2 = r * r;
+    const V q3 = q * q * q;
+    const V a3 = a * V(1.0f / 3.0f);
+    const auto three = r2 < q3;
+
+    // три корня: q > 0, φ = acos(r / q^1.5) / 3, cos(φ ± 2π/3) = -cos φ / 2 ∓ (√3 / 2) sin φ
+    const V sq = vsqrt(vmax(q, V(0.0f)));
+    const V cosT = vmin(vmax(r / vmax(sq * sq * sq, V(kKernelTiny)), V(-1.0f)), V(1.0f));
+    V sinPhi, cosPhi;
+    vsincos_small(vacos(cosT) * V(1.0f / 3.0f), sinPhi, cosPhi);
+    const V m = V(-2.0f) * sq;
+    const V halfCos = V(-0.5f) * cosPhi;
+    const V sinPart = V(0.86602540f) * sinPhi;
+    const V t0 = m * cosPhi - a3;
+    const V t1 = m * (halfCos - sinPart) - a3;
+    const V t2 = m * (halfCos + sinPart) - a3;
+
+    // один корень
+    const V u = select(r < V(0.0f), V(1.0f), V(-1.0f)) * vcbrt(vabs(r) + vsqrt(vmax(r2 - q3, V(0.0f))));
+    const auto uZero = u == V(0.0f);
+    const V v = select(uZero, V(0.0f), q / select(uZero, V(1.0f), u));
+    const V c0 = (u + v) - a3;
+    const V c1 = V(-0.5f) * (u + v) - a3;
+
+    x0 = select(three, t0, c0);
+    x1 = select(three, t1, c1);
+    x2 = select(three, t2, c1);
+}
+
+template <class V>
+inline void linear_distance(const MsdfKernelEdge& e, V px, V py, V& dist, V& dot, V& param)
+{
+    const V aqx = px - V(e.p0[0]);
+    const V aqy = py - V(e.p0[1]);
+    const V abx = V(e.ab[0]);
+    const V aby = V(e.ab[1]);
+    param = (aqx * abx + aqy * aby) * V(e.invAbLength2);
+
+    const auto far = param > V(0.5f);
+    const V eqx = select(far, V(e.p1[0]), V(e.p0[0])) - px;
+    const V eqy = select(far, V(e.p1[1]), V(e.p0[1])) - py;
+    const V endDist = vsqrt(eqx * eqx + eqy * eqy);
+
+    const V cr = aqx * aby - aqy * abx;
+    const V ortho = cr * V(e.invAbLength);
+    const auto inside = (param > V(0.0f)) & (param < V(1.0f)) & (vabs(ortho) < endDist);
+    dist = select(inside, ortho, non_zero_sign(cr) * endDist);
+
+    // |cos| между ребром и направлением на ближний конец
+    const V cosEnd = vabs(eqx * V(e.dir0[0]) + eqy * V(e.dir0[1])) / vmax(endDist, V(kKernelTiny));
+    dot = select(inside, V(0.0f), cosEnd);
+}
+
+template <class V>
+inline void quadratic_distance(const MsdfKernelEdge& e, V px, V py, V& dist, V& dot, V& param)
+{
+    const V qax = V(e.p0[0]) - px;
+    const V qay = V(e.p0[1]) - py;
+    const V abx = V(e.ab[0]);
+    const V aby = V(e.ab[1]);
+    const V brx = V(e.br[0]);
+    const V bry = V(e.br[1]);
+
+    // ближайшая точка: производная |B(t) - p|² по t
+    V t[3];
+    solve_cubic_normed(V(e.cubicA),
+                       V(e.cubicB) + qax * V(e.brA[0]) + qay * V(e.brA[1]),
+                       qax * V(e.abA[0]) + qay * V(e.abA[1]),
+                       t[0], t[1], t[2]);
+
+    // концы
+    const V qaLen = vsqrt(qax * qax + qay * qay);
+    V md = non_zero_sign(abx * qay - aby * qax) * qaLen;
+    V prm = V(0.0f) - (qax * abx + qay * aby) * V(e.invAbLength2);
+
+    const V e1x = V(e.e1[0]);
+    const V e1y = V(e.e1[1]);
+    const V bqx = V(e.p1[0]) - px;
+    const V bqy = V(e.p1[1]) - py;
+    const V bqLen = vsqrt(bqx * bqx + bqy * bqy);
+    const auto end1 = bqLen < vabs(md);
+    md = select(end1, non_zero_sign(e1x * bqy - e1y * bqx) * bqLen, md);
+    prm = select(end1, ((px - V(e.c[0])) * e1x + (py - V(e.c[1])) * e1y) * V(e.invE1Length2), prm);
+
+    for (int k = 0; k < 3; ++k)
+    {
+        const V tk = t[k];
+        const V qex = qax + V(2.0f) * tk * abx + tk * tk * brx;
+        const V qey = qay + V(2.0f) * tk * aby + tk * tk * bry;
+        const V d = vsqrt(qex * qex + qey * qey);
+        const auto better = (tk > V(0.0f)) & (tk < V(1.0f)) & (d <= vabs(md));
+        const V tanx = abx + tk * brx;
+        const V tany = aby + tk * bry;
+        md = select(better, non_zero_sign(tanx * qey - tany * qex) * d, md);
+        prm = select(better, tk, prm);
+    }
+
+    dist = md;
+    param = prm;
+
+    const V cos0 = vabs(qax * V(e.dir0[0]) + qay * V(e.dir0[1])) / vmax(qaLen, V(kKernelTiny));
+    const V cos1 = vabs(bqx * V(e.dir1[0]) + bqy * V(e.dir1[1])) / vmax(bqLen, V(kKernelTiny));
+    const auto onEdge = (prm >= V(0.0f)) & (prm <= V(1.0f));
+    dot = select(onEdge, V(0.0f), select(prm < V(0.5f), cos0, cos1));
+}
+
+// Псевдо-расстояние: за концом ребра — до продолжения его касательной, если оно ближе.
+// Так каналы двух рёбер угла пересекаются прямо в угле, и медиана держит его острым.
+template <class V>
+inline V pseudo_distance(const MsdfKernelEdge& e, V px, V py, V dist, V param)
+{
+    const V ad = vabs(dist);
+
+    const V aqx = px - V(e.p0[0]);
+    const V aqy = py - V(e.p0[1]);
+    const V ts0 = aqx * V(e.dir0[0]) + aqy * V(e.dir0[1]);
+    const V pd0 = aqx * V(e.dir0[1]) - aqy * V(e.dir0[0]);
+    const auto use0 = (param < V(0.0f)) & (ts0 < V(0.0f)) & (vabs(pd0) <= ad);
+
+    const V bqx = px - V(e.p1[0]);
+    const V bqy = py - V(e.p1[1]);
+    const V ts1 = bqx * V(e.dir1[0]) + bqy * V(e.dir1[1]);
+    const V pd1 = bqx * V(e.dir1[1]) - bqy * V(e.dir1[0]);
+    const auto use1 = (param > V(1.0f)) & (ts1 > V(0.0f)) & (vabs(pd1) <= ad);
+
+    return select(use0, pd0, select(use1, pd1, dist));
+}
+
+// ближайшее ребро канала: минимальное |расстояние|, при равенстве — меньший |cos|
+template <class V>
+struct ChannelBest
+{
+    V dist;
+    V dot;
+    V pseudo;
+};
+
+template <class V>
+inline void update_channel(ChannelBest<V>& best, V dist, V dot, V pseudo)
+{
+    const V ad = vabs(dist);
+    const V bd = vabs(best.dist);
+    const auto closer = (ad < bd) | ((ad == bd) & (dot < best.dot));
+    best.dist = select(closer, dist, best.dist);
+    best.dot = select(closer, dot, best.dot);
+    best.pseudo = select(closer, pseudo, best.pseudo);
+}
+
+template <class V>
+inline void distance_row(const MsdfKernelEdge* edges, uint32_t edgeCount, float x0, float dx, float y,
+                         uint32_t count, float* r, float* g, float* b)
+{
+    float* const out[3] = { r, g, b };
+    const V py(y);
+
+    for (uint32_t i = 0; i < count; i += V::kLanes)
+    {
+        const V px = (V::iota() + V((float)i)) * V(dx) + V(x0);
+
+        ChannelBest<V> best[3];
+        for (int ch = 0; ch < 3; ++ch)
+            best[ch] = { V(-FLT_MAX), V(1.0f), V(kMsdfNoEdgeDistance) };
+
+        for (uint32_t k = 0; k < edgeCount; ++k)
+        {
+            const MsdfKernelEdge& e = edges[k];
+            V dist, dot, param;
+            if (e.curve)
+                quadratic_distance(e, px, py, dist, dot, param);
+            else
+                linear_distance(e, px, py, dist, dot, param);
+
+            const V pseudo = pseudo_distance(e, px, py, dist, param);
+            for (int ch = 0; ch < 3; ++ch)
+            {
+                if (e.color & (1u << ch))
+                    update_channel(best[ch], dist, dot, pseudo);
+            }
+        }
+
+        // хвост строки — через буфер: за count писать нельзя
+        const uint32_t n = count - i < V::kLanes ? count - i : V::kLanes;
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            if (n == V::kLanes)
+            {
+                best[ch].pseudo.store(out[ch] + i);
+                continue;
+            }
+            float tail[V::kLanes];
+            best[ch].pseudo.store(tail);
+            for (uint32_t l = 0; l < n; ++l)
+                out[ch][i + l] = tail[l];
+        }
+    }
+}
+
+} // namespace
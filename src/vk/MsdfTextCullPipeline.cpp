@@ -0,0 +1,75 @@
+#include "vk/MsdfTextCullPipeline.h"
+#include "vk/PipelineCache.h"
+#include "vk/VulkanUtils.h"
+
+#include <chrono>
+#include <iostream>
+
+MsdfTextCullPipeline::MsdfTextCullPipeline(VkDevice device, PipelineCache& cache)
+    : m_device(device), m_cache(cache)
+{
+    createLayouts();
+    createPipeline();
+}
+
+MsdfTextCullPipeline::~MsdfTextCullPipeline()
+{
+    if (m_pipeline) vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    if (m_layout) vkDestroyPipelineLayout(m_device, m_layout, nullptr);
+    if (m_setLayout) vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+}
+
+void MsdfTextCullPipeline::createLayouts()
+{
+    VkDescriptorSetLayoutBinding b[5]{};
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        b[i].binding = i;
+        b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[i].descriptorCount = 1;
+        b[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo sl{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    sl.bindingCount = 5;
+    sl.pBindings = b;
+
+    vk_check(vkCreateDescriptorSetLayout(m_device, &sl, nullptr, &m_setLayout),
+             "vkCreateDescriptorSetLayout(msdf cull)");
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcr.offset = 0;
+    pcr.size = sizeof(MsdfTextCullPushConstants);
+
+    VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pl.setLayoutCount = 1;
+    pl.pSetLayouts = &m_setLayout;
+    pl.pushConstantRangeCount = 1;
+    pl.pPushConstantRanges = &pcr;
+
+    vk_check(vkCreatePipelineLayout(m_device, &pl, nullptr, &m_layout),
+             "vkCreatePipelineLayout(msdf cull)");
+}
+
+void MsdfTextCullPipeline::createPipeline()
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    VkShaderModule compMod = create_shader_module(m_device, "msdf_text_cull.comp");
+
+    VkComputePipelineCreateInfo cp{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    cp.stage = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    cp.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    cp.stage.module = compMod;
+    cp.stage.pName = "main";
+    cp.layout = m_layout;
+
+    vk_check(vkCreateComputePipelines(m_device, m_cache.handle(), 1, &cp, nullptr, &m_pipeline),
+             "vkCreateComputePipelines(msdf cull)");
+
+    vkDestroyShaderModule(m_device, compMod, nullptr);
+
+    const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Pipeline created (msdf text cull): " << createMs << " ms\n";
+}
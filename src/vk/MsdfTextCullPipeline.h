@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+class PipelineCache;
+
+// Совпадает с push_constant в shaders/msdf_text_cull.comp.glsl
+struct MsdfTextCullPushConstants
+{
+    float viewRect[4] = { -1.0f, -1.0f, 1.0f, 1.0f }; // видимая область, NDC
+    uint32_t blockCount = 0;                           // TextCullTable::blockCapacity()
+};
+
+// Compute pre-pass MSDF текста (GPU-driven): по потоку на слот TextCullTable блоков.
+//   binding 0 — TextCullTable блоки, 1 — drawCount (обнулить перед dispatch),
+//   2 — VkDrawMeshTasksIndirectCommandEXT[], 3 — TextDrawInfo (uvec4) на команду,
+//   4 — MsdfTextCullStats (блоки, отброшенные целиком).
+// Результат — аргументы vkCmdDrawMeshTasksIndirectCountEXT для MsdfTextPipeline.
+class MsdfTextCullPipeline
+{
+public:
+    static constexpr uint32_t kWorkgroupSize = 64; // local_size_x шейдера
+
+    MsdfTextCullPipeline(VkDevice device, PipelineCache& cache);
+    ~MsdfTextCullPipeline();
+
+    MsdfTextCullPipeline(const MsdfTextCullPipeline&) = delete;
+    MsdfTextCullPipeline& operator=(const MsdfTextCullPipeline&) = delete;
+
+    VkPipeline pipeline() const { return m_pipeline; }
+    VkPipelineLayout layout() const { return m_layout; }
+    VkDescriptorSetLayout descriptorSetLayout() const { return m_setLayout; }
+
+    // число workgroup для vkCmdDispatch
+    static uint32_t dispatchCountFor(uint32_t blockCount)
+    {
+        return (blockCount + kWorkgroupSize - 1) / kWorkgroupSize;
+    }
+
+private:
+    void createLayouts();
+    void createPipeline();
+
+private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    PipelineCache& m_cache;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+};
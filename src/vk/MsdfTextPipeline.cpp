@@ -0,0 +1,210 @@
+#include "vk/MsdfTextPipeline.h"
+#include "vk/PipelineCache.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+MsdfTextPipeline::MsdfTextPipeline(
+    VkDevice device,
+    PipelineCache& cache,
+    VkFormat colorFormat,
+    const VkPhysicalDeviceMeshShaderPropertiesEXT& meshProps)
+    : m_device(device), m_cache(cache), m_colorFormat(colorFormat)
+{
+    // 64 потока, если железо их предпочитает (AMD wave64), иначе 32 — по вершине на поток
+    m_workgroupSize = meshProps.maxPreferredMeshWorkGroupInvocations >= 64 ? 64u : 32u;
+    m_workgroupSize = std::min(m_workgroupSize, meshProps.maxMeshWorkGroupInvocations);
+
+    m_glyphsPerGroup = std::min({ kMaxGlyphsPerGroup,
+                                  meshProps.maxMeshOutputVertices / 4u,
+                                  meshProps.maxMeshOutputPrimitives / 2u });
+    m_glyphsPerGroup = std::max(m_glyphsPerGroup, 1u);
+
+    std::cout << "MSDF mesh packing: " << m_glyphsPerGroup << " glyphs / "
+              << m_workgroupSize << " invocations per workgroup\n";
+
+    createLayouts();
+    createPipeline();
+}
+
+MsdfTextPipeline::~MsdfTextPipeline()
+{
+    destroyAll();
+}
+
+void MsdfTextPipeline::destroyPipeline()
+{
+    if (m_pipeline) vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+}
+
+void MsdfTextPipeline::destroyAll()
+{
+    destroyPipeline();
+    if (m_layout) vkDestroyPipelineLayout(m_device, m_layout, nullptr);
+    if (m_setLayout) vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+    m_setLayout = VK_NULL_HANDLE;
+}
+
+void MsdfTextPipeline::recreate(VkFormat colorFormat)
+{
+    if (colorFormat == m_colorFormat) return;
+    m_colorFormat = colorFormat;
+    destroyPipeline();
+    createPipeline();
+}
+
+void MsdfTextPipeline::createLayouts()
+{
+    const VkShaderStageFlags bindingStages[6] = {
+        VK_SHADER_STAGE_FRAGMENT_BIT,                                // атласы
+        VK_SHADER_STAGE_MESH_BIT_EXT,                                // инстансы
+        VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, // cull blocks
+        VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, // cull groups
+        VK_SHADER_STAGE_TASK_BIT_EXT,                                // cull stats
+        VK_SHADER_STAGE_TASK_BIT_EXT,                                // draw infos
+    };
+
+    VkDescriptorSetLayoutBinding b[6]{};
+    VkDescriptorBindingFlags flags[6]{};
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        b[i].binding = i;
+        b[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[i].descriptorCount = i == 0 ? kMsdfMaxAtlases : 1;
+        b[i].stageFlags = bindingStages[i];
+    }
+
+    // слоты таблицы без атласа остаются незаписанными
+    flags[0] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bf{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+    bf.bindingCount = 6;
+    bf.pBindingFlags = flags;
+
+    VkDescriptorSetLayoutCreateInfo sl{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    sl.pNext = &bf;
+    sl.bindingCount = 6;
+    sl.pBindings = b;
+
+    vk_check(vkCreateDescriptorSetLayout(m_device, &sl, nullptr, &m_setLayout),
+             "vkCreateDescriptorSetLayout(msdf)");
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0;
+    pcr.size = sizeof(MsdfTextPushConstants);
+
+    VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pl.setLayoutCount = 1;
+    pl.pSetLayouts = &m_setLayout;
+    pl.pushConstantRangeCount = 1;
+    pl.pPushConstantRanges = &pcr;
+
+    vk_check(vkCreatePipelineLayout(m_device, &pl, nullptr, &m_layout),
+             "vkCreatePipelineLayout(msdf)");
+}
+
+void MsdfTextPipeline::createPipeline()
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    VkShaderModule taskMod = create_shader_module(m_device, "msdf_text.task");
+    VkShaderModule meshMod = create_shader_module(m_device, "msdf_text.mesh");
+    VkShaderModule fragMod = create_shader_module(m_device, "msdf_text.frag");
+
+    // constant_id 0 = local_size_x, 1 = GLYPHS_PER_GROUP
+    const uint32_t specData[2] = { m_workgroupSize, m_glyphsPerGroup };
+    const VkSpecializationMapEntry specEntries[2] = {
+        { 0, 0, sizeof(uint32_t) },
+        { 1, sizeof(uint32_t), sizeof(uint32_t) },
+    };
+    VkSpecializationInfo spec{};
+    spec.mapEntryCount = 2;
+    spec.pMapEntries = specEntries;
+    spec.dataSize = sizeof(specData);
+    spec.pData = specData;
+
+    VkPipelineShaderStageCreateInfo stages[3]{};
+    stages[0] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    stages[0].stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+    stages[0].module = taskMod;
+    stages[0].pName = "main";
+
+    stages[1] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    stages[1].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+    stages[1].module = meshMod;
+    stages[1].pName = "main";
+    stages[1].pSpecializationInfo = &spec;
+
+    stages[2] = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+    stages[2].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[2].module = fragMod;
+    stages[2].pName = "main";
+
+    VkPipelineViewportStateCreateInfo vp{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    vp.viewportCount = 1;
+    vp.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rs{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    rs.polygonMode = VK_POLYGON_MODE_FILL;
+    rs.cullMode = VK_CULL_MODE_NONE;
+    rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rs.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo msaa{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    msaa.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // alpha из MSDF покрытия
+    VkPipelineColorBlendAttachmentState cba{};
+    cba.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+        VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    cba.blendEnable = VK_TRUE;
+    cba.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    cba.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.colorBlendOp = VK_BLEND_OP_ADD;
+    cba.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    cba.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    cb.attachmentCount = 1;
+    cb.pAttachments = &cba;
+
+    VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dyn{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dyn.dynamicStateCount = 2;
+    dyn.pDynamicStates = dynStates;
+
+    VkPipelineRenderingCreateInfo rendering{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    rendering.colorAttachmentCount = 1;
+    rendering.pColorAttachmentFormats = &m_colorFormat;
+
+    // mesh pipeline: без vertex input / input assembly
+    VkGraphicsPipelineCreateInfo gp{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    gp.pNext = &rendering;
+    gp.stageCount = 3;
+    gp.pStages = stages;
+    gp.pViewportState = &vp;
+    gp.pRasterizationState = &rs;
+    gp.pMultisampleState = &msaa;
+    gp.pColorBlendState = &cb;
+    gp.pDynamicState = &dyn;
+    gp.layout = m_layout;
+    gp.renderPass = VK_NULL_HANDLE;
+    gp.subpass = 0;
+
+    vk_check(vkCreateGraphicsPipelines(m_device, m_cache.handle(), 1, &gp, nullptr, &m_pipeline),
+             "vkCreateGraphicsPipelines(msdf)");
+
+    vkDestroyShaderModule(m_device, fragMod, nullptr);
+    vkDestroyShaderModule(m_device, meshMod, nullptr);
+    vkDestroyShaderModule(m_device, taskMod, nullptr);
+
+    const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Pipeline created (msdf text): " << createMs << " ms\n";
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+class PipelineCache;
+
+// Слотов в таблице атласов (binding 0): = MAX_ATLASES в shaders/msdf_text.frag.glsl, кратно 4
+constexpr uint32_t kMsdfMaxAtlases = 8;
+
+// Совпадает с push_constant в shaders/msdf_text.{task,frag}.glsl (task читает только params и viewRect;
+// mesh его не объявляет, но входит в диапазон — один vkCmdPushConstants на все стадии)
+struct MsdfTextPushConstants
+{
+    float debug = 0.0f;
+    float pad[3]{};
+    float viewRect[4] = { -1.0f, -1.0f, 1.0f, 1.0f }; // видимая область, NDC
+    float pxRange[kMsdfMaxAtlases]{};                 // по слотам таблицы атласов
+};
+static_assert(sizeof(MsdfTextPushConstants) <= 128, "maxPushConstantsSize is only guaranteed to be 128");
+
+// Счётчики отсечения (binding 4): блоки целиком считает compute pre-pass,
+// группы видимых блоков — task shader. По буферу на кадр
+struct MsdfTextCullStats
+{
+    uint32_t visibleGlyphs = 0;
+    uint32_t culledGlyphs = 0;
+    uint32_t visibleGroups = 0;
+    uint32_t culledGroups = 0;
+};
+
+// MSDF quad'ы из GlyphInstance, task -> mesh -> fragment:
+//   binding 0 — таблица атласов: kMsdfMaxAtlases texture array'ев (fragment, PARTIALLY_BOUND),
+//     GlyphInstance::atlas выбирает слот и слой; 1 — SSBO инстансов (mesh),
+//   2/3 — TextCullTable блоки/группы (task, mesh), 4 — MsdfTextCullStats (task),
+//   5 — TextDrawInfo от MsdfTextCullPipeline (task, по gl_DrawID).
+// Рисуется vkCmdDrawMeshTasksIndirectCountEXT: draw = видимый блок.
+// Task shader отсекает группы глифов по bbox и clip rect, mesh shader рисует
+// glyphsPerGroup() глифов группы workgroup'ой из workgroupSize() потоков;
+// оба числа подбираются по лимитам mesh shader'а устройства.
+class MsdfTextPipeline
+{
+public:
+    static constexpr uint32_t kMaxGlyphsPerGroup = 32; // = max_vertices / 4 в шейдере
+    static constexpr uint32_t kGroupsPerTask = 32;     // local_size_x task shader'а (и GROUPS_PER_TASK в cull.comp)
+
+    MsdfTextPipeline(
+        VkDevice device,
+        PipelineCache& cache,
+        VkFormat colorFormat,
+        const VkPhysicalDeviceMeshShaderPropertiesEXT& meshProps);
+    ~MsdfTextPipeline();
+
+    MsdfTextPipeline(const MsdfTextPipeline&) = delete;
+    MsdfTextPipeline& operator=(const MsdfTextPipeline&) = delete;
+
+    void recreate(VkFormat colorFormat);
+
+    VkPipeline pipeline() const { return m_pipeline; }
+    VkPipelineLayout layout() const { return m_layout; }
+    VkDescriptorSetLayout descriptorSetLayout() const { return m_setLayout; }
+
+    uint32_t workgroupSize() const { return m_workgroupSize; }
+    uint32_t glyphsPerGroup() const { return m_glyphsPerGroup; }
+
+private:
+    void createLayouts();
+    void createPipeline();
+    void destroyPipeline();
+    void destroyAll();
+
+private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    PipelineCache& m_cache;
+    VkFormat m_colorFormat = VK_FORMAT_UNDEFINED;
+
+    uint32_t m_workgroupSize = 32;
+    uint32_t m_glyphsPerGroup = kMaxGlyphsPerGroup;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_layout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+};
@@ -0,0 +1,133 @@
+#include "vk/PipelineCache.h"
+#include "vk/VulkanUtils.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+PipelineCache::PipelineCache(VkPhysicalDevice phys, VkDevice device, std::string path)
+    : m_phys(phys), m_device(device), m_path(std::move(path))
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> data;
+    if (readFile(data) && validate(data))
+        m_loaded = std::move(data);
+
+    VkPipelineCacheCreateInfo ci{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    ci.initialDataSize = m_loaded.size();
+    ci.pInitialData = m_loaded.empty() ? nullptr : m_loaded.data();
+
+    vk_check(vkCreatePipelineCache(m_device, &ci, nullptr, &m_cache), "vkCreatePipelineCache");
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Pipeline cache: " << (m_loaded.empty() ? "cold" : "warm")
+              << ", " << m_loaded.size() << " bytes from " << m_path
+              << " (" << ms << " ms)\n";
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (!m_cache)
+        return;
+
+    save();
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+    m_cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::readFile(std::vector<uint8_t>& out) const
+{
+    // нет файла — обычный первый запуск, не ошибка
+    std::ifstream f(m_path, std::ios::binary | std::ios::ate);
+    if (!f)
+        return false;
+
+    const std::streamsize size = f.tellg();
+    if (size <= 0)
+        return false;
+
+    out.resize((size_t)size);
+    f.seekg(0, std::ios::beg);
+    f.read(reinterpret_cast<char*>(out.data()), size);
+    return (bool)f;
+}
+
+bool PipelineCache::validate(const std::vector<uint8_t>& data) const
+{
+    // драйвер тоже проверяет заголовок, но не все делают это надёжно:
+    // чужой blob может уронить драйвер или молча дать мусор
+    VkPipelineCacheHeaderVersionOne hdr{};
+    if (data.size() < sizeof(hdr))
+    {
+        std::cerr << "Pipeline cache: truncated header, ignoring " << m_path << "\n";
+        return false;
+    }
+    std::memcpy(&hdr, data.data(), sizeof(hdr));
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(m_phys, &props);
+
+    if (hdr.headerSize < sizeof(hdr) || hdr.headerSize > data.size() ||
+        hdr.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+    {
+        std::cerr << "Pipeline cache: bad header, ignoring " << m_path << "\n";
+        return false;
+    }
+
+    if (hdr.vendorID != props.vendorID || hdr.deviceID != props.deviceID ||
+        std::memcmp(hdr.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "Pipeline cache: other device/driver, starting cold\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool PipelineCache::save()
+{
+    size_t size = 0;
+    vk_check(vkGetPipelineCacheData(m_device, m_cache, &size, nullptr), "vkGetPipelineCacheData(size)");
+
+    std::vector<uint8_t> data(size);
+    if (size)
+        vk_check(vkGetPipelineCacheData(m_device, m_cache, &size, data.data()), "vkGetPipelineCacheData");
+    data.resize(size);
+
+    if (data.empty() || data == m_loaded)
+        return true;
+
+    const std::string tmpPath = m_path + ".tmp";
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f)
+        {
+            std::cerr << "Pipeline cache: failed to open " << tmpPath << "\n";
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+        if (!f)
+        {
+            std::cerr << "Pipeline cache: failed to write " << tmpPath << "\n";
+            return false;
+        }
+    }
+
+    // rename поверх старого: читатель видит либо старый, либо новый файл целиком
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, m_path, ec);
+    if (ec)
+    {
+        std::cerr << "Pipeline cache: failed to replace " << m_path << ": " << ec.message() << "\n";
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    std::cout << "Pipeline cache saved: " << data.size() << " bytes to " << m_path << "\n";
+    m_loaded = std::move(data);
+    return true;
+}
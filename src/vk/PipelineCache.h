@@ -0,0 +1,38 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+// Общий VkPipelineCache для всех пайплайнов приложения.
+// При старте читает blob с диска; если заголовок не от этого устройства/драйвера
+// (vendorID, deviceID, pipelineCacheUUID) — начинаем с пустого кэша.
+// save() пишет blob атомарно: во временный файл, затем rename поверх старого.
+class PipelineCache
+{
+public:
+    PipelineCache(VkPhysicalDevice phys, VkDevice device, std::string path);
+    ~PipelineCache(); // сохраняет и уничтожает кэш
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache handle() const { return m_cache; }
+
+    // Сколько байт было принято с диска (0 = холодный старт)
+    size_t loadedBytes() const { return m_loaded.size(); }
+
+    bool save();
+
+private:
+    bool readFile(std::vector<uint8_t>& out) const;
+    bool validate(const std::vector<uint8_t>& data) const;
+
+private:
+    VkPhysicalDevice m_phys = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    std::string m_path;
+
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::vector<uint8_t> m_loaded; // что лежит на диске: если не поменялось, не пишем
+};
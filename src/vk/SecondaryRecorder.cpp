@@ -0,0 +1,146 @@
+#include "vk/SecondaryRecorder.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+
+SecondaryRecorder::SecondaryRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount)
+    : m_device(device)
+{
+    m_threads.resize(std::max(threadCount, 1u));
+
+    for (ThreadState& t : m_threads)
+    {
+        t.frames.resize(framesInFlight);
+        for (FramePool& f : t.frames)
+        {
+            // TRANSIENT: буферы живут один кадр, сбрасываются через vkResetCommandPool
+            VkCommandPoolCreateInfo pci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            pci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pci.queueFamilyIndex = queueFamilyIndex;
+            vk_check(vkCreateCommandPool(m_device, &pci, nullptr, &f.pool), "vkCreateCommandPool(secondary)");
+        }
+    }
+
+    for (uint32_t i = 1; i < (uint32_t)m_threads.size(); ++i)
+        m_threads[i].thread = std::thread(&SecondaryRecorder::workerLoop, this, i);
+}
+
+SecondaryRecorder::~SecondaryRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+
+    for (ThreadState& t : m_threads)
+    {
+        if (t.thread.joinable())
+            t.thread.join();
+
+        // буферы освобождаются вместе с пулом
+        for (FramePool& f : t.frames)
+            if (f.pool) vkDestroyCommandPool(m_device, f.pool, nullptr);
+    }
+}
+
+const std::vector<VkCommandBuffer>& SecondaryRecorder::record(
+    uint32_t frame,
+    uint32_t layerCount,
+    const VkCommandBufferInheritanceInfo& inheritance,
+    const RecordFn& fn)
+{
+    m_out.assign(layerCount, VK_NULL_HANDLE);
+
+    // слоёв меньше, чем потоков, — лишних не будим
+    const uint32_t active = std::min(layerCount, (uint32_t)m_threads.size());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frame = frame;
+        m_layerCount = layerCount;
+        m_inheritance = &inheritance;
+        m_fn = &fn;
+        m_pending = active > 1 ? active - 1 : 0;
+        ++m_job;
+    }
+    if (active > 1)
+        m_start.notify_all();
+
+    recordOnThread(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+
+    m_inheritance = nullptr;
+    m_fn = nullptr;
+    return m_out;
+}
+
+void SecondaryRecorder::workerLoop(uint32_t thread)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_quit || m_job != seen; });
+            if (m_quit)
+                return;
+            seen = m_job;
+
+            // задание не для этого потока (слоёв меньше, чем потоков)
+            if (thread >= m_layerCount)
+                continue;
+        }
+
+        recordOnThread(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pending;
+        }
+        m_done.notify_one();
+    }
+}
+
+void SecondaryRecorder::recordOnThread(uint32_t thread)
+{
+    const uint32_t stride = (uint32_t)m_threads.size();
+    if (thread >= m_layerCount)
+        return;
+
+    FramePool& fp = m_threads[thread].frames[m_frame];
+
+    // fence кадра пройден — прошлые буферы пула GPU больше не читает
+    vk_check(vkResetCommandPool(m_device, fp.pool, 0), "vkResetCommandPool(secondary)");
+
+    const uint32_t needed = (m_layerCount - thread + stride - 1) / stride;
+    if (fp.buffers.size() < needed)
+    {
+        const uint32_t first = (uint32_t)fp.buffers.size();
+        fp.buffers.resize(needed);
+
+        VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        ai.commandPool = fp.pool;
+        ai.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        ai.commandBufferCount = needed - first;
+        vk_check(vkAllocateCommandBuffers(m_device, &ai, fp.buffers.data() + first), "vkAllocateCommandBuffers(secondary)");
+    }
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    bi.pInheritanceInfo = m_inheritance;
+
+    uint32_t slot = 0;
+    for (uint32_t layer = thread; layer < m_layerCount; layer += stride, ++slot)
+    {
+        VkCommandBuffer cmd = fp.buffers[slot];
+        vk_check(vkBeginCommandBuffer(cmd, &bi), "vkBeginCommandBuffer(secondary)");
+        (*m_fn)(cmd, layer);
+        vk_check(vkEndCommandBuffer(cmd), "vkEndCommandBuffer(secondary)");
+
+        // разные индексы — без гонки
+        m_out[layer] = cmd;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Параллельная запись слоёв кадра во вторичные командные буферы.
+// У каждого потока на каждый кадр в полёте свой VkCommandPool (пулы не потокобезопасны),
+// буферы пула переиспользуются: пул кадра сбрасывается целиком, когда fence кадра пройден.
+//
+// Слой i пишет поток i % threadCount() (поток 0 — вызывающий), результат — в порядке слоёв,
+// primary исполняет его через vkCmdExecuteCommands внутри vkCmdBeginRendering с
+// VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+class SecondaryRecorder
+{
+public:
+    // cmd — вторичный буфер (уже begin), layer — номер слоя
+    using RecordFn = std::function<void(VkCommandBuffer cmd, uint32_t layer)>;
+
+    // threadCount >= 1, включая вызывающий поток
+    SecondaryRecorder(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount);
+    ~SecondaryRecorder();
+
+    SecondaryRecorder(const SecondaryRecorder&) = delete;
+    SecondaryRecorder& operator=(const SecondaryRecorder&) = delete;
+
+    uint32_t threadCount() const { return (uint32_t)m_threads.size(); }
+
+    // Вызывать после fence кадра frame. inheritance — формат attachment'ов dynamic rendering
+    // (VkCommandBufferInheritanceRenderingInfo в pNext). Возвращает буферы слоёв по порядку
+    // (валидны до следующего record() того же кадра).
+    const std::vector<VkCommandBuffer>& record(
+        uint32_t frame,
+        uint32_t layerCount,
+        const VkCommandBufferInheritanceInfo& inheritance,
+        const RecordFn& fn);
+
+private:
+    struct FramePool
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers; // растёт по мере надобности
+    };
+
+    struct ThreadState
+    {
+        std::vector<FramePool> frames;
+        std::thread thread; // у потока 0 пустой
+    };
+
+    void workerLoop(uint32_t thread);
+    void recordOnThread(uint32_t thread);
+
+private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    std::vector<ThreadState> m_threads;
+
+    // текущее задание (пишет вызывающий под m_mutex)
+    uint32_t m_frame = 0;
+    uint32_t m_layerCount = 0;
+    const VkCommandBufferInheritanceInfo* m_inheritance = nullptr;
+    const RecordFn* m_fn = nullptr;
+    std::vector<VkCommandBuffer> m_out;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_job = 0;      // номер задания; рабочие ждут его смены
+    uint32_t m_pending = 0;  // рабочих, ещё не закончивших задание
+    bool m_quit = false;
+};
@@ -0,0 +1,59 @@
+#include "vk/ShaderRegistry.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static bool read_spv_u32(const std::string& path, std::vector<uint32_t>& out)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) { std::cerr << "Failed to open SPV: " << path << "\n"; return false; }
+
+    const std::streamsize size = file.tellg();
+    if (size <= 0 || (size % 4) != 0) { std::cerr << "Invalid SPV size: " << path << "\n"; return false; }
+
+    out.resize((size_t)size / 4);
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(out.data()), size);
+    return true;
+}
+
+std::span<const uint32_t> findEmbeddedShader(std::string_view name)
+{
+    // шейдеров единицы — линейного поиска хватает
+    for (const EmbeddedShader& s : embeddedShaders())
+    {
+        if (name == s.name)
+            return { s.code, s.wordCount };
+    }
+    return {};
+}
+
+bool ShaderCode::load(std::string_view name)
+{
+    m_disk.clear();
+    m_code = {};
+
+    if (const char* dir = std::getenv("APP_SHADER_DIR"); dir && *dir)
+    {
+        if (!read_spv_u32(std::string(dir) + "/" + std::string(name) + ".spv", m_disk))
+            return false;
+        m_code = m_disk;
+        return true;
+    }
+
+    m_code = findEmbeddedShader(name);
+    if (!m_code.empty())
+        return true;
+
+#ifdef APP_SHADER_DIR
+    if (!read_spv_u32(std::string(APP_SHADER_DIR) + "/" + std::string(name) + ".spv", m_disk))
+        return false;
+    m_code = m_disk;
+    return true;
+#else
+    std::cerr << "Shader not embedded: " << name << "\n";
+    return false;
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// SPIR-V, вшитый в бинарник при сборке (cmake/EmbedSpirv.cmake -> EmbeddedShaders.cpp).
+// name = имя .spv без расширения: "lb_glyphlets.mesh"
+struct EmbeddedShader
+{
+    const char* name;
+    const uint32_t* code;
+    size_t wordCount;
+};
+
+std::span<const EmbeddedShader> embeddedShaders();
+
+std::span<const uint32_t> findEmbeddedShader(std::string_view name);
+
+// SPIR-V шейдера по имени.
+// Обычно — вшитый массив, без файлового I/O. Для hot reload задай переменную окружения
+// APP_SHADER_DIR: тогда <dir>/<name>.spv читается с диска (и после правки шейдера
+// достаточно пересоздать пайплайн). Шейдеры, которых нет в бинарнике, тоже читаются
+// с диска — из каталога сборки.
+class ShaderCode
+{
+public:
+    bool load(std::string_view name);
+
+    const uint32_t* data() const { return m_code.data(); }
+    size_t sizeBytes() const { return m_code.size_bytes(); }
+    bool fromDisk() const { return !m_disk.empty(); }
+
+private:
+    std::vector<uint32_t> m_disk;
+    std::span<const uint32_t> m_code;
+};
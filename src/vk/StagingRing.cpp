@@ -0,0 +1,90 @@
+#include "vk/StagingRing.h"
+
+StagingRing::StagingRing(GpuAllocator& allocator, VkDeviceSize capacity)
+    : m_allocator(allocator)
+    , m_capacity(capacity)
+{
+    m_buffer = m_allocator.createBuffer(m_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, GpuMemoryUsage::Upload, "staging ring");
+}
+
+StagingRing::~StagingRing()
+{
+    m_allocator.destroyBuffer(m_buffer);
+}
+
+bool StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& out)
+{
+    if (size == 0 || size > m_capacity)
+        return false;
+
+    // пустое кольцо — начинаем с нуля, без хвоста на wrap
+    if (m_used == 0)
+        m_head = m_tail = 0;
+    else if (m_head == m_tail)
+        return false; // полное
+
+    auto alignUp = [alignment](VkDeviceSize v) { return (v + alignment - 1) / alignment * alignment; };
+
+    VkDeviceSize offset = alignUp(m_head);
+    VkDeviceSize consumed = 0;
+
+    if (m_used == 0 || m_head > m_tail)
+    {
+        // свободно [head, capacity) и [0, tail)
+        if (offset + size <= m_capacity)
+        {
+            consumed = offset + size - m_head;
+        }
+        else if (size <= m_tail)
+        {
+            consumed = (m_capacity - m_head) + size; // хвост до конца пропадает до reclaim
+            offset = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // свободно только [head, tail)
+        if (offset + size > m_tail)
+            return false;
+        consumed = offset + size - m_head;
+    }
+
+    m_head = offset + size;
+    if (m_head == m_capacity)
+        m_head = 0;
+    m_used += consumed;
+    m_pending += consumed;
+
+    out.buffer = m_buffer.buffer;
+    out.offset = offset;
+    out.ptr = m_buffer.alloc.mapped + offset;
+    return true;
+}
+
+void StagingRing::flush(const Allocation& a, VkDeviceSize size)
+{
+    m_allocator.flush(m_buffer.alloc, a.offset, size);
+}
+
+void StagingRing::retire(uint64_t value)
+{
+    if (m_pending == 0)
+        return;
+
+    m_retired.push_back({ value, m_head, m_pending });
+    m_pending = 0;
+}
+
+void StagingRing::reclaim(uint64_t completedValue)
+{
+    while (!m_retired.empty() && m_retired.front().value <= completedValue)
+    {
+        m_tail = m_retired.front().end;
+        m_used -= m_retired.front().bytes;
+        m_retired.pop_front();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+
+// Кольцевой staging буфер: один VkBuffer, постоянно замаплен, линейное выделение с wrap'ом.
+// Выделенное с прошлого retire(value) освобождается целиком, когда timeline semaphore
+// загрузок достиг value (reclaim). Память под копии больше не аллоцируется на каждую загрузку.
+class StagingRing
+{
+public:
+    struct Allocation
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        uint8_t* ptr = nullptr;
+    };
+
+    StagingRing(GpuAllocator& allocator, VkDeviceSize capacity);
+    ~StagingRing();
+
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    VkDeviceSize capacity() const { return m_capacity; }
+
+    // false — места нет (дождаться reclaim или выделить отдельно)
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, Allocation& out);
+
+    // Для non-coherent памяти: сделать записанное видимым GPU (до submit'а)
+    void flush(const Allocation& a, VkDeviceSize size);
+
+    // Всё выделенное с прошлого retire() принадлежит загрузке со значением value
+    void retire(uint64_t value);
+
+    // Освободить загрузки со значением <= completedValue
+    void reclaim(uint64_t completedValue);
+
+    // Есть ли что освобождать (ждать) — иначе кольцо занято только текущими выделениями
+    bool hasRetired() const { return !m_retired.empty(); }
+    uint64_t oldestRetired() const { return m_retired.empty() ? 0 : m_retired.front().value; }
+
+private:
+    struct Retired
+    {
+        uint64_t value = 0;
+        VkDeviceSize end = 0;   // m_head на момент retire
+        VkDeviceSize bytes = 0; // включая выравнивание и хвост при wrap'е
+    };
+
+    GpuAllocator& m_allocator;
+    GpuBuffer m_buffer{};
+
+    VkDeviceSize m_capacity = 0;
+    VkDeviceSize m_head = 0;    // следующая запись
+    VkDeviceSize m_tail = 0;    // начало самой старой живой загрузки
+    VkDeviceSize m_used = 0;    // занято (живые + ещё не retire)
+    VkDeviceSize m_pending = 0; // выделено с прошлого retire
+
+    std::deque<Retired> m_retired;
+};
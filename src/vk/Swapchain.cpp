@@ -50,7 +50,7 @@ Swapchain::Swapchain(
     , m_graphicsFamily(graphicsFamily)
     , m_presentFamily(presentFamily)
 {
-    create(fbWidth, fbHeight);
+    create(fbWidth, fbHeight, VK_NULL_HANDLE);
 }
 
 Swapchain::~Swapchain()
@@ -60,11 +60,18 @@ Swapchain::~Swapchain()
 
 void Swapchain::recreate(int fbWidth, int fbHeight)
 {
-    destroy();
-    create(fbWidth, fbHeight);
+    destroyImageViews();
+
+    VkSwapchainKHR old = m_swapchain;
+    m_swapchain = VK_NULL_HANDLE;
+    create(fbWidth, fbHeight, old);
+
+    // old уже retired: его images, ещё не отданные приложению, освобождаются вместе с ним
+    if (old)
+        vkDestroySwapchainKHR(m_device, old, nullptr);
 }
 
-void Swapchain::create(int fbWidth, int fbHeight)
+void Swapchain::create(int fbWidth, int fbHeight, VkSwapchainKHR oldSwapchain)
 {
     VkSurfaceCapabilitiesKHR caps{};
     vk_check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_phys, m_surface, &caps),
@@ -118,6 +125,7 @@ void Swapchain::create(int fbWidth, int fbHeight)
     ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     ci.presentMode = chosenPresent;
     ci.clipped = VK_TRUE;
+    ci.oldSwapchain = oldSwapchain;
 
     vk_check(vkCreateSwapchainKHR(m_device, &ci, nullptr, &m_swapchain), "vkCreateSwapchainKHR");
 
@@ -152,11 +160,16 @@ void Swapchain::create(int fbWidth, int fbHeight)
               << " images, extent " << m_extent.width << "x" << m_extent.height << "\n";
 }
 
-void Swapchain::destroy()
+void Swapchain::destroyImageViews()
 {
     for (auto v : m_imageViews)
         vkDestroyImageView(m_device, v, nullptr);
     m_imageViews.clear();
+}
+
+void Swapchain::destroy()
+{
+    destroyImageViews();
 
     if (m_swapchain)
         vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
@@ -22,6 +22,9 @@ public:
     Swapchain(const Swapchain&) = delete;
     Swapchain& operator=(const Swapchain&) = delete;
 
+    // Новый swapchain создаётся с oldSwapchain = текущий: уже показанные кадры остаются
+    // на экране, пока не придёт первый present нового. Вызывающий должен дождаться кадров,
+    // которые ещё пишут в старые images (views старых images уничтожаются здесь).
     void recreate(int fbWidth, int fbHeight);
 
     VkSwapchainKHR handle() const { return m_swapchain; }
@@ -55,7 +58,8 @@ public:
     }
 
 private:
-    void create(int fbWidth, int fbHeight);
+    void create(int fbWidth, int fbHeight, VkSwapchainKHR oldSwapchain);
+    void destroyImageViews();
     void destroy();
 
 private:
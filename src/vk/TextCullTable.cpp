@@ -0,0 +1,229 @@
+#include "vk/TextCullTable.h"
+#include "vk/GlyphInstanceBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+static VkDeviceSize align_up(VkDeviceSize v, VkDeviceSize a)
+{
+    return (v + a - 1) / a * a;
+}
+
+TextCullTable::TextCullTable(GpuAllocator& allocator, uint32_t frameSlots)
+    : m_allocator(allocator)
+    , m_device(allocator.device())
+{
+    m_offsetAlign = std::max<VkDeviceSize>(allocator.limits().minStorageBufferOffsetAlignment, 1);
+
+    m_slotCount = std::max(frameSlots, 1u);
+    m_slotStale.assign(m_slotCount, 0);
+    m_slotAllStale.assign(m_slotCount, 0);
+    m_slotStaleGroups.resize(m_slotCount);
+
+    createBuffer(64, 256);
+}
+
+TextCullTable::~TextCullTable()
+{
+    destroyBuffer();
+}
+
+void TextCullTable::createBuffer(uint32_t blockCapacity, uint32_t groupCapacity)
+{
+    m_blockCapacity = blockCapacity;
+    m_groupCapacity = groupCapacity;
+    m_groupsOffset = align_up(blocksSize(), m_offsetAlign);
+    m_sliceStride = align_up(m_groupsOffset + groupsSize(), m_offsetAlign);
+
+    m_buffer = m_allocator.createBuffer(
+        m_sliceStride * m_slotCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, GpuMemoryUsage::Upload, "text cull");
+}
+
+void TextCullTable::destroyBuffer()
+{
+    m_allocator.destroyBuffer(m_buffer);
+}
+
+// пустой bbox (min > max) не пересекается ни с чем, групп нет
+static const TextCullBlock kEmptyBlock{ { 1.0f, 1.0f }, { -1.0f, -1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0, 0, 0, 0 };
+
+void TextCullTable::update(const GlyphInstanceBuffer& glyphs, uint32_t glyphsPerGroup)
+{
+    // смена размера группы — пересборка всех блоков
+    uint32_t since = m_builtVersion;
+    if (glyphsPerGroup != m_builtGroupSize)
+    {
+        since = 0;
+        m_builtGroupSize = glyphsPerGroup;
+        m_blocks.assign(m_blocks.size(), kEmptyBlock);
+        m_blockGroups.clear();
+        m_glyphCount = 0;
+    }
+    else if (glyphs.layoutVersion() == m_builtVersion)
+        return;
+
+    m_builtVersion = glyphs.layoutVersion();
+
+    const uint32_t slotCount = glyphs.blockSlotCount();
+    if (m_blocks.size() < slotCount)
+        m_blocks.resize(slotCount, kEmptyBlock);
+    if (m_blockGroups.size() < slotCount)
+        m_blockGroups.resize(slotCount);
+
+    const GlyphInstance* inst = glyphs.instances();
+    bool repack = since == 0;
+
+    glyphs.forEachBlockSince(since, [&](uint32_t index, uint32_t first, const TextLayoutResult& layout, const TextClipRect& clip)
+    {
+        const uint32_t oldGroups = (uint32_t)m_blockGroups[index].size();
+        buildBlock(index, first, layout, clip, inst, glyphsPerGroup);
+
+        const std::vector<TextCullGroup>& groups = m_blockGroups[index];
+        if (repack || groups.size() != oldGroups)
+        {
+            repack = true;
+            return;
+        }
+
+        // то же число групп — на месте
+        const uint32_t firstGroup = m_blocks[index].firstGroup;
+        std::copy(groups.begin(), groups.end(), m_groups.begin() + firstGroup);
+        markGroupsStale(firstGroup, firstGroup + (uint32_t)groups.size());
+    });
+
+    if (repack)
+        repackGroups();
+
+    if (m_blocks.size() > m_blockCapacity || m_groups.size() > m_groupCapacity)
+    {
+        uint32_t blockCap = m_blockCapacity;
+        uint32_t groupCap = m_groupCapacity;
+        while (blockCap < m_blocks.size()) blockCap *= 2;
+        while (groupCap < m_groups.size()) groupCap *= 2;
+
+        // как и у GlyphInstanceBuffer: рост редкий, старый буфер может читаться кадрами в полёте
+        vkDeviceWaitIdle(m_device);
+        destroyBuffer();
+        createBuffer(blockCap, groupCap);
+        ++m_generation;
+        std::fill(m_slotAllStale.begin(), m_slotAllStale.end(), 1);
+    }
+
+    // хвост до ёмкости — пустые слоты (compute pre-pass читает всю таблицу)
+    m_blocks.resize(m_blockCapacity, kEmptyBlock);
+
+    std::fill(m_slotStale.begin(), m_slotStale.end(), 1);
+}
+
+void TextCullTable::buildBlock(uint32_t index, uint32_t first, const TextLayoutResult& layout, const TextClipRect& clip,
+                               const GlyphInstance* inst, uint32_t glyphsPerGroup)
+{
+    TextCullBlock& b = m_blocks[index];
+    m_glyphCount -= b.glyphCount;
+
+    const uint32_t firstGroup = b.firstGroup;
+    b = kEmptyBlock;
+    b.firstGroup = firstGroup;
+
+    std::vector<TextCullGroup>& groups = m_blockGroups[index];
+    groups.clear();
+
+    // удалённый или пустой блок — группы не нужны
+    const uint32_t count = layout.glyphCount;
+    if (count == 0)
+        return;
+
+    b.boundsMin[0] = std::min(layout.boundsMin[0], layout.boundsMax[0]);
+    b.boundsMin[1] = std::min(layout.boundsMin[1], layout.boundsMax[1]);
+    b.boundsMax[0] = std::max(layout.boundsMin[0], layout.boundsMax[0]);
+    b.boundsMax[1] = std::max(layout.boundsMin[1], layout.boundsMax[1]);
+    b.clipMin[0] = clip.minX;
+    b.clipMin[1] = clip.minY;
+    b.clipMax[0] = clip.maxX;
+    b.clipMax[1] = clip.maxY;
+    b.groupCount = (count + glyphsPerGroup - 1) / glyphsPerGroup;
+    b.glyphCount = count;
+    m_glyphCount += count;
+
+    for (uint32_t g = 0; g < count; g += glyphsPerGroup)
+    {
+        TextCullGroup grp{};
+        grp.firstInstance = first + g;
+        grp.count = std::min(glyphsPerGroup, count - g);
+        grp.block = index;
+
+        // при scaleY < 0 posMin.y > posMax.y — нормализуем
+        float mn[2] = { 1e30f, 1e30f };
+        float mx[2] = { -1e30f, -1e30f };
+        for (uint32_t i = 0; i < grp.count; ++i)
+        {
+            const GlyphInstance& q = inst[grp.firstInstance + i];
+            mn[0] = std::min({ mn[0], q.posMin[0], q.posMax[0] });
+            mn[1] = std::min({ mn[1], q.posMin[1], q.posMax[1] });
+            mx[0] = std::max({ mx[0], q.posMin[0], q.posMax[0] });
+            mx[1] = std::max({ mx[1], q.posMin[1], q.posMax[1] });
+        }
+        grp.boundsMin[0] = mn[0];
+        grp.boundsMin[1] = mn[1];
+        grp.boundsMax[0] = mx[0];
+        grp.boundsMax[1] = mx[1];
+        groups.push_back(grp);
+    }
+}
+
+void TextCullTable::repackGroups()
+{
+    // только копирование закэшированных групп, инстансы не читаются
+    m_groups.clear();
+    for (uint32_t i = 0; i < (uint32_t)m_blockGroups.size(); ++i)
+    {
+        m_blocks[i].firstGroup = (uint32_t)m_groups.size();
+        m_groups.insert(m_groups.end(), m_blockGroups[i].begin(), m_blockGroups[i].end());
+    }
+
+    std::fill(m_slotAllStale.begin(), m_slotAllStale.end(), 1);
+}
+
+void TextCullTable::markGroupsStale(uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+        return;
+    for (uint32_t s = 0; s < m_slotCount; ++s)
+    {
+        if (!m_slotAllStale[s])
+            m_slotStaleGroups[s].push_back({ begin, end });
+    }
+}
+
+void TextCullTable::flush(uint32_t slot)
+{
+    if (!m_slotStale[slot])
+        return;
+    m_slotStale[slot] = 0;
+
+    uint8_t* mapped = m_buffer.alloc.mapped;
+    std::vector<Range>& stale = m_slotStaleGroups[slot];
+
+    // таблица блоков маленькая (blockCapacity записей) — всегда целиком
+    const size_t blockBytes = m_blocks.size() * sizeof(TextCullBlock);
+    if (blockBytes)
+        std::memcpy(mapped + blocksOffset(slot), m_blocks.data(), blockBytes);
+    m_allocator.flush(m_buffer.alloc, blocksOffset(slot), blocksSize());
+
+    if (m_slotAllStale[slot])
+    {
+        m_slotAllStale[slot] = 0;
+        stale.assign(1, { 0, (uint32_t)m_groups.size() });
+    }
+
+    for (const Range& r : stale)
+    {
+        if (r.begin >= r.end)
+            continue;
+        const VkDeviceSize offset = groupsOffset(slot) + (VkDeviceSize)r.begin * sizeof(TextCullGroup);
+        const VkDeviceSize bytes = (VkDeviceSize)(r.end - r.begin) * sizeof(TextCullGroup);
+        std::memcpy(mapped + offset, m_groups.data() + r.begin, (size_t)bytes);
+        m_allocator.flush(m_buffer.alloc, offset, bytes);
+    }
+    stale.clear();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+#include "vk/TextLayout.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+class GlyphInstanceBuffer;
+struct TextClipRect;
+
+// Совпадают с TextCullBlock/TextCullGroup в shaders/msdf_text.{cull.comp,task,mesh}.glsl (std430)
+struct TextCullBlock
+{
+    float boundsMin[2];
+    float boundsMax[2];
+    float clipMin[2];
+    float clipMax[2];
+    uint32_t firstGroup;
+    uint32_t groupCount; // 0 = слот свободен
+    uint32_t glyphCount;
+    uint32_t pad;
+};
+
+struct TextCullGroup
+{
+    float boundsMin[2];
+    float boundsMax[2];
+    uint32_t firstInstance;
+    uint32_t count;
+    uint32_t block;
+    uint32_t pad;
+};
+
+static_assert(sizeof(TextCullBlock) == 48, "TextCullBlock must match std430 layout");
+static_assert(sizeof(TextCullGroup) == 32, "TextCullGroup must match std430 layout");
+
+// Таблицы для GPU отсечения: по блоку (bbox + clip rect + его диапазон групп) и
+// по группе глифов (до glyphsPerGroup подряд идущих инстансов одного блока, со своим bbox).
+// Группа = одна mesh workgroup; дырки между блоками в группы не попадают.
+// Таблица блоков всегда занимает blockCapacity() записей: compute pre-pass
+// обходит её целиком и не зависит от числа блоков на CPU.
+//
+// update() пересчитывает группы только блоков, изменённых после прошлой сборки
+// (GlyphInstanceBuffer::forEachBlockSince). Если число групп блока не изменилось, они
+// переписываются на месте; иначе массив групп переупаковывается из кэша по блокам
+// без повторного чтения инстансов. Срезы по кадрам — как у GlyphInstanceBuffer:
+// flush(slot) копирует только накопленные для среза диапазоны групп.
+class TextCullTable
+{
+public:
+    TextCullTable(GpuAllocator& allocator, uint32_t frameSlots);
+    ~TextCullTable();
+
+    TextCullTable(const TextCullTable&) = delete;
+    TextCullTable& operator=(const TextCullTable&) = delete;
+
+    void update(const GlyphInstanceBuffer& glyphs, uint32_t glyphsPerGroup);
+
+    // Скопировать таблицы в срез slot, если он отстал; вызывать после fence кадра
+    void flush(uint32_t slot);
+
+    VkBuffer buffer() const { return m_buffer.buffer; }
+    VkDeviceSize blocksOffset(uint32_t slot) const { return m_sliceStride * slot; }
+    VkDeviceSize blocksSize() const { return (VkDeviceSize)m_blockCapacity * sizeof(TextCullBlock); }
+    VkDeviceSize groupsOffset(uint32_t slot) const { return m_sliceStride * slot + m_groupsOffset; }
+    VkDeviceSize groupsSize() const { return (VkDeviceSize)m_groupCapacity * sizeof(TextCullGroup); }
+
+    uint32_t blockCapacity() const { return m_blockCapacity; }
+    uint32_t groupCount() const { return (uint32_t)m_groups.size(); }
+    uint32_t glyphCount() const { return m_glyphCount; }
+
+    // Растёт при переезде в больший VkBuffer: дескрипторы надо переписать
+    uint32_t generation() const { return m_generation; }
+
+private:
+    struct Range
+    {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    void createBuffer(uint32_t blockCapacity, uint32_t groupCapacity);
+    void destroyBuffer();
+
+    void buildBlock(uint32_t index, uint32_t first, const TextLayoutResult& layout, const TextClipRect& clip,
+                    const GlyphInstance* inst, uint32_t glyphsPerGroup);
+    void repackGroups();
+    void markGroupsStale(uint32_t begin, uint32_t end);
+
+private:
+    GpuAllocator& m_allocator;
+    VkDevice m_device = VK_NULL_HANDLE;
+
+    GpuBuffer m_buffer{};
+    VkDeviceSize m_offsetAlign = 1;
+
+    uint32_t m_slotCount = 1;
+    uint32_t m_blockCapacity = 0;
+    uint32_t m_groupCapacity = 0;
+    VkDeviceSize m_groupsOffset = 0; // внутри среза
+    VkDeviceSize m_sliceStride = 0;
+    uint32_t m_generation = 0;
+
+    uint32_t m_builtVersion = 0;
+    uint32_t m_builtGroupSize = 0;
+    uint32_t m_glyphCount = 0;
+
+    std::vector<TextCullBlock> m_blocks; // по blockIndex до m_blockCapacity, пустые слоты — groupCount 0
+    std::vector<TextCullGroup> m_groups;
+    std::vector<std::vector<TextCullGroup>> m_blockGroups; // по blockIndex: группы блока для переупаковки
+
+    // по срезам: всё (рост/переупаковка) или только эти диапазоны групп; таблица блоков копируется целиком
+    std::vector<uint8_t> m_slotStale;
+    std::vector<uint8_t> m_slotAllStale;
+    std::vector<std::vector<Range>> m_slotStaleGroups;
+};
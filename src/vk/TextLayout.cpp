@@ -0,0 +1,228 @@
+#include "vk/TextLayout.h"
+#include "vk/MsdfFont.h"
+#include "vk/Utf8.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr uint32_t kTabSpaces = 4;
+    constexpr size_t kDecodeChunk = 256;
+
+    // Служебные коды в зарезервированном диапазоне glyph index (см. MsdfFont::kMaxGlyphs)
+    constexpr uint16_t kCodeSpace   = 0xFFF0u;
+    constexpr uint16_t kCodeTab     = 0xFFF1u;
+    constexpr uint16_t kCodeNewline = 0xFFF2u;
+    constexpr uint16_t kCodeSkip    = 0xFFF3u; // '\r'
+
+    inline void shiftInstances(GlyphInstance* out, uint32_t begin, uint32_t end, float dx, float dy)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            out[i].posMin[0] += dx;
+            out[i].posMax[0] += dx;
+            out[i].posMin[1] += dy;
+            out[i].posMax[1] += dy;
+        }
+    }
+}
+
+TextLayout::TextLayout(const MsdfFont& font, uint32_t atlas)
+    : m_font(font)
+    , m_atlas(atlas)
+{
+    m_fallbackGlyph = m_font.glyphIndex(kUtf8ReplacementChar);
+    if (m_fallbackGlyph == MsdfFont::kInvalidGlyph)
+        m_fallbackGlyph = m_font.glyphIndex('?');
+
+    for (uint32_t c = 0; c < 128; ++c)
+    {
+        const uint16_t gi = m_font.glyphIndex(c);
+        m_asciiMap[c] = gi != MsdfFont::kInvalidGlyph ? gi : m_fallbackGlyph;
+    }
+    m_asciiMap[' '] = kCodeSpace;
+    m_asciiMap['\t'] = kCodeTab;
+    m_asciiMap['\n'] = kCodeNewline;
+    m_asciiMap['\r'] = kCodeSkip;
+    utf8BuildAsciiShuffle(m_asciiMap.data(), m_asciiShuffle);
+}
+
+TextLayoutResult TextLayout::layout(
+    std::string_view utf8,
+    const TextLayoutParams& params,
+    GlyphInstance* out,
+    uint32_t capacity) const
+{
+    TextLayoutResult res{};
+
+    const MsdfMetrics& metrics = m_font.metrics();
+    const float sx = params.scaleX;
+    const float sy = params.scaleY;
+    const float lineAdvance = metrics.lineHeight * params.lineSpacing;
+
+    const bool wrap = params.maxWidth > 0.0f && sx != 0.0f;
+    const float maxWidthEm = wrap ? params.maxWidth / std::fabs(sx) : 0.0f;
+
+    const float alignFactor =
+        params.align == TextAlign::Center ? 0.5f :
+        params.align == TextAlign::Right  ? 1.0f : 0.0f;
+
+    const uint16_t spaceGlyph = m_font.glyphIndex(' ');
+    const float spaceAdvance = spaceGlyph != MsdfFont::kInvalidGlyph ? m_font.advance(spaceGlyph) : 0.25f;
+
+    uint32_t count = 0;
+    uint32_t lineStart = 0;   // первый инстанс текущей строки
+    uint32_t lineIndex = 0;
+    float penX = 0.0f;        // em от начала строки
+    float lineEnd = 0.0f;     // em, правый край без хвостовых пробелов
+    float baseline = params.originY;
+
+    // левый глиф для кернинга; kInvalidGlyph — пары нет (начало строки, таб, kerning выключен)
+    const bool kerning = params.kerning && m_font.kerningPairCount() > 0;
+    uint16_t prev = MsdfFont::kInvalidGlyph;
+
+    // последняя точка переноса (после пробела) в текущей строке
+    bool hasBreak = false;
+    uint32_t breakInst = 0;
+    float breakPenX = 0.0f;
+    float breakLineEnd = 0.0f;
+
+    float minX = std::numeric_limits<float>::max();
+    float maxX = -std::numeric_limits<float>::max();
+
+    // выравнивание строки: без maxWidth якорь — originX
+    auto finishLine = [&](uint32_t endInst, float widthEm)
+    {
+        const float offsetEm = (wrap ? (maxWidthEm - widthEm) : -widthEm) * alignFactor;
+        const float dx = offsetEm * sx;
+        if (dx != 0.0f)
+            shiftInstances(out, lineStart, endInst, dx, 0.0f);
+
+        const float x0 = params.originX + dx;
+        const float x1 = x0 + widthEm * sx;
+        minX = std::min(minX, std::min(x0, x1));
+        maxX = std::max(maxX, std::max(x0, x1));
+        ++lineIndex;
+    };
+
+    const Utf8GlyphMap map{ m_asciiMap.data(), &m_font, m_fallbackGlyph, &m_asciiShuffle };
+    uint16_t chunk[kDecodeChunk];
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(utf8.data());
+    const uint8_t* end = p + utf8.size();
+
+    while (p < end && !res.truncated)
+    {
+        const size_t n = utf8ToGlyphs(p, end, map, chunk, kDecodeChunk);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint16_t gi = chunk[i];
+
+            if (gi >= MsdfFont::kMaxGlyphs)
+            {
+                if (gi == kCodeSpace || gi == kCodeTab)
+                {
+                    if (gi == kCodeSpace && kerning && spaceGlyph != MsdfFont::kInvalidGlyph)
+                    {
+                        penX += m_font.kerning(prev, spaceGlyph);
+                        prev = spaceGlyph;
+                    }
+                    else
+                    {
+                        prev = MsdfFont::kInvalidGlyph;
+                    }
+
+                    penX += (gi == kCodeTab ? (float)kTabSpaces : 1.0f) * spaceAdvance;
+                    hasBreak = true;
+                    breakInst = count;
+                    breakPenX = penX;
+                    breakLineEnd = lineEnd;
+                }
+                else if (gi == kCodeNewline)
+                {
+                    finishLine(count, lineEnd);
+                    lineStart = count;
+                    penX = 0.0f;
+                    lineEnd = 0.0f;
+                    hasBreak = false;
+                    prev = MsdfFont::kInvalidGlyph;
+                    baseline -= lineAdvance * sy;
+                }
+                // kCodeSkip и kInvalidGlyph (нет даже fallback) пропускаем
+                continue;
+            }
+
+            const float adv = m_font.advance(gi);
+            float kern = m_font.kerning(prev, gi);
+
+            if (wrap && penX + kern + adv > maxWidthEm && count > lineStart)
+            {
+                if (hasBreak)
+                {
+                    // слово после последнего пробела уезжает на новую строку целиком
+                    finishLine(breakInst, breakLineEnd);
+                    shiftInstances(out, breakInst, count, -breakPenX * sx, -lineAdvance * sy);
+                    lineStart = breakInst;
+                    penX -= breakPenX;
+                    lineEnd = std::max(0.0f, lineEnd - breakPenX);
+                }
+                else
+                {
+                    // слово длиннее строки — рвём по символу
+                    finishLine(count, lineEnd);
+                    lineStart = count;
+                    penX = 0.0f;
+                    lineEnd = 0.0f;
+                    kern = 0.0f;
+                }
+                hasBreak = false;
+                baseline -= lineAdvance * sy;
+            }
+
+            penX += kern;
+            if (kerning)
+                prev = gi;
+
+            if (m_font.hasQuad(gi))
+            {
+                if (count == capacity)
+                {
+                    res.truncated = true;
+                    break;
+                }
+
+                const MsdfGlyphQuad& q = m_font.quad(gi);
+                GlyphInstance& g = out[count++];
+                g.posMin[0] = params.originX + (penX + q.planeLeft) * sx;
+                g.posMin[1] = baseline + q.planeBottom * sy;
+                g.posMax[0] = params.originX + (penX + q.planeRight) * sx;
+                g.posMax[1] = baseline + q.planeTop * sy;
+                g.uvMin[0] = q.u0;
+                g.uvMin[1] = q.vTop;
+                g.uvMax[0] = q.u1;
+                g.uvMax[1] = q.vBottom;
+                g.glyph = gi;
+                g.atlas = m_atlas;
+            }
+
+            penX += adv;
+            lineEnd = penX;
+        }
+    }
+
+    finishLine(count, lineEnd);
+
+    res.glyphCount = count;
+    res.lineCount = lineIndex;
+
+    const float top = params.originY + metrics.ascender * sy;
+    const float bottom = params.originY - (float)(lineIndex - 1) * lineAdvance * sy + metrics.descender * sy;
+    res.boundsMin[0] = minX;
+    res.boundsMax[0] = maxX;
+    res.boundsMin[1] = std::min(top, bottom);
+    res.boundsMax[1] = std::max(top, bottom);
+    return res;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vk/Utf8.h"
+
+#include <string_view>
+#include <array>
+#include <cstdint>
+
+class MsdfFont;
+
+// Совпадает с GlyphInstance в shaders/*.glsl (std430, 40 байт)
+struct GlyphInstance
+{
+    float posMin[2]; // (left, bottom)
+    float posMax[2]; // (right, top)
+    float uvMin[2];  // (u0, vTop)    - v=0 вверху
+    float uvMax[2];  // (u1, vBottom)
+    uint32_t glyph;  // glyph index в MsdfFont (таблица glyphlet'ов Loop–Blinn)
+    uint32_t atlas;  // glyph_atlas_ref: слот таблицы атласов и слой в нём
+};
+static_assert(sizeof(GlyphInstance) == 40, "GlyphInstance must match the std430 layout");
+
+// GlyphInstance::atlas: слот таблицы атласов рендерера (binding 0 MsdfTextPipeline,
+// sampler2DArray[]) в старших 16 битах, слой texture array — в младших
+constexpr uint32_t glyph_atlas_ref(uint32_t slot, uint32_t layer)
+{
+    return slot << 16 | (layer & 0xFFFFu);
+}
+
+enum class TextAlign : uint8_t
+{
+    Left,
+    Center,
+    Right,
+};
+
+// Все величины в выходных единицах (NDC, пиксели — что решит вызывающий).
+// em -> output: x * scaleX, y * scaleY. Для y-вниз (NDC Vulkan) scaleY < 0.
+struct TextLayoutParams
+{
+    float originX = 0.0f;     // левый край блока (или точка выравнивания, если maxWidth == 0)
+    float originY = 0.0f;     // baseline первой строки
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    float maxWidth = 0.0f;    // ширина переноса строк; 0 = без переноса
+    float lineSpacing = 1.0f; // множитель к MsdfMetrics::lineHeight
+    TextAlign align = TextAlign::Left;
+    bool kerning = true;      // пары из MsdfFont::kerning()
+};
+
+struct TextLayoutResult
+{
+    uint32_t glyphCount = 0;   // записано инстансов (пробелы инстансов не дают)
+    uint32_t lineCount = 0;
+    bool truncated = false;    // не хватило capacity
+
+    // bbox блока в выходных единицах
+    float boundsMin[2] = { 0.0f, 0.0f };
+    float boundsMax[2] = { 0.0f, 0.0f };
+};
+
+// UTF-8 -> GlyphInstance. Пишет прямо в буфер вызывающего (например, mapped SSBO),
+// без аллокаций на глиф; перенос строк и выравнивание правят уже записанные инстансы in-place.
+class TextLayout
+{
+public:
+    // atlas — glyph_atlas_ref атласа шрифта: пишется во все инстансы, поэтому блоки разных
+    // шрифтов живут в одном буфере и рисуются одним draw
+    explicit TextLayout(const MsdfFont& font, uint32_t atlas = 0);
+
+    TextLayoutResult layout(
+        std::string_view utf8,
+        const TextLayoutParams& params,
+        GlyphInstance* out,
+        uint32_t capacity) const;
+
+    const MsdfFont& font() const { return m_font; }
+    uint32_t atlas() const { return m_atlas; }
+
+private:
+    const MsdfFont& m_font;
+    uint32_t m_atlas = 0;
+    uint16_t m_fallbackGlyph; // U+FFFD или '?'
+
+    // ASCII -> glyph index для utf8ToGlyphs; пробелы/переводы строк — служебные коды
+    std::array<uint16_t, 128> m_asciiMap{};
+    Utf8AsciiShuffle m_asciiShuffle{}; // m_asciiMap для AVX2 пути
+};
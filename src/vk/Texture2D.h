@@ -1,8 +1,14 @@
 #pragma once
+#include "vk/GpuAllocator.h"
+
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <cstdint>
 
+class UploadManager;
+
+// Image с одним mip'ом и layers() слоями; view — всегда 2D_ARRAY (одинарная текстура —
+// массив из одного слоя), шейдеры сэмплируют sampler2DArray
 class Texture2D
 {
 public:
@@ -15,30 +21,65 @@ public:
     Texture2D(Texture2D&& rhs) noexcept;
     Texture2D& operator=(Texture2D&& rhs) noexcept;
 
+    // Копия ставится в текущий batch uploads (без ожидания); текстура читаема во фрагментном
+    // шейдере после uploads.flush(), завершения тикета и acquire на graphics очереди
     void createFromRGBA8(
-        VkPhysicalDevice phys,
-        VkDevice device,
-        VkCommandPool cmdPool,
-        VkQueue graphicsQueue,
+        GpuAllocator& allocator,
+        UploadManager& uploads,
         uint32_t width,
         uint32_t height,
         const std::vector<uint8_t>& rgba,
         VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
 
+    // То же, но из произвольной памяти (например, замапленный font pack) — без промежуточной копии
+    void createFromRGBA8(
+        GpuAllocator& allocator,
+        UploadManager& uploads,
+        uint32_t width,
+        uint32_t height,
+        const uint8_t* rgba,
+        size_t rgbaSize,
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+
+    // Texture array: слой i — из layers[i] (по layerSize байт), копия на слой в тот же batch.
+    // Атласы нескольких шрифтов одного размера — одна текстура
+    void createArrayFromRGBA8(
+        GpuAllocator& allocator,
+        UploadManager& uploads,
+        uint32_t width,
+        uint32_t height,
+        const uint8_t* const* layers,
+        uint32_t layerCount,
+        size_t layerSize,
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+
+    // Пустая текстура под частичные загрузки (динамический атлас): image в layout UNDEFINED,
+    // первый переход и все копии — на владельце, в его командном буфере
+    void createEmpty(
+        GpuAllocator& allocator,
+        uint32_t width,
+        uint32_t height,
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+
     void destroy();
 
+    VkImage image() const { return m_image.image; }
     VkImageView view() const { return m_view; }
     VkSampler sampler() const { return m_sampler; }
+    uint32_t layers() const { return m_layers; }
 
 private:
-    VkPhysicalDevice m_phys = VK_NULL_HANDLE;
+    void createImage(GpuAllocator& allocator, uint32_t width, uint32_t height, uint32_t layers, VkFormat format);
+    void createViewAndSampler();
+
+    GpuAllocator* m_allocator = nullptr;
     VkDevice m_device = VK_NULL_HANDLE;
 
-    VkImage m_image = VK_NULL_HANDLE;
-    VkDeviceMemory m_mem = VK_NULL_HANDLE;
+    GpuImage m_image{};
     VkImageView m_view = VK_NULL_HANDLE;
     VkSampler m_sampler = VK_NULL_HANDLE;
 
     uint32_t m_width = 0, m_height = 0;
+    uint32_t m_layers = 0;
     VkFormat m_format = VK_FORMAT_UNDEFINED;
 };
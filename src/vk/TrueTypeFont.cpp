@@ -0,0 +1,659 @@
+#include "vk/TrueTypeFont.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static uint16_t be16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static int16_t bes16(const uint8_t* p)
+{
+    return (int16_t)be16(p);
+}
+
+static uint32_t be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static constexpr uint32_t make_tag(char a, char b, char c, char d)
+{
+    return ((uint32_t)(uint8_t)a << 24) | ((uint32_t)(uint8_t)b << 16) | ((uint32_t)(uint8_t)c << 8) | (uint8_t)d;
+}
+
+static float f2dot14(const uint8_t* p)
+{
+    return (float)bes16(p) / 16384.0f;
+}
+
+const uint8_t* TrueTypeFont::table(uint32_t tag, uint32_t& length) const
+{
+    const uint8_t* base = m_file.data();
+    const size_t size = m_file.size();
+
+    // коллекция (.ttc): берём первый шрифт
+    size_t dir = 0;
+    if (be32(base) == make_tag('t', 't', 'c', 'f'))
+    {
+        if (size < 16) return nullptr;
+        dir = be32(base + 12);
+        if (dir > size - 12) return nullptr;
+    }
+
+    const uint32_t numTables = be16(base + dir + 4);
+    if ((uint64_t)dir + 12 + (uint64_t)numTables * 16 > size)
+        return nullptr;
+
+    for (uint32_t i = 0; i < numTables; ++i)
+    {
+        const uint8_t* rec = base + dir + 12 + i * 16;
+        if (be32(rec) != tag)
+            continue;
+
+        const uint32_t offset = be32(rec + 8);
+        length = be32(rec + 12);
+        if (offset > size || length > size - offset)
+            return nullptr;
+        return base + offset;
+    }
+    return nullptr;
+}
+
+bool TrueTypeFont::load(const std::string& path)
+{
+    if (!m_file.open(path))
+    {
+        std::cerr << "Failed to open font: " << path << "\n";
+        return false;
+    }
+
+    if (m_file.size() < 12 || be32(m_file.data()) == make_tag('O', 'T', 'T', 'O'))
+    {
+        std::cerr << "Not a TrueType (glyf) font: " << path << "\n";
+        m_file.close();
+        return false;
+    }
+
+    uint32_t headLen = 0, maxpLen = 0, hheaLen = 0;
+    const uint8_t* head = table(make_tag('h', 'e', 'a', 'd'), headLen);
+    const uint8_t* maxp = table(make_tag('m', 'a', 'x', 'p'), maxpLen);
+    const uint8_t* hhea = table(make_tag('h', 'h', 'e', 'a'), hheaLen);
+    m_loca = table(make_tag('l', 'o', 'c', 'a'), m_locaLength);
+    m_glyf = table(make_tag('g', 'l', 'y', 'f'), m_glyfLength);
+    m_hmtx = table(make_tag('h', 'm', 't', 'x'), m_hmtxLength);
+
+    bool ok = head && headLen >= 54 && maxp && maxpLen >= 6 && hhea && hheaLen >= 36 && m_loca && m_glyf && m_hmtx;
+    if (ok)
+    {
+        m_unitsPerEm = be16(head + 18);
+        m_longLoca = bes16(head + 50) != 0;
+        m_numGlyphs = be16(maxp + 4);
+        m_numHMetrics = be16(hhea + 34);
+
+        ok = m_unitsPerEm > 0 && m_numHMetrics > 0 &&
+             (uint64_t)m_locaLength >= (uint64_t)(m_numGlyphs + 1) * (m_longLoca ? 4u : 2u) &&
+             (uint64_t)m_hmtxLength >= (uint64_t)m_numHMetrics * 4u;
+    }
+
+    if (ok)
+    {
+        const float em = 1.0f / (float)m_unitsPerEm;
+        m_metrics.ascender = (float)bes16(hhea + 4) * em;
+        m_metrics.descender = (float)bes16(hhea + 6) * em;
+        m_metrics.lineHeight = m_metrics.ascender - m_metrics.descender + (float)bes16(hhea + 8) * em;
+
+        uint32_t postLen = 0;
+        if (const uint8_t* post = table(make_tag('p', 'o', 's', 't'), postLen); post && postLen >= 12)
+        {
+            m_metrics.underlineY = (float)bes16(post + 8) * em;
+            m_metrics.underlineThickness = (float)bes16(post + 10) * em;
+        }
+
+        m_kern = table(make_tag('k', 'e', 'r', 'n'), m_kernLength);
+        if (m_kernLength < 4)
+            m_kern = nullptr;
+    }
+
+    if (!ok || !selectCmap())
+    {
+        std::cerr << "Corrupted or unsupported TrueType font: " << path << "\n";
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool TrueTypeFont::selectCmap()
+{
+    uint32_t length = 0;
+    const uint8_t* cmap = table(make_tag('c', 'm', 'a', 'p'), length);
+    if (!cmap || length < 4)
+        return false;
+
+    const uint32_t numTables = be16(cmap + 2);
+    if (4 + (uint64_t)numTables * 8 > length)
+        return false;
+
+    // Unicode: формат 12 (весь диапазон) лучше формата 4 (только BMP)
+    int best = 0;
+    for (uint32_t i = 0; i < numTables; ++i)
+    {
+        const uint8_t* rec = cmap + 4 + i * 8;
+        const uint16_t platform = be16(rec);
+        const uint16_t encoding = be16(rec + 2);
+        const uint32_t offset = be32(rec + 4);
+
+        const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode || offset + 8ull > length)
+            continue;
+
+        const uint8_t* sub = cmap + offset;
+        const uint16_t format = be16(sub);
+
+        int score = 0;
+        uint32_t subLength = 0;
+        if (format == 12)
+        {
+            subLength = be32(sub + 4);
+            const uint32_t groups = be32(sub + 12);
+            if (subLength <= length - offset && 16 + (uint64_t)groups * 12 <= subLength)
+                score = 2;
+        }
+        else if (format == 4)
+        {
+            subLength = be16(sub + 2);
+            const uint32_t segX2 = be16(sub + 6);
+            if (subLength <= length - offset && 16 + (uint64_t)segX2 * 4 <= subLength)
+                score = 1;
+        }
+
+        if (score > best)
+        {
+            best = score;
+            m_cmap = sub;
+            m_cmapLength = subLength;
+            m_cmapFormat = format;
+        }
+    }
+    return best > 0;
+}
+
+uint32_t TrueTypeFont::glyphIndex(uint32_t cp) const
+{
+    if (m_cmapFormat == 12)
+    {
+        const uint8_t* groups = m_cmap + 16;
+        uint32_t lo = 0, hi = be32(m_cmap + 12);
+        while (lo < hi)
+        {
+            const uint32_t mid = (lo + hi) / 2;
+            const uint8_t* g = groups + mid * 12;
+            if (cp < be32(g))
+                hi = mid;
+            else if (cp > be32(g + 4))
+                lo = mid + 1;
+            else
+            {
+                const uint32_t glyph = be32(g + 8) + (cp - be32(g));
+                return glyph < m_numGlyphs ? glyph : 0;
+            }
+        }
+        return 0;
+    }
+
+    if (m_cmapFormat != 4 || cp > 0xFFFFu)
+        return 0;
+
+    // формат 4: сегменты [startCode, endCode], отсортированы по endCode
+    const uint32_t segX2 = be16(m_cmap + 6);
+    const uint8_t* endCodes = m_cmap + 14;
+    const uint8_t* startCodes = endCodes + segX2 + 2;
+    const uint8_t* deltas = startCodes + segX2;
+    const uint8_t* rangeOffsets = deltas + segX2;
+
+    uint32_t lo = 0, hi = segX2 / 2;
+    while (lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2;
+        if (be16(endCodes + mid * 2) < cp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == segX2 / 2)
+        return 0;
+
+    const uint32_t start = be16(startCodes + lo * 2);
+    if (cp < start)
+        return 0;
+
+    const uint16_t delta = be16(deltas + lo * 2);
+    const uint32_t rangeOffset = be16(rangeOffsets + lo * 2);
+    uint32_t glyph = 0;
+    if (rangeOffset == 0)
+        glyph = (cp + delta) & 0xFFFFu;
+    else
+    {
+        // idRangeOffset — смещение от самого поля до glyphIdArray
+        const size_t at = (size_t)(rangeOffsets + lo * 2 - m_cmap) + rangeOffset + (cp - start) * 2;
+        if (at + 2 > m_cmapLength)
+            return 0;
+        glyph = be16(m_cmap + at);
+        if (glyph != 0)
+            glyph = (glyph + delta) & 0xFFFFu;
+    }
+    return glyph < m_numGlyphs ? glyph : 0;
+}
+
+float TrueTypeFont::advance(uint32_t glyph) const
+{
+    const uint32_t metric = std::min(glyph, m_numHMetrics - 1);
+    return (float)be16(m_hmtx + metric * 4) / (float)m_unitsPerEm;
+}
+
+void TrueTypeFont::kerningPairs(std::vector<TtfKerningPair>& out) const
+{
+    out.clear();
+    if (!m_kern || be16(m_kern) != 0)
+        return;
+
+    // kern v0 (Microsoft): подтаблицы друг за другом, берём формат 0 с горизонтальным кернингом
+    const float em = 1.0f / (float)m_unitsPerEm;
+    const uint32_t tables = be16(m_kern + 2);
+    size_t at = 4;
+    for (uint32_t t = 0; t < tables && at + 6 <= m_kernLength; ++t)
+    {
+        const uint8_t* sub = m_kern + at;
+        const uint32_t length = be16(sub + 2);
+        const uint32_t coverage = be16(sub + 4);
+        if (length < 6)
+            break;
+
+        // формат в старшем байте coverage; биты 0..2: horizontal, minimum, cross-stream
+        const bool usable = (coverage >> 8) == 0 && (coverage & 0x7u) == 0x1u;
+        if (usable && at + 14 <= m_kernLength)
+        {
+            // length 16-битный и у больших таблиц переполняется: верим nPairs, обрезаем по таблице
+            const uint32_t pairs = std::min<uint32_t>(be16(sub + 6), (uint32_t)((m_kernLength - at - 14) / 6));
+            const uint8_t* p = sub + 14;
+            for (uint32_t i = 0; i < pairs; ++i, p += 6)
+            {
+                const float value = (float)bes16(p + 4) * em;
+                if (value != 0.0f)
+                    out.push_back({ be16(p), be16(p + 2), value });
+            }
+            at += 14 + (size_t)pairs * 6;
+            continue;
+        }
+        at += length;
+    }
+}
+
+bool TrueTypeFont::glyphData(uint32_t glyph, const uint8_t*& begin, const uint8_t*& end) const
+{
+    if (glyph >= m_numGlyphs)
+        return false;
+
+    uint32_t from = 0, to = 0;
+    if (m_longLoca)
+    {
+        from = be32(m_loca + glyph * 4);
+        to = be32(m_loca + glyph * 4 + 4);
+    }
+    else
+    {
+        from = be16(m_loca + glyph * 2) * 2u;
+        to = be16(m_loca + glyph * 2 + 2) * 2u;
+    }
+
+    if (from > to || to > m_glyfLength)
+        return false;
+
+    begin = m_glyf + from;
+    end = m_glyf + to;
+    return true;
+}
+
+bool TrueTypeFont::appendGlyph(uint32_t glyph, const float xf[6], uint32_t depth, std::vector<RawContour>& out) const
+{
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    if (!glyphData(glyph, p, end))
+        return false;
+
+    // пустой глиф (пробел)
+    if (p == end)
+        return true;
+    if (end - p < 10)
+        return false;
+
+    const int16_t contourCount = bes16(p);
+    if (contourCount >= 0)
+        return appendSimple(p + 10, end, contourCount, xf, out);
+
+    if (depth >= kMaxCompositeDepth)
+        return false;
+    return appendComposite(p + 10, end, xf, depth, out);
+}
+
+bool TrueTypeFont::appendSimple(const uint8_t* p, const uint8_t* end, int16_t contourCount, const float xf[6], std::vector<RawContour>& out) const
+{
+    if (contourCount == 0)
+        return true;
+    if (end - p < contourCount * 2 + 2)
+        return false;
+
+    std::vector<uint16_t> endPts((size_t)contourCount);
+    for (int16_t i = 0; i < contourCount; ++i)
+        endPts[(size_t)i] = be16(p + i * 2);
+    p += contourCount * 2;
+
+    const uint32_t pointCount = (uint32_t)endPts.back() + 1;
+    const uint16_t instructionLength = be16(p);
+    p += 2 + instructionLength;
+    if (p > end)
+        return false;
+
+    enum : uint8_t
+    {
+        kOnCurve = 0x01,
+        kXShort = 0x02,
+        kYShort = 0x04,
+        kRepeat = 0x08,
+        kXSameOrPositive = 0x10,
+        kYSameOrPositive = 0x20,
+    };
+
+    std::vector<uint8_t> flags(pointCount);
+    for (uint32_t i = 0; i < pointCount;)
+    {
+        if (p >= end) return false;
+        const uint8_t f = *p++;
+        flags[i++] = f;
+        if (f & kRepeat)
+        {
+            if (p >= end) return false;
+            for (uint8_t r = *p++; r > 0 && i < pointCount; --r)
+                flags[i++] = f;
+        }
+    }
+
+    // координаты — дельты; x и y идут двумя отдельными массивами
+    std::vector<int32_t> xs(pointCount), ys(pointCount);
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const uint8_t shortBit = axis == 0 ? kXShort : kYShort;
+        const uint8_t sameBit = axis == 0 ? kXSameOrPositive : kYSameOrPositive;
+        std::vector<int32_t>& v = axis == 0 ? xs : ys;
+
+        int32_t acc = 0;
+        for (uint32_t i = 0; i < pointCount; ++i)
+        {
+            if (flags[i] & shortBit)
+            {
+                if (p >= end) return false;
+                const int32_t d = *p++;
+                acc += (flags[i] & sameBit) ? d : -d;
+            }
+            else if (!(flags[i] & sameBit))
+            {
+                if (end - p < 2) return false;
+                acc += bes16(p);
+                p += 2;
+            }
+            v[i] = acc;
+        }
+    }
+
+    // отрицательный определитель (зеркальный компонент) меняет обход контуров
+    const bool mirrored = xf[0] * xf[3] - xf[1] * xf[2] < 0.0f;
+
+    uint32_t first = 0;
+    for (uint16_t last : endPts)
+    {
+        if (last < first || last >= pointCount)
+            return false;
+
+        RawContour c;
+        c.points.reserve(last - first + 1);
+        c.reverse = mirrored;
+        for (uint32_t i = first; i <= last; ++i)
+        {
+            const float x = (float)xs[i], y = (float)ys[i];
+            c.points.push_back({ xf[0] * x + xf[2] * y + xf[4], xf[1] * x + xf[3] * y + xf[5], (flags[i] & kOnCurve) != 0 });
+        }
+        out.push_back(std::move(c));
+        first = (uint32_t)last + 1;
+    }
+    return true;
+}
+
+bool TrueTypeFont::appendComposite(const uint8_t* p, const uint8_t* end, const float xf[6], uint32_t depth, std::vector<RawContour>& out) const
+{
+    enum : uint16_t
+    {
+        kArgsAreWords = 0x0001,
+        kArgsAreXY = 0x0002,
+        kHaveScale = 0x0008,
+        kMoreComponents = 0x0020,
+        kHaveXYScale = 0x0040,
+        kHave2x2 = 0x0080,
+        kScaledOffset = 0x0800,
+    };
+
+    // номера точек для привязки компонентов (не ARGS_ARE_XY) — сквозные по всему глифу
+    const size_t firstContour = out.size();
+    auto pointAt = [&](size_t from, uint32_t index, RawPoint& pt) -> bool
+    {
+        for (size_t c = from; c < out.size(); ++c)
+        {
+            if (index < out[c].points.size())
+            {
+                pt = out[c].points[index];
+                return true;
+            }
+            index -= (uint32_t)out[c].points.size();
+        }
+        return false;
+    };
+
+    uint16_t flags = 0;
+    do
+    {
+        if (end - p < 4) return false;
+        flags = be16(p);
+        const uint32_t child = be16(p + 2);
+        p += 4;
+
+        int32_t arg1 = 0, arg2 = 0;
+        const bool signedArgs = (flags & kArgsAreXY) != 0;
+        if (flags & kArgsAreWords)
+        {
+            if (end - p < 4) return false;
+            arg1 = signedArgs ? bes16(p) : be16(p);
+            arg2 = signedArgs ? bes16(p + 2) : be16(p + 2);
+            p += 4;
+        }
+        else
+        {
+            if (end - p < 2) return false;
+            arg1 = signedArgs ? (int8_t)p[0] : p[0];
+            arg2 = signedArgs ? (int8_t)p[1] : p[1];
+            p += 2;
+        }
+
+        // матрица компонента: x' = a*x + c*y, y' = b*x + d*y
+        float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+        if (flags & kHaveScale)
+        {
+            if (end - p < 2) return false;
+            a = d = f2dot14(p);
+            p += 2;
+        }
+        else if (flags & kHaveXYScale)
+        {
+            if (end - p < 4) return false;
+            a = f2dot14(p);
+            d = f2dot14(p + 2);
+            p += 4;
+        }
+        else if (flags & kHave2x2)
+        {
+            if (end - p < 8) return false;
+            a = f2dot14(p);
+            b = f2dot14(p + 2);
+            c = f2dot14(p + 4);
+            d = f2dot14(p + 6);
+            p += 8;
+        }
+
+        float dx = 0.0f, dy = 0.0f;
+        if (flags & kArgsAreXY)
+        {
+            dx = (float)arg1;
+            dy = (float)arg2;
+            if (flags & kScaledOffset)
+            {
+                const float sx = dx, sy = dy;
+                dx = a * sx + c * sy;
+                dy = b * sx + d * sy;
+            }
+        }
+
+        // родитель ∘ компонент
+        const float m[6] = {
+            xf[0] * a + xf[2] * b,
+            xf[1] * a + xf[3] * b,
+            xf[0] * c + xf[2] * d,
+            xf[1] * c + xf[3] * d,
+            xf[0] * dx + xf[2] * dy + xf[4],
+            xf[1] * dx + xf[3] * dy + xf[5],
+        };
+
+        const size_t childFirst = out.size();
+        if (!appendGlyph(child, m, depth + 1, out))
+            return false;
+
+        if (!(flags & kArgsAreXY))
+        {
+            // точка arg2 компонента совмещается с точкой arg1 уже собранной части
+            RawPoint anchor{}, moved{};
+            if (!pointAt(firstContour, (uint32_t)arg1, anchor) || !pointAt(childFirst, (uint32_t)arg2, moved))
+                return false;
+
+            const float tx = anchor.x - moved.x, ty = anchor.y - moved.y;
+            for (size_t ci = childFirst; ci < out.size(); ++ci)
+            {
+                for (RawPoint& pt : out[ci].points)
+                {
+                    pt.x += tx;
+                    pt.y += ty;
+                }
+            }
+        }
+    } while (flags & kMoreComponents);
+
+    return true;
+}
+
+bool TrueTypeFont::outline(uint32_t glyph, TtfOutline& out) const
+{
+    out = {};
+
+    std::vector<RawContour> raw;
+    const float identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    if (!appendGlyph(glyph, identity, 0, raw))
+        return false;
+
+    const float s = 1.0f / (float)m_unitsPerEm;
+    auto em = [s](const RawPoint& p) { return TtfPoint{ p.x * s, p.y * s }; };
+    auto mid = [](TtfPoint a, TtfPoint b) { return TtfPoint{ (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f }; };
+    auto same = [](TtfPoint a, TtfPoint b) { return a.x == b.x && a.y == b.y; };
+
+    out.min = { INFINITY, INFINITY };
+    out.max = { -INFINITY, -INFINITY };
+
+    for (RawContour& rc : raw)
+    {
+        std::vector<RawPoint>& pts = rc.points;
+        if (pts.size() < 2)
+            continue;
+        if (rc.reverse)
+            std::reverse(pts.begin(), pts.end());
+
+        const size_t n = pts.size();
+        size_t first = 0;
+        while (first < n && !pts[first].onCurve)
+            ++first;
+
+        // старт — точка на кривой; если таких нет, середина между последней и первой off-curve
+        TtfPoint start{};
+        size_t from = 0, count = n;
+        if (first == n)
+            start = mid(em(pts[n - 1]), em(pts[0]));
+        else
+        {
+            start = em(pts[first]);
+            from = first + 1;
+            count = n - 1;
+        }
+
+        TtfContour contour;
+        TtfPoint cur = start;
+        TtfPoint ctrl{};
+        bool pending = false;
+
+        auto emit = [&](TtfPoint to)
+        {
+            TtfSegment seg{};
+            seg.p0 = cur;
+            seg.p1 = to;
+            seg.curve = pending;
+            seg.c = pending ? ctrl : mid(cur, to);
+            if (!same(seg.p0, seg.p1) || (pending && !same(seg.p0, seg.c)))
+                contour.segments.push_back(seg);
+            cur = to;
+        };
+
+        // между двумя off-curve точками — неявная on-curve в середине
+        for (size_t k = 0; k <= count; ++k)
+        {
+            const bool closing = k == count;
+            const RawPoint& rp = pts[(from + k) % n];
+            const TtfPoint q = closing ? start : em(rp);
+
+            if (closing || rp.onCurve)
+            {
+                emit(q);
+                pending = false;
+            }
+            else
+            {
+                if (pending)
+                    emit(mid(ctrl, q));
+                ctrl = q;
+                pending = true;
+            }
+        }
+
+        if (contour.segments.empty())
+            continue;
+
+        for (const TtfSegment& seg : contour.segments)
+        {
+            for (const TtfPoint& p : { seg.p0, seg.c })
+            {
+                out.min = { std::min(out.min.x, p.x), std::min(out.min.y, p.y) };
+                out.max = { std::max(out.max.x, p.x), std::max(out.max.y, p.y) };
+            }
+        }
+        out.contours.push_back(std::move(contour));
+    }
+
+    if (out.contours.empty())
+        out.min = out.max = {};
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "platform/MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TtfPoint
+{
+    float x = 0.0f, y = 0.0f;
+};
+
+// Отрезок контура: прямая (p0, p1) или квадратичная Безье (p0, c, p1)
+struct TtfSegment
+{
+    TtfPoint p0, c, p1;
+    bool curve = false;
+};
+
+// Замкнутый контур: p1 каждого отрезка — p0 следующего
+struct TtfContour
+{
+    std::vector<TtfSegment> segments;
+};
+
+// Контуры глифа в em (y вверх, от baseline). TrueType: внешние контуры — по часовой стрелке
+// (заливка справа по ходу), дырки — против
+struct TtfOutline
+{
+    std::vector<TtfContour> contours;
+    TtfPoint min, max; // bbox точек (с контрольными)
+
+    bool empty() const { return contours.empty(); }
+};
+
+// Вертикальные метрики (em): hhea + post, как в metrics json msdf-atlas-gen
+struct TtfMetrics
+{
+    float ascender = 0.0f;
+    float descender = 0.0f;
+    float lineHeight = 0.0f; // ascender - descender + lineGap
+    float underlineY = 0.0f;
+    float underlineThickness = 0.0f;
+};
+
+// Пара кернинга по glyph index'ам (em, прибавляется к advance левого)
+struct TtfKerningPair
+{
+    uint32_t left = 0;
+    uint32_t right = 0;
+    float advance = 0.0f;
+};
+
+// Контуры глифов TrueType (.ttf, таблица glyf): только то, что нужно для геометрии —
+// cmap, hmtx, loca/glyf, составные глифы. CFF (.otf) не поддерживается.
+// Файл остаётся в mmap, глифы декодируются по запросу.
+class TrueTypeFont
+{
+public:
+    bool load(const std::string& path);
+
+    uint32_t glyphCount() const { return m_numGlyphs; }
+    uint32_t unitsPerEm() const { return m_unitsPerEm; }
+
+    // codepoint -> glyph index (0 — .notdef, если глифа нет)
+    uint32_t glyphIndex(uint32_t cp) const;
+
+    // em
+    float advance(uint32_t glyph) const;
+
+    // false — битые данные; пустой out (пробел) — не ошибка
+    bool outline(uint32_t glyph, TtfOutline& out) const;
+
+    const TtfMetrics& metrics() const { return m_metrics; }
+
+    // Все пары таблицы kern (формат 0, горизонтальные); GPOS не читается
+    void kerningPairs(std::vector<TtfKerningPair>& out) const;
+
+private:
+    struct RawPoint
+    {
+        float x, y;
+        bool onCurve;
+    };
+    struct RawContour
+    {
+        std::vector<RawPoint> points; // font units, уже в системе координат глифа
+        bool reverse = false;         // пришёл через зеркальное преобразование
+    };
+
+    // [m00 m01 m10 m11 dx dy]: x' = m00*x + m10*y + dx, y' = m01*x + m11*y + dy
+    bool appendGlyph(uint32_t glyph, const float xf[6], uint32_t depth, std::vector<RawContour>& out) const;
+    bool appendSimple(const uint8_t* p, const uint8_t* end, int16_t contourCount, const float xf[6], std::vector<RawContour>& out) const;
+    bool appendComposite(const uint8_t* p, const uint8_t* end, const float xf[6], uint32_t depth, std::vector<RawContour>& out) const;
+
+    bool glyphData(uint32_t glyph, const uint8_t*& begin, const uint8_t*& end) const;
+    const uint8_t* table(uint32_t tag, uint32_t& length) const;
+    bool selectCmap();
+
+    static constexpr uint32_t kMaxCompositeDepth = 8;
+
+private:
+    MappedFile m_file;
+
+    uint32_t m_unitsPerEm = 0;
+    uint32_t m_numGlyphs = 0;
+    uint32_t m_numHMetrics = 0;
+    bool m_longLoca = false;
+
+    const uint8_t* m_loca = nullptr;
+    uint32_t m_locaLength = 0;
+    const uint8_t* m_glyf = nullptr;
+    uint32_t m_glyfLength = 0;
+    const uint8_t* m_hmtx = nullptr;
+    uint32_t m_hmtxLength = 0;
+    const uint8_t* m_kern = nullptr; // nullptr — таблицы нет
+    uint32_t m_kernLength = 0;
+
+    TtfMetrics m_metrics;
+
+    // выбранная подтаблица cmap (формат 4 или 12)
+    const uint8_t* m_cmap = nullptr;
+    uint32_t m_cmapLength = 0;
+    uint16_t m_cmapFormat = 0;
+};
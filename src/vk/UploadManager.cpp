@@ -0,0 +1,329 @@
+#include "vk/UploadManager.h"
+#include "vk/VulkanUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+UploadManager::UploadManager(
+    GpuAllocator& allocator,
+    uint32_t transferFamily,
+    VkQueue transferQueue,
+    uint32_t graphicsFamily,
+    VkDeviceSize stagingRingSize)
+    : m_allocator(allocator)
+    , m_device(allocator.device())
+    , m_transferFamily(transferFamily)
+    , m_graphicsFamily(graphicsFamily)
+    , m_queue(transferQueue)
+    , m_ring(allocator, stagingRingSize)
+{
+    m_copyAlignment = std::max<VkDeviceSize>(m_copyAlignment, allocator.limits().optimalBufferCopyOffsetAlignment);
+
+    VkCommandPoolCreateInfo pci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    pci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pci.queueFamilyIndex = m_transferFamily;
+    vk_check(vkCreateCommandPool(m_device, &pci, nullptr, &m_cmdPool), "vkCreateCommandPool(upload)");
+
+    VkSemaphoreTypeCreateInfo tci{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    tci.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    tci.initialValue = 0;
+
+    VkSemaphoreCreateInfo sci{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    sci.pNext = &tci;
+    vk_check(vkCreateSemaphore(m_device, &sci, nullptr, &m_timeline), "vkCreateSemaphore(upload timeline)");
+}
+
+UploadManager::~UploadManager()
+{
+    // открытый batch никто не увидит — отправляем, чтобы корректно освободить
+    flush();
+    wait({ m_submitted });
+
+    for (Batch& b : m_inFlight)
+        releaseBatch(b);
+    m_inFlight.clear();
+
+    if (m_timeline) vkDestroySemaphore(m_device, m_timeline, nullptr);
+    if (m_cmdPool) vkDestroyCommandPool(m_device, m_cmdPool, nullptr);
+}
+
+UploadManager::Batch& UploadManager::openBatch()
+{
+    if (m_hasOpen)
+        return m_open;
+
+    m_open = {};
+
+    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    ai.commandPool = m_cmdPool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 1;
+    vk_check(vkAllocateCommandBuffers(m_device, &ai, &m_open.cmd), "vkAllocateCommandBuffers(upload)");
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vk_check(vkBeginCommandBuffer(m_open.cmd, &bi), "vkBeginCommandBuffer(upload)");
+
+    m_hasOpen = true;
+    return m_open;
+}
+
+GpuBuffer UploadManager::createDedicatedStaging(const void* data, VkDeviceSize size)
+{
+    GpuBuffer s = m_allocator.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, GpuMemoryUsage::Upload, "upload staging, dedicated");
+    std::memcpy(s.alloc.mapped, data, (size_t)size);
+    m_allocator.flush(s.alloc);
+    return s;
+}
+
+UploadManager::StagingSlice UploadManager::stage(Batch& b, const void* data, VkDeviceSize size)
+{
+    StagingRing::Allocation a{};
+    bool ok = m_ring.allocate(size, m_copyAlignment, a);
+
+    // кольцо занято: ждём самые старые отправленные загрузки, пока не освободится место
+    // (куски открытого batch'а освободятся только после его flush())
+    while (!ok && size <= m_ring.capacity())
+    {
+        if (!m_ring.hasRetired())
+            break;
+
+        wait({ m_ring.oldestRetired() });
+        m_ring.reclaim(completedValue());
+        ok = m_ring.allocate(size, m_copyAlignment, a);
+    }
+
+    if (ok)
+    {
+        std::memcpy(a.ptr, data, (size_t)size);
+        m_ring.flush(a, size);
+        return { a.buffer, a.offset };
+    }
+
+    // больше кольца (или кольцо целиком занято открытым batch'ем) — отдельный буфер
+    b.staging.push_back(createDedicatedStaging(data, size));
+    return { b.staging.back().buffer, 0 };
+}
+
+void UploadManager::uploadImage(
+    VkImage image,
+    uint32_t width,
+    uint32_t height,
+    const void* data,
+    VkDeviceSize size,
+    VkImageLayout finalLayout,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess,
+    uint32_t layer)
+{
+    Batch& b = openBatch();
+    const StagingSlice staging = stage(b, data, size);
+
+    VkImageMemoryBarrier toDst{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    toDst.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toDst.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toDst.srcAccessMask = 0;
+    toDst.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toDst.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toDst.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toDst.image = image;
+    toDst.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toDst.subresourceRange.levelCount = 1;
+    toDst.subresourceRange.baseArrayLayer = layer;
+    toDst.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toDst);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = staging.offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.baseArrayLayer = layer;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { width, height, 1 };
+    vkCmdCopyBufferToImage(b.cmd, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // переход в finalLayout: здесь (одно семейство) или парой release/acquire
+    VkImageMemoryBarrier release = toDst;
+    release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    release.newLayout = finalLayout;
+    release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    if (ownershipTransfer())
+    {
+        release.dstAccessMask = 0; // игнорируется при release
+        release.srcQueueFamilyIndex = m_transferFamily;
+        release.dstQueueFamilyIndex = m_graphicsFamily;
+        vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &release);
+
+        VkImageMemoryBarrier acquire = release;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = dstAccess;
+        b.imageAcquires.push_back(acquire);
+        b.acquireStages |= dstStage;
+    }
+    else
+    {
+        release.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+                             0, nullptr, 0, nullptr, 1, &release);
+    }
+}
+
+void UploadManager::uploadBuffer(
+    VkBuffer dst,
+    VkDeviceSize dstOffset,
+    const void* data,
+    VkDeviceSize size,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess)
+{
+    Batch& b = openBatch();
+    const StagingSlice staging = stage(b, data, size);
+
+    VkBufferCopy region{};
+    region.srcOffset = staging.offset;
+    region.dstOffset = dstOffset;
+    region.size = size;
+    vkCmdCopyBuffer(b.cmd, staging.buffer, dst, 1, &region);
+
+    VkBufferMemoryBarrier release{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    release.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    release.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    release.buffer = dst;
+    release.offset = dstOffset;
+    release.size = size;
+
+    if (ownershipTransfer())
+    {
+        release.srcQueueFamilyIndex = m_transferFamily;
+        release.dstQueueFamilyIndex = m_graphicsFamily;
+        vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 1, &release, 0, nullptr);
+
+        VkBufferMemoryBarrier acquire = release;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = dstAccess;
+        b.bufferAcquires.push_back(acquire);
+        b.acquireStages |= dstStage;
+    }
+    else
+    {
+        release.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+                             0, nullptr, 1, &release, 0, nullptr);
+    }
+}
+
+UploadTicket UploadManager::flush()
+{
+    collect();
+
+    if (!m_hasOpen)
+        return { m_submitted };
+
+    Batch b = std::move(m_open);
+    m_open = {};
+    m_hasOpen = false;
+
+    vk_check(vkEndCommandBuffer(b.cmd), "vkEndCommandBuffer(upload)");
+
+    b.value = ++m_submitted;
+    m_ring.retire(b.value);
+    b.acquired = b.imageAcquires.empty() && b.bufferAcquires.empty();
+
+    VkTimelineSemaphoreSubmitInfo tsi{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    tsi.signalSemaphoreValueCount = 1;
+    tsi.pSignalSemaphoreValues = &b.value;
+
+    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    si.pNext = &tsi;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &b.cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = &m_timeline;
+
+    vk_check(vkQueueSubmit(m_queue, 1, &si, VK_NULL_HANDLE), "vkQueueSubmit(upload)");
+
+    m_inFlight.push_back(std::move(b));
+    return { m_submitted };
+}
+
+uint64_t UploadManager::completedValue() const
+{
+    uint64_t value = 0;
+    vk_check(vkGetSemaphoreCounterValue(m_device, m_timeline, &value), "vkGetSemaphoreCounterValue(upload)");
+    return value;
+}
+
+bool UploadManager::isComplete(UploadTicket ticket) const
+{
+    return ticket.value <= m_submitted && completedValue() >= ticket.value;
+}
+
+void UploadManager::wait(UploadTicket ticket) const
+{
+    if (!ticket.valid())
+        return;
+
+    VkSemaphoreWaitInfo wi{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    wi.semaphoreCount = 1;
+    wi.pSemaphores = &m_timeline;
+    wi.pValues = &ticket.value;
+    vk_check(vkWaitSemaphores(m_device, &wi, UINT64_MAX), "vkWaitSemaphores(upload)");
+}
+
+uint64_t UploadManager::recordAcquires(VkCommandBuffer graphicsCmd)
+{
+    const uint64_t done = completedValue();
+
+    uint64_t waitValue = 0;
+    for (Batch& b : m_inFlight)
+    {
+        // только завершённые: graphics не должен ждать DMA
+        if (b.value > done)
+            break;
+        if (b.acquired)
+            continue;
+
+        // srcStage — стадия ожидания timeline semaphore в сабмите кадра
+        vkCmdPipelineBarrier(graphicsCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, b.acquireStages, 0,
+                             0, nullptr,
+                             (uint32_t)b.bufferAcquires.size(), b.bufferAcquires.data(),
+                             (uint32_t)b.imageAcquires.size(), b.imageAcquires.data());
+
+        b.acquired = true;
+        waitValue = b.value;
+    }
+
+    return waitValue;
+}
+
+void UploadManager::collect()
+{
+    if (m_inFlight.empty())
+        return;
+
+    const uint64_t done = completedValue();
+    m_ring.reclaim(done);
+    while (!m_inFlight.empty() && m_inFlight.front().value <= done && m_inFlight.front().acquired)
+    {
+        releaseBatch(m_inFlight.front());
+        m_inFlight.pop_front();
+    }
+}
+
+void UploadManager::releaseBatch(Batch& b)
+{
+    for (GpuBuffer& s : b.staging)
+        m_allocator.destroyBuffer(s);
+    b.staging.clear();
+
+    if (b.cmd)
+    {
+        vkFreeCommandBuffers(m_device, m_cmdPool, 1, &b.cmd);
+        b.cmd = VK_NULL_HANDLE;
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "vk/GpuAllocator.h"
+#include "vk/StagingRing.h"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Готовность загрузок одного flush(): значение timeline semaphore UploadManager'а
+struct UploadTicket
+{
+    uint64_t value = 0; // 0 — пустой
+
+    bool valid() const { return value != 0; }
+};
+
+// Асинхронные загрузки на transfer очереди (отдельное DMA семейство, если есть).
+// Копии копятся в открытом batch'е (один командный буфер), flush() отправляет его
+// и сигналит timeline semaphore значением тикета — ни очередь graphics, ни вызывающий не ждут.
+//
+// Если семейства разные, ресурсы переходят в graphics через queue family ownership transfer:
+// release пишется здесь, acquire — в кадр graphics очереди через recordAcquires(),
+// сабмит кадра ждёт timeline semaphore (значение уже достигнуто — ожидание бесплатное).
+//
+// Данные копий пишутся в общий StagingRing (освобождается по timeline semaphore);
+// запросы больше кольца получают отдельный staging буфер на время batch'а.
+//
+// Однопоточный: все вызовы — из потока рендера.
+class UploadManager
+{
+public:
+    UploadManager(
+        GpuAllocator& allocator,
+        uint32_t transferFamily,
+        VkQueue transferQueue,
+        uint32_t graphicsFamily,
+        VkDeviceSize stagingRingSize = kDefaultStagingRingSize);
+    ~UploadManager();
+
+    static constexpr VkDeviceSize kDefaultStagingRingSize = 16ull << 20;
+
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    // Копия data во весь mip 0 слоя layer image (UNDEFINED -> TRANSFER_DST -> finalLayout).
+    // dstStage/dstAccess — где graphics будет его читать.
+    void uploadImage(
+        VkImage image,
+        uint32_t width,
+        uint32_t height,
+        const void* data,
+        VkDeviceSize size,
+        VkImageLayout finalLayout,
+        VkPipelineStageFlags dstStage,
+        VkAccessFlags dstAccess,
+        uint32_t layer = 0);
+
+    // Копия data в [dstOffset, dstOffset + size) буфера (буфер — с TRANSFER_DST)
+    void uploadBuffer(
+        VkBuffer dst,
+        VkDeviceSize dstOffset,
+        const void* data,
+        VkDeviceSize size,
+        VkPipelineStageFlags dstStage,
+        VkAccessFlags dstAccess);
+
+    // Отправить накопленное; тикет покрывает все копии с прошлого flush()
+    // (пустой batch — тикет последней отправки)
+    UploadTicket flush();
+
+    bool isComplete(UploadTicket ticket) const;
+    void wait(UploadTicket ticket) const;
+
+    // В командный буфер graphics очереди (до первого использования ресурсов): acquire барьеры
+    // завершённых batch'ей. Возвращает значение timeline semaphore, которое должен ждать сабмит
+    // этого буфера (0 — ждать нечего).
+    uint64_t recordAcquires(VkCommandBuffer graphicsCmd);
+
+    VkSemaphore timelineSemaphore() const { return m_timeline; }
+    bool ownershipTransfer() const { return m_transferFamily != m_graphicsFamily; }
+
+private:
+    // источник копии: кусок кольца или отдельный буфер
+    struct StagingSlice
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        std::vector<GpuBuffer> staging; // только отдельные; кольцо освобождается по value
+        std::vector<VkImageMemoryBarrier> imageAcquires;
+        std::vector<VkBufferMemoryBarrier> bufferAcquires;
+        VkPipelineStageFlags acquireStages = 0;
+        uint64_t value = 0;
+        bool acquired = false;
+    };
+
+    Batch& openBatch();
+    StagingSlice stage(Batch& b, const void* data, VkDeviceSize size);
+    // отдельный буфер под запрос больше кольца
+    GpuBuffer createDedicatedStaging(const void* data, VkDeviceSize size);
+    uint64_t completedValue() const;
+
+    // освободить staging и командные буферы завершённых (и принятых graphics'ом) batch'ей
+    void collect();
+    void releaseBatch(Batch& b);
+
+private:
+    GpuAllocator& m_allocator;
+    VkDevice m_device = VK_NULL_HANDLE;
+
+    uint32_t m_transferFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+    VkQueue m_queue = VK_NULL_HANDLE;
+
+    StagingRing m_ring;
+    VkDeviceSize m_copyAlignment = 16; // bufferOffset копий: кратно texel'ю и optimalBufferCopyOffsetAlignment
+
+    VkCommandPool m_cmdPool = VK_NULL_HANDLE;
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    uint64_t m_submitted = 0; // значение последнего flush()
+
+    bool m_hasOpen = false;
+    Batch m_open;
+    std::deque<Batch> m_inFlight; // по возрастанию value
+};
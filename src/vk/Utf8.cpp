@@ -0,0 +1,262 @@
+#include "vk/Utf8.h"
+#include "vk/MsdfFont.h"
+
+#include <cstring>
+
+#if APP_ARCH_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define APP_TARGET(isa)
+  #else
+    #define APP_TARGET(isa) __attribute__((target(isa)))
+  #endif
+#endif
+
+static inline uint32_t count_trailing_zeros(uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, v);
+    return (uint32_t)idx;
+#else
+    return (uint32_t)__builtin_ctz(v);
+#endif
+}
+
+// n <= 32; без ветвлений по содержимому
+static inline void map_ascii(const uint8_t* src, size_t n, const uint16_t* ascii, uint16_t* out)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = ascii[src[i]];
+}
+
+static inline uint16_t map_non_ascii(const uint8_t*& p, const uint8_t* end, const Utf8GlyphMap& map)
+{
+    const uint32_t cp = utf8DecodeOne(p, end);
+    const uint16_t gi = cp < 0x80u ? map.ascii[cp] : map.font->glyphIndex(cp);
+    return gi == MsdfFont::kInvalidGlyph ? map.fallback : gi;
+}
+
+// Строка k таблицы — T_k ^ T_(k-1), где T_k = ascii[16k .. 16k + 15]. Для кода c со старшим
+// полубайтом h индекс c - 16k при k <= h лежит в [0, 128), а при k > h отрицателен, и
+// (v)pshufb даёт 0. XOR по всем строкам телескопически оставляет T_h[c & 15].
+void utf8BuildAsciiShuffle(const uint16_t* ascii, Utf8AsciiShuffle& out)
+{
+    for (uint32_t k = 0; k < 8; ++k)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t c = k * 16 + i;
+            const uint16_t v = k ? (uint16_t)(ascii[c] ^ ascii[c - 16]) : ascii[c];
+            out.lo[k][i] = out.lo[k][i + 16] = (uint8_t)v;
+            out.hi[k][i] = out.hi[k][i + 16] = (uint8_t)(v >> 8);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scalar (SWAR по 8 байт)
+// ---------------------------------------------------------------------------
+
+static constexpr uint64_t kHighBits64 = 0x8080808080808080ull;
+
+static size_t ascii_prefix_scalar(const uint8_t* p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        if (w & kHighBits64)
+            break;
+    }
+    while (i < n && p[i] < 0x80u)
+        ++i;
+    return i;
+}
+
+static size_t to_glyphs_scalar(const uint8_t*& p, const uint8_t* end, const Utf8GlyphMap& map,
+                               uint16_t* out, size_t maxOut)
+{
+    size_t o = 0;
+    while (o < maxOut && p < end)
+    {
+        if (end - p >= 8 && maxOut - o >= 8)
+        {
+            uint64_t w;
+            std::memcpy(&w, p, 8);
+            if ((w & kHighBits64) == 0)
+            {
+                map_ascii(p, 8, map.ascii, out + o);
+                p += 8;
+                o += 8;
+                continue;
+            }
+        }
+
+        if (*p < 0x80u)
+            out[o++] = map.ascii[*p++];
+        else
+            out[o++] = map_non_ascii(p, end, map);
+    }
+    return o;
+}
+
+// ---------------------------------------------------------------------------
+// SSE2 (только ASCII-префикс) / AVX2
+// ---------------------------------------------------------------------------
+
+#if APP_ARCH_X86
+
+APP_TARGET("sse2")
+static size_t ascii_prefix_sse2(const uint8_t* p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+        if (mask)
+            return i + count_trailing_zeros(mask);
+    }
+    return i + ascii_prefix_scalar(p + i, n - i);
+}
+
+APP_TARGET("avx2")
+static size_t ascii_prefix_avx2(const uint8_t* p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        if (mask)
+            return i + count_trailing_zeros(mask);
+    }
+    return i + ascii_prefix_sse2(p + i, n - i);
+}
+
+// 32 ASCII кода -> 32 glyph index: по строке таблицы на старший полубайт, индексы c - 16k.
+// Байты с установленным старшим битом дают мусор — вызывающий его не использует.
+APP_TARGET("avx2")
+static inline void map_ascii_avx2(__m256i bytes, const Utf8AsciiShuffle& t, uint16_t* out)
+{
+    const __m256i step = _mm256_set1_epi8(16);
+    __m256i idx = bytes;
+    __m256i lo = _mm256_setzero_si256();
+    __m256i hi = _mm256_setzero_si256();
+    for (uint32_t k = 0; k < 8; ++k)
+    {
+        lo = _mm256_xor_si256(lo, _mm256_shuffle_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(t.lo[k])), idx));
+        hi = _mm256_xor_si256(hi, _mm256_shuffle_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(t.hi[k])), idx));
+        idx = _mm256_sub_epi8(idx, step);
+    }
+
+    // unpack работает внутри 128-битных половин: a = [0..7 | 16..23], b = [8..15 | 24..31]
+    const __m256i a = _mm256_unpacklo_epi8(lo, hi);
+    const __m256i b = _mm256_unpackhi_epi8(lo, hi);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+APP_TARGET("avx2")
+static size_t to_glyphs_avx2(const uint8_t*& p, const uint8_t* end, const Utf8GlyphMap& map,
+                             uint16_t* out, size_t maxOut)
+{
+    Utf8AsciiShuffle local;
+    const Utf8AsciiShuffle* shuffle = map.asciiShuffle;
+
+    size_t o = 0;
+    while (end - p >= 32 && maxOut - o >= 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(bytes);
+        const uint32_t n = mask ? count_trailing_zeros(mask) : 32;
+
+        // короткие ASCII-куски между многобайтовыми символами дешевле по одному
+        if (n >= 8)
+        {
+            if (!shuffle)
+            {
+                utf8BuildAsciiShuffle(map.ascii, local);
+                shuffle = &local;
+            }
+            map_ascii_avx2(bytes, *shuffle, out + o); // коды за n перезапишутся дальше
+        }
+        else
+        {
+            map_ascii(p, n, map.ascii, out + o);
+        }
+        p += n;
+        o += n;
+
+        if (mask)
+            out[o++] = map_non_ascii(p, end, map);
+    }
+
+    // хвост чанка / входа
+    return o + to_glyphs_scalar(p, end, map, out + o, maxOut - o);
+}
+
+#endif // APP_ARCH_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+using AsciiPrefixFn = size_t (*)(const uint8_t*, size_t);
+using ToGlyphsFn = size_t (*)(const uint8_t*&, const uint8_t*, const Utf8GlyphMap&, uint16_t*, size_t);
+
+struct Utf8Dispatch
+{
+    SimdLevel level;
+    AsciiPrefixFn asciiPrefix;
+    ToGlyphsFn toGlyphs;
+};
+
+static Utf8Dispatch make_dispatch(SimdLevel level)
+{
+#if APP_ARCH_X86
+    switch (level)
+    {
+    // 64-байтных блоков нет: AVX-512 идёт путём AVX2
+    case SimdLevel::AVX512:
+    case SimdLevel::AVX2: return { SimdLevel::AVX2, ascii_prefix_avx2, to_glyphs_avx2 };
+    // без pshufb (SSSE3) подстановку не векторизовать: 16-байтный movemask
+    // перед скалярной подстановкой медленнее SWAR, поэтому decode — scalar
+    case SimdLevel::SSE2: return { SimdLevel::SSE2, ascii_prefix_sse2, to_glyphs_scalar };
+    case SimdLevel::Scalar: break;
+    }
+#else
+    (void)level;
+#endif
+    return { SimdLevel::Scalar, ascii_prefix_scalar, to_glyphs_scalar };
+}
+
+static Utf8Dispatch& dispatch()
+{
+    static Utf8Dispatch d = make_dispatch(cpuSimdLevel());
+    return d;
+}
+
+size_t utf8AsciiPrefix(const uint8_t* p, size_t n)
+{
+    return dispatch().asciiPrefix(p, n);
+}
+
+size_t utf8ToGlyphs(const uint8_t*& p, const uint8_t* end, const Utf8GlyphMap& map,
+                    uint16_t* out, size_t maxOut)
+{
+    return dispatch().toGlyphs(p, end, map, out, maxOut);
+}
+
+SimdLevel utf8SimdLevel()
+{
+    return dispatch().level;
+}
+
+SimdLevel utf8SetSimdLevel(SimdLevel level)
+{
+    const SimdLevel cpu = cpuSimdLevel();
+    dispatch() = make_dispatch(level < cpu ? level : cpu);
+    return dispatch().level;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "platform/CpuFeatures.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class MsdfFont;
+
+static constexpr uint32_t kUtf8ReplacementChar = 0xFFFDu;
+
+// Один codepoint из UTF-8; на битой последовательности (overlong, суррогаты, > U+10FFFF,
+// обрыв) возвращает U+FFFD и сдвигает p на 1 байт. p < end обязательно.
+inline uint32_t utf8DecodeOne(const uint8_t*& p, const uint8_t* end)
+{
+    const uint32_t c0 = p[0];
+    if (c0 < 0x80u)
+    {
+        ++p;
+        return c0;
+    }
+
+    uint32_t need = 0, cp = 0, minCp = 0;
+    if ((c0 & 0xE0u) == 0xC0u)      { need = 1; cp = c0 & 0x1Fu; minCp = 0x80u; }
+    else if ((c0 & 0xF0u) == 0xE0u) { need = 2; cp = c0 & 0x0Fu; minCp = 0x800u; }
+    else if ((c0 & 0xF8u) == 0xF0u) { need = 3; cp = c0 & 0x07u; minCp = 0x10000u; }
+    else
+    {
+        ++p;
+        return kUtf8ReplacementChar;
+    }
+
+    if ((size_t)(end - p) <= need)
+    {
+        ++p;
+        return kUtf8ReplacementChar;
+    }
+
+    for (uint32_t i = 1; i <= need; ++i)
+    {
+        const uint32_t c = p[i];
+        if ((c & 0xC0u) != 0x80u)
+        {
+            ++p;
+            return kUtf8ReplacementChar;
+        }
+        cp = (cp << 6) | (c & 0x3Fu);
+    }
+
+    if (cp < minCp || cp > 0x10FFFFu || (cp >= 0xD800u && cp <= 0xDFFFu))
+    {
+        ++p;
+        return kUtf8ReplacementChar;
+    }
+
+    p += need + 1;
+    return cp;
+}
+
+// ascii[0..127] в виде для (v)pshufb: 8 строк по 16 кодов (строка = старший полубайт),
+// младшие и старшие байты glyph index отдельно, каждая строка продублирована на обе
+// 128-битные половины. Строка k хранится как XOR со строкой k - 1 (см. Utf8.cpp).
+struct Utf8AsciiShuffle
+{
+    alignas(32) uint8_t lo[8][32];
+    alignas(32) uint8_t hi[8][32];
+};
+
+void utf8BuildAsciiShuffle(const uint16_t* ascii, Utf8AsciiShuffle& out);
+
+// Как переводить codepoint'ы в glyph indices.
+// ascii[0..127] — готовая таблица (вызывающий может класть туда служебные коды,
+// например для '\n' и ' '); остальное — через font.glyphIndex(), при промахе fallback.
+struct Utf8GlyphMap
+{
+    const uint16_t* ascii = nullptr; // 128 элементов
+    const MsdfFont* font = nullptr;
+    uint16_t fallback = 0xFFFFu;
+    // та же ascii, подготовленная utf8BuildAsciiShuffle; без неё AVX2 путь строит её на каждый вызов
+    const Utf8AsciiShuffle* asciiShuffle = nullptr;
+};
+
+// Длина чистого ASCII-префикса (SSE2/AVX2 по 16/32 байта).
+size_t utf8AsciiPrefix(const uint8_t* p, size_t n);
+
+// Валидирующий декодер UTF-8 -> glyph indices. AVX2: 32-байтный блок проверяется одним
+// movemask, его ASCII переводится через vpshufb по строкам таблицы и расширяется до uint16
+// без скалярной подстановки; остальное идёт через utf8DecodeOne. Без SSSE3 подстановку
+// не векторизовать, поэтому SSE2 идёт scalar путём (SWAR по 8 байт).
+// Пишет не больше maxOut индексов (по одному на codepoint), сдвигает p, возвращает число индексов;
+// AVX2 путь может испортить out за возвращённым числом (в пределах maxOut).
+size_t utf8ToGlyphs(const uint8_t*& p, const uint8_t* end, const Utf8GlyphMap& map,
+                    uint16_t* out, size_t maxOut);
+
+// Текущий путь dispatch (по умолчанию cpuSimdLevel()).
+SimdLevel utf8SimdLevel();
+
+// Принудительно понизить уровень (бенчмарки/сверка со scalar). Не потокобезопасно:
+// вызывать до начала работы. Возвращает реально выставленный уровень.
+SimdLevel utf8SetSimdLevel(SimdLevel level);
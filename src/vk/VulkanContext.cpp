@@ -240,6 +240,7 @@ void VulkanContext::pickPhysicalDevice()
     auto q = find_queue_families(m_physicalDevice, m_surface);
     m_graphicsFamily = q.graphicsFamily.value();
     m_presentFamily = q.presentFamily.value();
+    m_transferFamily = find_dedicated_transfer_family(m_physicalDevice).value_or(m_graphicsFamily);
 }
 
 void VulkanContext::createDevice()
@@ -255,7 +256,7 @@ void VulkanContext::createDevice()
     const bool needSpirv14Fallback = !apiAtLeast12;
     auto deviceExts = get_device_extensions_for_mesh_text(m_physicalDevice, needSpirv14Fallback);
 
-    std::set<uint32_t> uniqueFamilies = { m_graphicsFamily, m_presentFamily };
+    std::set<uint32_t> uniqueFamilies = { m_graphicsFamily, m_presentFamily, m_transferFamily };
     std::vector<VkDeviceQueueCreateInfo> queues;
     queues.reserve(uniqueFamilies.size());
 
@@ -273,9 +274,13 @@ void VulkanContext::createDevice()
     VkPhysicalDeviceMeshShaderFeaturesEXT supportedMeshFeat{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT };
     VkPhysicalDeviceVulkan13Features supported13{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
     supported13.pNext = &supportedMeshFeat;
+    VkPhysicalDeviceVulkan12Features supported12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    supported12.pNext = &supported13;
+    VkPhysicalDeviceVulkan11Features supported11{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+    supported11.pNext = &supported12;
 
     VkPhysicalDeviceFeatures2 supported2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
-    supported2.pNext = &supported13;
+    supported2.pNext = &supported11;
 
     vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supported2);
 
@@ -289,9 +294,24 @@ void VulkanContext::createDevice()
     v13.maintenance4     = supported13.maintenance4 ? VK_TRUE : VK_FALSE;
     v13.pNext = &meshFeat;
 
+    // MSDF текст рисуется vkCmdDrawMeshTasksIndirectCountEXT, task shader читает gl_DrawID
+    VkPhysicalDeviceVulkan12Features v12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    v12.drawIndirectCount = supported12.drawIndirectCount;
+    v12.timelineSemaphore = supported12.timelineSemaphore; // UploadManager: готовность загрузок
+    // таблица атласов MSDF текста: sampler2DArray[] с индексом из инстанса, незаполненные слоты
+    v12.shaderSampledImageArrayNonUniformIndexing = supported12.shaderSampledImageArrayNonUniformIndexing;
+    v12.descriptorBindingPartiallyBound = supported12.descriptorBindingPartiallyBound;
+    v12.pNext = &v13;
+
+    VkPhysicalDeviceVulkan11Features v11{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+    v11.shaderDrawParameters = supported11.shaderDrawParameters;
+    v11.pNext = &v12;
+
     VkPhysicalDeviceFeatures2 feats2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
     feats2.features = {};
-    feats2.pNext = &v13;
+    feats2.features.shaderClipDistance = supported2.features.shaderClipDistance; // clip rect текстовых блоков
+    feats2.features.multiDrawIndirect = supported2.features.multiDrawIndirect;   // по draw на видимый блок
+    feats2.pNext = &v11;
 
     VkDeviceCreateInfo dci{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
     dci.queueCreateInfoCount = (uint32_t)queues.size();
@@ -311,9 +331,12 @@ void VulkanContext::createDevice()
 
     vkGetDeviceQueue(m_device, m_graphicsFamily, 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, m_presentFamily, 0, &m_presentQueue);
+    vkGetDeviceQueue(m_device, m_transferFamily, 0, &m_transferQueue);
 
     // Подготовим функцию mesh draw на будущее (пока не используем)
     vkCmdDrawMeshTasksEXT = (PFN_vkCmdDrawMeshTasksEXT)vkGetDeviceProcAddr(m_device, "vkCmdDrawMeshTasksEXT");
+    vkCmdDrawMeshTasksIndirectCountEXT = (PFN_vkCmdDrawMeshTasksIndirectCountEXT)vkGetDeviceProcAddr(
+        m_device, "vkCmdDrawMeshTasksIndirectCountEXT");
 
     if (!supported13.dynamicRendering)
     {
@@ -321,9 +344,44 @@ void VulkanContext::createDevice()
         std::exit(EXIT_FAILURE);
     }
 
+    // MSDF текст: task shader отсекает группы глифов, clip distance режет по clip rect
+    if (!supportedMeshFeat.taskShader || !supported2.features.shaderClipDistance)
+    {
+        std::cerr << "GPU does not support taskShader/shaderClipDistance features.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // GPU-driven dispatch MSDF текста: compute пишет команды и их число
+    if (!supported12.drawIndirectCount || !supported2.features.multiDrawIndirect || !supported11.shaderDrawParameters)
+    {
+        std::cerr << "GPU does not support drawIndirectCount/multiDrawIndirect/shaderDrawParameters features.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (!supported12.timelineSemaphore)
+    {
+        std::cerr << "GPU does not support timelineSemaphore feature.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // атлас глифа выбирается во фрагментном шейдере по GlyphInstance::atlas
+    if (!supported12.shaderSampledImageArrayNonUniformIndexing || !supported12.descriptorBindingPartiallyBound)
+    {
+        std::cerr << "GPU does not support shaderSampledImageArrayNonUniformIndexing/descriptorBindingPartiallyBound features.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    VkPhysicalDeviceProperties2 props2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+    props2.pNext = &m_meshProps;
+    vkGetPhysicalDeviceProperties2(m_physicalDevice, &props2);
+    m_meshProps.pNext = nullptr;
+
     std::cout << "Device created. MeshShader="
               << (supportedMeshFeat.meshShader ? "YES" : "NO")
               << ", TaskShader="
               << (supportedMeshFeat.taskShader ? "YES" : "NO")
+              << ", meshOut=" << m_meshProps.maxMeshOutputVertices << "v/" << m_meshProps.maxMeshOutputPrimitives << "p"
+              << ", preferredMeshInvocations=" << m_meshProps.maxPreferredMeshWorkGroupInvocations
+              << ", transferQueue=" << (m_transferFamily != m_graphicsFamily ? "dedicated" : "graphics")
               << "\n";
 }
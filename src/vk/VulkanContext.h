@@ -22,11 +22,19 @@ public:
     uint32_t graphicsFamily() const { return m_graphicsFamily; }
     uint32_t presentFamily() const { return m_presentFamily; }
 
+    // Очередь загрузок: отдельное transfer-семейство, если есть, иначе — graphics очередь
+    uint32_t transferFamily() const { return m_transferFamily; }
+    VkQueue transferQueue() const { return m_transferQueue; }
+
     VkQueue graphicsQueue() const { return m_graphicsQueue; }
     VkQueue presentQueue() const { return m_presentQueue; }
 
+    // Лимиты mesh shader'а: по ним подбирается упаковка глифов в workgroup
+    const VkPhysicalDeviceMeshShaderPropertiesEXT& meshShaderProperties() const { return m_meshProps; }
+
     // На будущее (mesh draw)
     PFN_vkCmdDrawMeshTasksEXT vkCmdDrawMeshTasksEXT = nullptr;
+    PFN_vkCmdDrawMeshTasksIndirectCountEXT vkCmdDrawMeshTasksIndirectCountEXT = nullptr;
 
 private:
     void createInstance();
@@ -48,9 +56,13 @@ private:
 
     uint32_t m_graphicsFamily = UINT32_MAX;
     uint32_t m_presentFamily = UINT32_MAX;
+    uint32_t m_transferFamily = UINT32_MAX;
 
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
     VkQueue m_presentQueue = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
+
+    VkPhysicalDeviceMeshShaderPropertiesEXT m_meshProps{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_PROPERTIES_EXT };
 
     bool m_enableValidation = false;
 
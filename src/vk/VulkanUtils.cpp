@@ -1,6 +1,8 @@
 #include "vk/VulkanUtils.h"
+#include "vk/ShaderRegistry.h"
 
 #include <iostream>
+#include <bit>
 #include <cstring>
 #include <unordered_set>
 #include <GLFW/glfw3.h>
@@ -14,6 +16,50 @@ void vk_check(VkResult res, const char* what)
     }
 }
 
+std::optional<uint32_t> find_memory_type(
+    const VkPhysicalDeviceMemoryProperties& mp,
+    uint32_t typeBits,
+    VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred)
+{
+    std::optional<uint32_t> best;
+    int bestScore = -1;
+
+    for (uint32_t i = 0; i < mp.memoryTypeCount; ++i)
+    {
+        const VkMemoryPropertyFlags flags = mp.memoryTypes[i].propertyFlags;
+        if (!(typeBits & (1u << i)) || (flags & required) != required)
+            continue;
+
+        const int score = std::popcount(flags & preferred);
+        if (score > bestScore)
+        {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    return best;
+}
+
+VkShaderModule create_shader_module(VkDevice device, const char* shaderName)
+{
+    ShaderCode code;
+    if (!code.load(shaderName))
+    {
+        std::cerr << "Failed to load shader: " << shaderName << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    VkShaderModuleCreateInfo ci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    ci.codeSize = code.sizeBytes();
+    ci.pCode = code.data();
+
+    VkShaderModule mod = VK_NULL_HANDLE;
+    vk_check(vkCreateShaderModule(device, &ci, nullptr, &mod), "vkCreateShaderModule");
+    return mod;
+}
+
 bool has_validation_layer_support(const std::vector<const char*>& layers)
 {
     uint32_t count = 0;
@@ -87,6 +133,22 @@ QueueFamilyIndices find_queue_families(VkPhysicalDevice phys, VkSurfaceKHR surfa
     return out;
 }
 
+std::optional<uint32_t> find_dedicated_transfer_family(VkPhysicalDevice phys)
+{
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &count, families.data());
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const VkQueueFlags f = families[i].queueFlags;
+        if ((f & VK_QUEUE_TRANSFER_BIT) && !(f & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            return i;
+    }
+    return std::nullopt;
+}
+
 bool device_supports_extensions(VkPhysicalDevice phys, const std::vector<const char*>& required)
 {
     uint32_t count = 0;
@@ -17,12 +17,26 @@ struct QueueFamilyIndices
 
 void vk_check(VkResult res, const char* what);
 
+// Тип памяти из typeBits со всеми флагами required; среди них — с наибольшим числом флагов preferred.
+// Нет подходящего — пусто
+std::optional<uint32_t> find_memory_type(
+    const VkPhysicalDeviceMemoryProperties& mp,
+    uint32_t typeBits,
+    VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred = 0);
+
+// SPIR-V по имени из ShaderRegistry (вшитый или с диска при hot reload); при ошибке — exit
+VkShaderModule create_shader_module(VkDevice device, const char* shaderName);
+
 bool has_validation_layer_support(const std::vector<const char*>& layers);
 
 std::vector<const char*> get_required_instance_extensions(bool enableValidation);
 
 QueueFamilyIndices find_queue_families(VkPhysicalDevice phys, VkSurfaceKHR surface);
 
+// Семейство только для копий (TRANSFER без GRAPHICS/COMPUTE — DMA движок); нет — пусто
+std::optional<uint32_t> find_dedicated_transfer_family(VkPhysicalDevice phys);
+
 bool device_supports_extensions(VkPhysicalDevice phys, const std::vector<const char*>& required);
 
 std::vector<const char*> get_device_extensions_for_mesh_text(